@@ -68,6 +68,9 @@ double ground_state(Simulation_context& ctx,
         }
         density.load();
         potential.load();
+        if (ctx.control().save_wave_functions_ && !ctx.full_potential()) {
+            kset.load(storage_file_name);
+        }
     } else {
         dft.initial_state();
     }
@@ -55,7 +55,7 @@ void test_hloc(std::vector<int> mpi_grid_dims__, double cutoff__, int num_bands_
         phi.pw_coeffs(0).copy_to(memory_t::device, 0, 4 * num_bands__);
         hphi.pw_coeffs(0).allocate(memory_t::device);
     }
-    hloc.prepare_k(gvecp); 
+    hloc.prepare_k(fft, gvecp);
     for (int i = 0; i < 4; i++) {
         hloc.apply_h(fft, gvecp, spin_range(0), phi, hphi, i * num_bands__, num_bands__);
     }
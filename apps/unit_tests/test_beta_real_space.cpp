@@ -0,0 +1,79 @@
+#include <sirius.hpp>
+#include "testing.hpp"
+
+/* test the real-space application of the beta-projectors against the plane-wave projectors */
+
+using namespace sirius;
+
+std::vector<double> solve_bands(bool beta_real_space__, double radius_scale__)
+{
+    /* two atoms in a skewed cell, so that the projector spheres overlap and wrap around the cell */
+    auto ctx_ptr = create_model_context(
+        "{"
+        "   \"parameters\" : {"
+        "        \"num_bands\" : 12,"
+        "        \"gk_cutoff\" : 8"
+        "    },"
+        "   \"control\" : {"
+        "       \"beta_real_space\" : " + std::string(beta_real_space__ ? "true" : "false") + ","
+        "       \"beta_real_space_radius_scale\" : " + std::to_string(radius_scale__) +
+        "    },"
+        "   \"iterative_solver\" : {"
+        "       \"type\" : \"davidson\","
+        "       \"num_steps\" : 100,"
+        "       \"residual_tolerance\" : 1e-8"
+        "    },"
+        "   \"unit_cell\" : {"
+        "       \"lattice_vectors\" : [[5, 0, 0], [1.5, 5, 0], [0, 1, 5]],"
+        "       \"atoms\" : {\"Cu\" : [[0, 0, 0], [0.4, 0.55, 0.3]]}"
+        "    }"
+        "}", [](Atom_type& atype) { add_gaussian_beta(atype, 2); });
+    auto& ctx = *ctx_ptr;
+
+    Density rho(ctx);
+    rho.initial_density();
+
+    Potential pot(ctx);
+    pot.generate(rho);
+
+    double vk[] = {0.1, 0.2, 0.3};
+    K_point kp(ctx, vk, 1.0, 0);
+    kp.initialize();
+
+    if (beta_real_space__ && !kp.beta_projectors_real_space()) {
+        throw std::runtime_error("real-space beta-projectors are not created");
+    }
+
+    Hamiltonian0 H0(pot);
+    auto Hk = H0(kp);
+    Band(ctx).initialize_subspace<double_complex>(Hk, ctx.unit_cell().num_ps_atomic_wf());
+    Band(ctx).solve_pseudo_potential<double_complex>(Hk);
+
+    std::vector<double> eval(ctx.num_bands());
+    for (int i = 0; i < ctx.num_bands(); i++) {
+        eval[i] = kp.band_energy(i, 0);
+    }
+    return eval;
+}
+
+int test_beta_real_space(double radius_scale__, double tol__)
+{
+    auto eval_ref = solve_bands(false, radius_scale__);
+    auto eval     = solve_bands(true, radius_scale__);
+
+    double diff{0};
+    for (size_t i = 0; i < eval.size(); i++) {
+        diff = std::max(diff, std::abs(eval[i] - eval_ref[i]));
+    }
+    printf("radius scale: %f, maximum eigen-value difference: %18.12e\n", radius_scale__, diff);
+    return (diff > tol__) ? 1 : 0;
+}
+
+int main(int argn, char** argv)
+{
+    sirius::initialize(true);
+    int err{0};
+    err += call_test("real-space beta-projectors", []() { return test_beta_real_space(1.0, 1e-5); });
+    sirius::finalize();
+    return std::min(err, 1);
+}
@@ -0,0 +1,80 @@
+#include <sirius.hpp>
+#include "testing.hpp"
+
+/* test Chebyshev-filtered subspace iteration against the exact diagonalization of the pseudopotential Hamiltonian */
+
+using namespace sirius;
+
+std::vector<double> solve_bands(std::string solver__, int degree__, int max_degree__)
+{
+    /* norm-conserving model atom with s, p and d projectors */
+    auto ctx_ptr = create_model_context(
+        "{"
+        "   \"parameters\" : {"
+        "        \"num_bands\" : 12"
+        "    },"
+        "   \"iterative_solver\" : {"
+        "       \"type\" : \"" + solver__ + "\","
+        "       \"num_steps\" : 100,"
+        "       \"residual_tolerance\" : 1e-8,"
+        "       \"chebyshev_degree\" : " + std::to_string(degree__) + ","
+        "       \"chebyshev_max_degree\" : " + std::to_string(max_degree__) +
+        "    }"
+        "}", [](Atom_type& atype) {
+            int icut    = atype.radial_grid().index_of(1.0);
+            double rcut = atype.radial_grid(icut);
+            std::vector<double> beta(icut + 1);
+            for (int l = 0; l <= 2; l++) {
+                for (int i = 0; i <= icut; i++) {
+                    beta[i] = utils::confined_polynomial(atype.radial_grid(i), rcut, l, l + 1, 0);
+                }
+                atype.add_beta_radial_function(l, beta);
+            }
+        });
+    auto& ctx = *ctx_ptr;
+
+    Density rho(ctx);
+    rho.initial_density();
+
+    Potential pot(ctx);
+    pot.generate(rho);
+
+    double vk[] = {0.1, 0.2, 0.3};
+    K_point kp(ctx, vk, 1.0, 0);
+    kp.initialize();
+
+    Hamiltonian0 H0(pot);
+    auto Hk = H0(kp);
+    Band(ctx).initialize_subspace<double_complex>(Hk, ctx.unit_cell().num_ps_atomic_wf());
+    Band(ctx).solve_pseudo_potential<double_complex>(Hk);
+
+    std::vector<double> eval(ctx.num_bands());
+    for (int i = 0; i < ctx.num_bands(); i++) {
+        eval[i] = kp.band_energy(i, 0);
+    }
+    return eval;
+}
+
+int test_chfsi(int degree__, int max_degree__)
+{
+    auto eval_ref = solve_bands("exact", degree__, max_degree__);
+    auto eval     = solve_bands("chebyshev", degree__, max_degree__);
+
+    double diff{0};
+    for (size_t i = 0; i < eval.size(); i++) {
+        diff = std::max(diff, std::abs(eval[i] - eval_ref[i]));
+    }
+    printf("maximum eigen-value difference: %18.12e\n", diff);
+    return (diff > 1e-8) ? 1 : 0;
+}
+
+int main(int argn, char** argv)
+{
+    sirius::initialize(true);
+    int err{0};
+    err += call_test("ChFSI with the default filter degree", []() { return test_chfsi(8, 32); });
+    /* low starting degree with a wide range checks the adaptation of the filter degree */
+    err += call_test("ChFSI with an adaptive filter degree", []() { return test_chfsi(2, 64); });
+    sirius::finalize();
+    return std::min(err, 1);
+}
@@ -0,0 +1,132 @@
+#include <sirius.hpp>
+#include "geometry/ewald_pme.hpp"
+
+/* test particle-mesh Ewald summation against the direct summation of the reciprocal-space part */
+
+using namespace sirius;
+
+int run_test(cmd_args& args)
+{
+    int num_atoms = args.value<int>("num_atoms", 7);
+    int order     = args.value<int>("order", 8);
+
+    Simulation_context ctx(
+        "{"
+        "   \"parameters\" : {"
+        "        \"electronic_structure_method\" : \"pseudopotential\","
+        "        \"pw_cutoff\" : 8,"
+        "        \"gk_cutoff\" : 3,"
+        "        \"use_symmetry\" : false"
+        "    },"
+        "   \"settings\" : {"
+        "        \"fft_grid_size\" : [32, 32, 32]"
+        "    },"
+        "   \"control\" : {"
+        "       \"verification\" : 0"
+        "    }"
+        "}");
+
+    /* simple atom type with a point charge */
+    auto& atype = ctx.unit_cell().add_atom_type("A");
+    atype.zn(3);
+    atype.set_radial_grid(radial_grid_t::lin_exp, 1000, 0.0, 100.0, 6);
+    std::vector<double> beta(atype.radial_grid().index_of(1.0) + 1, 0);
+    atype.add_beta_radial_function(0, beta);
+    matrix<double> dion(1, 1);
+    dion.zero();
+    atype.d_mtrx_ion(dion);
+    std::vector<double> v(atype.radial_grid().num_points(), 0);
+    atype.local_potential(v);
+    for (int i = 0; i < atype.radial_grid().num_points(); i++) {
+        double x = atype.radial_grid(i);
+        v[i] = 2 * atype.zn() * std::exp(-x * x) * x;
+    }
+    atype.ps_total_charge_density(v);
+
+    ctx.unit_cell().set_lattice_vectors({{7.0, 0.0, 0.0}, {0.5, 7.5, 0.0}, {0.3, 0.2, 6.5}});
+    for (int ia = 0; ia < num_atoms; ia++) {
+        ctx.unit_cell().add_atom("A", {utils::random<double>(), utils::random<double>(), utils::random<double>()});
+    }
+    ctx.initialize();
+
+    auto& uc     = ctx.unit_cell();
+    double alpha = ctx.ewald_lambda();
+
+    /* direct summation */
+    double e_ref{0};
+    mdarray<double, 2> f_ref(3, uc.num_atoms());
+    f_ref.zero();
+    for (int igloc = 0; igloc < ctx.gvec().count(); igloc++) {
+        int ig = ctx.gvec().offset() + igloc;
+        if (!ig) {
+            continue;
+        }
+        double g2 = std::pow(ctx.gvec().gvec_len(ig), 2);
+        double f  = std::exp(-g2 / 4 / alpha) / g2;
+        auto G    = ctx.gvec().gvec_cart<index_domain_t::local>(igloc);
+
+        double_complex rho(0, 0);
+        for (int ia = 0; ia < uc.num_atoms(); ia++) {
+            rho += ctx.gvec_phase_factor(ig, ia) * static_cast<double>(uc.atom(ia).zn());
+        }
+        e_ref += std::norm(rho) * f;
+        for (int ia = 0; ia < uc.num_atoms(); ia++) {
+            double z = (fourpi / uc.omega()) * f * uc.atom(ia).zn() *
+                       (std::conj(rho) * ctx.gvec_phase_factor(ig, ia)).imag();
+            for (int x : {0, 1, 2}) {
+                f_ref(x, ia) += z * G[x];
+            }
+        }
+    }
+    ctx.comm().allreduce(&e_ref, 1);
+    ctx.comm().allreduce(f_ref.at(memory_t::host), static_cast<int>(f_ref.size()));
+    double scale = ctx.gvec().reduced() ? 2 : 1;
+    e_ref *= scale * twopi / uc.omega();
+
+    /* particle-mesh Ewald */
+    Ewald_pme pme(ctx, order);
+    mdarray<double, 2> f_pme(3, uc.num_atoms());
+    f_pme.zero();
+    double e_pme = pme.reciprocal_sum(&f_pme);
+
+    double diff_f{0};
+    for (int ia = 0; ia < uc.num_atoms(); ia++) {
+        for (int x : {0, 1, 2}) {
+            diff_f = std::max(diff_f, std::abs(f_pme(x, ia) - scale * f_ref(x, ia)));
+        }
+    }
+    double diff_e = std::abs(e_pme - e_ref) / std::abs(e_ref);
+
+    if (diff_e > 1e-6 || diff_f > 1e-4) {
+        printf("energy: %18.12f %18.12f, relative difference: %18.12e, max. force difference: %18.12e\n",
+               e_ref, e_pme, diff_e, diff_f);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argn, char **argv)
+{
+    cmd_args args;
+    args.register_key("--num_atoms=", "{int} number of atoms");
+    args.register_key("--order=", "{int} order of B-spline interpolation");
+
+    args.parse_args(argn, argv);
+    if (args.exist("help")) {
+        printf("Usage: %s [options]\n", argv[0]);
+        args.print_help();
+        return 0;
+    }
+
+    sirius::initialize(true);
+    printf("running %-30s : ", argv[0]);
+    int result = run_test(args);
+    if (result) {
+        printf("\x1b[31m" "Failed" "\x1b[0m" "\n");
+    } else {
+        printf("\x1b[32m" "OK" "\x1b[0m" "\n");
+    }
+    sirius::finalize();
+
+    return result;
+}
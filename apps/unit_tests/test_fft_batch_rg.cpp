@@ -0,0 +1,115 @@
+#include <sirius.hpp>
+
+/* test batched transformation of smooth periodic functions against the single transformations */
+
+using namespace sirius;
+
+int run_test(cmd_args& args)
+{
+    double cutoff = args.value<double>("cutoff", 10);
+    int nbatch    = args.value<int>("nbatch", 3);
+
+    matrix3d<double> M = {{1, 0.1, 0}, {0.2, 1, 0}, {0, 0.3, 1}};
+
+    auto fft_grid = get_min_fft_grid(cutoff, M);
+
+    auto spl_z = split_fft_z(fft_grid[2], Communicator::world());
+
+    Gvec gvec(M, cutoff, Communicator::world(), true);
+
+    Gvec_partition gvp(gvec, Communicator::world(), Communicator::self());
+
+    spfft::Grid spfft_grid(fft_grid[0], fft_grid[1], fft_grid[2], gvp.zcol_count_fft(), spl_z.local_size(),
+                           SPFFT_PU_HOST, -1, Communicator::world().mpi_comm(), SPFFT_EXCH_DEFAULT);
+
+    auto gv = gvp.get_gvec();
+    spfft::Transform spfft(spfft_grid.create_transform(SPFFT_PU_HOST, SPFFT_TRANS_R2C, fft_grid[0], fft_grid[1],
+        fft_grid[2], spl_z.local_size(), gvp.gvec_count_fft(), SPFFT_INDEX_TRIPLETS, gv.at(memory_t::host)));
+
+    std::vector<spfft::Transform> spfft_batch;
+    for (int i = 0; i < nbatch; i++) {
+        spfft_batch.emplace_back(spfft.clone());
+    }
+
+    /* number of functions is not a multiple of the batch size */
+    int nf = 2 * nbatch + 1;
+
+    std::vector<Smooth_periodic_function<double>> f;
+    std::vector<Smooth_periodic_function<double>> g;
+    for (int i = 0; i < nf; i++) {
+        f.emplace_back(spfft, gvp);
+        g.emplace_back(spfft, gvp);
+        for (int ig = 0; ig < gvec.count(); ig++) {
+            auto z = utils::random<double_complex>();
+            if (gvec.offset() + ig == 0) {
+                z = z.real();
+            }
+            f[i].f_pw_local(ig) = z;
+            g[i].f_pw_local(ig) = z;
+        }
+    }
+
+    std::vector<Smooth_periodic_function<double>*> ptr;
+    for (int i = 0; i < nf; i++) {
+        ptr.push_back(&g[i]);
+    }
+
+    double diff_rg{0};
+    double diff_pw{0};
+
+    for (int i = 0; i < nf; i++) {
+        f[i].fft_transform(1);
+    }
+    fft_transform(ptr, 1, spfft_batch);
+    for (int i = 0; i < nf; i++) {
+        for (int ir = 0; ir < spfft.local_slice_size(); ir++) {
+            diff_rg += std::abs(f[i].f_rg(ir) - g[i].f_rg(ir));
+            f[i].f_rg(ir) *= (ir % 7);
+            g[i].f_rg(ir) *= (ir % 7);
+        }
+    }
+
+    for (int i = 0; i < nf; i++) {
+        f[i].fft_transform(-1);
+    }
+    fft_transform(ptr, -1, spfft_batch);
+    for (int i = 0; i < nf; i++) {
+        for (int ig = 0; ig < gvec.count(); ig++) {
+            diff_pw += std::abs(f[i].f_pw_local(ig) - g[i].f_pw_local(ig));
+        }
+    }
+    Communicator::world().allreduce(&diff_rg, 1);
+    Communicator::world().allreduce(&diff_pw, 1);
+
+    if (diff_rg > 1e-10 || diff_pw > 1e-10) {
+        printf("diff_rg: %18.12e, diff_pw: %18.12e\n", diff_rg, diff_pw);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argn, char **argv)
+{
+    cmd_args args;
+    args.register_key("--cutoff=", "{double} cutoff radius in G-space");
+    args.register_key("--nbatch=", "{int} number of FFT drivers in the pool");
+
+    args.parse_args(argn, argv);
+    if (args.exist("help")) {
+        printf("Usage: %s [options]\n", argv[0]);
+        args.print_help();
+        return 0;
+    }
+
+    sirius::initialize(true);
+    printf("running %-30s : ", argv[0]);
+    int result = run_test(args);
+    if (result) {
+        printf("\x1b[31m" "Failed" "\x1b[0m" "\n");
+    } else {
+        printf("\x1b[32m" "OK" "\x1b[0m" "\n");
+    }
+    sirius::finalize();
+
+    return result;
+}
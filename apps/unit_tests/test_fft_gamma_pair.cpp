@@ -0,0 +1,113 @@
+#include <sirius.hpp>
+
+/* test transformation of two real functions with one complex FFT against the single R2C transformations */
+
+using namespace sirius;
+
+int run_test(cmd_args& args)
+{
+    double cutoff = args.value<double>("cutoff", 10);
+
+    matrix3d<double> M = {{1, 0.1, 0}, {0.2, 1, 0}, {0, 0.3, 1}};
+
+    auto fft_grid = get_min_fft_grid(cutoff, M);
+
+    auto spl_z = split_fft_z(fft_grid[2], Communicator::world());
+
+    Gvec gvec(M, cutoff, Communicator::world(), true);
+
+    Gvec_partition gvp(gvec, Communicator::world(), Communicator::self());
+
+    spfft::Grid spfft_grid(fft_grid[0], fft_grid[1], fft_grid[2], gvp.zcol_count_fft(), spl_z.local_size(),
+                           SPFFT_PU_HOST, -1, Communicator::world().mpi_comm(), SPFFT_EXCH_DEFAULT);
+
+    auto gv = gvp.get_gvec();
+    spfft::Transform spfft(spfft_grid.create_transform(SPFFT_PU_HOST, SPFFT_TRANS_R2C, fft_grid[0], fft_grid[1],
+        fft_grid[2], spl_z.local_size(), gvp.gvec_count_fft(), SPFFT_INDEX_TRIPLETS, gv.at(memory_t::host)));
+
+    Gamma_pair_transform spfft_pair(gvp, fft_grid, spl_z.local_size());
+
+    int ngv = gvp.gvec_count_fft();
+    int nr  = spfft.local_slice_size();
+
+    /* plane-wave coefficients of two real functions */
+    mdarray<double_complex, 2> f(ngv, 2);
+    for (int i = 0; i < 2; i++) {
+        for (int ig = 0; ig < ngv; ig++) {
+            f(ig, i) = utils::random<double_complex>();
+            if (gv(0, ig) == 0 && gv(1, ig) == 0 && gv(2, ig) == 0) {
+                f(ig, i) = f(ig, i).real();
+            }
+        }
+    }
+    /* real-space potential */
+    mdarray<double, 1> v(nr);
+    for (int ir = 0; ir < nr; ir++) {
+        v(ir) = utils::random<double>();
+    }
+
+    /* reference result: separate R2C transformations */
+    mdarray<double, 2> f_rg(nr, 2);
+    mdarray<double_complex, 2> vf(ngv, 2);
+    for (int i = 0; i < 2; i++) {
+        spfft.backward(reinterpret_cast<double const*>(f.at(memory_t::host, 0, i)), SPFFT_PU_HOST);
+        spfft_output(spfft, f_rg.at(memory_t::host, 0, i));
+        spfft_multiply(spfft, [&](int ir) { return v(ir); });
+        spfft.forward(SPFFT_PU_HOST, reinterpret_cast<double*>(vf.at(memory_t::host, 0, i)), SPFFT_FULL_SCALING);
+    }
+
+    double diff_rg{0};
+    double diff_pw{0};
+
+    /* pair of functions and a single function (odd number of bands) */
+    for (int n : {2, 1}) {
+        spfft_pair.backward(f.at(memory_t::host, 0, 0), (n == 2) ? f.at(memory_t::host, 0, 1) : nullptr);
+        auto z = spfft_pair.space_domain_data();
+        for (int ir = 0; ir < nr; ir++) {
+            diff_rg += std::abs(z[ir].real() - f_rg(ir, 0));
+            diff_rg += std::abs(z[ir].imag() - ((n == 2) ? f_rg(ir, 1) : 0));
+            z[ir] *= v(ir);
+        }
+        mdarray<double_complex, 2> vf1(ngv, 2);
+        vf1.zero();
+        spfft_pair.forward(vf1.at(memory_t::host, 0, 0), (n == 2) ? vf1.at(memory_t::host, 0, 1) : nullptr);
+        for (int i = 0; i < n; i++) {
+            for (int ig = 0; ig < ngv; ig++) {
+                diff_pw += std::abs(vf1(ig, i) - vf(ig, i));
+            }
+        }
+    }
+    Communicator::world().allreduce(&diff_rg, 1);
+    Communicator::world().allreduce(&diff_pw, 1);
+
+    if (diff_rg > 1e-10 || diff_pw > 1e-10) {
+        printf("diff_rg: %18.12e, diff_pw: %18.12e\n", diff_rg, diff_pw);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argn, char **argv)
+{
+    cmd_args args;
+    args.register_key("--cutoff=", "{double} cutoff radius in G-space");
+
+    args.parse_args(argn, argv);
+    if (args.exist("help")) {
+        printf("Usage: %s [options]\n", argv[0]);
+        args.print_help();
+        return 0;
+    }
+
+    sirius::initialize(true);
+    printf("running %-30s : ", argv[0]);
+    int result = run_test(args);
+    if (result) {
+        printf("\x1b[31m" "Failed" "\x1b[0m" "\n");
+    } else {
+        printf("\x1b[32m" "OK" "\x1b[0m" "\n");
+    }
+    sirius::finalize();
+
+    return result;
+}
@@ -0,0 +1,77 @@
+#include <sirius.hpp>
+#include "testing.hpp"
+
+/* test compressed storage of the Gaunt coefficients against the direct evaluation */
+
+using namespace sirius;
+
+template <typename T>
+int test_gaunt(std::function<T(int, int, int, int, int, int)> get__)
+{
+    int lmax1{4};
+    int lmax3{8};
+    int lmax2{3};
+
+    Gaunt_coefficients<T> gc(lmax1, lmax3, lmax2, get__);
+
+    auto full = gc.get_full_set_L3();
+
+    std::vector<double> v(utils::lmmax(lmax3));
+    for (auto& e : v) {
+        e = utils::random<double>();
+    }
+
+    double d{0};
+    for (int l1 = 0, lm1 = 0; l1 <= lmax1; l1++) {
+        for (int m1 = -l1; m1 <= l1; m1++, lm1++) {
+            for (int l2 = 0, lm2 = 0; l2 <= lmax2; l2++) {
+                for (int m2 = -l2; m2 <= l2; m2++, lm2++) {
+                    T sum{0};
+                    for (int l3 = 0, lm3 = 0; l3 <= lmax3; l3++) {
+                        for (int m3 = -l3; m3 <= l3; m3++, lm3++) {
+                            auto g = get__(l1, l3, l2, m1, m3, m2);
+                            d += std::abs(full(lm3, lm1, lm2) - g);
+                            sum += g * v[lm3];
+                        }
+                    }
+                    d += std::abs(gc.sum_L3_gaunt(lm1, lm2, v.data()) - sum);
+                    for (int k = 0; k < gc.num_gaunt(lm1, lm2); k++) {
+                        auto& g = gc.gaunt(lm1, lm2, k);
+                        d += std::abs(g.coef - gc.gaunt_vector(lm1, lm2).coef()[k]);
+                        d += std::abs(g.lm3 - gc.gaunt_vector(lm1, lm2).lm3()[k]);
+                    }
+                }
+            }
+        }
+    }
+    /* check the grouping by lm3 */
+    for (int lm3 = 0; lm3 < utils::lmmax(lmax3); lm3++) {
+        for (int k = 0; k < gc.num_gaunt(lm3); k++) {
+            auto& g = gc.gaunt(lm3, k);
+            d += std::abs(full(lm3, g.lm1, g.lm2) - g.coef);
+        }
+    }
+    if (d < 1e-12) {
+        return 0;
+    } else {
+        return 1;
+    }
+}
+
+int test1()
+{
+    return test_gaunt<double>(SHT::gaunt_rrr);
+}
+
+int test2()
+{
+    return test_gaunt<double_complex>(SHT::gaunt_hybrid);
+}
+
+int main(int argn, char** argv)
+{
+    int err{0};
+    err += call_test("<Rlm|Rlm|Rlm> storage", test1);
+    err += call_test("<Ylm|Rlm|Ylm> storage", test2);
+    return std::min(err, 1);
+}
@@ -0,0 +1,85 @@
+#include <sirius.hpp>
+
+/* test block-wise write and read of HDF5 datasets */
+
+using namespace sirius;
+
+int test1()
+{
+    int n1{7};
+    int n2{10};
+
+    std::string fname = "test_hdf5_slab.h5";
+
+    mdarray<double, 3> a(2, n1, n2);
+    for (size_t i = 0; i < a.size(); i++) {
+        a[i] = utils::random<double>();
+    }
+
+    {
+        HDF5_tree fout(fname, hdf5_access_t::truncate);
+        fout.create_node("wf");
+        fout["wf"].create_dataset<double>("0", {2, n1, n2});
+        /* write blocks of rows */
+        for (int i0 = 0; i0 < n1; i0 += 3) {
+            int n = std::min(3, n1 - i0);
+            mdarray<double, 3> b(2, n, n2);
+            for (int j = 0; j < n2; j++) {
+                for (int i = 0; i < n; i++) {
+                    for (int x : {0, 1}) {
+                        b(x, i, j) = a(x, i0 + i, j);
+                    }
+                }
+            }
+            fout["wf"].write_slab("0", b.at(memory_t::host), {0, i0, 0}, {2, n, n2});
+        }
+    }
+
+    HDF5_tree fin(fname, hdf5_access_t::read_only);
+
+    /* read the full array */
+    mdarray<double, 3> c(2, n1, n2);
+    fin["wf"].read("0", c);
+
+    /* read blocks of columns */
+    mdarray<double, 3> d(2, n1, n2);
+    for (int j0 = 0; j0 < n2; j0 += 4) {
+        int n = std::min(4, n2 - j0);
+        fin["wf"].read_slab("0", d.at(memory_t::host, 0, 0, j0), {0, 0, j0}, {2, n1, n});
+    }
+
+    for (int j = 0; j < n2; j++) {
+        for (int i = 0; i < n1; i++) {
+            for (int x : {0, 1}) {
+                if (a(x, i, j) != c(x, i, j) || a(x, i, j) != d(x, i, j)) {
+                    return 1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+int main(int argn, char** argv)
+{
+    cmd_args args;
+
+    args.parse_args(argn, argv);
+    if (args.exist("help")) {
+        printf("Usage: %s [options]\n", argv[0]);
+        args.print_help();
+        return 0;
+    }
+
+    sirius::initialize(1);
+    printf("%-30s", "testing HDF5 slabs: ");
+    int result = test1();
+    if (result) {
+        printf("\x1b[31m" "Failed" "\x1b[0m" "\n");
+    } else {
+        printf("\x1b[32m" "OK" "\x1b[0m" "\n");
+    }
+    sirius::finalize();
+
+    return result;
+}
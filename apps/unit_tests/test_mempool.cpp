@@ -7,30 +7,30 @@
 using double_complex = std::complex<double>;
 using namespace sddk;
 
-void test1()
+void test1(memory_pool_t t)
 {
-    memory_pool mp(memory_t::host);
+    memory_pool mp(memory_t::host, 0, t);
 }
 
-void test2()
+void test2(memory_pool_t t)
 {
-    memory_pool mp(memory_t::host);
+    memory_pool mp(memory_t::host, 0, t);
     auto ptr = mp.allocate<double_complex>(1024);
     mp.free(ptr);
 }
 
-void test2a()
+void test2a(memory_pool_t t)
 {
-    memory_pool mp(memory_t::host);
+    memory_pool mp(memory_t::host, 0, t);
     auto ptr = mp.allocate<double_complex>(1024);
     mp.free(ptr);
     ptr = mp.allocate<double_complex>(512);
     mp.free(ptr);
 }
 
-void test3()
+void test3(memory_pool_t t)
 {
-    memory_pool mp(memory_t::host);
+    memory_pool mp(memory_t::host, 0, t);
     auto p1 = mp.allocate<double_complex>(1024);
     auto p2 = mp.allocate<double_complex>(2024);
     auto p3 = mp.allocate<double_complex>(3024);
@@ -39,18 +39,18 @@ void test3()
     mp.free(p3);
 }
 
-void test3a()
+void test3a(memory_pool_t t)
 {
-    memory_pool mp(memory_t::host);
+    memory_pool mp(memory_t::host, 0, t);
     mp.allocate<double_complex>(1024);
     mp.allocate<double_complex>(2024);
     mp.allocate<double_complex>(3024);
     mp.reset();
 }
 
-void test4()
+void test4(memory_pool_t t)
 {
-    memory_pool mp(memory_t::host);
+    memory_pool mp(memory_t::host, 0, t);
     mp.allocate<double_complex>(1024);
     mp.reset();
     mp.allocate<double_complex>(1024);
@@ -62,9 +62,9 @@ void test4()
     mp.reset();
 }
 
-void test5()
+void test5(memory_pool_t t)
 {
-    memory_pool mp(memory_t::host);
+    memory_pool mp(memory_t::host, 0, t);
 
     for (int k = 0; k < 2; k++) {
         std::vector<double*> vp;
@@ -127,7 +127,7 @@ double test_alloc(size_t n, memory_pool& mp)
     return (t3 - t0) - 2 * (t2 - t1);
 }
 
-void test6()
+void test6(memory_pool_t t)
 {
     double t0{0};
     for (int k = 0; k < 8; k++) {
@@ -136,7 +136,7 @@ void test6()
             t0 += test_alloc(sz);
         }
     }
-    memory_pool mp(memory_t::host);
+    memory_pool mp(memory_t::host, 0, t);
     double t1{0};
     for (int k = 0; k < 8; k++) {
         for (int i = 10; i < 30; i++) {
@@ -147,7 +147,7 @@ void test6()
     std::cout << "std::malloc time: " << t0 << ", sddk::memory_pool time: " << t1 << "\n";
 }
 
-void test6a()
+void test6a(memory_pool_t t)
 {
     double t0{0};
     for (int k = 0; k < 500; k++) {
@@ -156,7 +156,7 @@ void test6a()
             t0 += test_alloc(sz);
         }
     }
-    memory_pool mp(memory_t::host);
+    memory_pool mp(memory_t::host, 0, t);
     double t1{0};
     for (int k = 0; k < 500; k++) {
         for (int i = 2; i < 1024; i++) {
@@ -168,9 +168,9 @@ void test6a()
     mp.print();
 }
 
-void test7()
+void test7(memory_pool_t t)
 {
-    memory_pool mp(memory_t::host);
+    memory_pool mp(memory_t::host, 0, t);
 
     int N = 10000;
     std::vector<double*> v(N);
@@ -254,7 +254,7 @@ double test_alloc_array(size_t n, memory_pool& mp)
     return (t3 - t0) - 2 * (t2 - t1);
 }
 
-void test9()
+void test9(memory_pool_t t)
 {
     double t0{0};
     for (int k = 0; k < 500; k++) {
@@ -263,7 +263,7 @@ void test9()
             t0 += test_alloc_array(sz);
         }
     }
-    memory_pool mp(memory_t::host);
+    memory_pool mp(memory_t::host, 0, t);
     double t1{0};
     for (int k = 0; k < 500; k++) {
         for (int i = 2; i < 1024; i++) {
@@ -274,20 +274,75 @@ void test9()
     std::cout << "std::malloc time: " << t0 << ", sddk::memory_pool time: " << t1 << "\n";
 }
 
+/* allocate and free from many threads; only the size-class pool is thread-safe */
+void test10(memory_pool_t t)
+{
+    memory_pool mp(memory_t::host, 0, t);
+
+    int N = 1000;
+    #pragma omp parallel
+    {
+        std::vector<double*> v(N);
+        for (int k = 0; k < 10; k++) {
+            for (int i = 0; i < N; i++) {
+                auto n = (i * 37 + k) % 1024 + 1;
+                v[i] = mp.allocate<double>(n);
+                v[i][0] = v[i][n - 1] = 0;
+            }
+            for (int i = 0; i < N; i++) {
+                mp.free(v[i]);
+            }
+        }
+    }
+    if (mp.free_size() != mp.total_size()) {
+        throw std::runtime_error("wrong free size");
+    }
+    if (mp.num_stored_ptr() != 0) {
+        throw std::runtime_error("wrong number of stored pointers");
+    }
+}
+
+/* compare the allocation strategies on the pattern of random sizes and print the statistics */
+void test11()
+{
+    int N = 10000;
+    std::vector<double*> v(N);
+    for (auto t : {memory_pool_t::block_list, memory_pool_t::size_class}) {
+        memory_pool mp(memory_t::host, 0, t);
+        double t0 = wtime();
+        for (int k = 0; k < 30; k++) {
+            for (int i = 0; i < N; i++) {
+                auto n = (utils::rand() & 0b1111111111) + 1;
+                v[i] = mp.allocate<double>(n);
+            }
+            std::random_shuffle(v.begin(), v.end());
+            for (int i = 0; i < N; i++) {
+                mp.free(v[i]);
+            }
+        }
+        std::cout << "memory pool type: " << static_cast<int>(t) << ", time: " << wtime() - t0 << "\n";
+        mp.print();
+    }
+}
+
 int run_test()
 {
-    test1();
-    test2();
-    test2a();
-    test3();
-    test3a();
-    test4();
-    test5();
-    //test6();
-    //test6a();
-    test7();
-    //test8();
-    //test9();
+    for (auto t : {memory_pool_t::block_list, memory_pool_t::size_class}) {
+        test1(t);
+        test2(t);
+        test2a(t);
+        test3(t);
+        test3a(t);
+        test4(t);
+        test5(t);
+        //test6(t);
+        //test6a(t);
+        test7(t);
+        //test8();
+        //test9(t);
+    }
+    test10(memory_pool_t::size_class);
+    //test11();
     return 0;
 }
 
@@ -0,0 +1,154 @@
+#include <sirius.hpp>
+#include "testing.hpp"
+#include "mixer/mixer_functions.hpp"
+#include "mixer/linear_mixer.hpp"
+#include "mixer/broyden1_mixer.hpp"
+
+/* test the mixing of plane-wave coefficients of the density with and without Kerker preconditioning */
+
+using namespace sirius;
+
+using pw_t = mdarray<double_complex, 2>;
+
+std::unique_ptr<Simulation_context> create_ctx()
+{
+    auto ctx = std::unique_ptr<Simulation_context>(new Simulation_context(
+        "{"
+        "   \"parameters\" : {"
+        "        \"electronic_structure_method\" : \"pseudopotential\","
+        "        \"pw_cutoff\" : 8,"
+        "        \"gk_cutoff\" : 3,"
+        "        \"num_mag_dims\" : 1,"
+        "        \"use_symmetry\" : false"
+        "    },"
+        "   \"control\" : {"
+        "       \"verification\" : 0"
+        "    }"
+        "}"));
+
+    /* simple atom type with a local potential only */
+    auto& atype = ctx->unit_cell().add_atom_type("A");
+    atype.zn(1);
+    atype.set_radial_grid(radial_grid_t::lin_exp, 1000, 0.0, 100.0, 6);
+    std::vector<double> beta(atype.radial_grid().index_of(1.0) + 1, 0);
+    atype.add_beta_radial_function(0, beta);
+    matrix<double> dion(1, 1);
+    dion.zero();
+    atype.d_mtrx_ion(dion);
+    std::vector<double> v(atype.radial_grid().num_points(), 0);
+    atype.local_potential(v);
+    atype.ps_total_charge_density(v);
+
+    ctx->unit_cell().set_lattice_vectors({{6.0, 0.0, 0.0}, {0.0, 6.0, 0.0}, {0.0, 0.0, 6.0}});
+    ctx->unit_cell().add_atom("A", {0.0, 0.0, 0.0});
+    ctx->initialize();
+
+    return ctx;
+}
+
+/* Kerker preconditioner scales the charge residual by G^2 / (G^2 + q0^2) and leaves magnetization untouched */
+int test1()
+{
+    auto ctx = create_ctx();
+    double q0{1.5};
+    int ngc = ctx->gvec_coarse().count();
+
+    auto prop = mixer::pw_density_function_property(*ctx, false, q0);
+    if (!prop.precondition) {
+        return 1;
+    }
+
+    pw_t x(ngc, 2);
+    pw_t y(ngc, 2);
+    for (std::size_t i = 0; i < x.size(); i++) {
+        x[i] = y[i] = utils::random<double_complex>();
+    }
+    prop.precondition(x);
+
+    double diff{0};
+    for (int igloc = 0; igloc < ngc; igloc++) {
+        int ig  = ctx->gvec().offset() + ctx->gvec().gvec_base_mapping(igloc);
+        auto g2 = std::pow(ctx->gvec().gvec_len(ig), 2);
+        diff += std::abs(x(igloc, 0) - y(igloc, 0) * g2 / (g2 + q0 * q0));
+        diff += std::abs(x(igloc, 1) - y(igloc, 1));
+    }
+    if (diff > 1e-12) {
+        printf("diff: %18.12e\n", diff);
+        return 1;
+    }
+    return 0;
+}
+
+/* solve x = F(x) with F(x)_G = a_G x_G + b_G; the initial value of the mixer is the starting guess */
+int solve(mixer::Mixer<pw_t>& mixer__, Simulation_context& ctx__, double kerker_q0__)
+{
+    int ngc = ctx__.gvec_coarse().count();
+
+    pw_t a(ngc, 2);
+    pw_t b(ngc, 2);
+    pw_t x(ngc, 2);
+    for (int j = 0; j < 2; j++) {
+        for (int igloc = 0; igloc < ngc; igloc++) {
+            int ig  = ctx__.gvec().offset() + ctx__.gvec().gvec_base_mapping(igloc);
+            auto g2 = std::pow(ctx__.gvec().gvec_len(ig), 2);
+            /* long-wavelength components respond strongly, as in the charge sloshing */
+            a(igloc, j) = -0.8 / (1 + g2);
+            b(igloc, j) = utils::random<double_complex>();
+            x(igloc, j) = utils::random<double_complex>();
+            /* Kerker preconditioner does not change the G=0 component of the charge; it is fixed by the
+               normalization in the real calculation, so start from the exact value */
+            if (ig == 0 && j == 0) {
+                x(igloc, j) = b(igloc, j) / (1.0 - a(igloc, j));
+            }
+        }
+    }
+
+    mixer__.initialize_function<0>(mixer::pw_density_function_property(ctx__, false, kerker_q0__), x, ngc, 2);
+
+    pw_t y(ngc, 2);
+    for (int iter = 1; iter <= 300; iter++) {
+        for (std::size_t i = 0; i < x.size(); i++) {
+            y[i] = a[i] * x[i] + b[i];
+        }
+        mixer__.set_input<0>(y);
+        double rms = mixer__.mix(1e-12);
+        mixer__.get_output<0>(x);
+        if (rms < 1e-12) {
+            double diff{0};
+            for (std::size_t i = 0; i < x.size(); i++) {
+                diff = std::max(diff, std::abs(x[i] - b[i] / (1.0 - a[i])));
+            }
+            ctx__.comm().allreduce<double, mpi_op_t::max>(&diff, 1);
+            if (diff > 1e-8) {
+                printf("converged in %i iterations to the wrong solution, max. difference: %18.12e\n", iter, diff);
+                return 1;
+            }
+            return 0;
+        }
+    }
+    printf("not converged\n");
+    return 1;
+}
+
+int test2()
+{
+    auto ctx = create_ctx();
+    int err{0};
+    for (double q0 : {0.0, 1.5}) {
+        mixer::Linear<pw_t> linear(0.5);
+        err += solve(linear, *ctx, q0);
+        mixer::Broyden1<pw_t> broyden(8, 0.5, 0.1, 1.0, ctx->comm());
+        err += solve(broyden, *ctx, q0);
+    }
+    return err;
+}
+
+int main(int argn, char** argv)
+{
+    sirius::initialize(true);
+    int err{0};
+    err += call_test("Kerker preconditioning of plane-wave density", test1);
+    err += call_test("Mixing of plane-wave density", test2);
+    sirius::finalize();
+    return std::min(err, 1);
+}
@@ -0,0 +1,145 @@
+#include <sirius.hpp>
+#include "testing.hpp"
+
+/* test the cell-list search of the nearest neighbours and the reuse of the neighbour candidates against the
+   brute-force search */
+
+using namespace sirius;
+
+/* compare the list of the nearest neighbours with the brute-force search */
+int check_neighbours(Unit_cell const& uc__, double radius__)
+{
+    /* range of translations which covers the sphere; distance between the lattice planes is 1 / |b_x| */
+    vector3d<int> nt;
+    for (int x : {0, 1, 2}) {
+        auto& b = uc__.inverse_lattice_vectors();
+        double d = 1.0 / vector3d<double>(b(x, 0), b(x, 1), b(x, 2)).length();
+        nt[x]    = static_cast<int>(std::ceil(radius__ / d)) + 3;
+    }
+
+    auto cmp = [](nearest_neighbour_descriptor const& a, nearest_neighbour_descriptor const& b) {
+        return std::tie(a.atom_id, a.translation) < std::tie(b.atom_id, b.translation);
+    };
+
+    int err{0};
+    for (int ia = 0; ia < uc__.num_atoms(); ia++) {
+        auto r0 = uc__.get_cartesian_coordinates(uc__.atom(ia).position());
+
+        std::vector<nearest_neighbour_descriptor> nn_ref;
+        for (int ja = 0; ja < uc__.num_atoms(); ja++) {
+            for (int t0 = -nt[0]; t0 <= nt[0]; t0++) {
+                for (int t1 = -nt[1]; t1 <= nt[1]; t1++) {
+                    for (int t2 = -nt[2]; t2 <= nt[2]; t2++) {
+                        nearest_neighbour_descriptor nnd;
+                        nnd.atom_id     = ja;
+                        nnd.translation = {t0, t1, t2};
+                        auto r = uc__.atom(ja).position() + vector3d<double>(t0, t1, t2);
+                        nnd.distance = (uc__.get_cartesian_coordinates(r) - r0).length();
+                        if (nnd.distance <= radius__) {
+                            nn_ref.push_back(nnd);
+                        }
+                    }
+                }
+            }
+        }
+
+        std::vector<nearest_neighbour_descriptor> nn;
+        for (int i = 0; i < uc__.num_nearest_neighbours(ia); i++) {
+            nn.push_back(uc__.nearest_neighbour(i, ia));
+        }
+        /* the list must be sorted by distance and start with the atom itself */
+        for (int i = 1; i < static_cast<int>(nn.size()); i++) {
+            if (nn[i].distance < nn[i - 1].distance) {
+                printf("neighbours of atom %i are not sorted by distance\n", ia);
+                err++;
+            }
+        }
+        if (nn.empty() || nn[0].atom_id != ia || nn[0].distance != 0) {
+            printf("first neighbour of atom %i is not the atom itself\n", ia);
+            err++;
+        }
+
+        std::sort(nn.begin(), nn.end(), cmp);
+        std::sort(nn_ref.begin(), nn_ref.end(), cmp);
+        if (nn.size() != nn_ref.size()) {
+            printf("atom %i: number of neighbours %i, expected %i\n", ia, static_cast<int>(nn.size()),
+                   static_cast<int>(nn_ref.size()));
+            err++;
+            continue;
+        }
+        for (size_t i = 0; i < nn.size(); i++) {
+            if (nn[i].atom_id != nn_ref[i].atom_id || nn[i].translation != nn_ref[i].translation ||
+                std::abs(nn[i].distance - nn_ref[i].distance) > 1e-10) {
+                printf("atom %i: wrong neighbour %i\n", ia, static_cast<int>(i));
+                err++;
+                break;
+            }
+        }
+    }
+    return err;
+}
+
+/* shift the atom by a Cartesian vector */
+void move_atom(Unit_cell& uc__, int ia__, vector3d<double> v__)
+{
+    uc__.atom(ia__).set_position(uc__.atom(ia__).position() + uc__.get_fractional_coordinates(v__));
+}
+
+int test_neighbours(double radius__, double skin__)
+{
+    Simulation_context ctx(
+        "{"
+        "   \"parameters\" : {"
+        "        \"electronic_structure_method\" : \"pseudopotential\","
+        "        \"nn_skin\" : " + std::to_string(skin__) +
+        "    }"
+        "}");
+
+    auto& uc = ctx.unit_cell();
+    uc.add_atom_type("A");
+    /* strongly skewed cell */
+    uc.set_lattice_vectors({{4.0, 0, 0}, {2.9, 3.1, 0}, {-1.7, 1.3, 5.2}});
+    /* some of the positions are outside of the [0, 1) range */
+    std::vector<vector3d<double>> pos = {{0.0, 0.0, 0.0},   {0.51, 0.23, 0.77}, {0.93, 0.98, 0.02},
+                                         {-0.21, 0.4, 0.6}, {0.3, 1.35, -0.45}, {0.66, 0.12, 0.41}};
+    for (auto& p : pos) {
+        uc.add_atom("A", p, {0, 0, 0});
+    }
+
+    uc.find_nearest_neighbours(radius__);
+    int err = check_neighbours(uc, radius__);
+
+    if (skin__ > 0) {
+        /* random directions of the displacements */
+        std::vector<vector3d<double>> dir(uc.num_atoms());
+        for (auto& d : dir) {
+            d = vector3d<double>(utils::random<double>() - 0.5, utils::random<double>() - 0.5,
+                                 utils::random<double>() - 0.5);
+            d = d * (1.0 / d.length());
+        }
+        /* displacements are smaller than half of the skin: the list of candidates is reused */
+        for (int ia = 0; ia < uc.num_atoms(); ia++) {
+            move_atom(uc, ia, dir[ia] * (0.4 * skin__));
+        }
+        uc.find_nearest_neighbours(radius__);
+        err += check_neighbours(uc, radius__);
+
+        /* one atom is moved further, by more than half of the skin in total: the list of candidates is rebuilt */
+        move_atom(uc, 1, dir[1] * (0.8 * skin__));
+        uc.find_nearest_neighbours(radius__);
+        err += check_neighbours(uc, radius__);
+    }
+    return err;
+}
+
+int main(int argn, char** argv)
+{
+    sirius::initialize(true);
+    int err{0};
+    err += call_test("neighbours within a small radius", []() { return test_neighbours(2.5, 0); });
+    /* radius is larger than the unit cell: the search must include several periodic images */
+    err += call_test("neighbours within a large radius", []() { return test_neighbours(13.0, 0); });
+    err += call_test("neighbours within a large radius with skin", []() { return test_neighbours(13.0, 1.0); });
+    sirius::finalize();
+    return std::min(err, 1);
+}
@@ -0,0 +1,88 @@
+#include <sirius.hpp>
+#include "testing.hpp"
+
+/* test the real-space generation of the augmentation charge against the plane-wave one */
+
+using namespace sirius;
+
+int test_rho_aug_rg(int num_mag_dims__)
+{
+    /* ultrasoft model atom with s and p projectors in a skewed cell with two atoms; the spheres of the augmentation
+       charge wrap around the cell; Gaussian augmentation functions are converged at the density cutoff, so their
+       filtered radial functions are not truncated by the real-space sphere */
+    auto ctx_ptr = create_model_context(
+        "{"
+        "   \"parameters\" : {"
+        "        \"num_mag_dims\" : " + std::to_string(num_mag_dims__) +
+        "    },"
+        "   \"control\" : {"
+        "       \"rho_aug_real_space_radius_scale\" : 1.0"
+        "    },"
+        "   \"unit_cell\" : {"
+        "       \"lattice_vectors\" : [[4, 0, 0], [1.2, 4, 0], [0, 0.8, 4]],"
+        "       \"atoms\" : {\"Cu\" : [[0, 0, 0], [0.4, 0.55, 0.3]]}"
+        "    }"
+        "}", [](Atom_type& atype) {
+            add_gaussian_beta(atype, 1);
+            std::vector<double> q(atype.radial_grid().num_points());
+            for (int l1 = 0; l1 <= 1; l1++) {
+                for (int l2 = l1; l2 <= 1; l2++) {
+                    for (int l = std::abs(l1 - l2); l <= l1 + l2; l += 2) {
+                        for (int i = 0; i < atype.radial_grid().num_points(); i++) {
+                            double x = atype.radial_grid(i);
+                            q[i]     = (1 + l1 + l2) * std::pow(x, l + 2) * std::exp(-2 * x * x);
+                        }
+                        atype.add_q_radial_function(l1, l2, l, q);
+                    }
+                }
+            }
+        });
+    auto& ctx = *ctx_ptr;
+
+    Density rho(ctx);
+
+    /* random Hermitian density matrix */
+    auto& dm = rho.density_matrix();
+    dm.zero();
+    for (int ia = 0; ia < ctx.unit_cell().num_atoms(); ia++) {
+        int n = ctx.unit_cell().atom(ia).mt_basis_size();
+        for (int ispn = 0; ispn < ctx.num_spins(); ispn++) {
+            for (int xi2 = 0; xi2 < n; xi2++) {
+                for (int xi1 = 0; xi1 <= xi2; xi1++) {
+                    double re = utils::random<double>() - 0.5;
+                    double im = (xi1 == xi2) ? 0 : utils::random<double>() - 0.5;
+                    double_complex z(re, im);
+                    dm(xi1, xi2, ispn, ia) = z;
+                    dm(xi2, xi1, ispn, ia) = std::conj(z);
+                }
+            }
+        }
+    }
+
+    auto rho_aug_ref = rho.generate_rho_aug();
+    auto rho_aug     = rho.generate_rho_aug_rg();
+
+    double diff{0};
+    double norm{0};
+    for (int iv = 0; iv < ctx.num_mag_dims() + 1; iv++) {
+        for (int igloc = 0; igloc < ctx.gvec().count(); igloc++) {
+            diff = std::max(diff, std::abs(rho_aug(igloc, iv) - rho_aug_ref(igloc, iv)));
+            norm = std::max(norm, std::abs(rho_aug_ref(igloc, iv)));
+        }
+    }
+    ctx.comm().allreduce<double, mpi_op_t::max>(&diff, 1);
+    ctx.comm().allreduce<double, mpi_op_t::max>(&norm, 1);
+    printf("maximum relative difference: %18.12e\n", diff / norm);
+
+    return (diff > 1e-6 * norm) ? 1 : 0;
+}
+
+int main(int argn, char** argv)
+{
+    sirius::initialize(true);
+    int err{0};
+    err += call_test("real-space augmentation charge", []() { return test_rho_aug_rg(0); });
+    err += call_test("real-space augmentation charge and magnetization", []() { return test_rho_aug_rg(1); });
+    sirius::finalize();
+    return std::min(err, 1);
+}
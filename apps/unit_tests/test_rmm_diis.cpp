@@ -0,0 +1,168 @@
+#include <sirius.hpp>
+#include "testing.hpp"
+
+/* test RMM-DIIS solver against the exact diagonalization of the pseudopotential Hamiltonian */
+
+using namespace sirius;
+
+std::unique_ptr<Simulation_context> create_context(std::string solver__)
+{
+    /* Davidson warm start is limited to a few steps, so RMM-DIIS has to do the rest of the work; small blocks
+       check that the bands are refined block by block */
+    return create_model_context(
+        "{"
+        "   \"parameters\" : {"
+        "        \"num_bands\" : 12"
+        "    },"
+        "   \"iterative_solver\" : {"
+        "       \"type\" : \"" + solver__ + "\","
+        "       \"num_steps\" : 4,"
+        "       \"energy_tolerance\" : 1e-2,"
+        "       \"residual_tolerance\" : 1e-6,"
+        "       \"converge_by_energy\" : 0,"
+        "       \"rmm_diis_num_steps\" : 4,"
+        "       \"rmm_diis_block_size\" : 5,"
+        "       \"rmm_diis_switch_tolerance\" : 1e-4"
+        "    }"
+        "}", [](Atom_type& atype) { add_gaussian_beta(atype, 2); });
+}
+
+/* maximum norm of the residuals of the lowest n bands */
+double max_residual(Simulation_context& ctx__, Hamiltonian_k& Hk__, int n__)
+{
+    auto& kp  = Hk__.kp();
+    auto& psi = kp.spinor_wave_functions();
+
+    Wave_functions hpsi(kp.gkvec_partition(), ctx__.num_bands(), memory_t::host);
+    Wave_functions spsi(kp.gkvec_partition(), ctx__.num_bands(), memory_t::host);
+    Hk__.apply_h_s<double_complex>(spin_range(0), 0, ctx__.num_bands(), psi, &hpsi, &spsi);
+
+    std::vector<double> rn(n__, 0);
+    for (int j = 0; j < n__; j++) {
+        for (int ig = 0; ig < kp.num_gkvec_loc(); ig++) {
+            auto z = hpsi.pw_coeffs(0).prime(ig, j) - spsi.pw_coeffs(0).prime(ig, j) * kp.band_energy(j, 0);
+            rn[j] += std::norm(z);
+        }
+    }
+    kp.comm().allreduce(rn);
+
+    double r{0};
+    for (int j = 0; j < n__; j++) {
+        r = std::max(r, std::sqrt(rn[j]));
+    }
+    return r;
+}
+
+int test_rmm_diis()
+{
+    std::vector<double> eval_ref;
+    {
+        auto ctx = create_context("exact");
+        Density rho(*ctx);
+        rho.initial_density();
+        Potential pot(*ctx);
+        pot.generate(rho);
+
+        double vk[] = {0.1, 0.2, 0.3};
+        K_point kp(*ctx, vk, 1.0, 0);
+        kp.initialize();
+        Hamiltonian0 H0(pot);
+        auto Hk = H0(kp);
+        Band(*ctx).initialize_subspace<double_complex>(Hk, ctx->unit_cell().num_ps_atomic_wf());
+        Band(*ctx).solve_pseudo_potential<double_complex>(Hk);
+        for (int i = 0; i < ctx->num_bands(); i++) {
+            eval_ref.push_back(kp.band_energy(i, 0));
+        }
+    }
+
+    auto ctx = create_context("rmm-diis");
+    Density rho(*ctx);
+    rho.initial_density();
+    Potential pot(*ctx);
+    pot.generate(rho);
+
+    double vk[] = {0.1, 0.2, 0.3};
+    K_point kp(*ctx, vk, 1.0, 0);
+    kp.initialize();
+    Hamiltonian0 H0(pot);
+    auto Hk = H0(kp);
+    Band band(*ctx);
+    band.initialize_subspace<double_complex>(Hk, ctx->unit_cell().num_ps_atomic_wf());
+
+    int nb     = ctx->num_bands();
+    auto& itso = ctx->iterative_solver_input();
+
+    /* loose tolerance: Davidson warm start */
+    band.solve_pseudo_potential<double_complex>(Hk);
+    ctx->iterative_solver_tolerance(1e-8);
+
+    /* RMM-DIIS is called until all bands are converged on entry and no refinement step is taken */
+    int niter{-1};
+    int ncall{0};
+    for (; ncall < 100 && niter; ncall++) {
+        niter = band.solve_pseudo_potential<double_complex>(Hk);
+        if (ncall == 0 && niter == 0) {
+            printf("Davidson warm start is already converged, RMM-DIIS is not tested\n");
+            return 1;
+        }
+    }
+    if (niter) {
+        printf("RMM-DIIS is not converged after %i calls\n", ncall);
+        return 1;
+    }
+
+    int err{0};
+    /* each band is converged to the residual tolerance */
+    double r = max_residual(*ctx, Hk, nb);
+    printf("number of calls: %i, maximum residual: %18.12e\n", ncall, r);
+    if (r > itso.residual_tolerance_) {
+        printf("residuals are not converged\n");
+        err++;
+    }
+    double diff{0};
+    for (int i = 0; i < nb; i++) {
+        diff = std::max(diff, std::abs(kp.band_energy(i, 0) - eval_ref[i]));
+    }
+    printf("maximum eigen-value difference: %18.12e\n", diff);
+    if (diff > 1e-8) {
+        err++;
+    }
+
+    /* the upper half of the bands is perturbed; the lower half stays converged and must be locked, i.e. left
+       as it is by the refinement of the perturbed bands up to the final subspace rotation */
+    std::vector<double> eval(nb);
+    for (int i = 0; i < nb; i++) {
+        eval[i] = kp.band_energy(i, 0);
+    }
+    auto& psi = kp.spinor_wave_functions();
+    for (int j = nb / 2; j < nb; j++) {
+        for (int ig = 0; ig < kp.num_gkvec_loc(); ig++) {
+            psi.pw_coeffs(0).prime(ig, j) += 1e-3 * (utils::random<double_complex>() - double_complex(0.5, 0.5));
+        }
+    }
+    niter = band.solve_pseudo_potential<double_complex>(Hk);
+    if (niter == 0) {
+        printf("perturbed bands are not refined\n");
+        err++;
+    }
+    double diff_locked{0};
+    for (int i = 0; i < nb / 2; i++) {
+        diff_locked = std::max(diff_locked, std::abs(kp.band_energy(i, 0) - eval[i]));
+    }
+    r = max_residual(*ctx, Hk, nb / 2);
+    printf("locked bands: maximum eigen-value change: %18.12e, maximum residual: %18.12e\n", diff_locked, r);
+    if (diff_locked > 1e-10 || r > 2 * itso.residual_tolerance_) {
+        err++;
+    }
+
+    return err;
+}
+
+int main(int argn, char** argv)
+{
+    sirius::initialize(true);
+    int err{0};
+    err += call_test("RMM-DIIS solver", test_rmm_diis);
+    sirius::finalize();
+    return std::min(err, 1);
+}
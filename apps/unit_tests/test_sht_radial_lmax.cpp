@@ -0,0 +1,92 @@
+#include <sirius.hpp>
+#include "testing.hpp"
+
+/* test spherical harmonic transforms with the radially dependent number of harmonics against the transforms of
+   the truncated functions */
+
+using namespace sirius;
+
+int test1()
+{
+    int lmax{8};
+    SHT sht(sddk::device_t::CPU, lmax);
+    int lmmax = utils::lmmax(lmax);
+    int np    = sht.num_points();
+    int nr{40};
+    int n{3};
+
+    auto l_by_lm = utils::l_by_lm(lmax);
+
+    /* functions are spherical near the origin and gain higher harmonics outwards */
+    std::vector<std::vector<double>> f(n, std::vector<double>(lmmax * nr));
+    for (int i = 0; i < n; i++) {
+        for (int ir = 0; ir < nr; ir++) {
+            f[i][ir * lmmax] = 1 + utils::random<double>();
+            for (int lm = 1; lm < lmmax; lm++) {
+                f[i][ir * lmmax + lm] = (l_by_lm[lm] <= ir / 5) ? utils::random<double>() : 1e-12;
+            }
+        }
+    }
+
+    std::vector<int> lmmax_r(nr, 0);
+    std::vector<double const*> ptr;
+    for (int i = 0; i < n; i++) {
+        auto lmmax_r_i = SHT::radial_lmmax(lmmax, f[i].data(), nr, lmmax, 1e-8);
+        for (int ir = 0; ir < nr; ir++) {
+            lmmax_r[ir] = std::max(lmmax_r[ir], lmmax_r_i[ir]);
+        }
+        ptr.push_back(f[i].data());
+    }
+    int err{0};
+    for (int ir = 0; ir < nr; ir++) {
+        if (lmmax_r[ir] != utils::lmmax(std::min(lmax, ir / 5))) {
+            err++;
+        }
+    }
+    auto shells = SHT::radial_shells(lmmax_r);
+
+    /* reference: transform the truncated functions with the full expansion */
+    std::vector<std::vector<double>> g(n, std::vector<double>(lmmax * nr, 0));
+    for (int i = 0; i < n; i++) {
+        for (int ir = 0; ir < nr; ir++) {
+            std::copy(&f[i][ir * lmmax], &f[i][ir * lmmax] + lmmax_r[ir], &g[i][ir * lmmax]);
+        }
+    }
+
+    double d{0};
+    std::vector<double> ftp(np * nr * n);
+    std::vector<double> gtp(np * nr);
+    sht.backward_transform(lmmax, ptr, shells, ftp.data());
+    for (int i = 0; i < n; i++) {
+        sht.backward_transform(lmmax, g[i].data(), nr, lmmax, gtp.data());
+        for (int k = 0; k < np * nr; k++) {
+            d += std::abs(ftp[i * np * nr + k] - gtp[k]);
+        }
+    }
+
+    /* forward transform returns the truncated functions */
+    std::vector<std::vector<double>> h(n, std::vector<double>(lmmax * nr, 1));
+    std::vector<double*> hptr;
+    for (int i = 0; i < n; i++) {
+        hptr.push_back(h[i].data());
+    }
+    sht.forward_transform(ftp.data(), shells, lmmax, lmmax, hptr);
+    for (int i = 0; i < n; i++) {
+        for (int k = 0; k < lmmax * nr; k++) {
+            d += std::abs(h[i][k] - g[i][k]);
+        }
+    }
+    if (d > 1e-10) {
+        printf("diff: %18.12e\n", d);
+        err++;
+    }
+    return err;
+}
+
+int main(int argn, char** argv)
+{
+    sirius::initialize(true);
+    int err = call_test("SHT with radially dependent lmax", test1);
+    sirius::finalize();
+    return err;
+}
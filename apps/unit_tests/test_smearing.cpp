@@ -0,0 +1,144 @@
+#include <sirius.hpp>
+#include "testing.hpp"
+
+/* test smearing functions and the search of the Fermi level */
+
+using namespace sirius;
+
+std::vector<smearing::smearing_t> const smearing_types = {smearing::smearing_t::gaussian,
+    smearing::smearing_t::fermi_dirac, smearing::smearing_t::methfessel_paxton, smearing::smearing_t::cold};
+
+std::vector<std::string> const smearing_labels = {"gaussian", "fermi_dirac", "methfessel_paxton", "cold"};
+
+/* occupancy must go from 1 to 0, be an antiderivative of the delta-function and the delta-function must
+   integrate to one */
+int test_smearing_functions()
+{
+    double width{0.02};
+    int err{0};
+    for (auto type : smearing_types) {
+        if (std::abs(smearing::occupancy(type, -1.0, width) - 1) > 1e-12 ||
+            std::abs(smearing::occupancy(type, 1.0, width)) > 1e-12) {
+            printf("wrong limits of the occupancy\n");
+            err++;
+        }
+        double h{1e-5};
+        double diff{0};
+        double sum{0};
+        int n{40000};
+        double de = 80.0 * width / n;
+        for (int i = 0; i <= n; i++) {
+            double e = -40 * width + i * de;
+            double d = smearing::delta(type, e, width);
+            double d1 = (smearing::occupancy(type, e - h, width) - smearing::occupancy(type, e + h, width)) / 2 / h;
+            diff = std::max(diff, std::abs(d - d1) * width);
+            sum += ((i == 0 || i == n) ? 0.5 : 1.0) * d * de;
+        }
+        if (diff > 1e-6 || std::abs(sum - 1) > 1e-10) {
+            printf("derivative error: %18.12e, norm of the delta-function: %18.12f\n", diff, sum);
+            err++;
+        }
+    }
+    return err;
+}
+
+/* band energies of the two k-points with weights 1/4 and 3/4; the energies are symmetric with respect to zero */
+double band_energy(int ik__, int j__, int nb__)
+{
+    return (ik__ + 1) * 0.01 * (j__ - (nb__ - 1) / 2.0);
+}
+
+int test_fermi_level(int itype__)
+{
+    int nb{11};
+    double width{0.02};
+
+    /* model atom has nb = 11 valence electrons, which half-fill the nb bands; no projectors are needed */
+    auto ctx_ptr = create_model_context(
+        "{"
+        "   \"parameters\" : {"
+        "        \"smearing\" : \"" + smearing_labels[itype__] + "\","
+        "        \"smearing_width\" : " + std::to_string(width) + ","
+        "        \"num_bands\" : " + std::to_string(nb) + ","
+        "        \"pw_cutoff\" : 10,"
+        "        \"gk_cutoff\" : 3"
+        "    }"
+        "}");
+    auto& ctx = *ctx_ptr;
+    if (ctx.smearing() != smearing_types[itype__]) {
+        printf("wrong smearing type\n");
+        return 1;
+    }
+
+    K_point_set kset(ctx);
+    double vk0[] = {0, 0, 0};
+    double vk1[] = {0.5, 0, 0};
+    kset.add_kpoint(vk0, 0.25);
+    kset.add_kpoint(vk1, 0.75);
+    kset.initialize();
+
+    for (int ik = 0; ik < kset.num_kpoints(); ik++) {
+        for (int j = 0; j < nb; j++) {
+            kset[ik]->band_energy(j, 0, band_energy(ik, j, nb));
+        }
+    }
+    kset.find_band_occupancies();
+    double ef = kset.energy_fermi();
+
+    /* number of electrons for a given Fermi level */
+    auto count_electrons = [&](double ef__) {
+        double ne{0};
+        for (int ik = 0; ik < kset.num_kpoints(); ik++) {
+            for (int j = 0; j < nb; j++) {
+                ne += kset[ik]->weight() * ctx.max_occupancy() *
+                      smearing::occupancy(ctx.smearing(), band_energy(ik, j, nb) - ef__, width);
+            }
+        }
+        return ne;
+    };
+
+    /* reference Fermi level; occupancies of the Gaussian, Fermi-Dirac and Methfessel-Paxton smearing satisfy
+       f(-e) = 1 - f(e), so the reference is zero */
+    double ef_ref{0};
+    if (ctx.smearing() == smearing::smearing_t::cold) {
+        /* asymmetric smearing: plain bisection */
+        double e0{-1};
+        double e1{1};
+        while (e1 - e0 > 1e-15) {
+            ef_ref = 0.5 * (e0 + e1);
+            if (count_electrons(ef_ref) < nb) {
+                e0 = ef_ref;
+            } else {
+                e1 = ef_ref;
+            }
+        }
+    }
+
+    /* number of electrons from the computed occupancies */
+    double ne_occ{0};
+    for (int ik = 0; ik < kset.num_kpoints(); ik++) {
+        for (int j = 0; j < nb; j++) {
+            ne_occ += kset[ik]->weight() * kset[ik]->band_occupancy(j, 0);
+        }
+    }
+
+    printf("smearing: %s, Fermi level: %18.12e, reference: %18.12e, number of electrons: %18.12f\n",
+           smearing_labels[itype__].c_str(), ef, ef_ref, ne_occ);
+
+    if (std::abs(ne_occ - nb) > 1e-9 || std::abs(ef - ef_ref) > 1e-9) {
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argn, char** argv)
+{
+    sirius::initialize(true);
+    int err{0};
+    err += call_test("smearing functions", test_smearing_functions);
+    for (int i = 0; i < static_cast<int>(smearing_types.size()); i++) {
+        err += call_test("Fermi level with " + smearing_labels[i] + " smearing", [i]() { return test_fermi_level(i); });
+    }
+    sirius::finalize();
+    return std::min(err, 1);
+}
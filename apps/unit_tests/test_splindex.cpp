@@ -103,11 +103,71 @@ int test3()
     return 0;
 }
 
+/* partition of k-points by cost should be optimal among the contiguous partitions */
+int test4()
+{
+    for (int num_ranks = 1; num_ranks < 6; num_ranks++) {
+        for (int N = 1; N < 14; N++) {
+            std::vector<double> cost(N);
+            for (int i = 0; i < N; i++) {
+                cost[i] = 1 + utils::random<double>();
+            }
+            auto counts = K_point_set::partition_by_cost(cost, num_ranks);
+
+            int sz{0};
+            double max_cost{0};
+            for (int r = 0; r < num_ranks; r++) {
+                if (N >= num_ranks && counts[r] == 0) {
+                    throw std::runtime_error("test4: rank without k-points");
+                }
+                double c{0};
+                for (int i = sz; i < sz + counts[r]; i++) {
+                    c += cost[i];
+                }
+                max_cost = std::max(max_cost, c);
+                sz += counts[r];
+            }
+            if (sz != N) {
+                throw std::runtime_error("test4: wrong sum of counts");
+            }
+
+            /* optimal maximum cost: opt(r, n) for the first n elements split into r chunks */
+            mdarray<double, 2> opt(num_ranks + 1, N + 1);
+            for (int n = 0; n <= N; n++) {
+                double c{0};
+                for (int i = 0; i < n; i++) {
+                    c += cost[i];
+                }
+                opt(1, n) = c;
+            }
+            for (int r = 2; r <= num_ranks; r++) {
+                for (int n = 0; n <= N; n++) {
+                    opt(r, n) = opt(r - 1, n);
+                    double c{0};
+                    for (int m = n - 1; m >= 0; m--) {
+                        c += cost[m];
+                        opt(r, n) = std::min(opt(r, n), std::max(opt(r - 1, m), c));
+                    }
+                }
+            }
+            if (max_cost > opt(num_ranks, N) * (1 + 1e-10)) {
+                std::stringstream s;
+                s << "test4: partition is not optimal" << std::endl
+                  << "number of ranks: " << num_ranks << ", number of elements: " << N << std::endl
+                  << "maximum cost: " << max_cost << ", optimal: " << opt(num_ranks, N);
+                throw std::runtime_error(s.str());
+            }
+        }
+    }
+    return 0;
+}
+
 int main(int argn, char** argv)
 {
     int err{0};
     err += call_test("test block index", test1);
     err += call_test("test block-cyclic index", test2);
     err += call_test("test chunk index", test3);
+    err += call_test("test partition by cost", test4);
     return std::min(err, 1);
 }
@@ -3,7 +3,9 @@
 tests='test_init test_nan test_ylm test_rlm test_rlm_deriv test_sinx_cosx test_gvec test_fft_correctness_1 
 test_fft_correctness_2 test_fft_real_1 test_fft_real_2 test_fft_real_3 test_spline 
 test_rot_ylm test_linalg test_wf_ortho test_serialize test_mempool test_roundoff 
-test_sht_lapl test_sht test_spheric_function test_splindex test_gaunt_coeff_1 test_gaunt_coeff_2'
+test_sht_lapl test_sht test_spheric_function test_splindex test_gaunt_coeff_1 test_gaunt_coeff_2
+test_fft_gamma_pair test_hdf5_slab test_ewald_pme test_fft_batch_rg test_gaunt_coeff_3 test_mixer_sp_history
+test_sht_radial_lmax test_mixer_pw test_chfsi test_smearing test_beta_real_space test_rho_aug_rg test_neighbours test_rmm_diis'
 
 for test in $tests; do
   echo "running '${test}'"
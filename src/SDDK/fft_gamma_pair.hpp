@@ -0,0 +1,192 @@
+// Copyright (c) 2013-2020 Anton Kozhevnikov, Thomas Schulthess
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+// the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+//    following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+//    and the following disclaimer in the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** \file fft_gamma_pair.hpp
+ *
+ *  \brief Contains declaration and implementation of sddk::Gamma_pair_transform class.
+ */
+
+#ifndef __FFT_GAMMA_PAIR_HPP__
+#define __FFT_GAMMA_PAIR_HPP__
+
+#include "gvec.hpp"
+#include "fft.hpp"
+
+namespace sddk {
+
+/// Transform two real functions with a single complex FFT.
+/** Two real functions \f$ f_1({\bf r}) \f$ and \f$ f_2({\bf r}) \f$, given by their plane-wave coefficients on the
+ *  reduced set of G-vectors, are combined into a complex function \f$ z({\bf r}) = f_1({\bf r}) + i f_2({\bf r}) \f$.
+ *  The plane-wave coefficients of \f$ z({\bf r}) \f$ on the full set of G-vectors are
+ *  \f[
+ *      z({\bf G}) = f_1({\bf G}) + i f_2({\bf G}) \quad
+ *      z(-{\bf G}) = f_1^{*}({\bf G}) + i f_2^{*}({\bf G})
+ *  \f]
+ *  and the coefficients of the two functions are recovered after the forward transformation as
+ *  \f[
+ *      f_1({\bf G}) = \frac{1}{2}\Big(z({\bf G}) + z^{*}(-{\bf G})\Big) \quad
+ *      f_2({\bf G}) = \frac{1}{2i}\Big(z({\bf G}) - z^{*}(-{\bf G})\Big)
+ *  \f]
+ *
+ *  The reduced set of G-vectors contains complete z-columns from one half of the {x,y} plane and the non-negative
+ *  half of the {0,0} column. Mirrored columns are therefore not stored anywhere and they are added to the same rank
+ *  as the original ones; this keeps the z-column distribution valid for the complex transform.
+ *
+ *  Only the host memory is supported.
+ */
+class Gamma_pair_transform
+{
+  private:
+    /// Local number of G-vectors of the reduced set.
+    int ngv_fft_{0};
+
+    /// Position of -G coefficient in the full list of G-vectors for each G-vector of the reduced set.
+    mdarray<int, 1> idx_minus_;
+
+    /// Plane-wave coefficients of the complex function on the full set of G-vectors.
+    mdarray<double_complex, 1> buf_pw_;
+
+    /// SpFFT grid of the complex transform.
+    std::unique_ptr<spfft::Grid> spfft_grid_;
+
+    /// SpFFT complex transform.
+    std::unique_ptr<spfft::Transform> spfft_;
+
+  public:
+    /// Constructor.
+    /** \param [in] gvecp          FFT-friendly partition of the reduced set of G-vectors.
+     *  \param [in] dims           Dimensions of the FFT box.
+     *  \param [in] local_z_length Local number of z-planes of the FFT box.
+     */
+    Gamma_pair_transform(Gvec_partition const& gvecp__, std::array<int, 3> dims__, int local_z_length__)
+    {
+        PROFILE("sddk::Gamma_pair_transform");
+
+        if (!gvecp__.gvec().reduced()) {
+            throw std::runtime_error("[sddk::Gamma_pair_transform] reduced set of G-vectors is expected");
+        }
+
+        ngv_fft_ = gvecp__.gvec_count_fft();
+
+        auto gv = gvecp__.get_gvec();
+
+        /* count the mirrored G-vectors; G=0 is mapped to itself */
+        int ngv_minus{0};
+        for (int ig = 0; ig < ngv_fft_; ig++) {
+            if (gv(0, ig) || gv(1, ig) || gv(2, ig)) {
+                ngv_minus++;
+            }
+        }
+
+        idx_minus_ = mdarray<int, 1>(ngv_fft_, memory_t::host, "Gamma_pair_transform::idx_minus_");
+
+        mdarray<int, 2> gv_full(3, ngv_fft_ + ngv_minus);
+        int n{ngv_fft_};
+        for (int ig = 0; ig < ngv_fft_; ig++) {
+            for (int x : {0, 1, 2}) {
+                gv_full(x, ig) = gv(x, ig);
+            }
+            if (gv(0, ig) || gv(1, ig) || gv(2, ig)) {
+                for (int x : {0, 1, 2}) {
+                    gv_full(x, n) = -gv(x, ig);
+                }
+                idx_minus_[ig] = n++;
+            } else {
+                idx_minus_[ig] = ig;
+            }
+        }
+
+        buf_pw_ = mdarray<double_complex, 1>(ngv_fft_ + ngv_minus, memory_t::host, "Gamma_pair_transform::buf_pw_");
+
+        /* each z-column of the reduced set is accompanied by its mirror image */
+        spfft_grid_ = std::unique_ptr<spfft::Grid>(
+            new spfft::Grid(dims__[0], dims__[1], dims__[2], 2 * gvecp__.zcol_count_fft(), local_z_length__,
+                            SPFFT_PU_HOST, -1, gvecp__.fft_comm().mpi_comm(), SPFFT_EXCH_DEFAULT));
+
+        spfft_ = std::unique_ptr<spfft::Transform>(new spfft::Transform(spfft_grid_->create_transform(
+            SPFFT_PU_HOST, SPFFT_TRANS_C2C, dims__[0], dims__[1], dims__[2], local_z_length__,
+            ngv_fft_ + ngv_minus, SPFFT_INDEX_TRIPLETS, gv_full.at(memory_t::host))));
+    }
+
+    /// Transform two functions to real space.
+    /** The result is stored in the FFT buffer: real part is the first function and imaginary part is the
+     *  second function. Second function can be omitted by passing a null pointer. */
+    void backward(double_complex const* f1__, double_complex const* f2__)
+    {
+        PROFILE("sddk::Gamma_pair_transform::backward");
+
+        if (f2__) {
+            #pragma omp parallel for schedule(static)
+            for (int ig = 0; ig < ngv_fft_; ig++) {
+                auto z1 = f1__[ig];
+                auto z2 = f2__[ig];
+                buf_pw_[idx_minus_[ig]] = double_complex(z1.real() + z2.imag(), z2.real() - z1.imag());
+                buf_pw_[ig]             = double_complex(z1.real() - z2.imag(), z1.imag() + z2.real());
+            }
+        } else {
+            #pragma omp parallel for schedule(static)
+            for (int ig = 0; ig < ngv_fft_; ig++) {
+                buf_pw_[idx_minus_[ig]] = std::conj(f1__[ig]);
+                buf_pw_[ig]             = f1__[ig];
+            }
+        }
+        spfft_->backward(reinterpret_cast<double const*>(buf_pw_.at(memory_t::host)), SPFFT_PU_HOST);
+    }
+
+    /// Transform the content of FFT buffer to the plane-wave coefficients of two functions.
+    /** The transformation is scaled. Second function can be omitted by passing a null pointer. */
+    void forward(double_complex* f1__, double_complex* f2__)
+    {
+        PROFILE("sddk::Gamma_pair_transform::forward");
+
+        spfft_->forward(SPFFT_PU_HOST, reinterpret_cast<double*>(buf_pw_.at(memory_t::host)), SPFFT_FULL_SCALING);
+
+        #pragma omp parallel for schedule(static)
+        for (int ig = 0; ig < ngv_fft_; ig++) {
+            auto z  = buf_pw_[ig];
+            auto zm = std::conj(buf_pw_[idx_minus_[ig]]);
+            f1__[ig] = 0.5 * (z + zm);
+            if (f2__) {
+                f2__[ig] = double_complex(0, -0.5) * (z - zm);
+            }
+        }
+    }
+
+    /// Complex FFT buffer in real space.
+    inline double_complex* space_domain_data()
+    {
+        return reinterpret_cast<double_complex*>(spfft_->space_domain_data(SPFFT_PU_HOST));
+    }
+
+    /// Local number of real-space points.
+    inline int local_slice_size() const
+    {
+        return spfft_->local_slice_size();
+    }
+
+    /// Underlying SpFFT transform.
+    inline spfft::Transform& spfft()
+    {
+        return *spfft_;
+    }
+};
+
+} // namespace sddk
+
+#endif // __FFT_GAMMA_PAIR_HPP__
@@ -730,8 +730,55 @@ Gvec_shells::Gvec_shells(Gvec const& gvec__)
             }
         }
     }
+
+    /* bounding box of the local G-vectors */
+    std::array<std::pair<int, int>, 3> box;
+    for (int x : {0, 1, 2}) {
+        box[x] = std::make_pair(0, 0);
+    }
+    for (int ig = 0; ig < gvec_count_remapped(); ig++) {
+        for (int x : {0, 1, 2}) {
+            box[x].first  = std::min(box[x].first, gvec_remapped_(x, ig));
+            box[x].second = std::max(box[x].second, gvec_remapped_(x, ig));
+        }
+    }
+    idx_gvec_ = mdarray<int, 3>(box[0], box[1], box[2], memory_t::host, "Gvec_shells::idx_gvec_");
+    std::fill(idx_gvec_.at(memory_t::host), idx_gvec_.at(memory_t::host) + idx_gvec_.size(), -1);
     for (int ig = 0; ig < gvec_count_remapped(); ig++) {
-        idx_gvec[gvec_remapped(ig)] = ig;
+        idx_gvec_(gvec_remapped_(0, ig), gvec_remapped_(1, ig), gvec_remapped_(2, ig)) = ig;
+    }
+}
+
+void Gvec_shells::init_rotations(std::vector<matrix3d<int>> const& R__)
+{
+    PROFILE("sddk::Gvec_shells::init_rotations");
+
+    int nrot = static_cast<int>(R__.size());
+
+    idx_rot_ = mdarray<int, 2>(nrot, gvec_count_remapped(), memory_t::host, "Gvec_shells::idx_rot_");
+
+    /* number of rotated G-vectors which are not found */
+    int num_missing{0};
+    #pragma omp parallel for schedule(static) reduction(+:num_missing)
+    for (int igloc = 0; igloc < gvec_count_remapped(); igloc++) {
+        auto G = gvec_remapped(igloc);
+        for (int i = 0; i < nrot; i++) {
+            auto G_rot = R__[i] * G;
+            int ig_rot = index_by_gvec(G_rot);
+            if (ig_rot == -1) {
+                ig_rot = index_by_gvec(G_rot * (-1));
+                if (ig_rot == -1) {
+                    num_missing++;
+                }
+                ig_rot = -(ig_rot + 1);
+            }
+            idx_rot_(i, igloc) = ig_rot;
+        }
+    }
+    if (num_missing) {
+        std::stringstream s;
+        s << "[sddk::Gvec_shells::init_rotations] " << num_missing << " rotated G-vectors are not found";
+        throw std::runtime_error(s.str());
     }
 }
 
@@ -749,8 +749,14 @@ class Gvec_shells
 
     Gvec const& gvec_;
 
-    /// A mapping between G-vector and it's local index in the new distribution.
-    std::map<vector3d<int>, int> idx_gvec;
+    /// Dense mapping between G-vector and it's local index in the new distribution.
+    /** The array spans the bounding box of the local G-vectors; -1 marks the G-vectors which are not stored locally. */
+    mdarray<int, 3> idx_gvec_;
+
+    /// Local index of the rotated G-vectors for each rotation and each local G-vector in the remapped set.
+    /** Index \f$ i \ge 0 \f$ is stored if \f$ {\bf R}{\bf G} \f$ is found in the local set and \f$ -(i + 1) \f$
+     *  is stored if only \f$ -{\bf R}{\bf G} \f$ is found. */
+    mdarray<int, 2> idx_rot_;
 
   public:
 
@@ -780,14 +786,34 @@ class Gvec_shells
         return vector3d<int>(gvec_remapped_(0, igloc__), gvec_remapped_(1, igloc__), gvec_remapped_(2, igloc__));
     }
 
-    /// Return local index of the G-vector in the remapped set.
-    int index_by_gvec(vector3d<int> G__) const
+    /// Return local index of the G-vector in the remapped set or -1 if G-vector is not stored locally.
+    inline int index_by_gvec(vector3d<int> G__) const
     {
-        if (idx_gvec.count(G__)) {
-            return idx_gvec.at(G__);
-        } else {
-            return -1;
+        for (int x : {0, 1, 2}) {
+            if (G__[x] < idx_gvec_.dim(x).begin() || G__[x] > idx_gvec_.dim(x).end()) {
+                return -1;
+            }
         }
+        return idx_gvec_(G__[0], G__[1], G__[2]);
+    }
+
+    /// Compute the index of rotated G-vectors for a list of rotation matrices.
+    /** Full shells of G-vectors are stored locally, so for every local G-vector either the rotated
+     *  vector or its inverse (in case of the reduced set of G-vectors) can be found on the same rank. */
+    void init_rotations(std::vector<matrix3d<int>> const& R__);
+
+    /// Number of rotations for which the index of rotated G-vectors was computed.
+    inline int num_rotations() const
+    {
+        return static_cast<int>(idx_rot_.size(0));
+    }
+
+    /// Local index of the rotated G-vector in the remapped set.
+    /** Negative value \f$ -(i + 1) \f$ means that the rotated G-vector is stored as the inverse vector with the
+     *  local index \f$ i \f$. */
+    inline int index_rotated(int isym__, int igloc__) const
+    {
+        return idx_rot_(isym__, igloc__);
     }
 
     /// Index of the G-vector shell by the local G-vector index (in the remapped set).
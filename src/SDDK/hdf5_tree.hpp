@@ -253,6 +253,53 @@ class HDF5_tree
         }
     }
 
+    /// Read or write a block of the existing multidimensional dataset.
+    /** Offsets and sizes of the block are given in the column-major order. */
+    template <typename T>
+    void slab_io(std::string const& name__, T* data__, std::vector<int> const& offset__,
+                 std::vector<int> const& count__, bool write__)
+    {
+        int n = static_cast<int>(count__.size());
+        for (int i = 0; i < n; i++) {
+            if (count__[i] == 0) {
+                return;
+            }
+        }
+
+        HDF5_group group(file_id_, path_);
+
+        HDF5_dataset dataset(group.id(), name__);
+
+        /* dataspace of the data block in memory */
+        HDF5_dataspace mspace(count__);
+
+        /* select the block in the file dataspace */
+        std::vector<hsize_t> offs(n);
+        std::vector<hsize_t> cnt(n);
+        for (int i = 0; i < n; i++) {
+            offs[n - i - 1] = offset__[i];
+            cnt[n - i - 1]  = count__[i];
+        }
+        hid_t fspace = H5Dget_space(dataset.id());
+        if (fspace < 0) {
+            TERMINATE("error in H5Dget_space()");
+        }
+        if (H5Sselect_hyperslab(fspace, H5S_SELECT_SET, offs.data(), NULL, cnt.data(), NULL) < 0) {
+            TERMINATE("error in H5Sselect_hyperslab()");
+        }
+
+        herr_t status;
+        if (write__) {
+            status = H5Dwrite(dataset.id(), hdf5_type_wrapper<T>::type_id(), mspace.id(), fspace, H5P_DEFAULT, data__);
+        } else {
+            status = H5Dread(dataset.id(), hdf5_type_wrapper<T>::type_id(), mspace.id(), fspace, H5P_DEFAULT, data__);
+        }
+        H5Sclose(fspace);
+        if (status < 0) {
+            TERMINATE("error in H5Dwrite() / H5Dread()");
+        }
+    }
+
     // HDF5_tree(HDF5_tree const& src) = delete;
 
     // HDF5_tree& operator=(HDF5_tree const& src) = delete;
@@ -326,6 +373,34 @@ class HDF5_tree
         return (*this)[name];
     }
 
+    /// Create a dataset without writing the data.
+    /** The dataset is filled later in blocks with write_slab(). Dimensions are given in the column-major order. */
+    template <typename T>
+    void create_dataset(std::string const& name__, std::vector<int> const& dims__)
+    {
+        HDF5_group group(file_id_, path_);
+
+        HDF5_dataspace dataspace(dims__);
+
+        HDF5_dataset dataset(group, dataspace, name__, hdf5_type_wrapper<T>::type_id());
+    }
+
+    /// Write a block of the existing dataset.
+    template <typename T>
+    void write_slab(std::string const& name__, T const* data__, std::vector<int> const& offset__,
+                    std::vector<int> const& count__)
+    {
+        slab_io(name__, const_cast<T*>(data__), offset__, count__, true);
+    }
+
+    /// Read a block of the existing dataset.
+    template <typename T>
+    void read_slab(std::string const& name__, T* data__, std::vector<int> const& offset__,
+                   std::vector<int> const& count__)
+    {
+        slab_io(name__, data__, offset__, count__, false);
+    }
+
     template <typename T, int N>
     void write(const std::string& name, mdarray<std::complex<T>, N> const& data)
     {
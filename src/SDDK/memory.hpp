@@ -28,6 +28,8 @@
 #include <list>
 #include <iostream>
 #include <map>
+#include <unordered_map>
+#include <mutex>
 #include <memory>
 #include <cstring>
 #include <functional>
@@ -453,30 +455,184 @@ struct memory_subblock_descriptor
     /// This is the precise beginning of the memory sub-block.
     /** Used to compute the exact location of the sub-block inside a memory block. */
     uint8_t* unaligned_ptr_;
+    /// Requested size in bytes (without the alignment).
+    size_t requested_size_;
+};
+
+/// Allocation strategy of the memory pool.
+enum class memory_pool_t
+{
+    /// List of memory blocks split into sub-blocks; released sub-blocks are merged with the free neighbours.
+    block_list,
+    /// Segregated size classes with a free list per class; allocation and release are O(1).
+    size_class
+};
+
+inline memory_pool_t get_memory_pool_t(std::string name__)
+{
+    std::transform(name__.begin(), name__.end(), name__.begin(), ::tolower);
+
+    std::map<std::string, memory_pool_t> const map_to_type = {
+        {"block_list", memory_pool_t::block_list},
+        {"size_class", memory_pool_t::size_class}
+    };
+
+    if (map_to_type.count(name__) == 0) {
+        std::stringstream s;
+        s << "wrong label of memory pool type: " << name__;
+        throw std::runtime_error(s.str());
+    }
+
+    return map_to_type.at(name__);
+}
+
+/// Store information about the sub-block allocated from the size-class free list.
+struct memory_chunk_descriptor
+{
+    /// Beginning of the chunk (unaligned).
+    uint8_t* unaligned_ptr_;
+    /// Index of the size class.
+    int size_class_;
+    /// Requested size in bytes.
+    size_t size_;
+};
+
+/// Usage statistics of the memory pool.
+struct memory_pool_stats
+{
+    /// Total number of allocations.
+    size_t num_allocations{0};
+    /// Number of allocations served from the memory already owned by the pool.
+    size_t num_hits{0};
+    /// Number of bytes requested by the currently allocated pointers.
+    size_t used_size{0};
+    /// Peak value of the requested number of bytes.
+    size_t peak_used_size{0};
 };
 
 //// Memory pool.
 /** This class stores list of allocated memory blocks. Each of the blocks can be divided into subblocks. When subblock
  *  is deallocated it is merged with previous or next free subblock in the memory block. If this was the last subblock
  *  in the block of memory, the (now) free block of memory is merged with the neighbours (if any are available).
+ *
+ *  Alternatively, the pool can be created with memory_pool_t::size_class strategy. In this case the requested size is
+ *  rounded up to one of the segregated size classes (four classes per power of two, so the internal waste is below
+ *  25%) and the chunks are taken from and returned to the free list of this class. Chunks are never merged or split,
+ *  pointers are indexed in a hash table and the pool can be used from within OpenMP parallel regions.
  */
 class memory_pool
 {
   private:
     /// Type of memory that is handeled by this pool.
     memory_t M_;
+    /// Allocation strategy.
+    memory_pool_t type_{memory_pool_t::block_list};
     /// List of blocks of allocated memory.
     std::list<memory_block_descriptor> memory_blocks_;
     /// Mapping between an allocated pointer and a subblock descriptor.
     std::map<uint8_t*, memory_subblock_descriptor> map_ptr_;
+    /// Storage of all chunks of the size-class pool.
+    std::vector<std::unique_ptr<uint8_t, memory_t_deleter_base>> chunks_;
+    /// Size class of each stored chunk.
+    std::vector<int> chunks_size_class_;
+    /// Free lists of chunks for each size class.
+    std::vector<std::vector<uint8_t*>> free_chunks_;
+    /// Mapping between an allocated pointer and a chunk descriptor.
+    std::unordered_map<uint8_t*, memory_chunk_descriptor> map_chunk_;
+    /// Lock for the size-class pool.
+    std::unique_ptr<std::mutex> mutex_;
+    /// Usage statistics.
+    memory_pool_stats stats_;
+
+    /// Smallest size class in bytes.
+    static const size_t min_class_size_{256};
+
+    /// Return index and size in bytes of the size class that fits a given number of bytes.
+    static inline int size_class(size_t size__, size_t& class_size__)
+    {
+        size__ = std::max(size__, min_class_size_);
+        /* find e such that 2^e < size <= 2^(e+1) */
+        int e{0};
+        while ((size_t(1) << (e + 1)) < size__) {
+            e++;
+        }
+        /* split [2^e, 2^(e+1)] into four classes */
+        size_t step  = size_t(1) << (e - 2);
+        size_t m     = (size__ - 1 - (size_t(1) << e)) / step;
+        class_size__ = (size_t(1) << e) + (m + 1) * step;
+        return 4 * e + static_cast<int>(m);
+    }
+
+    /// Size in bytes of the chunk for a given size class.
+    static inline size_t chunk_size(int ic__)
+    {
+        int e = ic__ / 4;
+        int m = ic__ % 4;
+        return (size_t(1) << e) + (m + 1) * (size_t(1) << (e - 2));
+    }
+
+    /// Return a chunk of memory from the size-class free lists.
+    uint8_t* allocate_chunk(size_t size__, size_t align_size__)
+    {
+        size_t class_size{0};
+        int ic = size_class(size__ + align_size__, class_size);
+
+        std::lock_guard<std::mutex> lock(*mutex_);
+
+        if (static_cast<int>(free_chunks_.size()) <= ic) {
+            free_chunks_.resize(ic + 1);
+        }
+        uint8_t* ptr{nullptr};
+        if (free_chunks_[ic].size()) {
+            ptr = free_chunks_[ic].back();
+            free_chunks_[ic].pop_back();
+            stats_.num_hits++;
+        } else {
+            chunks_.push_back(sddk::get_unique_ptr<uint8_t>(class_size, M_));
+            chunks_size_class_.push_back(ic);
+            ptr = chunks_.back().get();
+            if (!ptr) {
+                throw std::runtime_error("memory allocation failed");
+            }
+        }
+        auto uip = reinterpret_cast<std::uintptr_t>(ptr);
+        /* align the pointer */
+        if (uip % align_size__) {
+            uip += (align_size__ - uip % align_size__);
+        }
+        auto aligned_ptr = reinterpret_cast<uint8_t*>(uip);
+        map_chunk_[aligned_ptr] = {ptr, ic, size__};
+
+        stats_.num_allocations++;
+        stats_.used_size += size__;
+        stats_.peak_used_size = std::max(stats_.peak_used_size, stats_.used_size);
+
+        return aligned_ptr;
+    }
+
+    /// Return the chunk of memory to the free list of its size class.
+    void free_chunk(uint8_t* ptr__)
+    {
+        std::lock_guard<std::mutex> lock(*mutex_);
+
+        auto it = map_chunk_.find(ptr__);
+        if (it == map_chunk_.end()) {
+            throw std::runtime_error("memory_pool::free(): pointer is not allocated by the pool");
+        }
+        free_chunks_[it->second.size_class_].push_back(it->second.unaligned_ptr_);
+        stats_.used_size -= it->second.size_;
+        map_chunk_.erase(it);
+    }
 
   public:
 
     /// Constructor
-    memory_pool(memory_t M__, size_t initial_size__ = 0)
+    memory_pool(memory_t M__, size_t initial_size__ = 0, memory_pool_t type__ = memory_pool_t::block_list)
         : M_(M__)
+        , type_(type__)
+        , mutex_(new std::mutex)
     {
-        if (initial_size__) {
+        if (initial_size__ && type_ == memory_pool_t::block_list) {
             memory_blocks_.push_back(memory_block_descriptor(initial_size__, M_));
         }
     }
@@ -488,11 +644,20 @@ class memory_pool
 #if defined(__USE_MEMORY_POOL)
         /* memory block descriptor returns an unaligned memory; here we compute the the aligment value */
         size_t align_size = std::max(size_t(__GPU_MEMORY_ALIGMENT), alignof(T));
+
+        if (type_ == memory_pool_t::size_class) {
+            return reinterpret_cast<T*>(allocate_chunk(num_elements__ * sizeof(T), align_size));
+        }
+
         /* size of the memory block in bytes */
         size_t size = num_elements__ * sizeof(T) + align_size;
 
         uint8_t* ptr{nullptr};
 
+        stats_.num_allocations++;
+        stats_.used_size += num_elements__ * sizeof(T);
+        stats_.peak_used_size = std::max(stats_.peak_used_size, stats_.used_size);
+
         /* iterate over existing blocks */
         auto it = memory_blocks_.begin();
         for (; it != memory_blocks_.end(); it++) {
@@ -500,6 +665,7 @@ class memory_pool
             ptr = it->allocate_subblock(size);
             /* break if this memory block can store the subblock */
             if (ptr) {
+                stats_.num_hits++;
                 break;
             }
         }
@@ -536,6 +702,8 @@ class memory_pool
         msb.size_ = size;
         /* beginning of the block (unaligned) */
         msb.unaligned_ptr_ = ptr;
+        /* size requested by the caller */
+        msb.requested_size_ = num_elements__ * sizeof(T);
         auto uip = reinterpret_cast<std::uintptr_t>(ptr);
         /* align the pointer */
         if (uip % align_size) {
@@ -555,10 +723,15 @@ class memory_pool
     {
 #if defined(__USE_MEMORY_POOL)
         auto ptr = reinterpret_cast<uint8_t*>(ptr__);
+        if (type_ == memory_pool_t::size_class) {
+            free_chunk(ptr);
+            return;
+        }
         /* get a descriptor of this pointer */
         auto& msb = map_ptr_.at(ptr);
         /* free the sub-block */
         msb.it_->free_subblock(msb.unaligned_ptr_, msb.size_);
+        stats_.used_size -= msb.requested_size_;
         /* remove this pointer from the hash table */
         map_ptr_.erase(ptr);
 #else
@@ -586,6 +759,15 @@ class memory_pool
             it->free_subblocks_.push_back(std::make_pair(0, it->size_));
         }
         map_ptr_.clear();
+        /* return all chunks to the free lists */
+        for (auto& e: free_chunks_) {
+            e.clear();
+        }
+        for (size_t i = 0; i < chunks_.size(); i++) {
+            free_chunks_[chunks_size_class_[i]].push_back(chunks_[i].get());
+        }
+        map_chunk_.clear();
+        stats_.used_size = 0;
     }
 
     void print()
@@ -597,6 +779,45 @@ class memory_pool
                       << ", free size: " << e.get_free_size() << "\n";
             i++;
         }
+        for (size_t ic = 0; ic < free_chunks_.size(); ic++) {
+            int n = static_cast<int>(std::count(chunks_size_class_.begin(), chunks_size_class_.end(), ic));
+            if (n) {
+                std::cout << "size class: " << ic << ", chunk size: " << chunk_size(ic) << ", chunks: " << n
+                          << ", free chunks: " << free_chunks_[ic].size() << "\n";
+            }
+        }
+        std::cout << "number of allocations : " << stats_.num_allocations << "\n"
+                  << "hit rate              : " << hit_rate() << "\n"
+                  << "used size             : " << stats_.used_size << "\n"
+                  << "peak used size        : " << stats_.peak_used_size << "\n"
+                  << "fragmentation         : " << fragmentation() << "\n";
+    }
+
+    /// Return the usage statistics.
+    inline memory_pool_stats const& stats() const
+    {
+        return stats_;
+    }
+
+    /// Fraction of allocations that were served without allocating new memory.
+    inline double hit_rate() const
+    {
+        return (stats_.num_allocations) ? static_cast<double>(stats_.num_hits) / stats_.num_allocations : 0;
+    }
+
+    /// Fraction of the occupied memory which does not hold the requested data.
+    /** For the block-list pool the occupied memory includes the alignment padding; for the size-class pool it
+     *  includes rounding of the requested size to the size of the chunk. */
+    inline double fragmentation() const
+    {
+        size_t occupied = total_size() - free_size();
+        return (occupied) ? 1 - static_cast<double>(stats_.used_size) / occupied : 0;
+    }
+
+    /// Return the allocation strategy of the pool.
+    inline memory_pool_t type() const
+    {
+        return type_;
     }
 
     /// Return the type of memory this pool is managing.
@@ -612,6 +833,9 @@ class memory_pool
         for (auto it = memory_blocks_.begin(); it != memory_blocks_.end(); it++) {
             s += it->size_;
         }
+        for (auto ic: chunks_size_class_) {
+            s += chunk_size(ic);
+        }
         return s;
     }
 
@@ -622,6 +846,9 @@ class memory_pool
         for (auto it = memory_blocks_.begin(); it != memory_blocks_.end(); it++) {
             s += it->get_free_size();
         }
+        for (size_t ic = 0; ic < free_chunks_.size(); ic++) {
+            s += free_chunks_[ic].size() * chunk_size(static_cast<int>(ic));
+        }
         return s;
     }
 
@@ -632,13 +859,16 @@ class memory_pool
         for (auto it = memory_blocks_.begin(); it != memory_blocks_.end(); it++) {
             s += it->free_subblocks_.size();
         }
+        for (auto& e: free_chunks_) {
+            s += e.size();
+        }
         return s;
     }
 
     /// Get the number of stored pointers.
     size_t num_stored_ptr() const
     {
-        return map_ptr_.size();
+        return map_ptr_.size() + map_chunk_.size();
     }
 };
 
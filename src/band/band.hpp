@@ -76,14 +76,27 @@ class Band // TODO: Band class is lightweight and in principle can be converted
     template <typename T>
     int diag_pseudo_potential_davidson(Hamiltonian_k& Hk__) const;
 
+    /// Chebyshev-filtered subspace iteration.
+    /** The subspace of the lowest bands is refined with a polynomial filter which amplifies the wanted part of the
+     *  spectrum. The upper bound of the spectrum is estimated with a few Lanczos steps, the lower bound of the damped
+     *  interval is taken from the largest Ritz value of the subspace and the degree of the filter is adapted to the
+     *  slowest unconverged band. Only norm-conserving pseudopotentials and host memory are supported. */
+    template <typename T>
+    int diag_pseudo_potential_chebyshev(Hamiltonian_k& Hk__) const;
+
+    /// Residual minimization with direct inversion in the iterative subspace (RMM-DIIS).
+    /** After the Rayleigh-Ritz step in the subspace of the current wave-functions each unconverged band is refined
+     *  independently by a few preconditioned residual-minimization steps. Bands are processed in blocks and H and S
+     *  are applied only to the bands which are still active, so the cost is proportional to the number of
+     *  unconverged bands. Davidson solver is used as a warm start while the SCF tolerance is loose. Only host
+     *  memory is supported. */
+    template <typename T>
+    int diag_pseudo_potential_rmm_diis(Hamiltonian_k& Hk__) const;
+
     /// Diagonalize S operator to check for the negative eigen-values.
     template <typename T>
     sddk::mdarray<double, 1> diag_S_davidson(Hamiltonian_k& Hk__) const;
 
-    ///// RMM-DIIS diagonalization.
-    //template <typename T>
-    //void diag_pseudo_potential_rmm_diis(K_point* kp__, int ispn__, Hamiltonian& H__) const;
-
   public:
     /// Constructor
     Band(Simulation_context& ctx__);
@@ -27,17 +27,6 @@
 #include "potential/potential.hpp"
 #include "utils/profiler.hpp"
 
-#if defined(__GPU) && defined(__CUDA)
-#include "gpu/acc.hpp"
-extern "C" void compute_chebyshev_polynomial_gpu(int num_gkvec,
-                                                 int n,
-                                                 double c,
-                                                 double r,
-                                                 acc_complex_double_t* phi0,
-                                                 acc_complex_double_t* phi1,
-                                                 acc_complex_double_t* phi2);
-#endif
-
 namespace sirius {
 
 template <typename T>
@@ -58,23 +47,10 @@ int Band::diag_pseudo_potential(Hamiltonian_k& Hk__) const
         }
     } else if (itso.type_ == "davidson") {
         niter = diag_pseudo_potential_davidson<T>(Hk__);
-    //} else if (itso.type_ == "rmm-diis") {
-    //    if (ctx_.num_mag_dims() != 3) {
-    //        for (int ispn = 0; ispn < ctx_.num_spins(); ispn++) {
-    //            diag_pseudo_potential_rmm_diis<T>(kp__, ispn, H__);
-    //        }
-    //    } else {
-    //        STOP();
-    //    }
-    //} else if (itso.type_ == "chebyshev") {
-    //    P_operator<T> p_op(ctx_, kp__->p_mtrx());
-    //    if (ctx_.num_mag_dims() != 3) {
-    //        for (int ispn = 0; ispn < ctx_.num_spins(); ispn++) {
-    //            diag_pseudo_potential_chebyshev<T>(kp__, ispn, H__, p_op);
-    //        }
-    //    } else {
-    //        STOP();
-    //    }
+    } else if (itso.type_ == "rmm-diis") {
+        niter = diag_pseudo_potential_rmm_diis<T>(Hk__);
+    } else if (itso.type_ == "chebyshev") {
+        niter = diag_pseudo_potential_chebyshev<T>(Hk__);
     } else {
         TERMINATE("unknown iterative solver type");
     }
@@ -948,637 +924,747 @@ Band::diag_S_davidson(Hamiltonian_k& Hk__) const
     return eval;
 }
 
-//template <typename T>
-//inline void Band::diag_pseudo_potential_chebyshev(K_point* kp__,
-//                                                  int ispn__,
-//                                                  Hamiltonian &H__,
-//                                                  P_operator<T>& p_op__) const
-//{
-//    PROFILE("sirius::Band::diag_pseudo_potential_chebyshev");
-//
-////==     auto pu = ctx_.processing_unit();
-////==
-////==     /* short notation for number of target wave-functions */
-////==     int num_bands = ctx_.num_fv_states();
-////==
-////==     auto& itso = ctx_.iterative_solver_input_section();
-////==
-////==     /* short notation for target wave-functions */
-////==     auto& psi = kp__->spinor_wave_functions<false>(ispn__);
-////==
-////== //==
-////== //==     //auto& beta_pw_panel = kp__->beta_pw_panel();
-////== //==     //dmatrix<double_complex> S(unit_cell_.mt_basis_size(), unit_cell_.mt_basis_size(), kp__->blacs_grid());
-////== //==     //linalg<device_t::CPU>::gemm(2, 0, unit_cell_.mt_basis_size(), unit_cell_.mt_basis_size(), kp__->num_gkvec(), complex_one,
-////== //==     //                  beta_pw_panel, beta_pw_panel, complex_zero, S);
-////== //==     //for (int ia = 0; ia < unit_cell_.num_atoms(); ia++)
-////== //==     //{
-////== //==     //    auto type = unit_cell_.atom(ia)->type();
-////== //==     //    int nbf = type->mt_basis_size();
-////== //==     //    int ofs = unit_cell_.atom(ia)->offset_lo();
-////== //==     //    matrix<double_complex> qinv(nbf, nbf);
-////== //==     //    type->uspp().q_mtrx >> qinv;
-////== //==     //    linalg<device_t::CPU>::geinv(nbf, qinv);
-////== //==     //    for (int i = 0; i < nbf; i++)
-////== //==     //    {
-////== //==     //        for (int j = 0; j < nbf; j++) S.add(ofs + j, ofs + i, qinv(j, i));
-////== //==     //    }
-////== //==     //}
-////== //==     //linalg<device_t::CPU>::geinv(unit_cell_.mt_basis_size(), S);
-////== //==
-////== //==
-////==     /* maximum order of Chebyshev polynomial*/
-////==     int order = itso.num_steps_ + 2;
-////==
-////==     std::vector< Wave_functions<false>* > phi(order);
-////==     for (int i = 0; i < order; i++) {
-////==         phi[i] = new Wave_functions<false>(kp__->num_gkvec_loc(), num_bands, pu);
-////==     }
-////==
-////==     Wave_functions<false> hphi(kp__->num_gkvec_loc(), num_bands, pu);
-////==
-////==     /* trial basis functions */
-////==     phi[0]->copy_from(psi, 0, num_bands);
-////==
-////==     /* apply Hamiltonian to the basis functions */
-////==     apply_h<T>(kp__, ispn__, 0, num_bands, *phi[0], hphi, h_op__, d_op__);
-////==
-////==     /* compute Rayleight quotients */
-////==     std::vector<double> e0(num_bands, 0.0);
-////==     if (pu == CPU) {
-////==         #pragma omp parallel for schedule(static)
-////==         for (int i = 0; i < num_bands; i++) {
-////==             for (int igk = 0; igk < kp__->num_gkvec_loc(); igk++) {
-////==                 e0[i] += std::real(std::conj((*phi[0])(igk, i)) * hphi(igk, i));
-////==             }
-////==         }
-////==     }
-////==     kp__->comm().allreduce(e0);
-////==
-////==     //== if (parameters_.processing_unit() == GPU)
-////==     //== {
-////==     //==     #ifdef __GPU
-////==     //==     mdarray<double, 1> e0_loc(kp__->spl_fv_states().local_size());
-////==     //==     e0_loc.allocate_on_device();
-////==     //==     e0_loc.zero_on_device();
-////==
-////==     //==     compute_inner_product_gpu(kp__->num_gkvec_row(),
-////==     //==                               (int)kp__->spl_fv_states().local_size(),
-////==     //==                               phi[0].at<GPU>(),
-////==     //==                               hphi.at<GPU>(),
-////==     //==                               e0_loc.at<GPU>());
-////==     //==     e0_loc.copy_to_host();
-////==     //==     for (int iloc = 0; iloc < (int)kp__->spl_fv_states().local_size(); iloc++)
-////==     //==     {
-////==     //==         int i = kp__->spl_fv_states(iloc);
-////==     //==         e0[i] = e0_loc(iloc);
-////==     //==     }
-////==     //==     #endif
-////==     //== }
-////==     //==
-////==
-////==     /* estimate low and upper bounds of the Chebyshev filter */
-////==     double lambda0 = -1e10;
-////==     //double emin = 1e100;
-////==     for (int i = 0; i < num_bands; i++)
-////==     {
-////==         lambda0 = std::max(lambda0, e0[i]);
-////==         //emin = std::min(emin, e0[i]);
-////==     }
-////==     double lambda1 = 0.5 * std::pow(ctx_.gk_cutoff(), 2);
-////==
-////==     double r = (lambda1 - lambda0) / 2.0;
-////==     double c = (lambda1 + lambda0) / 2.0;
-////==
-////==     auto apply_p = [kp__, &p_op__, num_bands](Wave_functions<false>& phi, Wave_functions<false>& op_phi) {
-////==         op_phi.copy_from(phi, 0, num_bands);
-////==         //for (int i = 0; i < kp__->beta_projectors().num_beta_chunks(); i++) {
-////==         //    kp__->beta_projectors().generate(i);
-////==
-////==         //    kp__->beta_projectors().inner<T>(i, phi, 0, num_bands);
-////==
-////==         //    p_op__.apply(i, 0, op_phi, 0, num_bands);
-////==         //}
-////==     };
-////==
-////==     apply_p(hphi, *phi[1]);
-////==
-////==     /* compute \psi_1 = (S^{-1}H\psi_0 - c\psi_0) / r */
-////==     if (pu == CPU) {
-////==         #pragma omp parallel for schedule(static)
-////==         for (int i = 0; i < num_bands; i++) {
-////==             for (int igk = 0; igk < kp__->num_gkvec_loc(); igk++) {
-////==                 (*phi[1])(igk, i) = ((*phi[1])(igk, i) - (*phi[0])(igk, i) * c) / r;
-////==             }
-////==         }
-////==     }
-////== //==     //if (parameters_.processing_unit() == GPU)
-////== //==     //{
-////== //==     //    #ifdef __GPU
-////== //==     //    compute_chebyshev_polynomial_gpu(kp__->num_gkvec_row(), (int)kp__->spl_fv_states().local_size(), c, r,
-////== //==     //                                     phi[0].at<GPU>(), phi[1].at<GPU>(), NULL);
-////== //==     //    phi[1].panel().copy_to_host();
-////== //==     //    #endif
-////== //==     //}
-////== //==
-////==
-////==     /* compute higher polynomial orders */
-////==     for (int k = 2; k < order; k++) {
-////==
-////==         apply_h<T>(kp__, ispn__, 0, num_bands, *phi[k - 1], hphi, h_op__, d_op__);
-////==
-////==         apply_p(hphi, *phi[k]);
-////==
-////==         if (pu == CPU) {
-////==             #pragma omp parallel for schedule(static)
-////==             for (int i = 0; i < num_bands; i++) {
-////==                 for (int igk = 0; igk < kp__->num_gkvec_loc(); igk++) {
-////==                     (*phi[k])(igk, i) = ((*phi[k])(igk, i) - c * (*phi[k - 1])(igk, i)) * 2.0 / r - (*phi[k - 2])(igk, i);
-////==                 }
-////==             }
-////==         }
-////==         //== if (parameters_.processing_unit() == GPU)
-////==         //== {
-////==         //==     #ifdef __GPU
-////==         //==     compute_chebyshev_polynomial_gpu(kp__->num_gkvec(), num_bands, c, r,
-////==         //==                                      phi[k - 2].at<GPU>(), phi[k - 1].at<GPU>(), phi[k].at<GPU>());
-////==         //==     phi[k].copy_to_host();
-////==         //==     #endif
-////==         //== }
-////==     }
-////==
-////==     /* allocate Hamiltonian and overlap */
-////==     matrix<T> hmlt(num_bands, num_bands);
-////==     matrix<T> ovlp(num_bands, num_bands);
-////==     matrix<T> evec(num_bands, num_bands);
-////==     matrix<T> hmlt_old;
-////==     matrix<T> ovlp_old;
-////==
-////==     int bs = ctx_.cyclic_block_size();
-////==
-////==     dmatrix<T> hmlt_dist;
-////==     dmatrix<T> ovlp_dist;
-////==     dmatrix<T> evec_dist;
-////==     if (kp__->comm().size() == 1) {
-////==         hmlt_dist = dmatrix<T>(&hmlt(0, 0), num_bands, num_bands, ctx_.blacs_grid(), bs, bs);
-////==         ovlp_dist = dmatrix<T>(&ovlp(0, 0), num_bands, num_bands, ctx_.blacs_grid(), bs, bs);
-////==         evec_dist = dmatrix<T>(&evec(0, 0), num_bands, num_bands, ctx_.blacs_grid(), bs, bs);
-////==     } else {
-////==         hmlt_dist = dmatrix<T>(num_bands, num_bands, ctx_.blacs_grid(), bs, bs);
-////==         ovlp_dist = dmatrix<T>(num_bands, num_bands, ctx_.blacs_grid(), bs, bs);
-////==         evec_dist = dmatrix<T>(num_bands, num_bands, ctx_.blacs_grid(), bs, bs);
-////==     }
-////==
-////==     std::vector<double> eval(num_bands);
-////==
-////==     /* apply Hamiltonian and overlap operators to the new basis functions */
-////==     apply_h_o<T>(kp__, ispn__, 0, num_bands, *phi[order - 1], hphi, *phi[0], h_op__, d_op__, q_op__);
-////==
-////==     //orthogonalize<T>(kp__, N, n, phi, hphi, ophi, ovlp);
-////==
-////==     /* setup eigen-value problem */
-////==     set_h_o<T>(kp__, 0, num_bands, *phi[order - 1], hphi, *phi[0], hmlt, ovlp, hmlt_old, ovlp_old);
-////==
-////==     /* solve generalized eigen-value problem with the size N */
-////==     diag_h_o<T>(kp__, num_bands, num_bands, hmlt, ovlp, evec, hmlt_dist, ovlp_dist, evec_dist, eval);
-////==
-////==     /* recompute wave-functions */
-////==     /* \Psi_{i} = \sum_{mu} \phi_{mu} * Z_{mu, i} */
-////==     psi.transform_from<T>(*phi[order - 1], num_bands, evec, num_bands);
-////==
-////==     for (int j = 0; j < ctx_.num_fv_states(); j++) {
-////==         kp__->band_energy(j + ispn__ * ctx_.num_fv_states()) = eval[j];
-////==     }
-////==
-////==     for (int i = 0; i < order; i++) {
-////==         delete phi[i];
-////==     }
-//}
-//
-////template <typename T>
-////inline T
-////inner_local(K_point* kp__,
-////            wave_functions& a,
-////            int ia,
-////            wave_functions& b,
-////            int ib);
-////
-////template<>
-////inline double
-////inner_local<double>(K_point* kp__,
-////                    wave_functions& a,
-////                    int ia,
-////                    wave_functions& b,
-////                    int ib)
-////{
-////    double result{0};
-////    double* a_tmp = reinterpret_cast<double*>(&a.pw_coeffs().prime(0, ia));
-////    double* b_tmp = reinterpret_cast<double*>(&b.pw_coeffs().prime(0, ib));
-////    for (int igk = 0; igk < 2 * kp__->num_gkvec_loc(); igk++) {
-////        result += a_tmp[igk] * b_tmp[igk];
-////    }
-////
-////    if (kp__->comm().rank() == 0) {
-////        result = 2 * result - a_tmp[0] * b_tmp[0];
-////    } else {
-////        result *= 2;
-////    }
-////
-////    return result;
-////}
-////
-////template<>
-////inline double_complex
-////inner_local<double_complex>(K_point* kp__,
-////                            wave_functions& a,
-////                            int ia,
-////                            wave_functions& b,
-////                            int ib)
-////{
-////    double_complex result{0, 0};
-////    for (int igk = 0; igk < kp__->num_gkvec_loc(); igk++) {
-////        result += std::conj(a.pw_coeffs().prime(igk, ia)) * b.pw_coeffs().prime(igk, ib);
-////    }
-////    return result;
-////}
-//
-//template <typename T>
-//inline void Band::diag_pseudo_potential_rmm_diis(K_point* kp__,
-//                                                 int ispn__,
-//                                                 Hamiltonian &H__) const
-//
-//{
-//    //auto& itso = ctx_.iterative_solver_input();
-//    double tol = ctx_.iterative_solver_tolerance();
-//
-//    if (tol > 1e-4) {
-//        diag_pseudo_potential_davidson<T>(kp__, H__);
-//        return;
-//    }
-//
-//    PROFILE("sirius::Band::diag_pseudo_potential_rmm_diis");
-//
-//    /* get diagonal elements for preconditioning */
-//    //auto h_diag = get_h_diag(kp__, ispn__, local_op_->v0(ispn__), d_op__);
-//    //auto o_diag = get_o_diag(kp__, q_op__);
-//    STOP();
-//
-////    /* short notation for number of target wave-functions */
-////    int num_bands = ctx_.num_fv_states();
-////
-////    //auto pu = ctx_.processing_unit();
-////
-////    /* short notation for target wave-functions */
-////    auto& psi = kp__->spinor_wave_functions(ispn__);
-////
-////    int niter = itso.num_steps_;
-////
-////    Eigenproblem_lapack evp_solver(2 * linalg_base::dlamch('S'));
-////
-////    std::vector<wave_functions*> phi(niter);
-////    std::vector<wave_functions*> res(niter);
-////    std::vector<wave_functions*> ophi(niter);
-////    std::vector<wave_functions*> hphi(niter);
-////
-////    for (int i = 0; i < niter; i++) {
-////        phi[i]  = new wave_functions(ctx_.processing_unit(), kp__->gkvec(), num_bands);
-////        res[i]  = new wave_functions(ctx_.processing_unit(), kp__->gkvec(), num_bands);
-////        hphi[i] = new wave_functions(ctx_.processing_unit(), kp__->gkvec(), num_bands);
-////        ophi[i] = new wave_functions(ctx_.processing_unit(), kp__->gkvec(), num_bands);
-////    }
-////
-////    wave_functions  phi_tmp(ctx_.processing_unit(), kp__->gkvec(), num_bands);
-////    wave_functions hphi_tmp(ctx_.processing_unit(), kp__->gkvec(), num_bands);
-////    wave_functions ophi_tmp(ctx_.processing_unit(), kp__->gkvec(), num_bands);
-////
-////    auto mem_type = (gen_evp_solver_->type() == ev_magma) ? memory_t::host_pinned : memory_t::host;
-////
-////    int bs = ctx_.cyclic_block_size();
-////
-////    dmatrix<T> hmlt(num_bands, num_bands, ctx_.blacs_grid(), bs, bs, mem_type);
-////    dmatrix<T> ovlp(num_bands, num_bands, ctx_.blacs_grid(), bs, bs, mem_type);
-////    dmatrix<T> evec(num_bands, num_bands, ctx_.blacs_grid(), bs, bs, mem_type);
-////    dmatrix<T> hmlt_old;
-////    dmatrix<T> ovlp_old;
-////
-////    std::vector<double> eval(num_bands);
-////    for (int i = 0; i < num_bands; i++) {
-////        eval[i] = kp__->band_energy(i);
-////    }
-////    std::vector<double> eval_old(num_bands);
-////
-////    /* trial basis functions */
-////    phi[0]->copy_from(psi, 0, num_bands);
-////
-////    std::vector<int> last(num_bands, 0);
-////    std::vector<bool> conv_band(num_bands, false);
-////    std::vector<double> res_norm(num_bands);
-////    std::vector<double> res_norm_start(num_bands);
-////    std::vector<double> lambda(num_bands, 0);
-////
-////    auto update_res = [kp__, num_bands, &phi, &res, &hphi, &ophi, &last, &conv_band]
-////                      (std::vector<double>& res_norm__, std::vector<double>& eval__) -> void
-////    {
-////        utils::timer t("sirius::Band::diag_pseudo_potential_rmm_diis|res");
-////        std::vector<double> e_tmp(num_bands, 0), d_tmp(num_bands, 0);
-////
-////        #pragma omp parallel for
-////        for (int i = 0; i < num_bands; i++) {
-////            if (!conv_band[i]) {
-////                e_tmp[i] = std::real(inner_local<T>(kp__, *phi[last[i]], i, *hphi[last[i]], i));
-////                d_tmp[i] = std::real(inner_local<T>(kp__, *phi[last[i]], i, *ophi[last[i]], i));
-////            }
-////        }
-////        kp__->comm().allreduce(e_tmp);
-////        kp__->comm().allreduce(d_tmp);
-////
-////        res_norm__ = std::vector<double>(num_bands, 0);
-////        #pragma omp parallel for
-////        for (int i = 0; i < num_bands; i++) {
-////            if (!conv_band[i]) {
-////                eval__[i] = e_tmp[i] / d_tmp[i];
-////
-////                /* compute residual r_{i} = H\Psi_{i} - E_{i}O\Psi_{i} */
-////                for (int igk = 0; igk < kp__->num_gkvec_loc(); igk++) {
-////                    (*res[last[i]]).pw_coeffs().prime(igk, i) = (*hphi[last[i]]).pw_coeffs().prime(igk, i) - eval__[i] * (*ophi[last[i]]).pw_coeffs().prime(igk, i);
-////                }
-////                res_norm__[i] = std::real(inner_local<T>(kp__, *res[last[i]], i, *res[last[i]], i));
-////            }
-////        }
-////        kp__->comm().allreduce(res_norm__);
-////        for (int i = 0; i < num_bands; i++) {
-////            if (!conv_band[i]) {
-////                res_norm__[i] = std::sqrt(res_norm__[i]);
-////            }
-////        }
-////    };
-////
-////    auto apply_h_o = [this, kp__, num_bands, &phi, &phi_tmp, &hphi, &hphi_tmp, &ophi, &ophi_tmp, &conv_band, &last,
-////                      &d_op__, &q_op__, ispn__]() -> int
-////    {
-////        utils::timer t("sirius::Band::diag_pseudo_potential_rmm_diis|h_o");
-////        int n{0};
-////        for (int i = 0; i < num_bands; i++) {
-////            if (!conv_band[i]) {
-////                std::memcpy(&phi_tmp.pw_coeffs().prime(0, n), &(*phi[last[i]]).pw_coeffs().prime(0, i), kp__->num_gkvec_loc() * sizeof(double_complex));
-////                n++;
-////            }
-////        }
-////
-////        if (n == 0) {
-////            return 0;
-////        }
-////
-////        /* apply Hamiltonian and overlap operators to the initial basis functions */
-////        this->apply_h_o<T>(kp__, ispn__, 0, n, phi_tmp, hphi_tmp, ophi_tmp, d_op__, q_op__);
-////
-////        n = 0;
-////        for (int i = 0; i < num_bands; i++) {
-////            if (!conv_band[i]) {
-////                std::memcpy(&(*hphi[last[i]]).pw_coeffs().prime(0, i), &hphi_tmp.pw_coeffs().prime(0, n), kp__->num_gkvec_loc() * sizeof(double_complex));
-////                std::memcpy(&(*ophi[last[i]]).pw_coeffs().prime(0, i), &ophi_tmp.pw_coeffs().prime(0, n), kp__->num_gkvec_loc() * sizeof(double_complex));
-////                n++;
-////            }
-////        }
-////        return n;
-////    };
-////
-////    STOP();
-////
-////    //auto apply_preconditioner = [kp__, num_bands, &h_diag, &o_diag, &eval, &conv_band]
-////    //                            (std::vector<double> lambda,
-////    //                             wave_functions& res__,
-////    //                             double alpha,
-////    //                             wave_functions& kres__) -> void
-////    //{
-////    //    utils::timer t("sirius::Band::diag_pseudo_potential_rmm_diis|pre");
-////    //    #pragma omp parallel for
-////    //    for (int i = 0; i < num_bands; i++) {
-////    //        if (!conv_band[i]) {
-////    //            for (int igk = 0; igk < kp__->num_gkvec_loc(); igk++) {
-////    //                double p = h_diag[igk] - eval[i] * o_diag[igk];
-////
-////    //                p *= 2; // QE formula is in Ry; here we convert to Ha
-////    //                p = 0.25 * (1 + p + std::sqrt(1 + (p - 1) * (p - 1)));
-////    //                kres__.pw_coeffs().prime(igk, i) = alpha * kres__.pw_coeffs().prime(igk, i) + lambda[i] * res__.pw_coeffs().prime(igk, i) / p;
-////    //            }
-////    //        }
-////
-////    //        //== double Ekin = 0;
-////    //        //== double norm = 0;
-////    //        //== for (int igk = 0; igk < kp__->num_gkvec(); igk++)
-////    //        //== {
-////    //        //==     Ekin += 0.5 * std::pow(std::abs(res__(igk, i)), 2) * std::pow(kp__->gkvec_cart(igk).length(), 2);
-////    //        //==     norm += std::pow(std::abs(res__(igk, i)), 2);
-////    //        //== }
-////    //        //== Ekin /= norm;
-////    //        //== for (int igk = 0; igk < kp__->num_gkvec(); igk++)
-////    //        //== {
-////    //        //==     double x = std::pow(kp__->gkvec_cart(igk).length(), 2) / 3 / Ekin;
-////    //        //==     kres__(igk, i) = alpha * kres__(igk, i) + lambda[i] * res__(igk, i) *
-////    //        //==         (4.0 / 3 / Ekin) * (27 + 18 * x + 12 * x * x + 8 * x * x * x) / (27 + 18 * x + 12 * x * x + 8 * x * x * x + 16 * x * x * x * x);
-////    //        //== }
-////    //    }
-////    //};
-////
-////    /* apply Hamiltonian and overlap operators to the initial basis functions */
-////    this->apply_h_o<T>(kp__, ispn__, 0, num_bands, *phi[0], *hphi[0], *ophi[0], d_op__, q_op__);
-////
-////    /* compute initial residuals */
-////    update_res(res_norm_start, eval);
-////
-////    bool conv{true};
-////    for (int i = 0; i < num_bands; i++) {
-////        if (res_norm_start[i] > itso.residual_tolerance_) {
-////            conv = false;
-////        }
-////    }
-////    if (conv) {
-////        DUMP("all bands are converged at stage#0");
-////        return;
-////    }
-////
-////    last = std::vector<int>(num_bands, 1);
-////
-////    phi[1]->pw_coeffs().prime().zero();
-////    /* apply preconditioner to the initial residuals */
-////    //apply_preconditioner(std::vector<double>(num_bands, 1), *res[0], 0.0, *phi[1]);
-////    STOP();
-////
-////    /* apply H and O to the preconditioned residuals */
-////    apply_h_o();
-////
-////    /* estimate lambda */
-////    std::vector<double> f1(num_bands, 0);
-////    std::vector<double> f2(num_bands, 0);
-////    std::vector<double> f3(num_bands, 0);
-////    std::vector<double> f4(num_bands, 0);
-////
-////    #pragma omp parallel for
-////    for (int i = 0; i < num_bands; i++) {
-////        if (!conv_band[i]) {
-////            f1[i] = std::real(inner_local<T>(kp__, *phi[1], i, *ophi[1], i));     //  <KR_i | OKR_i>
-////            f2[i] = std::real(inner_local<T>(kp__, *phi[0], i, *ophi[1], i)) * 2; // <phi_i | OKR_i>
-////            f3[i] = std::real(inner_local<T>(kp__, *phi[1], i, *hphi[1], i));     //  <KR_i | HKR_i>
-////            f4[i] = std::real(inner_local<T>(kp__, *phi[0], i, *hphi[1], i)) * 2; // <phi_i | HKR_i>
-////        }
-////    }
-////    kp__->comm().allreduce(f1);
-////    kp__->comm().allreduce(f2);
-////    kp__->comm().allreduce(f3);
-////    kp__->comm().allreduce(f4);
-////
-////    #pragma omp parallel for
-////    for (int i = 0; i < num_bands; i++) {
-////        if (!conv_band[i]) {
-////            double a = f1[i] * f4[i] - f2[i] * f3[i];
-////            double b = f3[i] - eval[i] * f1[i];
-////            double c = eval[i] * f2[i] - f4[i];
-////
-////            lambda[i] = (b - std::sqrt(b * b - 4.0 * a * c)) / 2.0 / a;
-////            if (std::abs(lambda[i]) > 2.0) {
-////                lambda[i] = 2.0 * Utils::sign(lambda[i]);
-////            }
-////            if (std::abs(lambda[i]) < 0.5) {
-////                lambda[i] = 0.5 * Utils::sign(lambda[i]);
-////            }
-////
-////            /* construct new basis functions */
-////            for (int igk = 0; igk < kp__->num_gkvec_loc(); igk++) {
-////                 (*phi[1]).pw_coeffs().prime(igk, i) =  (*phi[0]).pw_coeffs().prime(igk, i) + lambda[i] *  (*phi[1]).pw_coeffs().prime(igk, i);
-////                (*hphi[1]).pw_coeffs().prime(igk, i) = (*hphi[0]).pw_coeffs().prime(igk, i) + lambda[i] * (*hphi[1]).pw_coeffs().prime(igk, i);
-////                (*ophi[1]).pw_coeffs().prime(igk, i) = (*ophi[0]).pw_coeffs().prime(igk, i) + lambda[i] * (*ophi[1]).pw_coeffs().prime(igk, i);
-////            }
-////        }
-////    }
-////    /* compute new residuals */
-////    update_res(res_norm, eval);
-////    /* check which bands have converged */
-////    for (int i = 0; i < num_bands; i++) {
-////        if (res_norm[i] < itso.residual_tolerance_) {
-////            conv_band[i] = true;
-////        }
-////    }
-////
-////    mdarray<T, 3> A(niter, niter, num_bands);
-////    mdarray<T, 3> B(niter, niter, num_bands);
-////    mdarray<T, 2> V(niter, num_bands);
-////    std::vector<double> ev(niter);
-////
-////    /* start adjusting residuals */
-////    for (int iter = 2; iter < niter; iter++) {
-////        utils::timer t1("sirius::Band::diag_pseudo_potential_rmm_diis|AB");
-////        A.zero();
-////        B.zero();
-////        for (int i = 0; i < num_bands; i++) {
-////            if (!conv_band[i]) {
-////                for (int i1 = 0; i1 < iter; i1++) {
-////                    for (int i2 = 0; i2 < iter; i2++) {
-////                        A(i1, i2, i) = inner_local<T>(kp__, *res[i1], i, *res[i2], i);
-////                        B(i1, i2, i) = inner_local<T>(kp__, *phi[i1], i, *ophi[i2], i);
-////                    }
-////                }
-////            }
-////        }
-////        kp__->comm().allreduce(A.template at<CPU>(), (int)A.size());
-////        kp__->comm().allreduce(B.template at<CPU>(), (int)B.size());
-////        t1.stop();
-////
-////        utils::timer t2("sirius::Band::diag_pseudo_potential_rmm_diis|phi");
-////        for (int i = 0; i < num_bands; i++) {
-////            if (!conv_band[i]) {
-////                if (evp_solver.solve(iter, 1, &A(0, 0, i), A.ld(), &B(0, 0, i), B.ld(), &ev[0], &V(0, i), V.ld()) == 0) {
-////                    /* zero phi */
-////                    std::memset(&(*phi[iter]).pw_coeffs().prime(0, i), 0, kp__->num_gkvec_loc() * sizeof(double_complex));
-////                    /* zero residual */
-////                    std::memset(&(*res[iter]).pw_coeffs().prime(0, i), 0, kp__->num_gkvec_loc() * sizeof(double_complex));
-////                    /* make linear combinations */
-////                    for (int i1 = 0; i1 < iter; i1++) {
-////                        for (int igk = 0; igk < kp__->num_gkvec_loc(); igk++) {
-////                            (*phi[iter]).pw_coeffs().prime(igk, i) += (*phi[i1]).pw_coeffs().prime(igk, i) * V(i1, i);
-////                            (*res[iter]).pw_coeffs().prime(igk, i) += (*res[i1]).pw_coeffs().prime(igk, i) * V(i1, i);
-////                        }
-////                    }
-////                    last[i] = iter;
-////                } else {
-////                    conv_band[i] = true;
-////                }
-////            }
-////        }
-////        t2.stop();
-////
-////        //apply_preconditioner(lambda, *res[iter], 1.0, *phi[iter]);
-////        STOP();
-////
-////        apply_h_o();
-////
-////        eval_old = eval;
-////
-////        update_res(res_norm, eval);
-////
-////        for (int i = 0; i < num_bands; i++) {
-////            if (!conv_band[i]) {
-////                if (res_norm[i] < itso.residual_tolerance_) {
-////                    conv_band[i] = true;
-////                }
-////                //if (kp__->band_occupancy(i) <= 1e-2) {
-////                //    conv_band[i] = true;
-////                //}
-////                //if (kp__->band_occupancy(i) > 1e-2 && std::abs(eval[i] - eval_old[i]) < tol) {
-////                //    conv_band[i] = true;
-////                //}
-////                //if (kp__->band_occupancy(i) > 1e-2 && res_norm[i] < itso.residual_tolerance_) {
-////                //    conv_band[i] = true;
-////                //}
-////                //if (kp__->band_occupancy(i) <= 1e-2 ||
-////                //    res_norm[i] / res_norm_start[i] < 0.7 ||
-////                //    (kp__->band_occupancy(i) > 1e-2 && std::abs(eval[i] - eval_old[i]) < tol)) {
-////                //    conv_band[i] = true;
-////                //}
-////            }
-////        }
-////        if (std::all_of(conv_band.begin(), conv_band.end(), [](bool e){return e;})) {
-////            std::cout << "early exit from the diis loop" << std::endl;
-////            break;
-////        }
-////    }
-////
-////    #pragma omp parallel for
-////    for (int i = 0; i < num_bands; i++) {
-////        std::memcpy(&phi_tmp.pw_coeffs().prime(0, i),  &(*phi[last[i]]).pw_coeffs().prime(0, i),  kp__->num_gkvec_loc() * sizeof(double_complex));
-////        std::memcpy(&hphi_tmp.pw_coeffs().prime(0, i), &(*hphi[last[i]]).pw_coeffs().prime(0, i), kp__->num_gkvec_loc() * sizeof(double_complex));
-////        std::memcpy(&ophi_tmp.pw_coeffs().prime(0, i), &(*ophi[last[i]]).pw_coeffs().prime(0, i), kp__->num_gkvec_loc() * sizeof(double_complex));
-////    }
-////    orthogonalize<T>(0, num_bands, phi_tmp, hphi_tmp, ophi_tmp, ovlp, *res[0]);
-////
-////    /* setup eigen-value problem
-////     * N is the number of previous basis functions
-////     * n is the number of new basis functions */
-////    set_subspace_mtrx(0, num_bands, 0, phi_tmp, hphi_tmp, hmlt, hmlt_old);
-////
-////    if (std_evp_solver().solve(num_bands, num_bands, hmlt.template at<CPU>(), hmlt.ld(),
-////                               eval.data(), evec.template at<CPU>(), evec.ld(),
-////                               hmlt.num_rows_local(), hmlt.num_cols_local())) {
-////        std::stringstream s;
-////        s << "error in diagonalziation";
-////        TERMINATE(s);
-////    }
-////
-////    /* recompute wave-functions */
-////    /* \Psi_{i} = \sum_{mu} \phi_{mu} * Z_{mu, i} */
-////    transform<T>(phi_tmp, 0, num_bands, evec, 0, 0, psi, 0, num_bands);
-////
-////    for (int j = 0; j < ctx_.num_fv_states(); j++) {
-////        kp__->band_energy(j + ispn__ * ctx_.num_fv_states()) = eval[j];
-////    }
-////
-////    for (int i = 0; i < niter; i++) {
-////        delete phi[i];
-////        delete res[i];
-////        delete hphi[i];
-////        delete ophi[i];
-////    }
-//}
+/// Upper bound of the Hamiltonian spectrum from a few Lanczos steps.
+/** The largest eigen-value \f$ \theta_{max} \f$ of the \f$ k \times k \f$ Lanczos tridiagonal matrix is computed by
+ *  bisection and the bound is estimated as \f$ \theta_{max} + |\beta_{k}| \f$.
+ */
+template <typename T>
+static double
+upper_spectral_bound(Simulation_context& ctx__, Hamiltonian_k& Hk__, int ispn__, int num_steps__)
+{
+    PROFILE("sirius::upper_spectral_bound");
+
+    auto& kp = Hk__.kp();
+
+    const bool nc_mag = (ctx__.num_mag_dims() == 3);
+    const int num_sc  = nc_mag ? 2 : 1;
+    auto spins        = spin_range(nc_mag ? 2 : ispn__);
+
+    auto& mp = ctx__.mem_pool(ctx__.host_memory_t());
+
+    /* current and previous Lanczos vectors */
+    Wave_functions v(mp, kp.gkvec_partition(), 2, memory_t::host, num_sc);
+    Wave_functions hv(mp, kp.gkvec_partition(), 1, memory_t::host, num_sc);
+
+    /* random starting vector */
+    for (int ispn = 0; ispn < num_sc; ispn++) {
+        for (int igk_loc = 0; igk_loc < kp.num_gkvec_loc(); igk_loc++) {
+            v.pw_coeffs(ispn).prime(igk_loc, 0) = utils::random<double>() - 0.5;
+            v.pw_coeffs(ispn).prime(igk_loc, 1) = 0;
+        }
+    }
+    v.normalize(device_t::CPU, spins, 1);
+
+    dmatrix<T> a(1, 1);
+
+    std::vector<double> alpha;
+    std::vector<double> beta;
+    for (int j = 0; j < num_steps__; j++) {
+        Hk__.apply_h_s<T>(spins, 0, 1, v, &hv, nullptr);
+        inner(memory_t::host, ctx__.blas_linalg_t(), nc_mag ? 2 : 0, v, 0, 1, hv, 0, 1, a, 0, 0);
+        alpha.push_back(std::real(a(0, 0)));
+
+        /* w = H v_j - alpha_j v_j - beta_j v_{j-1} */
+        double b = (j == 0) ? 0 : beta.back();
+        for (int ispn : spins) {
+            #pragma omp parallel for schedule(static)
+            for (int igk_loc = 0; igk_loc < kp.num_gkvec_loc(); igk_loc++) {
+                auto w = hv.pw_coeffs(ispn).prime(igk_loc, 0) - alpha.back() * v.pw_coeffs(ispn).prime(igk_loc, 0) -
+                         b * v.pw_coeffs(ispn).prime(igk_loc, 1);
+                v.pw_coeffs(ispn).prime(igk_loc, 1) = v.pw_coeffs(ispn).prime(igk_loc, 0);
+                v.pw_coeffs(ispn).prime(igk_loc, 0) = w;
+            }
+        }
+        beta.push_back(v.l2norm(device_t::CPU, spins, 1)[0]);
+        if (beta.back() < 1e-10) {
+            break;
+        }
+        for (int ispn : spins) {
+            for (int igk_loc = 0; igk_loc < kp.num_gkvec_loc(); igk_loc++) {
+                v.pw_coeffs(ispn).prime(igk_loc, 0) /= beta.back();
+            }
+        }
+    }
+    int n = static_cast<int>(alpha.size());
+
+    /* Gershgorin interval of the tridiagonal matrix */
+    double lo{1e100};
+    double hi{-1e100};
+    for (int i = 0; i < n; i++) {
+        double r = ((i > 0) ? beta[i - 1] : 0) + ((i < n - 1) ? beta[i] : 0);
+        lo = std::min(lo, alpha[i] - r);
+        hi = std::max(hi, alpha[i] + r);
+    }
+    /* number of eigen-values smaller than x (Sturm sequence) */
+    auto count = [&](double x) {
+        int cnt{0};
+        double d{1};
+        for (int i = 0; i < n; i++) {
+            d = alpha[i] - x - ((i > 0) ? std::pow(beta[i - 1], 2) / d : 0);
+            if (std::abs(d) < 1e-300) {
+                d = -1e-300;
+            }
+            if (d < 0) {
+                cnt++;
+            }
+        }
+        return cnt;
+    };
+    /* bisection for the largest eigen-value */
+    while (hi - lo > 1e-8 * std::max(1.0, std::abs(hi))) {
+        double x = 0.5 * (lo + hi);
+        if (count(x) == n) {
+            hi = x;
+        } else {
+            lo = x;
+        }
+    }
+    return hi + beta.back();
+}
+
+/// Compute y_j = alpha * (hx_j - c_j x_j) + beta * y_j for the first n wave-functions.
+static void
+chebyshev_axpy(spin_range spins__, int n__, double alpha__, std::vector<double> const& c__, Wave_functions& hx__,
+               Wave_functions& x__, double beta__, Wave_functions& y__)
+{
+    for (int ispn : spins__) {
+        int ngk = x__.pw_coeffs(ispn).num_rows_loc();
+        #pragma omp parallel for schedule(static)
+        for (int i = 0; i < n__; i++) {
+            for (int ig = 0; ig < ngk; ig++) {
+                auto z = alpha__ * (hx__.pw_coeffs(ispn).prime(ig, i) - c__[i] * x__.pw_coeffs(ispn).prime(ig, i));
+                if (beta__ != 0) {
+                    z += beta__ * y__.pw_coeffs(ispn).prime(ig, i);
+                }
+                y__.pw_coeffs(ispn).prime(ig, i) = z;
+            }
+        }
+    }
+}
+
+template <typename T>
+int
+Band::diag_pseudo_potential_chebyshev(Hamiltonian_k& Hk__) const
+{
+    PROFILE("sirius::Band::diag_pseudo_potential_chebyshev");
+
+    auto& kp = Hk__.kp();
+
+    auto& itso = ctx_.iterative_solver_input();
+
+    if (unit_cell_.augment()) {
+        throw std::runtime_error("[sirius::Band::diag_pseudo_potential_chebyshev] generalized eigen-value problem "
+                                 "(ultrasoft or PAW pseudopotentials) is not supported");
+    }
+    if (is_device_memory(ctx_.preferred_memory_t())) {
+        throw std::runtime_error("[sirius::Band::diag_pseudo_potential_chebyshev] only host memory is supported");
+    }
+
+    /* true if this is a non-collinear case */
+    const bool nc_mag = (ctx_.num_mag_dims() == 3);
+
+    const int num_sc = nc_mag ? 2 : 1;
+
+    const int num_bands = ctx_.num_bands();
+
+    /* buffer states above the wanted bands; the largest Ritz value of the buffer is the lower bound of the damped
+       part of the spectrum */
+    const int nb = std::min(num_bands + std::max(4, num_bands / 10), kp.num_gkvec());
+
+    auto& psi = kp.spinor_wave_functions();
+
+    auto& mp = ctx_.mem_pool(ctx_.host_memory_t());
+
+    auto mem = memory_t::host;
+    auto la  = ctx_.blas_linalg_t();
+
+    Wave_functions phi(mp, kp.gkvec_partition(), nb, mem, num_sc);
+    Wave_functions hphi(mp, kp.gkvec_partition(), nb, mem, num_sc);
+    Wave_functions x(mp, kp.gkvec_partition(), nb, mem, num_sc);
+    Wave_functions hx(mp, kp.gkvec_partition(), nb, mem, num_sc);
+
+    const int bs = ctx_.cyclic_block_size();
+    dmatrix<T> hmlt(nb, nb, ctx_.blacs_grid(), bs, bs, mp);
+    dmatrix<T> ovlp(nb, nb, ctx_.blacs_grid(), bs, bs, mp);
+    dmatrix<T> evec(nb, nb, ctx_.blacs_grid(), bs, bs, mp);
+
+    auto& std_solver = ctx_.std_evp_solver();
+
+    /* number of Lanczos steps for the upper bound of the spectrum */
+    const int num_lanczos_steps{8};
+
+    int niter{0};
+
+    for (int ispin_step = 0; ispin_step < ctx_.num_spin_dims(); ispin_step++) {
+        auto spins = spin_range(nc_mag ? 2 : ispin_step);
+
+        mdarray<double, 1> eval(nb);
+        mdarray<double, 1> eval_old(nb);
+        eval_old = [](){return 1e10;};
+        if (itso.init_eval_old_) {
+            for (int j = 0; j < num_bands; j++) {
+                eval_old[j] = kp.band_energy(j, ispin_step);
+            }
+        }
+
+        /* starting subspace: current wave-functions and smooth random buffer states */
+        for (int ispn = 0; ispn < num_sc; ispn++) {
+            phi.copy_from(psi, num_bands, nc_mag ? ispn : ispin_step, 0, ispn, 0);
+            for (int i = num_bands; i < nb; i++) {
+                for (int igk_loc = 0; igk_loc < kp.num_gkvec_loc(); igk_loc++) {
+                    int igk = kp.idxgk(igk_loc);
+                    double gk = kp.gkvec().gkvec_cart<index_domain_t::global>(igk).length();
+                    phi.pw_coeffs(ispn).prime(igk_loc, i) = (utils::random<double>() - 0.5) / (1 + gk * gk);
+                }
+            }
+        }
+
+        double b_up = upper_spectral_bound<T>(ctx_, Hk__, ispin_step, num_lanczos_steps);
+
+        Hk__.apply_h_s<T>(spins, 0, nb, phi, &hphi, nullptr);
+        orthogonalize<T>(mem, la, nc_mag ? 2 : 0, phi, hphi, 0, nb, ovlp, x);
+
+        int degree = itso.chebyshev_degree_;
+
+        for (int k = 0; k < itso.num_steps_; k++) {
+            /* Rayleigh-Ritz step */
+            set_subspace_mtrx(0, nb, 0, phi, hphi, hmlt);
+            if (std_solver.solve(nb, nb, hmlt, &eval[0], evec)) {
+                std::stringstream s;
+                s << "error in diagonalization";
+                TERMINATE(s);
+            }
+            ctx_.evp_work_count(std::pow(static_cast<double>(nb) / num_bands, 3));
+            niter++;
+
+            /* Ritz vectors and H applied to them */
+            transform<T>(mem, la, nc_mag ? 2 : ispin_step, {&phi, &hphi}, 0, nb, evec, 0, 0, {&x, &hx}, 0, nb);
+
+            /* residuals R_j = H x_j - e_j x_j */
+            std::vector<double> e(&eval[0], &eval[0] + nb);
+            chebyshev_axpy(spins, num_bands, 1.0, e, hx, x, 0.0, phi);
+            auto res_norm = phi.l2norm(device_t::CPU, spins, num_bands);
+
+            /* estimated reduction of the error, which is required to converge each band */
+            std::vector<double> err(num_bands, 0);
+            for (int j = 0; j < num_bands; j++) {
+                if (itso.converge_by_energy_) {
+                    double tol = ctx_.iterative_solver_tolerance();
+                    if (std::abs(kp.band_occupancy(j, ispin_step)) < ctx_.min_occupancy() * ctx_.max_occupancy()) {
+                        tol += std::max(tol * ctx_.settings().itsol_tol_ratio_, itso.empty_states_tolerance_);
+                    }
+                    double de = std::abs(eval[j] - eval_old[j]);
+                    err[j] = (de > tol) ? std::sqrt(de / tol) : 0;
+                } else {
+                    err[j] = (res_norm[j] > itso.residual_tolerance_) ? res_norm[j] / itso.residual_tolerance_ : 0;
+                }
+            }
+            int num_unconverged = static_cast<int>(std::count_if(err.begin(), err.end(), [](double r){return r > 0;}));
+            for (int j = 0; j < nb; j++) {
+                eval_old[j] = eval[j];
+            }
+
+            kp.message(3, __function_name__, "step: %i, filter degree: %i, unconverged: %i\n", k, degree,
+                       num_unconverged);
+
+            bool last_iteration = (k == itso.num_steps_ - 1);
+
+            if (num_unconverged <= itso.min_num_res_ || last_iteration) {
+                for (int ispn = 0; ispn < num_sc; ispn++) {
+                    psi.copy_from(x, num_bands, ispn, 0, nc_mag ? ispn : ispin_step, 0);
+                }
+                for (int j = 0; j < num_bands; j++) {
+                    kp.band_energy(j, ispin_step, eval[j]);
+                }
+                if (last_iteration && num_unconverged > itso.min_num_res_) {
+                    std::stringstream s;
+                    s << "[sirius::Band::diag_pseudo_potential_chebyshev] maximum number of iterations reached, but "
+                      << num_unconverged << " band(s) did not converge for k-point " << kp.vk();
+                    WARNING(s);
+                }
+                break;
+            }
+
+            /* filter interval [a, b] is damped, the spectrum below a is amplified */
+            double a  = eval[nb - 1];
+            double a0 = eval[0];
+            double b  = std::max(b_up, a + 1e-3);
+            double ec = 0.5 * (b - a);
+            double c  = 0.5 * (b + a);
+
+            /* adapt the degree of the filter: T_m((e_j - c) / ec) must reduce the error of the slowest band */
+            int m{0};
+            for (int j = 0; j < num_bands; j++) {
+                if (err[j] > 0) {
+                    double t = std::abs(eval[j] - c) / ec;
+                    if (t > 1 + 1e-12) {
+                        m = std::max(m, static_cast<int>(std::ceil(std::acosh(std::max(err[j], 1.0)) / std::acosh(t))));
+                    } else {
+                        m = itso.chebyshev_max_degree_;
+                    }
+                }
+            }
+            degree = std::min(std::max(m, itso.chebyshev_degree_), itso.chebyshev_max_degree_);
+
+            /* scaled Chebyshev filter */
+            std::vector<double> cv(nb, c);
+            double sigma = ec / (a0 - c);
+            double tau   = 2 / sigma;
+
+            Wave_functions* x0 = &x;
+            Wave_functions* x1 = &phi;
+            /* x1 = (H x0 - c x0) * sigma / ec */
+            chebyshev_axpy(spins, nb, sigma / ec, cv, hx, *x0, 0.0, *x1);
+            for (int i = 2; i <= degree; i++) {
+                double sigma1 = 1.0 / (tau - sigma);
+                Hk__.apply_h_s<T>(spins, 0, nb, *x1, &hphi, nullptr);
+                /* x2 = (H x1 - c x1) * 2 sigma1 / ec - sigma sigma1 x0; x2 is stored in place of x0 */
+                chebyshev_axpy(spins, nb, 2 * sigma1 / ec, cv, hphi, *x1, -sigma * sigma1, *x0);
+                std::swap(x0, x1);
+                sigma = sigma1;
+            }
+            if (x1 != &phi) {
+                for (int ispn = 0; ispn < num_sc; ispn++) {
+                    phi.copy_from(*x1, nb, ispn, 0, ispn, 0);
+                }
+            }
+
+            /* new subspace */
+            phi.normalize(device_t::CPU, spins, nb);
+            Hk__.apply_h_s<T>(spins, 0, nb, phi, &hphi, nullptr);
+            orthogonalize<T>(mem, la, nc_mag ? 2 : 0, phi, hphi, 0, nb, ovlp, x);
+        }
+    }
+
+    return niter;
+}
+
+/// Inner products \f$ \langle a_i | b_i \rangle \f$ of the matching columns of two sets of wave-functions.
+template <typename T>
+static std::vector<double_complex>
+inner_diag(spin_range spins__, std::vector<int> const& idx__, Wave_functions& a__, Wave_functions& b__)
+{
+    std::vector<double_complex> result(idx__.size(), 0);
+    for (int ispn : spins__) {
+        int ngk = a__.pw_coeffs(ispn).num_rows_loc();
+        #pragma omp parallel for schedule(static)
+        for (int k = 0; k < static_cast<int>(idx__.size()); k++) {
+            int i = idx__[k];
+            double_complex z(0, 0);
+            for (int ig = 0; ig < ngk; ig++) {
+                z += std::conj(a__.pw_coeffs(ispn).prime(ig, i)) * b__.pw_coeffs(ispn).prime(ig, i);
+            }
+            /* reduced set of G-vectors: account for the -G half */
+            if (std::is_same<T, double>::value) {
+                z = 2 * z.real();
+                if (a__.comm().rank() == 0) {
+                    z -= std::real(std::conj(a__.pw_coeffs(ispn).prime(0, i)) * b__.pw_coeffs(ispn).prime(0, i));
+                }
+            }
+            result[k] += z;
+        }
+    }
+    a__.comm().allreduce(result);
+    return result;
+}
+
+/// Compute \f$ y_i = \alpha_i x_i + \beta y_i \f$ for the listed columns.
+static void
+axpby_diag(spin_range spins__, std::vector<int> const& idx__, std::vector<double_complex> const& alpha__,
+           Wave_functions& x__, double beta__, Wave_functions& y__)
+{
+    for (int ispn : spins__) {
+        int ngk = x__.pw_coeffs(ispn).num_rows_loc();
+        #pragma omp parallel for schedule(static)
+        for (int k = 0; k < static_cast<int>(idx__.size()); k++) {
+            int i = idx__[k];
+            for (int ig = 0; ig < ngk; ig++) {
+                auto z = alpha__[k] * x__.pw_coeffs(ispn).prime(ig, i);
+                if (beta__ != 0) {
+                    z += beta__ * y__.pw_coeffs(ispn).prime(ig, i);
+                }
+                y__.pw_coeffs(ispn).prime(ig, i) = z;
+            }
+        }
+    }
+}
+
+/// Solve the DIIS equations for the coefficients which minimise the norm of the combined residual.
+/** The coefficients minimise \f$ \sum_{jk} \alpha_j^{*} A_{jk} \alpha_k \f$ subject to \f$ \sum_j \alpha_j = 1 \f$.
+ *  If LAPACK reports a singular system, the last vector is taken. */
+static std::vector<double_complex>
+diis_coefficients(mdarray<double_complex, 2> const& A__, int n__)
+{
+    /* augmented system */
+    int m = n__ + 1;
+    mdarray<double_complex, 2> a(m, m);
+    std::vector<double_complex> x(m, 0);
+    a.zero();
+    /* scale to improve the condition number */
+    double s = std::abs(A__(n__ - 1, n__ - 1));
+    s = (s > 0) ? 1.0 / s : 1.0;
+    for (int j = 0; j < n__; j++) {
+        for (int k = 0; k < n__; k++) {
+            a(j, k) = A__(j, k) * s;
+        }
+        a(j, n__) = a(n__, j) = 1;
+    }
+    x[n__] = 1;
+    if (linalg(linalg_t::lapack).gesv<double_complex>(m, 1, a.at(memory_t::host), m, x.data(), m)) {
+        std::vector<double_complex> c(n__, 0);
+        c[n__ - 1] = 1;
+        return c;
+    }
+    return std::vector<double_complex>(x.begin(), x.begin() + n__);
+}
+
+template <typename T>
+int
+Band::diag_pseudo_potential_rmm_diis(Hamiltonian_k& Hk__) const
+{
+    auto& itso = ctx_.iterative_solver_input();
+
+    /* RMM-DIIS converges to the eigen-state closest to the starting vector; Davidson solver is used until the
+       wave-functions are good enough */
+    if (ctx_.iterative_solver_tolerance() > itso.rmm_diis_switch_tolerance_) {
+        return diag_pseudo_potential_davidson<T>(Hk__);
+    }
+
+    PROFILE("sirius::Band::diag_pseudo_potential_rmm_diis");
+
+    if (is_device_memory(ctx_.preferred_memory_t())) {
+        throw std::runtime_error("[sirius::Band::diag_pseudo_potential_rmm_diis] only host memory is supported");
+    }
+
+    auto& kp = Hk__.kp();
+
+    /* true if this is a non-collinear case */
+    const bool nc_mag = (ctx_.num_mag_dims() == 3);
+
+    const int num_sc = nc_mag ? 2 : 1;
+
+    const int num_bands = ctx_.num_bands();
+
+    /* maximum number of refinement steps for each band */
+    const int num_steps = itso.rmm_diis_num_steps_;
+
+    /* number of bands refined simultaneously */
+    const int block_size = std::min(itso.rmm_diis_block_size_, num_bands);
+
+    auto& psi = kp.spinor_wave_functions();
+
+    auto& mp = ctx_.mem_pool(ctx_.host_memory_t());
+
+    auto mem = memory_t::host;
+    auto la  = ctx_.blas_linalg_t();
+
+    auto new_wf = [&](int n) {
+        return std::unique_ptr<Wave_functions>(new Wave_functions(mp, kp.gkvec_partition(), n, mem, num_sc));
+    };
+
+    Wave_functions phi(mp, kp.gkvec_partition(), num_bands, mem, num_sc);
+    Wave_functions hphi(mp, kp.gkvec_partition(), num_bands, mem, num_sc);
+    Wave_functions sphi(mp, kp.gkvec_partition(), num_bands, mem, num_sc);
+    Wave_functions x(mp, kp.gkvec_partition(), num_bands, mem, num_sc);
+    Wave_functions hx(mp, kp.gkvec_partition(), num_bands, mem, num_sc);
+    Wave_functions sx(mp, kp.gkvec_partition(), num_bands, mem, num_sc);
+    Wave_functions res(mp, kp.gkvec_partition(), num_bands, mem, num_sc);
+
+    /* history of trial vectors, S applied to them and their residuals for a block of bands */
+    std::vector<std::unique_ptr<Wave_functions>> phi_h;
+    std::vector<std::unique_ptr<Wave_functions>> sphi_h;
+    std::vector<std::unique_ptr<Wave_functions>> res_h;
+    for (int i = 0; i <= num_steps; i++) {
+        phi_h.push_back(new_wf(block_size));
+        sphi_h.push_back(new_wf(block_size));
+        res_h.push_back(new_wf(block_size));
+    }
+    /* DIIS-optimal vector of the current step, H and S applied to it and its residual */
+    auto opt  = new_wf(block_size);
+    auto hopt = new_wf(block_size);
+    auto sopt = new_wf(block_size);
+    auto ropt = new_wf(block_size);
+    /* preconditioned residual (correction vector), H and S applied to it */
+    auto p  = new_wf(block_size);
+    auto hp = new_wf(block_size);
+    auto sp = new_wf(block_size);
+    /* contiguous storage of the correction vectors for the batched application of H and S */
+    auto pc  = new_wf(block_size);
+    auto hpc = new_wf(block_size);
+    auto spc = new_wf(block_size);
+
+    const int bs = ctx_.cyclic_block_size();
+    dmatrix<T> hmlt(num_bands, num_bands, ctx_.blacs_grid(), bs, bs, mp);
+    dmatrix<T> ovlp(num_bands, num_bands, ctx_.blacs_grid(), bs, bs, mp);
+    dmatrix<T> evec(num_bands, num_bands, ctx_.blacs_grid(), bs, bs, mp);
+
+    auto& std_solver = ctx_.std_evp_solver();
+
+    /* get diagonal elements for preconditioning */
+    auto h_o_diag = Hk__.get_h_o_diag_pw<T, 3>();
+
+    /* Rayleigh-Ritz step in the subspace of wave-functions; input wave-functions are S-orthonormalized in place */
+    auto rayleigh_ritz = [&](int ispn__, Wave_functions& phi__, Wave_functions& hphi__, Wave_functions& sphi__,
+                             Wave_functions& psi__, Wave_functions& hpsi__, Wave_functions& spsi__,
+                             mdarray<double, 1>& eval__) {
+        orthogonalize<T>(mem, la, nc_mag ? 2 : 0, phi__, hphi__, sphi__, 0, num_bands, ovlp, res);
+        set_subspace_mtrx(0, num_bands, 0, phi__, hphi__, hmlt);
+        if (std_solver.solve(num_bands, num_bands, hmlt, &eval__[0], evec)) {
+            std::stringstream s;
+            s << "error in diagonalization";
+            TERMINATE(s);
+        }
+        ctx_.evp_work_count(1);
+        transform<T>(mem, la, nc_mag ? 2 : ispn__, {&phi__, &hphi__, &sphi__}, 0, num_bands, evec, 0, 0,
+                     {&psi__, &hpsi__, &spsi__}, 0, num_bands);
+    };
+
+    /* copy single columns between the full set of bands and the block storage */
+    auto copy_column = [&](Wave_functions& src__, int i__, Wave_functions& dest__, int j__) {
+        for (int ispn = 0; ispn < num_sc; ispn++) {
+            dest__.copy_from(src__, 1, ispn, i__, ispn, j__);
+        }
+    };
+
+    int niter{0};
+
+    for (int ispin_step = 0; ispin_step < ctx_.num_spin_dims(); ispin_step++) {
+        auto spins = spin_range(nc_mag ? 2 : ispin_step);
+
+        /* tolerance for the eigen-energy difference */
+        auto energy_tol = [&](int j) {
+            double tol = ctx_.iterative_solver_tolerance();
+            if (std::abs(kp.band_occupancy(j, ispin_step)) < ctx_.min_occupancy() * ctx_.max_occupancy()) {
+                tol += std::max(tol * ctx_.settings().itsol_tol_ratio_, itso.empty_states_tolerance_);
+            }
+            return tol;
+        };
+
+        std::vector<double> eval_old(num_bands);
+        for (int j = 0; j < num_bands; j++) {
+            eval_old[j] = kp.band_energy(j, ispin_step);
+        }
+
+        for (int ispn = 0; ispn < num_sc; ispn++) {
+            phi.copy_from(psi, num_bands, nc_mag ? ispn : ispin_step, 0, ispn, 0);
+        }
+        Hk__.apply_h_s<T>(spins, 0, num_bands, phi, &hphi, &sphi);
+
+        /* subspace rotation of the starting wave-functions */
+        mdarray<double, 1> eval(num_bands);
+        rayleigh_ritz(ispin_step, phi, hphi, sphi, x, hx, sx, eval);
+
+        /* residuals of the Ritz vectors */
+        std::vector<int> all_bands(num_bands);
+        std::iota(all_bands.begin(), all_bands.end(), 0);
+        std::vector<double_complex> e(&eval[0], &eval[0] + num_bands);
+        for (auto& z : e) {
+            z = -z;
+        }
+        axpby_diag(spins, all_bands, std::vector<double_complex>(num_bands, 1), hx, 0, res);
+        axpby_diag(spins, all_bands, e, sx, 1, res);
+        auto rr = inner_diag<T>(spins, all_bands, res, res);
+
+        std::vector<int> unconverged;
+        for (int j = 0; j < num_bands; j++) {
+            bool conv = (itso.converge_by_energy_) ? std::abs(eval[j] - eval_old[j]) <= energy_tol(j)
+                                                   : std::sqrt(rr[j].real()) <= itso.residual_tolerance_;
+            if (!conv) {
+                unconverged.push_back(j);
+            }
+        }
+        kp.message(3, __function_name__, "number of unconverged bands: %i\n", static_cast<int>(unconverged.size()));
+
+        /* refine unconverged bands in blocks */
+        for (int ib0 = 0; ib0 < static_cast<int>(unconverged.size()); ib0 += block_size) {
+            int nb = std::min(block_size, static_cast<int>(unconverged.size()) - ib0);
+
+            std::vector<int> active(nb);
+            std::iota(active.begin(), active.end(), 0);
+
+            /* starting vectors */
+            std::vector<double> eopt(nb);
+            mdarray<double, 2> eps(num_steps + 1, nb);
+            for (int b = 0; b < nb; b++) {
+                int j = unconverged[ib0 + b];
+                copy_column(x, j, *phi_h[0], b);
+                copy_column(sx, j, *sphi_h[0], b);
+                copy_column(res, j, *res_h[0], b);
+                copy_column(x, j, *opt, b);
+                copy_column(hx, j, *hopt, b);
+                copy_column(sx, j, *sopt, b);
+                copy_column(res, j, *ropt, b);
+                eps(0, b) = eopt[b] = eval[j];
+            }
+            std::vector<double> lambda(nb, 0);
+
+            for (int m = 1; m <= num_steps && active.size(); m++) {
+                int na = static_cast<int>(active.size());
+
+                /* preconditioned residuals */
+                for (int ispn : spins) {
+                    #pragma omp parallel for schedule(static)
+                    for (int k = 0; k < na; k++) {
+                        int b = active[k];
+                        for (int ig = 0; ig < p->pw_coeffs(ispn).num_rows_loc(); ig++) {
+                            double d = h_o_diag.first(ig, ispn) - h_o_diag.second(ig, ispn) * eopt[b];
+                            d = 0.5 * (1 + d + std::sqrt(1 + (d - 1) * (d - 1)));
+                            p->pw_coeffs(ispn).prime(ig, b) = ropt->pw_coeffs(ispn).prime(ig, b) / d;
+                        }
+                    }
+                }
+                /* apply H and S to the active correction vectors only */
+                for (int k = 0; k < na; k++) {
+                    copy_column(*p, active[k], *pc, k);
+                }
+                Hk__.apply_h_s<T>(spins, 0, na, *pc, hpc.get(), spc.get());
+                for (int k = 0; k < na; k++) {
+                    copy_column(*hpc, k, *hp, active[k]);
+                    copy_column(*spc, k, *sp, active[k]);
+                }
+
+                if (m == 1) {
+                    /* step length which minimises the Rayleigh quotient along the correction vector */
+                    auto h00 = inner_diag<T>(spins, active, *opt, *hopt);
+                    auto h01 = inner_diag<T>(spins, active, *opt, *hp);
+                    auto h11 = inner_diag<T>(spins, active, *p, *hp);
+                    auto s00 = inner_diag<T>(spins, active, *opt, *sopt);
+                    auto s01 = inner_diag<T>(spins, active, *opt, *sp);
+                    auto s11 = inner_diag<T>(spins, active, *p, *sp);
+                    for (int k = 0; k < na; k++) {
+                        double a = h00[k].real();
+                        double b = h01[k].real();
+                        double c = h11[k].real();
+                        double d = s00[k].real();
+                        double e = s01[k].real();
+                        double f = s11[k].real();
+                        auto rq = [&](double l) { return (a + 2 * b * l + c * l * l) / (d + 2 * e * l + f * l * l); };
+                        /* stationary points of the Rayleigh quotient */
+                        double qa = c * e - b * f;
+                        double qb = c * d - a * f;
+                        double qc = b * d - a * e;
+                        double l{-0.3};
+                        double disc = qb * qb - 4 * qa * qc;
+                        if (std::abs(qa) > 1e-14 * std::abs(qb) && disc >= 0) {
+                            double l1 = (-qb + std::sqrt(disc)) / 2 / qa;
+                            double l2 = (-qb - std::sqrt(disc)) / 2 / qa;
+                            l = (rq(l1) < rq(l2)) ? l1 : l2;
+                        } else if (std::abs(qb) > 0) {
+                            l = -qc / qb;
+                        }
+                        lambda[active[k]] = l;
+                    }
+                }
+
+                /* new trial vectors phi_m = opt + lambda * p */
+                std::vector<double_complex> lam(na);
+                for (int k = 0; k < na; k++) {
+                    lam[k] = lambda[active[k]];
+                }
+                std::vector<double_complex> one(na, 1);
+                axpby_diag(spins, active, one, *opt, 0, *phi_h[m]);
+                axpby_diag(spins, active, lam, *p, 1, *phi_h[m]);
+                axpby_diag(spins, active, one, *sopt, 0, *sphi_h[m]);
+                axpby_diag(spins, active, lam, *sp, 1, *sphi_h[m]);
+                /* hp is overwritten by H applied to phi_m */
+                axpby_diag(spins, active, lam, *hp, 0, *hp);
+                axpby_diag(spins, active, one, *hopt, 1, *hp);
+
+                auto ph = inner_diag<T>(spins, active, *phi_h[m], *hp);
+                auto ps = inner_diag<T>(spins, active, *phi_h[m], *sphi_h[m]);
+                std::vector<double_complex> me(na);
+                for (int k = 0; k < na; k++) {
+                    eps(m, active[k]) = ph[k].real() / ps[k].real();
+                    me[k] = -eps(m, active[k]);
+                }
+                axpby_diag(spins, active, one, *hp, 0, *res_h[m]);
+                axpby_diag(spins, active, me, *sphi_h[m], 1, *res_h[m]);
+                auto rn = inner_diag<T>(spins, active, *res_h[m], *res_h[m]);
+
+                niter = std::max(niter, m);
+
+                /* store the converged bands and remove them from the active list */
+                std::vector<int> still_active;
+                for (int k = 0; k < na; k++) {
+                    int b = active[k];
+                    int j = unconverged[ib0 + b];
+                    bool conv = (itso.converge_by_energy_)
+                                    ? std::abs(eps(m, b) - eps(m - 1, b)) <= energy_tol(j)
+                                    : std::sqrt(rn[k].real()) <= itso.residual_tolerance_;
+                    if (conv || m == num_steps) {
+                        copy_column(*phi_h[m], b, x, j);
+                        copy_column(*hp, b, hx, j);
+                        copy_column(*sphi_h[m], b, sx, j);
+                    } else {
+                        still_active.push_back(b);
+                    }
+                }
+                active = still_active;
+                na = static_cast<int>(active.size());
+                if (!na) {
+                    break;
+                }
+
+                /* DIIS: combination of the trial vectors with the smallest residual */
+                mdarray<double_complex, 3> A(m + 1, m + 1, na);
+                for (int j1 = 0; j1 <= m; j1++) {
+                    for (int j2 = j1; j2 <= m; j2++) {
+                        auto a = inner_diag<T>(spins, active, *res_h[j1], *res_h[j2]);
+                        for (int k = 0; k < na; k++) {
+                            A(j1, j2, k) = a[k];
+                            A(j2, j1, k) = std::conj(a[k]);
+                        }
+                    }
+                }
+                mdarray<double_complex, 2> alpha(m + 1, na);
+                for (int k = 0; k < na; k++) {
+                    mdarray<double_complex, 2> a(&A(0, 0, k), m + 1, m + 1);
+                    auto c = diis_coefficients(a, m + 1);
+                    for (int j = 0; j <= m; j++) {
+                        alpha(j, k) = c[j];
+                    }
+                }
+                for (int j = 0; j <= m; j++) {
+                    std::vector<double_complex> c(na);
+                    std::vector<double_complex> ce(na);
+                    for (int k = 0; k < na; k++) {
+                        c[k]  = alpha(j, k);
+                        ce[k] = alpha(j, k) * eps(j, active[k]);
+                    }
+                    double beta = (j == 0) ? 0 : 1;
+                    axpby_diag(spins, active, c, *phi_h[j], beta, *opt);
+                    axpby_diag(spins, active, c, *sphi_h[j], beta, *sopt);
+                    axpby_diag(spins, active, c, *res_h[j], beta, *ropt);
+                    /* H phi_j = R_j + eps_j S phi_j */
+                    axpby_diag(spins, active, c, *res_h[j], beta, *hopt);
+                    axpby_diag(spins, active, ce, *sphi_h[j], 1, *hopt);
+                }
+                auto oh = inner_diag<T>(spins, active, *opt, *hopt);
+                auto os = inner_diag<T>(spins, active, *opt, *sopt);
+                for (int k = 0; k < na; k++) {
+                    eopt[active[k]] = oh[k].real() / os[k].real();
+                }
+            }
+        }
+
+        if (unconverged.size()) {
+            /* orthonormalize refined bands and rotate in their subspace */
+            rayleigh_ritz(ispin_step, x, hx, sx, phi, hphi, sphi, eval);
+            for (int ispn = 0; ispn < num_sc; ispn++) {
+                psi.copy_from(phi, num_bands, ispn, 0, nc_mag ? ispn : ispin_step, 0);
+            }
+        } else {
+            for (int ispn = 0; ispn < num_sc; ispn++) {
+                psi.copy_from(x, num_bands, ispn, 0, nc_mag ? ispn : ispin_step, 0);
+            }
+        }
+        for (int j = 0; j < num_bands; j++) {
+            kp.band_energy(j, ispin_step, eval[j]);
+        }
+    }
+
+    return niter;
+}
 
 template
 mdarray<double, 1>
@@ -1600,4 +1686,20 @@ template
 int
 Band::diag_pseudo_potential_davidson<double_complex>(Hamiltonian_k& Hk__) const;
 
+template
+int
+Band::diag_pseudo_potential_chebyshev<double>(Hamiltonian_k& Hk__) const;
+
+template
+int
+Band::diag_pseudo_potential_chebyshev<double_complex>(Hamiltonian_k& Hk__) const;
+
+template
+int
+Band::diag_pseudo_potential_rmm_diis<double>(Hamiltonian_k& Hk__) const;
+
+template
+int
+Band::diag_pseudo_potential_rmm_diis<double_complex>(Hamiltonian_k& Hk__) const;
+
 }
@@ -68,23 +68,10 @@ Band::solve_pseudo_potential(Hamiltonian_k& Hk__) const
         }
     } else if (itso.type_ == "davidson") {
         niter = diag_pseudo_potential_davidson<T>(Hk__);
-    //} else if (itso.type_ == "rmm-diis") {
-    //    if (ctx_.num_mag_dims() != 3) {
-    //        for (int ispn = 0; ispn < ctx_.num_spins(); ispn++) {
-    //            diag_pseudo_potential_rmm_diis<T>(&kp__, ispn, hamiltonian__);
-    //        }
-    //    } else {
-    //        STOP();
-    //    }
-    //} else if (itso.type_ == "chebyshev") {
-    //    P_operator<T> p_op(ctx_, kp__.p_mtrx());
-    //    if (ctx_.num_mag_dims() != 3) {
-    //        for (int ispn = 0; ispn < ctx_.num_spins(); ispn++) {
-    //            diag_pseudo_potential_chebyshev<T>(&kp__, ispn, hamiltonian__, p_op);
-    //        }
-    //    } else {
-    //        STOP();
-    //    }
+    } else if (itso.type_ == "rmm-diis") {
+        niter = diag_pseudo_potential_rmm_diis<T>(Hk__);
+    } else if (itso.type_ == "chebyshev") {
+        niter = diag_pseudo_potential_chebyshev<T>(Hk__);
     } else {
         TERMINATE("unknown iterative solver type");
     }
@@ -124,16 +111,22 @@ Band::solve(K_point_set& kset__, Hamiltonian0& H0__, bool precompute__) const
         int ik  = kset__.spl_num_kpoints(ikloc);
         auto kp = kset__[ik];
 
+        auto t0 = utils::time_now();
+
+        int niter{0};
         auto Hk = H0__(*kp);
         if (ctx_.full_potential()) {
             solve_full_potential(Hk);
         } else {
             if (ctx_.gamma_point() && (ctx_.so_correction() == false)) {
-                num_dav_iter += solve_pseudo_potential<double>(Hk);
+                niter = solve_pseudo_potential<double>(Hk);
             } else {
-                num_dav_iter += solve_pseudo_potential<double_complex>(Hk);
+                niter = solve_pseudo_potential<double_complex>(Hk);
             }
         }
+        num_dav_iter += niter;
+        /* store the cost of the k-point for the load balancing */
+        kset__.kpoint_cost(ik, utils::time_interval(t0), niter);
     }
     kset__.comm().allreduce(&num_dav_iter, 1);
     ctx_.num_itsol_steps(num_dav_iter);
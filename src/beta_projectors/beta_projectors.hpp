@@ -30,11 +30,74 @@
 namespace sirius {
 
 /// Stores <G+k | beta> expansion
+/** Plane-wave coefficients of the beta-projectors for the leading chunks of atoms are kept in a cache, the size of
+ *  which is limited by the control.beta_cache_size input parameter. Chunks that do not fit into the cache are
+ *  generated on the fly. On CPU the cache is filled once for the lifetime of the object; on GPU the cache is
+ *  allocated in device memory in prepare(), filled on the first request of a chunk and released in dismiss(), so
+ *  the chunks stay resident during all applications of the Hamiltonian for a given k-point. */
 class Beta_projectors : public Beta_projectors_base
 {
   protected:
     bool prepared_{false};
+    /// Cached plane-wave coefficients of beta-projectors for the leading chunks of atoms.
     matrix<double_complex> beta_pw_all_atoms_;
+    /// Buffer for the chunks which are generated on the fly.
+    matrix<double_complex> beta_pw_buf_;
+    /// Number of chunks stored in the cache.
+    int num_cached_chunks_{0};
+    /// True if the chunk is already generated in the cache.
+    std::vector<bool> is_cached_;
+    /// False if the coefficients of all chunks are generated on the fly.
+    bool use_cache_{true};
+
+    /// Maximum size of the cache in megabytes; negative value means no limit.
+    double cache_size() const
+    {
+        if (!use_cache_) {
+            return 0;
+        }
+        if (ctx_.control().beta_cache_size_ >= 0) {
+            return ctx_.control().beta_cache_size_;
+        }
+        if (ctx_.control().memory_usage_ == "low") {
+            return 0;
+        }
+        switch (ctx_.processing_unit()) {
+            case device_t::CPU: {
+                return -1;
+            }
+            case device_t::GPU: {
+                /* leave enough of device memory for the wave-functions and work arrays */
+                double f = (ctx_.control().memory_usage_ == "high") ? 0.5 : 0.25;
+                return f * acc::get_free_mem() / (1 << 20);
+            }
+        }
+        return 0;
+    }
+
+    /// Allocate the cache for the leading chunks which fit into the memory budget.
+    void allocate_cache(memory_pool* mp__)
+    {
+        double size = cache_size();
+        num_cached_chunks_ = 0;
+        for (int ichunk = 0; ichunk < num_chunks(); ichunk++) {
+            double sz = sizeof(double_complex) * double(num_gkvec_loc()) * (chunk(ichunk).offset_ + chunk(ichunk).num_beta_);
+            if (size >= 0 && sz > size * (1 << 20)) {
+                break;
+            }
+            num_cached_chunks_++;
+        }
+        if (num_cached_chunks_) {
+            int n = chunk(num_cached_chunks_ - 1).offset_ + chunk(num_cached_chunks_ - 1).num_beta_;
+            if (mp__) {
+                beta_pw_all_atoms_ = matrix<double_complex>(num_gkvec_loc(), n, *mp__);
+            } else {
+                beta_pw_all_atoms_ = matrix<double_complex>(num_gkvec_loc(), n);
+            }
+        }
+        is_cached_ = std::vector<bool>(num_cached_chunks_, false);
+    }
+
     /// Generate plane-wave coefficients for beta-projectors of atom types.
     void generate_pw_coefs_t(std::vector<int>& igk__)
     {
@@ -52,25 +115,36 @@ class Beta_projectors : public Beta_projectors_base
             z[l] = std::pow(double_complex(0, -1), l) * fourpi / std::sqrt(ctx_.unit_cell().omega());
         }
 
-        /* compute <G+k|beta> */
+        int lmax = ctx_.unit_cell().lmax();
+        int nrf  = ctx_.unit_cell().max_mt_radial_basis_size();
+
+        /* lengths of G+k vectors and real spherical harmonics */
+        std::vector<double> gk_len(num_gkvec_loc());
+        mdarray<double, 2> gkvec_rlm(utils::lmmax(lmax), num_gkvec_loc());
         #pragma omp parallel for
         for (int igkloc = 0; igkloc < num_gkvec_loc(); igkloc++) {
             int igk = igk__[igkloc];
             /* vs = {r, theta, phi} */
             auto vs = SHT::spherical_coordinates(gkvec_.gkvec_cart<index_domain_t::global>(igk));
-            /* compute real spherical harmonics for G+k vector */
-            std::vector<double> gkvec_rlm(utils::lmmax(ctx_.unit_cell().lmax()));
-            sf::spherical_harmonics(ctx_.unit_cell().lmax(), vs[1], vs[2], &gkvec_rlm[0]);
-            for (int iat = 0; iat < ctx_.unit_cell().num_atom_types(); iat++) {
-                auto& atom_type = ctx_.unit_cell().atom_type(iat);
-                /* get all values of radial integrals */
-                auto ri_val = beta_radial_integrals.values(iat, vs[0]);
+            gk_len[igkloc] = vs[0];
+            sf::spherical_harmonics(lmax, vs[1], vs[2], &gkvec_rlm(0, igkloc));
+        }
+
+        /* compute <G+k|beta> */
+        mdarray<double, 2> ri_val(nrf, num_gkvec_loc());
+        for (int iat = 0; iat < ctx_.unit_cell().num_atom_types(); iat++) {
+            auto& atom_type = ctx_.unit_cell().atom_type(iat);
+            /* get all values of radial integrals for all G+k vectors at once */
+            beta_radial_integrals.values(iat, num_gkvec_loc(), gk_len.data(), ri_val.at(memory_t::host), nrf);
+            #pragma omp parallel for
+            for (int igkloc = 0; igkloc < num_gkvec_loc(); igkloc++) {
                 for (int xi = 0; xi < atom_type.mt_basis_size(); xi++) {
                     int l     = atom_type.indexb(xi).l;
                     int lm    = atom_type.indexb(xi).lm;
                     int idxrf = atom_type.indexb(xi).idxrf;
 
-                    pw_coeffs_t_(igkloc, atom_type.offset_lo() + xi, 0) = z[l] * gkvec_rlm[lm] * ri_val(idxrf);
+                    pw_coeffs_t_(igkloc, atom_type.offset_lo() + xi, 0) =
+                        z[l] * gkvec_rlm(lm, igkloc) * ri_val(idxrf, igkloc);
                 }
             }
         }
@@ -86,8 +160,11 @@ class Beta_projectors : public Beta_projectors_base
     }
 
   public:
-    Beta_projectors(Simulation_context& ctx__, Gvec const& gkvec__, std::vector<int>& igk__)
+    /// Constructor.
+    /** If use_cache is false, no coefficients are kept between the requests of the chunks. */
+    Beta_projectors(Simulation_context& ctx__, Gvec const& gkvec__, std::vector<int>& igk__, bool use_cache__ = true)
         : Beta_projectors_base(ctx__, gkvec__, igk__, 1)
+        , use_cache_(use_cache__)
     {
         PROFILE("sirius::Beta_projectors");
         /* generate phase-factor independent projectors for atom types */
@@ -100,14 +177,20 @@ class Beta_projectors : public Beta_projectors_base
                 pw_coeffs_t_.allocate(memory_t::device).copy_to(memory_t::device);
                 break;
             }
-            /* generate beta projectors for all atoms */
+            /* generate beta projectors for all atoms that fit into the cache */
             case device_t::CPU: {
-                beta_pw_all_atoms_ = matrix<double_complex>(num_gkvec_loc(), ctx_.unit_cell().mt_lo_basis_size());
-                for (int ichunk = 0; ichunk < num_chunks(); ichunk++) {
+                allocate_cache(nullptr);
+                for (int ichunk = 0; ichunk < num_cached_chunks_; ichunk++) {
                     /* wrap the the pointer in the big array beta_pw_all_atoms */
                     pw_coeffs_a_ = matrix<double_complex>(&beta_pw_all_atoms_(0, chunk(ichunk).offset_),
                                                           num_gkvec_loc(), chunk(ichunk).num_beta_);
                     Beta_projectors_base::generate(ichunk, 0);
+                    is_cached_[ichunk] = true;
+                }
+                pw_coeffs_a_ = matrix<double_complex>();
+                if (num_cached_chunks_ < num_chunks()) {
+                    ctx_.message(2, __function_name__, "number of cached chunks of beta-projectors: %i out of %i\n",
+                                 num_cached_chunks_, num_chunks());
                 }
                 break;
             }
@@ -122,8 +205,12 @@ class Beta_projectors : public Beta_projectors_base
         switch (ctx_.processing_unit()) {
             case device_t::GPU: {
                 Beta_projectors_base::prepare();
+                /* keep the buffer for the chunks which are not cached */
+                beta_pw_buf_ = std::move(pw_coeffs_a_);
+                allocate_cache(&ctx_.mem_pool(memory_t::device));
                 break;
             }
+            /* buffer for the chunks which are not cached is allocated on the first request */
             case device_t::CPU: break;
         }
         prepared_ = true;
@@ -134,8 +221,13 @@ class Beta_projectors : public Beta_projectors_base
         if (!prepared_) {
             TERMINATE("beta projectors are already dismissed");
         }
+        pw_coeffs_a_ = matrix<double_complex>();
+        beta_pw_buf_ = matrix<double_complex>();
         switch (ctx_.processing_unit()) {
             case device_t::GPU: {
+                beta_pw_all_atoms_ = matrix<double_complex>();
+                is_cached_.clear();
+                num_cached_chunks_ = 0;
                 Beta_projectors_base::dismiss();
                 break;
             }
@@ -146,16 +238,44 @@ class Beta_projectors : public Beta_projectors_base
 
     void generate(int chunk__)
     {
-        switch (ctx_.processing_unit()) {
-            case device_t::CPU: {
-                pw_coeffs_a_ = matrix<double_complex>(&beta_pw_all_atoms_(0, chunk(chunk__).offset_),
-                                                      num_gkvec_loc(), chunk(chunk__).num_beta_);
-                break;
+        int n = chunk(chunk__).num_beta_;
+        if (chunk__ < num_cached_chunks_) {
+            int offs = chunk(chunk__).offset_;
+            switch (ctx_.processing_unit()) {
+                case device_t::CPU: {
+                    pw_coeffs_a_ = matrix<double_complex>(&beta_pw_all_atoms_(0, offs), num_gkvec_loc(), n);
+                    break;
+                }
+                case device_t::GPU: {
+                    pw_coeffs_a_ = matrix<double_complex>(nullptr, beta_pw_all_atoms_.at(memory_t::device, 0, offs),
+                                                          num_gkvec_loc(), n);
+                    if (is_cached_[chunk__]) {
+                        Beta_projectors_base::generate_pw_coeffs_g0(chunk__, 0);
+                    } else {
+                        Beta_projectors_base::generate(chunk__, 0);
+                        is_cached_[chunk__] = true;
+                    }
+                    break;
+                }
             }
-            case device_t::GPU: {
-                Beta_projectors_base::generate(chunk__, 0);
-                break;
+        } else {
+            /* generate on the fly */
+            switch (ctx_.processing_unit()) {
+                case device_t::CPU: {
+                    if (beta_pw_buf_.size() == 0) {
+                        beta_pw_buf_ = matrix<double_complex>(num_gkvec_loc(), max_num_beta(),
+                                                              ctx_.mem_pool(ctx_.host_memory_t()));
+                    }
+                    pw_coeffs_a_ = matrix<double_complex>(beta_pw_buf_.at(memory_t::host), num_gkvec_loc(), n);
+                    break;
+                }
+                case device_t::GPU: {
+                    pw_coeffs_a_ = matrix<double_complex>(nullptr, beta_pw_buf_.at(memory_t::device),
+                                                          num_gkvec_loc(), n);
+                    break;
+                }
             }
+            Beta_projectors_base::generate(chunk__, 0);
         }
     }
 };
@@ -106,6 +106,10 @@ class Beta_projectors_base
     /// Split beta-projectors into chunks.
     void split_in_chunks();
 
+    /// Copy G=0 component of beta-projectors for a chunk of atoms to the host buffer.
+    /** This is needed in the Gamma-point case when wave-functions are on CPU and beta-projectors are on GPU. */
+    void generate_pw_coeffs_g0(int ichunk__, int j__);
+
     template <typename T>
     void local_inner_aux(T* beta_pw_coeffs_a_ptr__, int nbeta__, Wave_functions& phi__, int ispn__, int idx0__,
                          int n__, matrix<T>& beta_phi__) const;
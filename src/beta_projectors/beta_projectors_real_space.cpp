@@ -0,0 +1,227 @@
+// Copyright (c) 2013-2020 Anton Kozhevnikov, Thomas Schulthess
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+// the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+//    following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+//    and the following disclaimer in the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** \file beta_projectors_real_space.cpp
+ *
+ *  \brief Contains implementation of sirius::Beta_projectors_real_space class.
+ */
+
+#include <numeric>
+#include "beta_projectors_real_space.hpp"
+#include "hamiltonian/non_local_operator.hpp"
+#include "utils/profiler.hpp"
+#include "SDDK/omp.hpp"
+
+namespace sirius {
+
+Beta_projectors_real_space::Beta_projectors_real_space(Simulation_context const& ctx__,
+                                                       spfft::Transform const& spfftk__, vector3d<double> vk__)
+    : ctx_(ctx__)
+{
+    PROFILE("sirius::Beta_projectors_real_space");
+
+    auto& uc = ctx_.unit_cell();
+
+    std::array<int, 3> dims = {spfftk__.dim_x(), spfftk__.dim_y(), spfftk__.dim_z()};
+    num_points_box_ = dims[0] * dims[1] * dims[2];
+
+    int z_off = spfftk__.local_z_offset();
+    int nz    = spfftk__.local_z_length();
+
+    offset_ = std::vector<int>(uc.num_atoms() + 1, 0);
+    for (int ia = 0; ia < uc.num_atoms(); ia++) {
+        offset_[ia + 1] = offset_[ia] + uc.atom(ia).mt_basis_size();
+    }
+
+    idx_rg_ = std::vector<std::vector<int>>(uc.num_atoms());
+    phase_  = std::vector<std::vector<double_complex>>(uc.num_atoms());
+    beta_   = std::vector<sddk::mdarray<double, 2>>(uc.num_atoms());
+
+    for (int iat = 0; iat < uc.num_atom_types(); iat++) {
+        auto& atom_type = uc.atom_type(iat);
+        if (!atom_type.mt_basis_size()) {
+            continue;
+        }
+
+        auto& beta_rf = ctx_.beta_rf_rg(iat);
+        double rmax   = ctx_.beta_rmax_rg(iat);
+
+        int nr   = beta_rf[0].num_points();
+        double h = rmax / (nr - 1);
+        int lmax = atom_type.lmax_beta();
+
+        #pragma omp parallel for schedule(dynamic)
+        for (int i = 0; i < atom_type.num_atoms(); i++) {
+            int ia   = atom_type.atom_id(i);
+            auto pos = uc.atom(ia).position();
+
+            std::vector<int> idx;
+            std::vector<double_complex> phase;
+            std::vector<double> beta;
+            std::vector<double> rlm(utils::lmmax(lmax));
+
+            /* points of the local slab inside the sphere around the atom */
+            for (int iz = 0; iz < nz; iz++) {
+                uc.for_each_grid_point_in_sphere(dims, iz + z_off, pos, rmax - h,
+                    [&](int ix, int iy, vector3d<double> r, vector3d<double> vs) {
+                        idx.push_back(ix + dims[0] * (iy + dims[1] * iz));
+                        phase.push_back(std::exp(double_complex(0, twopi * dot(vk__, r))));
+
+                        sf::spherical_harmonics(lmax, vs[1], vs[2], &rlm[0]);
+                        int ir    = static_cast<int>(vs[0] / h);
+                        double dx = vs[0] - ir * h;
+                        for (int xi = 0; xi < atom_type.mt_basis_size(); xi++) {
+                            int lm    = atom_type.indexb(xi).lm;
+                            int idxrf = atom_type.indexb(xi).idxrf;
+                            beta.push_back(beta_rf[idxrf](ir, dx) * rlm[lm]);
+                        }
+                    });
+            }
+            /* the box can wrap around the unit cell, so several points may refer to the same grid point; sort the
+               points by the grid index to keep such points together */
+            int np  = static_cast<int>(idx.size());
+            int nbf = atom_type.mt_basis_size();
+            std::vector<int> perm(np);
+            std::iota(perm.begin(), perm.end(), 0);
+            std::stable_sort(perm.begin(), perm.end(), [&idx](int a, int b) { return idx[a] < idx[b]; });
+
+            idx_rg_[ia] = std::vector<int>(np);
+            phase_[ia]  = std::vector<double_complex>(np);
+            beta_[ia]   = sddk::mdarray<double, 2>(nbf, np);
+            for (int ip = 0; ip < np; ip++) {
+                idx_rg_[ia][ip] = idx[perm[ip]];
+                phase_[ia][ip]  = phase[perm[ip]];
+                std::copy(&beta[perm[ip] * nbf], &beta[perm[ip] * nbf] + nbf, &beta_[ia](0, ip));
+            }
+        }
+    }
+}
+
+template <typename T>
+void Beta_projectors_real_space::inner(T const* psi_r__, sddk::mdarray<double_complex, 1>& beta_psi__) const
+{
+    PROFILE("sirius::Beta_projectors_real_space::inner");
+
+    auto& uc = ctx_.unit_cell();
+
+    double pref = std::sqrt(uc.omega()) / num_points_box_;
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int ia = 0; ia < uc.num_atoms(); ia++) {
+        int nbf = uc.atom(ia).mt_basis_size();
+        for (int xi = 0; xi < nbf; xi++) {
+            beta_psi__[offset_[ia] + xi] = 0;
+        }
+        for (int ip = 0; ip < static_cast<int>(idx_rg_[ia].size()); ip++) {
+            auto z = pref * phase_[ia][ip] * psi_r__[idx_rg_[ia][ip]];
+            for (int xi = 0; xi < nbf; xi++) {
+                beta_psi__[offset_[ia] + xi] += beta_[ia](xi, ip) * z;
+            }
+        }
+    }
+    if (ctx_.comm_fft_coarse().size() > 1) {
+        ctx_.comm_fft_coarse().allreduce(beta_psi__.at(memory_t::host), num_beta());
+    }
+}
+
+void Beta_projectors_real_space::apply_d(Non_local_operator& op__, int ispn__,
+                                         sddk::mdarray<double_complex, 1>& beta_psi__) const
+{
+    auto& uc = ctx_.unit_cell();
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int ia = 0; ia < uc.num_atoms(); ia++) {
+        int nbf = uc.atom(ia).mt_basis_size();
+        std::vector<double_complex> tmp(nbf, 0);
+        for (int xi2 = 0; xi2 < nbf; xi2++) {
+            for (int xi1 = 0; xi1 < nbf; xi1++) {
+                if (ctx_.gamma_point()) {
+                    tmp[xi1] += op__.value<double>(xi1, xi2, ispn__, ia) * beta_psi__[offset_[ia] + xi2];
+                } else {
+                    tmp[xi1] += op__.value<double_complex>(xi1, xi2, ispn__, ia) * beta_psi__[offset_[ia] + xi2];
+                }
+            }
+        }
+        std::copy(tmp.begin(), tmp.end(), beta_psi__.at(memory_t::host, offset_[ia]));
+    }
+}
+
+static inline void add_to(double& f__, double_complex z__)
+{
+    f__ += z__.real();
+}
+
+static inline void add_to(double_complex& f__, double_complex z__)
+{
+    f__ += z__;
+}
+
+template <typename T>
+void Beta_projectors_real_space::add(sddk::mdarray<double_complex, 1> const& c__, T* hpsi_r__) const
+{
+    PROFILE("sirius::Beta_projectors_real_space::add");
+
+    auto& uc = ctx_.unit_cell();
+
+    double pref = std::sqrt(uc.omega());
+
+    #pragma omp parallel
+    {
+        int nt = omp_get_num_threads();
+        int it = omp_get_thread_num();
+        /* spheres of different atoms can overlap, so atoms are processed one after another */
+        for (int ia = 0; ia < uc.num_atoms(); ia++) {
+            int nbf = uc.atom(ia).mt_basis_size();
+            auto& idx = idx_rg_[ia];
+            int np    = static_cast<int>(idx.size());
+            /* the points of one atom are split between threads; points are sorted by the grid index and the
+               periodic images of the same grid point are kept in one thread */
+            int ip0 = static_cast<int>(static_cast<int64_t>(np) * it / nt);
+            int ip1 = static_cast<int>(static_cast<int64_t>(np) * (it + 1) / nt);
+            while (ip0 > 0 && ip0 < np && idx[ip0] == idx[ip0 - 1]) {
+                ip0++;
+            }
+            while (ip1 > 0 && ip1 < np && idx[ip1] == idx[ip1 - 1]) {
+                ip1++;
+            }
+            for (int ip = ip0; ip < ip1; ip++) {
+                double_complex z(0, 0);
+                for (int xi = 0; xi < nbf; xi++) {
+                    z += beta_[ia](xi, ip) * c__[offset_[ia] + xi];
+                }
+                add_to(hpsi_r__[idx[ip]], pref * std::conj(phase_[ia][ip]) * z);
+            }
+            #pragma omp barrier
+        }
+    }
+}
+
+template void Beta_projectors_real_space::inner<double>(double const* psi_r__,
+                                                        sddk::mdarray<double_complex, 1>& beta_psi__) const;
+
+template void Beta_projectors_real_space::inner<double_complex>(double_complex const* psi_r__,
+                                                                sddk::mdarray<double_complex, 1>& beta_psi__) const;
+
+template void Beta_projectors_real_space::add<double>(sddk::mdarray<double_complex, 1> const& c__,
+                                                      double* hpsi_r__) const;
+
+template void Beta_projectors_real_space::add<double_complex>(sddk::mdarray<double_complex, 1> const& c__,
+                                                              double_complex* hpsi_r__) const;
+
+} // namespace sirius
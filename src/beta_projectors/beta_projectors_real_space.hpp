@@ -0,0 +1,111 @@
+// Copyright (c) 2013-2020 Anton Kozhevnikov, Thomas Schulthess
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+// the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+//    following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+//    and the following disclaimer in the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** \file beta_projectors_real_space.hpp
+ *
+ *  \brief Contains declaration of sirius::Beta_projectors_real_space class.
+ */
+
+#ifndef __BETA_PROJECTORS_REAL_SPACE_HPP__
+#define __BETA_PROJECTORS_REAL_SPACE_HPP__
+
+#include "simulation_context.hpp"
+
+namespace sirius {
+
+class Non_local_operator;
+
+/// Beta-projectors sampled on the points of the coarse FFT grid.
+/** The projectors are applied to the wave-functions in real space, right after the wave-functions are transformed
+ *  by the local operator. Each projector is sampled only inside a sphere around the atom, so the cost of
+ *  application scales linearly with the number of atoms instead of the quadratic scaling of the plane-wave
+ *  projectors.
+ *
+ *  The wave-function in real space is \f$ \psi({\bf r}) = \frac{1}{\sqrt{\Omega}} e^{i{\bf kr}} u({\bf r}) \f$,
+ *  where \f$ u({\bf r}) \f$ is the content of the FFT buffer after the backward transformation. Projection
+ *  coefficients are computed as
+ *  \f[
+ *      \langle \beta_{\xi}^{\alpha} | \psi \rangle = \frac{\sqrt{\Omega}}{N_r} \sum_{\bf r} \beta_{\xi}({\bf r} -
+ *      {\bf r}_{\alpha}) e^{i{\bf kr}} u({\bf r})
+ *  \f]
+ *  where the sum runs over the grid points inside the sphere (with their periodic images unwrapped around the
+ *  atom). To avoid aliasing, the radial part of the projectors is Fourier-filtered to the G+k cutoff:
+ *  \f[
+ *      \beta_{\ell}^{f}(r) = \frac{2}{\pi} \int_{0}^{G_{k,max}} q^2 \beta_{\ell}(q) j_{\ell}(qr) dq
+ *  \f]
+ *  with \f$ \beta_{\ell}(q) \f$ being the radial integrals of the projectors. The filtered radial functions do
+ *  not depend on k and are stored in Simulation_context::beta_rf_rg(). The radius of the sphere is the
+ *  cutoff radius of the projectors multiplied by Control_input::beta_real_space_radius_scale_.
+ *
+ *  Only the host memory and the spin-collinear case are supported.
+ */
+class Beta_projectors_real_space
+{
+  private:
+    Simulation_context const& ctx_;
+
+    /// Number of points in the full FFT box.
+    int num_points_box_{0};
+
+    /// Offsets of the atom projection coefficients in the full array of coefficients.
+    std::vector<int> offset_;
+
+    /// Local indices of the FFT buffer points inside the atomic spheres.
+    std::vector<std::vector<int>> idx_rg_;
+
+    /// Phase factors exp(i k*r) for the unwrapped points of the atomic spheres.
+    std::vector<std::vector<double_complex>> phase_;
+
+    /// Values of the beta-projectors in the points of the atomic spheres.
+    /** Each matrix has dimensions (mt_basis_size, number of points). */
+    std::vector<sddk::mdarray<double, 2>> beta_;
+
+  public:
+    /// Constructor.
+    /** \param [in] ctx    Simulation context.
+     *  \param [in] spfftk SpFFT transform object of the k-point; defines the local part of the FFT buffer.
+     *  \param [in] vk     Fractional coordinates of the k-point.
+     */
+    Beta_projectors_real_space(Simulation_context const& ctx__, spfft::Transform const& spfftk__,
+                               vector3d<double> vk__);
+
+    /// Total number of projection coefficients.
+    inline int num_beta() const
+    {
+        return offset_.back();
+    }
+
+    /// Compute projection coefficients <beta|psi> of a single wave-function.
+    /** \param [in]  psi_r    Wave-function in the local part of the FFT buffer (real or complex).
+     *  \param [out] beta_psi Projection coefficients of all atoms.
+     */
+    template <typename T>
+    void inner(T const* psi_r__, sddk::mdarray<double_complex, 1>& beta_psi__) const;
+
+    /// Multiply projection coefficients by the non-local operator matrix.
+    void apply_d(Non_local_operator& op__, int ispn__, sddk::mdarray<double_complex, 1>& beta_psi__) const;
+
+    /// Add sum_{xi} |beta_{xi}> c_{xi} to the wave-function in the local part of the FFT buffer.
+    template <typename T>
+    void add(sddk::mdarray<double_complex, 1> const& c__, T* hpsi_r__) const;
+};
+
+} // namespace sirius
+
+#endif
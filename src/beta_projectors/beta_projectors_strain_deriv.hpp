@@ -64,6 +64,21 @@ class Beta_projectors_strain_deriv : public Beta_projectors_base
             sf::dRlm_dr(lmax, gvc, rlm_dg_tmp);
         }
 
+        /* lengths of G+k vectors */
+        std::vector<double> gk_len(num_gkvec_loc());
+        for (int igkloc = 0; igkloc < num_gkvec_loc(); igkloc++) {
+            gk_len[igkloc] = gkvec_.gkvec_cart<index_domain_t::global>(igk__[igkloc]).length();
+        }
+
+        /* radial integrals of all atom types for all G+k vectors */
+        int nrf = ctx_.unit_cell().max_mt_radial_basis_size();
+        mdarray<double, 3> ri0(nrf, num_gkvec_loc(), ctx_.unit_cell().num_atom_types());
+        mdarray<double, 3> ri1(nrf, num_gkvec_loc(), ctx_.unit_cell().num_atom_types());
+        for (int iat = 0; iat < ctx_.unit_cell().num_atom_types(); iat++) {
+            beta_ri0.values(iat, num_gkvec_loc(), gk_len.data(), &ri0(0, 0, iat), nrf);
+            beta_ri1.values(iat, num_gkvec_loc(), gk_len.data(), &ri1(0, 0, iat), nrf);
+        }
+
         /* compute d <G+k|beta> / d epsilon_{mu, nu} */
         #pragma omp parallel for schedule(static)
         for (int igkloc = 0; igkloc < num_gkvec_loc(); igkloc++) {
@@ -79,7 +94,6 @@ class Beta_projectors_strain_deriv : public Beta_projectors_base
 
                         for (int iat = 0; iat < ctx_.unit_cell().num_atom_types(); iat++) {
                             auto& atom_type = ctx_.unit_cell().atom_type(iat);
-                            auto ri0 = beta_ri0.values(iat, gvs[0]);
 
                             for (int xi = 0; xi < atom_type.mt_basis_size(); xi++) {
                                 int l     = atom_type.indexb(xi).l;
@@ -88,7 +102,7 @@ class Beta_projectors_strain_deriv : public Beta_projectors_base
                                 if (l == 0) {
                                     auto z = fourpi / std::sqrt(ctx_.unit_cell().omega());
 
-                                    auto d1 = ri0(idxrf) * (-p * y00);
+                                    auto d1 = ri0(idxrf, igkloc, iat) * (-p * y00);
 
                                     pw_coeffs_t_(igkloc, atom_type.offset_lo() + xi, mu + nu * 3) = z * d1;
                                 } else {
@@ -104,9 +118,6 @@ class Beta_projectors_strain_deriv : public Beta_projectors_base
             for (int iat = 0; iat < ctx_.unit_cell().num_atom_types(); iat++) {
                 auto& atom_type = ctx_.unit_cell().atom_type(iat);
 
-                auto ri0 = beta_ri0.values(iat, gvs[0]);
-                auto ri1 = beta_ri1.values(iat, gvs[0]);
-
                 for (int nu = 0; nu < 3; nu++) {
                     for (int mu = 0; mu < 3; mu++) {
                         double p = (mu == nu) ? 0.5 : 0;
@@ -118,9 +129,10 @@ class Beta_projectors_strain_deriv : public Beta_projectors_base
 
                             auto z = std::pow(double_complex(0, -1), l) * fourpi / std::sqrt(ctx_.unit_cell().omega());
 
-                            auto d1 = ri0(idxrf) * (-gvc[mu] * rlm_dg(lm, nu, igkloc) - p * rlm_g(lm, igkloc));
+                            auto d1 = ri0(idxrf, igkloc, iat) *
+                                      (-gvc[mu] * rlm_dg(lm, nu, igkloc) - p * rlm_g(lm, igkloc));
 
-                            auto d2 = ri1(idxrf) * rlm_g(lm, igkloc) * (-gvc[mu] * gvc[nu] / gvs[0]);
+                            auto d2 = ri1(idxrf, igkloc, iat) * rlm_g(lm, igkloc) * (-gvc[mu] * gvc[nu] / gvs[0]);
 
                             pw_coeffs_t_(igkloc, atom_type.offset_lo() + xi, mu + nu * 3) = z * (d1 + d2);
                         }
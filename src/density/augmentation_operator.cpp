@@ -96,13 +96,21 @@ void Augmentation_operator::generate_pw_coeffs(Radial_integrals_aug<false> const
     /* number of beta- radial functions */
     int nbrf = atom_type_.mt_radial_basis_size();
 
+    /* lengths of the local G-vector shells */
+    std::vector<double> gsh_len(gvec_.num_gvec_shells_local());
+    for (int j = 0; j < gvec_.num_gvec_shells_local(); j++) {
+        gsh_len[j] = gvec_.gvec_shell_len_local(j);
+    }
+
+    /* radial integrals for all G-vector shells at once */
+    auto ri = radial_integrals__.values(atom_type_.id(), gvec_.num_gvec_shells_local(), gsh_len.data());
+
     sddk::mdarray<double, 3> ri_values(nbrf * (nbrf + 1) / 2, 2 * lmax_beta + 1, gvec_.num_gvec_shells_local(), mp__);
     #pragma omp parallel for
     for (int j = 0; j < gvec_.num_gvec_shells_local(); j++) {
-        auto ri = radial_integrals__.values(atom_type_.id(), gvec_.gvec_shell_len_local(j));
         for (int l = 0; l <= 2 * lmax_beta; l++) {
             for (int i = 0; i < nbrf * (nbrf + 1) / 2; i++) {
-                ri_values(i, l, j) = ri(i, l);
+                ri_values(i, l, j) = ri(i, l, j);
             }
         }
     }
@@ -281,14 +289,22 @@ void Augmentation_operator_gvec_deriv::prepare(Atom_type const& atom_type__,
     ri_values_ = sddk::mdarray<double, 3>(2 * lmax_beta + 1, nbrf * (nbrf + 1) / 2, gvec_.num_gvec_shells_local(), mp);
     ri_dg_values_ = sddk::mdarray<double, 3>(2 * lmax_beta + 1, nbrf * (nbrf + 1) / 2, gvec_.num_gvec_shells_local(),
         mp);
+    /* lengths of the local G-vector shells */
+    std::vector<double> gsh_len(gvec_.num_gvec_shells_local());
+    for (int j = 0; j < gvec_.num_gvec_shells_local(); j++) {
+        gsh_len[j] = gvec_.gvec_shell_len_local(j);
+    }
+
+    /* radial integrals for all G-vector shells at once */
+    auto ri    = ri__.values(atom_type__.id(), gvec_.num_gvec_shells_local(), gsh_len.data());
+    auto ri_dg = ri_dq__.values(atom_type__.id(), gvec_.num_gvec_shells_local(), gsh_len.data());
+
     #pragma omp parallel for
     for (int j = 0; j < gvec_.num_gvec_shells_local(); j++) {
-        auto ri = ri__.values(atom_type__.id(), gvec_.gvec_shell_len_local(j));
-        auto ri_dg = ri_dq__.values(atom_type__.id(), gvec_.gvec_shell_len_local(j));
         for (int l = 0; l <= 2 * lmax_beta; l++) {
             for (int i = 0; i < nbrf * (nbrf + 1) / 2; i++) {
-                ri_values_(l, i, j) = ri(i, l);
-                ri_dg_values_(l, i, j) = ri_dg(i, l);
+                ri_values_(l, i, j) = ri(i, l, j);
+                ri_dg_values_(l, i, j) = ri_dg(i, l, j);
             }
         }
     }
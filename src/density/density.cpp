@@ -28,6 +28,7 @@
 #include "mixer/mixer_functions.hpp"
 #include "mixer/mixer_factory.hpp"
 #include "utils/profiler.hpp"
+#include "specfunc/sbessel.hpp"
 
 namespace sirius {
 
@@ -558,6 +559,33 @@ void Density::add_k_point_contribution_rg(K_point* kp__)
                 continue;
             }
             int ncols =kp__->spinor_wave_functions().pw_coeffs(ispn).spl_num_col().local_size();
+
+            /* real wave-functions are transformed in pairs as psi_1(r) + i psi_2(r) */
+            if (kp__->spfft_transform_pair()) {
+                auto& spfft_pair = *kp__->spfft_transform_pair();
+                auto psi_r       = spfft_pair.space_domain_data();
+                for (int i = 0; i < ncols; i += 2) {
+                    /* global index of the band */
+                    int j1    = kp__->spinor_wave_functions().pw_coeffs(ispn).spl_num_col()[i];
+                    double w1 = kp__->band_occupancy(j1, ispn) * kp__->weight() / omega;
+                    double w2{0};
+                    double_complex const* inp_wf2{nullptr};
+                    if (i + 1 < ncols) {
+                        int j2  = kp__->spinor_wave_functions().pw_coeffs(ispn).spl_num_col()[i + 1];
+                        w2      = kp__->band_occupancy(j2, ispn) * kp__->weight() / omega;
+                        inp_wf2 = kp__->spinor_wave_functions().pw_coeffs(ispn).extra().at(memory_t::host, 0, i + 1);
+                    }
+                    /* transform to real space */
+                    spfft_pair.backward(kp__->spinor_wave_functions().pw_coeffs(ispn).extra().at(memory_t::host, 0, i),
+                                        inp_wf2);
+                    #pragma omp parallel for schedule(static)
+                    for (int ir = 0; ir < nr; ir++) {
+                        density_rg(ir, ispn) += w1 * std::pow(psi_r[ir].real(), 2) + w2 * std::pow(psi_r[ir].imag(), 2);
+                    }
+                }
+                continue;
+            }
+
             for (int ii = 0; ii < ncols; ii++) {
                 /* global index of the band */
                 int i = ncols-1-ii;
@@ -1091,7 +1119,7 @@ void Density::augment()
         return;
     }
 
-    auto rho_aug = generate_rho_aug();
+    auto rho_aug = (ctx_.control().rho_aug_real_space_) ? generate_rho_aug_rg() : generate_rho_aug();
 
     for (int iv = 0; iv < ctx_.num_mag_dims() + 1; iv++) {
         #pragma omp parallel for schedule(static)
@@ -1401,6 +1429,190 @@ mdarray<double_complex, 2> Density::generate_rho_aug()
     return rho_aug;
 }
 
+void Density::generate_q_rf_rg()
+{
+    PROFILE("sirius::Density::generate_q_rf_rg");
+
+    q_rf_rg_   = std::vector<mdarray<Spline<double>, 2>>(unit_cell_.num_atom_types());
+    q_rmax_rg_ = std::vector<double>(unit_cell_.num_atom_types(), 0);
+
+    for (int iat = 0; iat < unit_cell_.num_atom_types(); iat++) {
+        auto& atom_type = unit_cell_.atom_type(iat);
+        if (!atom_type.augment() || atom_type.num_atoms() == 0) {
+            continue;
+        }
+        int nbrf      = atom_type.mt_radial_basis_size();
+        int lmax_beta = atom_type.indexr().lmax();
+        int nidx      = nbrf * (nbrf + 1) / 2;
+
+        /* find the cutoff radius of the augmentation functions */
+        double fmax{0};
+        int ir_max{0};
+        for (int pass = 0; pass < 2; pass++) {
+            for (int l = 0; l <= 2 * lmax_beta; l++) {
+                for (int idxrf2 = 0; idxrf2 < nbrf; idxrf2++) {
+                    for (int idxrf1 = 0; idxrf1 <= idxrf2; idxrf1++) {
+                        auto& f = atom_type.q_radial_function(idxrf1, idxrf2, l);
+                        for (int ir = 0; ir < f.num_points(); ir++) {
+                            if (pass == 0) {
+                                fmax = std::max(fmax, std::abs(f(ir)));
+                            } else if (std::abs(f(ir)) > 1e-10 * fmax) {
+                                ir_max = std::max(ir_max, ir);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        double rmax = ctx_.control().rho_aug_real_space_radius_scale_ *
+            atom_type.radial_grid(std::min(ir_max + 1, atom_type.radial_grid().num_points() - 1));
+        q_rmax_rg_[iat] = rmax;
+
+        /* Q_l(r) = 2 / pi \int_{0}^{G_max} q^2 Q_l(q) j_l(qr) dq */
+        auto qgrid = filter_q_grid(ctx_.pw_cutoff());
+        int nq     = static_cast<int>(qgrid.size());
+        auto ri    = ctx_.aug_ri().values(iat, nq, qgrid.data());
+        int nf     = nidx * (2 * lmax_beta + 1);
+        mdarray<double, 2> ri_f(ri.at(memory_t::host), nf, nq);
+
+        /* orbital quantum number of each radial function */
+        std::vector<int> lf(nf);
+        for (int i = 0; i < nf; i++) {
+            lf[i] = i / nidx;
+        }
+        auto q_rf = filter_radial_functions(qgrid, ri_f, lf, rmax);
+
+        q_rf_rg_[iat] = mdarray<Spline<double>, 2>(nidx, 2 * lmax_beta + 1);
+        for (int l = 0; l <= 2 * lmax_beta; l++) {
+            for (int i = 0; i < nidx; i++) {
+                q_rf_rg_[iat](i, l) = std::move(q_rf[i + nidx * l]);
+            }
+        }
+    }
+}
+
+mdarray<double_complex, 2> Density::generate_rho_aug_rg()
+{
+    PROFILE("sirius::Density::generate_rho_aug_rg");
+
+    if (q_rf_rg_.empty()) {
+        generate_q_rf_rg();
+    }
+
+    int nmag = ctx_.num_mag_dims() + 1;
+
+    auto& spfft = ctx_.spfft();
+    std::array<int, 3> dims = {ctx_.fft_grid()[0], ctx_.fft_grid()[1], ctx_.fft_grid()[2]};
+    int z_off = spfft.local_z_offset();
+    int nz    = spfft.local_z_length();
+
+    /* augmentation charge in the local part of the real-space grid */
+    mdarray<double, 2> rho_rg(spfft.local_slice_size(), nmag, ctx_.mem_pool(memory_t::host));
+    rho_rg.zero();
+
+    for (int iat = 0; iat < unit_cell_.num_atom_types(); iat++) {
+        auto& atom_type = unit_cell_.atom_type(iat);
+
+        if (!atom_type.augment() || atom_type.num_atoms() == 0) {
+            continue;
+        }
+
+        int nbf       = atom_type.mt_basis_size();
+        int nbrf      = atom_type.mt_radial_basis_size();
+        int nidx      = nbrf * (nbrf + 1) / 2;
+        int lmax_beta = atom_type.indexr().lmax();
+        int lmmax     = utils::lmmax(2 * lmax_beta);
+        auto l_by_lm  = utils::l_by_lm(2 * lmax_beta);
+
+        Gaunt_coefficients<double> gaunt_coefs(lmax_beta, 2 * lmax_beta, lmax_beta, SHT::gaunt_rrr);
+
+        double rmax = q_rmax_rg_[iat];
+        int nr      = q_rf_rg_[iat](0, 0).num_points();
+        double h    = rmax / (nr - 1);
+
+        auto dm = density_matrix_aux(iat);
+
+        for (int i = 0; i < atom_type.num_atoms(); i++) {
+            int ia   = atom_type.atom_id(i);
+            auto pos = unit_cell_.atom(ia).position();
+
+            /* contract density matrix with Gaunt coefficients:
+               A_{L}^{\ell_1 \ell_2} = \sum_{m_1 m_2} w_{\xi_1 \xi_2} d_{\xi_1 \xi_2}
+                                         <R_{\ell_2 m_2}|R_{L}|R_{\ell_1 m_1}> */
+            mdarray<double, 3> a(nidx, lmmax, nmag);
+            a.zero();
+            for (int xi2 = 0; xi2 < nbf; xi2++) {
+                int lm2    = atom_type.indexb(xi2).lm;
+                int idxrf2 = atom_type.indexb(xi2).idxrf;
+                for (int xi1 = 0; xi1 <= xi2; xi1++) {
+                    int lm1     = atom_type.indexb(xi1).lm;
+                    int idxrf1  = atom_type.indexb(xi1).idxrf;
+                    int idx12   = utils::packed_index(xi1, xi2);
+                    int idxrf12 = utils::packed_index(idxrf1, idxrf2);
+                    double w    = ctx_.augmentation_op(iat)->sym_weight(idx12);
+                    for (auto& g : gaunt_coefs.gaunt_vector(lm2, lm1)) {
+                        for (int iv = 0; iv < nmag; iv++) {
+                            a(idxrf12, g.lm3, iv) += w * dm(idx12, i, iv) * g.coef;
+                        }
+                    }
+                }
+            }
+
+            /* the box can be larger than the unit cell, so several points of the box can wrap to the same grid
+               point; threads own distinct z-planes of the local slab and accumulate all images of a plane */
+            #pragma omp parallel
+            {
+                std::vector<double> rlm(lmmax);
+                #pragma omp for
+                for (int iz = 0; iz < nz; iz++) {
+                    unit_cell_.for_each_grid_point_in_sphere(dims, iz + z_off, pos, rmax - h,
+                        [&](int ix, int iy, vector3d<double>, vector3d<double> vs) {
+                            sf::spherical_harmonics(2 * lmax_beta, vs[1], vs[2], &rlm[0]);
+                            int ir    = static_cast<int>(vs[0] / h);
+                            double dx = vs[0] - ir * h;
+
+                            int idx = ctx_.fft_grid().index_by_coord(ix, iy, iz);
+                            for (int iv = 0; iv < nmag; iv++) {
+                                double val{0};
+                                for (int lm = 0; lm < lmmax; lm++) {
+                                    int l = l_by_lm[lm];
+                                    double s{0};
+                                    for (int i12 = 0; i12 < nidx; i12++) {
+                                        if (a(i12, lm, iv) != 0) {
+                                            s += a(i12, lm, iv) * q_rf_rg_[iat](i12, l)(ir, dx);
+                                        }
+                                    }
+                                    val += s * rlm[lm];
+                                }
+                                rho_rg(idx, iv) += val;
+                            }
+                        });
+                }
+            }
+        }
+    }
+
+    /* transform to the plane-wave domain */
+    mdarray<double_complex, 2> rho_aug(ctx_.gvec().count(), nmag, ctx_.mem_pool(memory_t::host));
+    Smooth_periodic_function<double> f(ctx_.spfft(), ctx_.gvec_partition(), &ctx_.mem_pool(memory_t::host));
+    for (int iv = 0; iv < nmag; iv++) {
+        std::copy(rho_rg.at(memory_t::host, 0, iv), rho_rg.at(memory_t::host, 0, iv) + spfft.local_slice_size(),
+                  &f.f_rg(0));
+        f.fft_transform(-1);
+        std::copy(&f.f_pw_local(0), &f.f_pw_local(0) + ctx_.gvec().count(), rho_aug.at(memory_t::host, 0, iv));
+    }
+
+    if (ctx_.control().print_checksum_) {
+        auto cs = rho_aug.checksum();
+        ctx_.comm().allreduce(&cs, 1);
+        if (ctx_.comm().rank() == 0) {
+            utils::print_checksum("rho_aug", cs);
+        }
+    }
+
+    return rho_aug;
+}
+
 template <int num_mag_dims>
 void Density::reduce_density_matrix(Atom_type const& atom_type__, int ia__, mdarray<double_complex, 4> const& zdens__,
                                     Gaunt_coefficients<double_complex> const& gaunt_coeffs__,
@@ -1419,19 +1631,36 @@ void Density::reduce_density_matrix(Atom_type const& atom_type__, int ia__, mdar
             for (int lm2 = utils::lm(l2, -l2); lm2 <= utils::lm(l2, l2); lm2++, xi2++) {
                 int xi1 = atom_type__.indexb().index_by_idxrf(idxrf1);
                 for (int lm1 = utils::lm(l1, -l1); lm1 <= utils::lm(l1, l1); lm1++, xi1++) {
-                    for (int k = 0; k < gaunt_coeffs__.num_gaunt(lm1, lm2); k++) {
-                        int lm3 = gaunt_coeffs__.gaunt(lm1, lm2, k).lm3;
-                        auto gc = gaunt_coeffs__.gaunt(lm1, lm2, k).coef;
-                        switch (num_mag_dims) {
-                            case 3: {
-                                mt_density_matrix__(lm3, offs, 2) += 2.0 * std::real(zdens__(xi1, xi2, 2, ia__) * gc);
-                                mt_density_matrix__(lm3, offs, 3) -= 2.0 * std::imag(zdens__(xi1, xi2, 2, ia__) * gc);
+                    /* contiguous arrays of lm3 indices and coefficients; lm3 indices are unique within a row */
+                    auto gnt = gaunt_coeffs__.gaunt_vector(lm1, lm2);
+                    auto lm3 = gnt.lm3();
+                    auto gc  = gnt.coef();
+                    int ngc  = gnt.size();
+                    switch (num_mag_dims) {
+                        case 3: {
+                            auto z   = zdens__(xi1, xi2, 2, ia__);
+                            auto dm2 = &mt_density_matrix__(0, offs, 2);
+                            auto dm3 = &mt_density_matrix__(0, offs, 3);
+                            #pragma omp simd
+                            for (int k = 0; k < ngc; k++) {
+                                dm2[lm3[k]] += 2.0 * (z.real() * gc[k].real() - z.imag() * gc[k].imag());
+                                dm3[lm3[k]] -= 2.0 * (z.real() * gc[k].imag() + z.imag() * gc[k].real());
                             }
-                            case 1: {
-                                mt_density_matrix__(lm3, offs, 1) += std::real(zdens__(xi1, xi2, 1, ia__) * gc);
+                        }
+                        case 1: {
+                            auto z   = zdens__(xi1, xi2, 1, ia__);
+                            auto dm1 = &mt_density_matrix__(0, offs, 1);
+                            #pragma omp simd
+                            for (int k = 0; k < ngc; k++) {
+                                dm1[lm3[k]] += z.real() * gc[k].real() - z.imag() * gc[k].imag();
                             }
-                            case 0: {
-                                mt_density_matrix__(lm3, offs, 0) += std::real(zdens__(xi1, xi2, 0, ia__) * gc);
+                        }
+                        case 0: {
+                            auto z   = zdens__(xi1, xi2, 0, ia__);
+                            auto dm0 = &mt_density_matrix__(0, offs, 0);
+                            #pragma omp simd
+                            for (int k = 0; k < ngc; k++) {
+                                dm0[lm3[k]] += z.real() * gc[k].real() - z.imag() * gc[k].imag();
                             }
                         }
                     }
@@ -1739,22 +1968,42 @@ void Density::mixer_init(Mixer_input mixer_cfg__)
     /* create mixer */
     this->mixer_ = mixer::Mixer_factory<Periodic_function<double>, Periodic_function<double>,
                                         Periodic_function<double>, Periodic_function<double>,
-                                        mdarray<double_complex, 4>, paw_density>(mixer_cfg__);
+                                        mdarray<double_complex, 4>, paw_density,
+                                        mdarray<double_complex, 2>>(mixer_cfg__, ctx_.comm());
 
     const bool init_mt = ctx_.full_potential();
 
+    pw_mixing_ = mixer_cfg__.pw_mixing_;
+
     /* initialize functions */
-    if (mixer_cfg__.use_hartree_) {
-        this->mixer_->initialize_function<0>(func_prop1, component(0), ctx_, lmmax_, init_mt);
+    if (pw_mixing_) {
+        if (ctx_.full_potential()) {
+            throw std::runtime_error("[sirius::Density::mixer_init] plane-wave mixing is not supported for "
+                                     "full-potential calculations");
+        }
+        auto pw_prop = mixer::pw_density_function_property(ctx_, mixer_cfg__.use_hartree_, mixer_cfg__.kerker_q0_);
+        /* initial value of the mixer are the plane-wave coefficients of the current density */
+        mdarray<double_complex, 2> rho_pw(ctx_.gvec_coarse().count(), ctx_.num_mag_dims() + 1);
+        for (int j = 0; j < ctx_.num_mag_dims() + 1; j++) {
+            #pragma omp parallel for schedule(static)
+            for (int igloc = 0; igloc < ctx_.gvec_coarse().count(); igloc++) {
+                rho_pw(igloc, j) = component(j).f_pw_local(ctx_.gvec().gvec_base_mapping(igloc));
+            }
+        }
+        this->mixer_->initialize_function<6>(pw_prop, rho_pw, ctx_.gvec_coarse().count(), ctx_.num_mag_dims() + 1);
     } else {
-        this->mixer_->initialize_function<0>(func_prop, component(0), ctx_, lmmax_, init_mt);
-    }
-    if (ctx_.num_mag_dims() > 0) {
-        this->mixer_->initialize_function<1>(func_prop, component(1), ctx_, lmmax_, init_mt);
-    }
-    if (ctx_.num_mag_dims() > 1) {
-        this->mixer_->initialize_function<2>(func_prop, component(2), ctx_, lmmax_, init_mt);
-        this->mixer_->initialize_function<3>(func_prop, component(3), ctx_, lmmax_, init_mt);
+        if (mixer_cfg__.use_hartree_) {
+            this->mixer_->initialize_function<0>(func_prop1, component(0), ctx_, lmmax_, init_mt);
+        } else {
+            this->mixer_->initialize_function<0>(func_prop, component(0), ctx_, lmmax_, init_mt);
+        }
+        if (ctx_.num_mag_dims() > 0) {
+            this->mixer_->initialize_function<1>(func_prop, component(1), ctx_, lmmax_, init_mt);
+        }
+        if (ctx_.num_mag_dims() > 1) {
+            this->mixer_->initialize_function<2>(func_prop, component(2), ctx_, lmmax_, init_mt);
+            this->mixer_->initialize_function<3>(func_prop, component(3), ctx_, lmmax_, init_mt);
+        }
     }
 
     this->mixer_->initialize_function<4>(density_prop, density_matrix_, unit_cell_.max_mt_basis_size(),
@@ -1769,13 +2018,25 @@ void Density::mixer_input()
 {
     PROFILE("sirius::Density::mixer_input");
 
-    mixer_->set_input<0>(component(0));
-    if (ctx_.num_mag_dims() > 0) {
-        mixer_->set_input<1>(component(1));
-    }
-    if (ctx_.num_mag_dims() > 1) {
-        mixer_->set_input<2>(component(2));
-        mixer_->set_input<3>(component(3));
+    if (pw_mixing_) {
+        /* collect plane-wave coefficients inside the coarse G-sphere */
+        mdarray<double_complex, 2> rho_pw(ctx_.gvec_coarse().count(), ctx_.num_mag_dims() + 1);
+        for (int j = 0; j < ctx_.num_mag_dims() + 1; j++) {
+            #pragma omp parallel for schedule(static)
+            for (int igloc = 0; igloc < ctx_.gvec_coarse().count(); igloc++) {
+                rho_pw(igloc, j) = component(j).f_pw_local(ctx_.gvec().gvec_base_mapping(igloc));
+            }
+        }
+        mixer_->set_input<6>(rho_pw);
+    } else {
+        mixer_->set_input<0>(component(0));
+        if (ctx_.num_mag_dims() > 0) {
+            mixer_->set_input<1>(component(1));
+        }
+        if (ctx_.num_mag_dims() > 1) {
+            mixer_->set_input<2>(component(2));
+            mixer_->set_input<3>(component(3));
+        }
     }
 
     mixer_->set_input<4>(density_matrix_);
@@ -1789,13 +2050,25 @@ void Density::mixer_output()
 {
     PROFILE("sirius::Density::mixer_output");
 
-    mixer_->get_output<0>(component(0));
-    if (ctx_.num_mag_dims() > 0) {
-        mixer_->get_output<1>(component(1));
-    }
-    if (ctx_.num_mag_dims() > 1) {
-        mixer_->get_output<2>(component(2));
-        mixer_->get_output<3>(component(3));
+    if (pw_mixing_) {
+        mdarray<double_complex, 2> rho_pw(ctx_.gvec_coarse().count(), ctx_.num_mag_dims() + 1);
+        mixer_->get_output<6>(rho_pw);
+        /* plane-wave coefficients outside of the coarse G-sphere keep their input values */
+        for (int j = 0; j < ctx_.num_mag_dims() + 1; j++) {
+            #pragma omp parallel for schedule(static)
+            for (int igloc = 0; igloc < ctx_.gvec_coarse().count(); igloc++) {
+                component(j).f_pw_local(ctx_.gvec().gvec_base_mapping(igloc)) = rho_pw(igloc, j);
+            }
+        }
+    } else {
+        mixer_->get_output<0>(component(0));
+        if (ctx_.num_mag_dims() > 0) {
+            mixer_->get_output<1>(component(1));
+        }
+        if (ctx_.num_mag_dims() > 1) {
+            mixer_->get_output<2>(component(2));
+            mixer_->get_output<3>(component(3));
+        }
     }
 
     mixer_->get_output<4>(density_matrix_);
@@ -1804,8 +2077,13 @@ void Density::mixer_output()
         mixer_->get_output<5>(paw_density_);
     }
 
-    /* transform mixed density to plane-wave domain */
-    this->fft_transform(-1);
+    if (pw_mixing_) {
+        /* real-space density is still needed for the XC potential */
+        this->fft_transform(1);
+    } else {
+        /* transform mixed density to plane-wave domain */
+        this->fft_transform(-1);
+    }
 }
 
 double Density::mix()
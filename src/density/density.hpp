@@ -184,6 +184,17 @@ class Density : public Field4D
     /// Non-zero Gaunt coefficients.
     std::unique_ptr<Gaunt_coefficients<double_complex>> gaunt_coefs_{nullptr};
 
+    /// Fourier-filtered radial functions of the augmentation operator on a linear real-space grid.
+    /** Used to generate the augmentation charge in real space. For each atom type the array is indexed by the
+        packed index of two beta radial functions and by the orbital quantum number. */
+    std::vector<sddk::mdarray<Spline<double>, 2>> q_rf_rg_;
+
+    /// Radius of the atomic box for the real-space augmentation charge of each atom type.
+    std::vector<double> q_rmax_rg_;
+
+    /// Generate the radial functions of the augmentation operator for the real-space augmentation charge.
+    void generate_q_rf_rg();
+
     /// Fast mapping between composite lm index and corresponding orbital quantum number.
     std::vector<int> l_by_lm_;
 
@@ -192,7 +203,11 @@ class Density : public Field4D
     /** Mix the following objects: density, x-,y-,z-components of magnetisation, density matrix and
         PAW density of atoms. */
     std::unique_ptr<mixer::Mixer<Periodic_function<double>, Periodic_function<double>, Periodic_function<double>,
-                                 Periodic_function<double>, sddk::mdarray<double_complex, 4>, paw_density>> mixer_;
+                                 Periodic_function<double>, sddk::mdarray<double_complex, 4>, paw_density,
+                                 sddk::mdarray<double_complex, 2>>> mixer_;
+
+    /// True if the plane-wave coefficients of the density inside the coarse G-sphere are mixed.
+    bool pw_mixing_{false};
 
     /// Generate atomic densities in the case of PAW.
     void generate_paw_atom_density(int iapaw__);
@@ -347,6 +362,20 @@ class Density : public Field4D
     /// Generate augmentation charge density.
     mdarray<double_complex, 2> generate_rho_aug();
 
+    /// Generate augmentation charge density in real space.
+    /** Augmentation charge of each atom is accumulated on the points of the fine FFT grid inside a sphere around
+        the atom:
+        \f[
+            \tilde \rho({\bf r}) = \sum_{\alpha} \sum_{\xi \xi'} d_{\xi \xi'}^{\alpha}
+                Q_{\xi' \xi}^{\alpha}({\bf r} - {\bf r}_{\alpha})
+        \f]
+        and then transformed to the plane-wave domain with a single FFT per component. Radial parts of
+        \f$ Q_{\xi' \xi}({\bf r}) \f$ are Fourier-filtered to the plane-wave cutoff of the density, so the result
+        matches generate_rho_aug() up to the truncation of the filtered functions at the sphere radius. Memory
+        consumption is proportional to the number of atoms and not to the number of G-vectors.
+     */
+    mdarray<double_complex, 2> generate_rho_aug_rg();
+
     /// Check density at MT boundary
     void check_density_continuity_at_mt()
     {
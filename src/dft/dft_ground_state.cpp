@@ -212,6 +212,10 @@ json DFT_ground_state::find(double rms_tol, double energy_tol, double initial_to
             std::printf("| SCF iteration %3i out of %3i |\n", iter, num_dft_iter);
             std::printf("+------------------------------+\n");
         }
+        /* balance the load of the band solver using the timings of the previous iteration */
+        if (iter > 0 && ctx_.control().kpoint_rebalance_) {
+            kset_.rebalance();
+        }
         Hamiltonian0 H0(potential_);
         /* find new wave-functions */
         Band(ctx_).solve(kset_, H0, true);
@@ -304,7 +308,11 @@ json DFT_ground_state::find(double rms_tol, double energy_tol, double initial_to
         }
         potential_.save();
         density_.save();
-        //kset_.save(storage_file_name);
+        /* wave-functions are stored only on request; they are large and can be used only in the
+           pseudopotential case */
+        if (ctx_.control().save_wave_functions_ && !ctx_.full_potential()) {
+            kset_.save(storage_file_name);
+        }
     }
 
     auto tstop = std::chrono::high_resolution_clock::now();
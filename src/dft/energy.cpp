@@ -1,36 +1,42 @@
 #include "energy.hpp"
+#include "geometry/ewald_pme.hpp"
 
 namespace sirius {
-double ewald_energy(const Simulation_context& ctx, const Gvec& gvec, const Unit_cell& unit_cell)
+double ewald_energy(Simulation_context& ctx, const Gvec& gvec, const Unit_cell& unit_cell)
 {
     double alpha{ctx.ewald_lambda()};
     double ewald_g{0};
 
-    #pragma omp parallel for reduction(+ : ewald_g)
-    for (int igloc = 0; igloc < gvec.count(); igloc++) {
-        int ig = gvec.offset() + igloc;
-        if (!ig) {
-            continue;
-        }
+    if (ctx.settings().ewald_method_ == "pme") {
+        Ewald_pme pme(ctx, ctx.settings().ewald_pme_order_);
+        ewald_g = pme.reciprocal_sum();
+    } else {
+        #pragma omp parallel for reduction(+ : ewald_g)
+        for (int igloc = 0; igloc < gvec.count(); igloc++) {
+            int ig = gvec.offset() + igloc;
+            if (!ig) {
+                continue;
+            }
 
-        double g2 = std::pow(gvec.gvec_len(ig), 2);
+            double g2 = std::pow(gvec.gvec_len(ig), 2);
 
-        double_complex rho(0, 0);
+            double_complex rho(0, 0);
 
-        for (int ia = 0; ia < unit_cell.num_atoms(); ia++) {
-            rho += ctx.gvec_phase_factor(gvec.gvec(ig), ia) * static_cast<double>(unit_cell.atom(ia).zn());
-        }
+            for (int ia = 0; ia < unit_cell.num_atoms(); ia++) {
+                rho += ctx.gvec_phase_factor(gvec.gvec(ig), ia) * static_cast<double>(unit_cell.atom(ia).zn());
+            }
 
-        ewald_g += std::pow(std::abs(rho), 2) * std::exp(-g2 / 4 / alpha) / g2;
-    }
+            ewald_g += std::pow(std::abs(rho), 2) * std::exp(-g2 / 4 / alpha) / g2;
+        }
 
-    ctx.comm().allreduce(&ewald_g, 1);
-    if (gvec.reduced()) {
-        ewald_g *= 2;
+        ctx.comm().allreduce(&ewald_g, 1);
+        if (gvec.reduced()) {
+            ewald_g *= 2;
+        }
+        ewald_g *= (twopi / unit_cell.omega());
     }
     /* remaining G=0 contribution */
-    ewald_g -= std::pow(unit_cell.num_electrons(), 2) / alpha / 4;
-    ewald_g *= (twopi / unit_cell.omega());
+    ewald_g -= (twopi / unit_cell.omega()) * std::pow(unit_cell.num_electrons(), 2) / alpha / 4;
 
     /* remove self-interaction */
     for (int ia = 0; ia < unit_cell.num_atoms(); ia++) {
@@ -85,8 +85,10 @@ namespace sirius {
  *      \Big|^2 - \sum_{\alpha} Z_{\alpha}^2 \sqrt{\frac{\lambda}{\pi}} - \frac{2\pi}{\Omega}
  *      \frac{N_{el}^2}{4 \lambda}
  *  \f]
+ *  The reciprocal-space sum is evaluated with the smooth particle-mesh Ewald method if "pme" is selected as
+ *  the Ewald method in the settings.
  */
-double ewald_energy(const Simulation_context& ctx, const Gvec& gvec, const Unit_cell& unit_cell);
+double ewald_energy(Simulation_context& ctx, const Gvec& gvec, const Unit_cell& unit_cell);
 
 /// Returns exchange correlation potential.
 double energy_vxc(Density const& density, Potential const& potential);
@@ -26,9 +26,47 @@
 #define __SMEARING_HPP__
 
 #include <cmath>
+#include <string>
+#include <map>
+#include <algorithm>
+#include <stdexcept>
 
 namespace smearing {
 
+/// Type of smearing function used to compute band occupancies.
+enum class smearing_t
+{
+    /// Gaussian smearing.
+    gaussian,
+
+    /// Fermi-Dirac distribution.
+    fermi_dirac,
+
+    /// First-order Methfessel-Paxton smearing.
+    methfessel_paxton,
+
+    /// Marzari-Vanderbilt (cold) smearing.
+    cold
+};
+
+/// Get smearing type from its label.
+inline smearing_t get_smearing_t(std::string name__)
+{
+    std::transform(name__.begin(), name__.end(), name__.begin(), ::tolower);
+
+    std::map<std::string, smearing_t> const m = {
+        {"gaussian", smearing_t::gaussian},
+        {"fermi_dirac", smearing_t::fermi_dirac},
+        {"methfessel_paxton", smearing_t::methfessel_paxton},
+        {"cold", smearing_t::cold},
+        {"marzari_vanderbilt", smearing_t::cold}};
+
+    if (m.count(name__) == 0) {
+        throw std::runtime_error("[smearing::get_smearing_t] wrong smearing type: " + name__);
+    }
+    return m.at(name__);
+}
+
 inline double fermi_dirac(double e)
 {
     double kT = 0.001;
@@ -46,6 +84,115 @@ inline double gaussian(double e, double delta)
     return 0.5 * (1 - std::erf(e / delta));
 }
 
+/* In the functions below the occupancy is computed for the energy e = E - E_F, measured from the Fermi level,
+ * and the smearing width delta. The "_delta" functions return the (negative) derivative of the occupancy with
+ * respect to the energy, which is the corresponding approximation to the delta-function. */
+
+inline double fermi_dirac(double e, double delta)
+{
+    double x = e / delta;
+    if (x > 50) {
+        return 0.0;
+    }
+    if (x < -50) {
+        return 1.0;
+    }
+    return 1.0 / (std::exp(x) + 1.0);
+}
+
+inline double fermi_dirac_delta(double e, double delta)
+{
+    double x = e / delta;
+    if (std::abs(x) > 50) {
+        return 0.0;
+    }
+    double f = 1.0 / (std::exp(x) + 1.0);
+    return f * (1 - f) / delta;
+}
+
+inline double gaussian_delta(double e, double delta)
+{
+    const double pi = 3.1415926535897932385;
+
+    double x = e / delta;
+    return std::exp(-x * x) / std::sqrt(pi) / delta;
+}
+
+/// First-order Methfessel-Paxton occupancy.
+inline double methfessel_paxton(double e, double delta)
+{
+    const double pi = 3.1415926535897932385;
+
+    double x = e / delta;
+    return 0.5 * (1 - std::erf(x)) - x * std::exp(-x * x) / 2 / std::sqrt(pi);
+}
+
+inline double methfessel_paxton_delta(double e, double delta)
+{
+    const double pi = 3.1415926535897932385;
+
+    double x = e / delta;
+    return std::exp(-x * x) * (1.5 - x * x) / std::sqrt(pi) / delta;
+}
+
+/// Marzari-Vanderbilt (cold smearing) occupancy.
+inline double marzari_vanderbilt(double e, double delta)
+{
+    const double pi = 3.1415926535897932385;
+
+    double u = e / delta + 1 / std::sqrt(2.0);
+    return 0.5 * (1 - std::erf(u)) + std::exp(-u * u) / std::sqrt(2 * pi);
+}
+
+inline double marzari_vanderbilt_delta(double e, double delta)
+{
+    const double pi = 3.1415926535897932385;
+
+    double x = e / delta;
+    double u = x + 1 / std::sqrt(2.0);
+    return std::exp(-u * u) * (2 + std::sqrt(2.0) * x) / std::sqrt(pi) / delta;
+}
+
+/// Occupancy of a state with energy e (measured from the Fermi level) for a given smearing type.
+inline double occupancy(smearing_t type__, double e, double delta)
+{
+    switch (type__) {
+        case smearing_t::gaussian: {
+            return gaussian(e, delta);
+        }
+        case smearing_t::fermi_dirac: {
+            return fermi_dirac(e, delta);
+        }
+        case smearing_t::methfessel_paxton: {
+            return methfessel_paxton(e, delta);
+        }
+        case smearing_t::cold: {
+            return marzari_vanderbilt(e, delta);
+        }
+    }
+    return 0;
+}
+
+/// Derivative of the occupancy with respect to the Fermi level.
+inline double delta(smearing_t type__, double e, double width)
+{
+    switch (type__) {
+        case smearing_t::gaussian: {
+            return gaussian_delta(e, width);
+        }
+        case smearing_t::fermi_dirac: {
+            return fermi_dirac_delta(e, width);
+        }
+        case smearing_t::methfessel_paxton: {
+            return methfessel_paxton_delta(e, width);
+        }
+        case smearing_t::cold: {
+            return marzari_vanderbilt_delta(e, width);
+        }
+    }
+    return 0;
+}
+
 inline double cold(double e)
 {
     const double pi = 3.1415926535897932385;
@@ -35,6 +35,13 @@ namespace sirius {
 
 using double_complex = std::complex<double>;
 
+template <typename T>
+class Smooth_periodic_function;
+
+template <typename T>
+void fft_transform(std::vector<Smooth_periodic_function<T>*> const& f__, int direction__,
+                   std::vector<spfft::Transform>& spfft_batch__);
+
 /// Representation of a smooth (Fourier-transformable) periodic function.
 /** The class is designed to handle periodic functions such as density or potential, defined on a regular FFT grid.
  *  The following functionality is provided:
@@ -69,9 +76,23 @@ class Smooth_periodic_function
         gvecp_->gather_pw_fft(f_pw_local_.at(sddk::memory_t::host), f_pw_fft_.at(sddk::memory_t::host));
     }
 
+    /// Copy the local part of the PW coefficients from the FFT storage after the forward transformation.
+    inline void scatter_f_pw_fft()
+    {
+        if (gvecp_->comm_ortho_fft().size() != 1) {
+            int count  = gvecp_->gvec_fft_slab().counts[gvecp_->comm_ortho_fft().rank()];
+            int offset = gvecp_->gvec_fft_slab().offsets[gvecp_->comm_ortho_fft().rank()];
+            std::memcpy(f_pw_local_.at(sddk::memory_t::host), f_pw_fft_.at(sddk::memory_t::host, offset),
+                        count * sizeof(double_complex));
+        }
+    }
+
     Smooth_periodic_function(Smooth_periodic_function<T> const& src__) = delete;
     Smooth_periodic_function<T>& operator=(Smooth_periodic_function<T> const& src__) = delete;
 
+    friend void sirius::fft_transform<T>(std::vector<Smooth_periodic_function<T>*> const& f__, int direction__,
+                                         std::vector<spfft::Transform>& spfft_batch__);
+
   public:
     /// Default constructor.
     Smooth_periodic_function()
@@ -222,12 +243,7 @@ class Smooth_periodic_function
                 spfft_input(*spfft_, &f_rg_[0]);
                 spfft_->forward(SPFFT_PU_HOST, reinterpret_cast<double*>(f_pw_fft_.at(sddk::memory_t::host)),
                                 SPFFT_FULL_SCALING);
-                if (gvecp_->comm_ortho_fft().size() != 1) {
-                    int count  = gvecp_->gvec_fft_slab().counts[gvecp_->comm_ortho_fft().rank()];
-                    int offset = gvecp_->gvec_fft_slab().offsets[gvecp_->comm_ortho_fft().rank()];
-                    std::memcpy(f_pw_local_.at(sddk::memory_t::host), f_pw_fft_.at(sddk::memory_t::host, offset),
-                                count * sizeof(double_complex));
-                }
+                scatter_f_pw_fft();
                 break;
             }
             default: {
@@ -303,6 +319,79 @@ class Smooth_periodic_function
     }
 };
 
+/// Transform a set of smooth periodic functions defined on the same FFT grid.
+/** The functions are transformed in batches of the size of the pool of FFT drivers. Each batch is processed with a
+ *  single multi-transform call of SpFFT, which pipelines the transformations and their MPI exchanges. The drivers
+ *  in the pool must be independent copies of the FFT driver of the functions (see Simulation_context::spfft_batch).
+ *  If the pool has less than two drivers, the functions are transformed one by one.
+ *
+ *  \param [in] f           List of functions.
+ *  \param [in] direction   Direction of the transformation: 1 (to real space) or -1 (to plane-wave domain).
+ *  \param [in] spfft_batch Pool of independent FFT drivers.
+ */
+template <typename T>
+void fft_transform(std::vector<Smooth_periodic_function<T>*> const& f__, int direction__,
+                   std::vector<spfft::Transform>& spfft_batch__)
+{
+    PROFILE("sirius::fft_transform");
+
+    int nbatch = static_cast<int>(spfft_batch__.size());
+
+    if (nbatch < 2) {
+        for (auto f : f__) {
+            f->fft_transform(direction__);
+        }
+        return;
+    }
+
+    for (auto f : f__) {
+        if (f->spfft().local_slice_size() != spfft_batch__[0].local_slice_size() ||
+            f->spfft().num_local_elements() != spfft_batch__[0].num_local_elements()) {
+            throw std::runtime_error("[sirius::fft_transform] FFT driver of the function does not match the pool");
+        }
+    }
+
+    std::vector<SpfftProcessingUnitType> pu(nbatch, SPFFT_PU_HOST);
+    std::vector<SpfftScalingType> scaling(nbatch, SPFFT_FULL_SCALING);
+
+    for (int i0 = 0; i0 < static_cast<int>(f__.size()); i0 += nbatch) {
+        int nb = std::min(nbatch, static_cast<int>(f__.size()) - i0);
+        switch (direction__) {
+            case 1: {
+                std::vector<double const*> pw_ptr(nb);
+                for (int j = 0; j < nb; j++) {
+                    auto f = f__[i0 + j];
+                    if (f->gvecp_->comm_ortho_fft().size() != 1) {
+                        f->gather_f_pw_fft();
+                    }
+                    pw_ptr[j] = reinterpret_cast<double const*>(f->f_pw_fft_.at(sddk::memory_t::host));
+                }
+                spfft::multi_transform_backward(nb, spfft_batch__.data(), pw_ptr.data(), pu.data());
+                for (int j = 0; j < nb; j++) {
+                    spfft_output(spfft_batch__[j], &f__[i0 + j]->f_rg_[0]);
+                }
+                break;
+            }
+            case -1: {
+                std::vector<double*> pw_ptr(nb);
+                for (int j = 0; j < nb; j++) {
+                    auto f = f__[i0 + j];
+                    spfft_input(spfft_batch__[j], &f->f_rg_[0]);
+                    pw_ptr[j] = reinterpret_cast<double*>(f->f_pw_fft_.at(sddk::memory_t::host));
+                }
+                spfft::multi_transform_forward(nb, spfft_batch__.data(), pu.data(), pw_ptr.data(), scaling.data());
+                for (int j = 0; j < nb; j++) {
+                    f__[i0 + j]->scatter_f_pw_fft();
+                }
+                break;
+            }
+            default: {
+                throw std::runtime_error("wrong FFT direction");
+            }
+        }
+    }
+}
+
 /// Vector of the smooth periodic functions.
 template <typename T>
 class Smooth_periodic_vector_function : public std::array<Smooth_periodic_function<T>, 3>
@@ -346,6 +435,12 @@ class Smooth_periodic_vector_function : public std::array<Smooth_periodic_functi
         assert(gvecp_ != nullptr);
         return *gvecp_;
     }
+
+    /// Transform all three components at once using a pool of independent FFT drivers.
+    void fft_transform(int direction__, std::vector<spfft::Transform>& spfft_batch__)
+    {
+        sirius::fft_transform<T>({&(*this)[0], &(*this)[1], &(*this)[2]}, direction__, spfft_batch__);
+    }
 };
 
 /// Gradient of the function in the plane-wave domain.
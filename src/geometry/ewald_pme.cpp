@@ -0,0 +1,212 @@
+// Copyright (c) 2013-2020 Anton Kozhevnikov, Thomas Schulthess
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+// the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+//    following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+//    and the following disclaimer in the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** \file ewald_pme.cpp
+ *
+ *  \brief Contains implementation of sirius::Ewald_pme class.
+ */
+
+#include "ewald_pme.hpp"
+#include "function3d/smooth_periodic_function.hpp"
+#include "SDDK/omp.hpp"
+
+namespace sirius {
+
+Ewald_pme::Ewald_pme(Simulation_context& ctx__, int order__)
+    : ctx_(ctx__)
+    , order_(order__)
+{
+    /* for odd orders the Euler spline factors are singular at m = K/2 */
+    if (order_ < 4 || order_ % 2) {
+        std::stringstream s;
+        s << "[sirius::Ewald_pme] B-spline order must be even and not smaller than 4; order : " << order_;
+        throw std::runtime_error(s.str());
+    }
+
+    /* values of the B-spline at integer points: M_p(k + 1), k = 0...p-2 */
+    std::vector<double> m(order_);
+    std::vector<double> dm(order_);
+    bspline(0, m.data(), dm.data());
+
+    for (int x : {0, 1, 2}) {
+        int K = ctx_.fft_grid()[x];
+        bsp_mod_[x] = std::vector<double>(K);
+        for (int i = 0; i < K; i++) {
+            double_complex z(0, 0);
+            for (int k = 0; k <= order_ - 2; k++) {
+                z += m[k] * std::exp(double_complex(0, twopi * i * k / K));
+            }
+            bsp_mod_[x][i] = 1.0 / std::norm(z);
+        }
+    }
+}
+
+void Ewald_pme::bspline(double w__, double* theta__, double* dtheta__) const
+{
+    /* order 2 */
+    theta__[0] = 1 - w__;
+    theta__[1] = w__;
+    for (int n = 3; n <= order_; n++) {
+        /* derivative of order p is expressed through the B-spline of order p-1 */
+        if (n == order_) {
+            dtheta__[0] = -theta__[0];
+            for (int j = 1; j < n - 1; j++) {
+                dtheta__[j] = theta__[j - 1] - theta__[j];
+            }
+            dtheta__[n - 1] = theta__[n - 2];
+        }
+        double div      = 1.0 / (n - 1);
+        theta__[n - 1] = div * w__ * theta__[n - 2];
+        for (int j = 1; j < n - 1; j++) {
+            theta__[n - 1 - j] = div * ((w__ + j) * theta__[n - 2 - j] + (n - j - w__) * theta__[n - 1 - j]);
+        }
+        theta__[0] = div * (1 - w__) * theta__[0];
+    }
+}
+
+double Ewald_pme::reciprocal_sum(sddk::mdarray<double, 2>* forces__) const
+{
+    PROFILE("sirius::Ewald_pme::reciprocal_sum");
+
+    auto& uc = ctx_.unit_cell();
+    int na   = uc.num_atoms();
+    int p    = order_;
+
+    std::array<int, 3> K;
+    for (int x : {0, 1, 2}) {
+        K[x] = ctx_.fft_grid()[x];
+    }
+    double N = static_cast<double>(K[0]) * K[1] * K[2];
+
+    int z_off = ctx_.spfft().local_z_offset();
+    int nz    = ctx_.spfft().local_z_length();
+
+    /* first grid point and B-spline weights of each atom for each direction */
+    sddk::mdarray<int, 2> grid_beg(3, na);
+    sddk::mdarray<double, 3> theta(p, 3, na);
+    sddk::mdarray<double, 3> dtheta(p, 3, na);
+    #pragma omp parallel for schedule(static)
+    for (int ia = 0; ia < na; ia++) {
+        auto pos = uc.atom(ia).position();
+        for (int x : {0, 1, 2}) {
+            double u = K[x] * (pos[x] - std::floor(pos[x]));
+            int i0   = static_cast<int>(std::floor(u));
+            bspline(u - i0, &theta(0, x, ia), &dtheta(0, x, ia));
+            grid_beg(x, ia) = i0 - p + 1;
+        }
+    }
+
+    auto wrap = [](int i, int n) { return ((i % n) + n) % n; };
+
+    /* spread charges over the local z-planes of the FFT box; each thread works on its own subset of planes */
+    Smooth_periodic_function<double> q(ctx_.spfft(), ctx_.gvec_partition());
+    q.f_rg().zero();
+    #pragma omp parallel
+    {
+        int nt  = omp_get_num_threads();
+        int tid = omp_get_thread_num();
+        for (int ia = 0; ia < na; ia++) {
+            double zn = uc.atom(ia).zn();
+            for (int j2 = 0; j2 < p; j2++) {
+                int iz = wrap(grid_beg(2, ia) + j2, K[2]) - z_off;
+                if (iz < 0 || iz >= nz || iz % nt != tid) {
+                    continue;
+                }
+                for (int j1 = 0; j1 < p; j1++) {
+                    int iy   = wrap(grid_beg(1, ia) + j1, K[1]);
+                    double w = zn * theta(j2, 2, ia) * theta(j1, 1, ia);
+                    for (int j0 = 0; j0 < p; j0++) {
+                        int ix = wrap(grid_beg(0, ia) + j0, K[0]);
+                        q.f_rg(ctx_.fft_grid().index_by_coord(ix, iy, iz)) += w * theta(j0, 0, ia);
+                    }
+                }
+            }
+        }
+    }
+    q.fft_transform(-1);
+
+    /* forward transformation is scaled by 1/N */
+    double alpha = ctx_.ewald_lambda();
+    double ewald_g{0};
+    #pragma omp parallel for schedule(static) reduction(+:ewald_g)
+    for (int igloc = 0; igloc < ctx_.gvec().count(); igloc++) {
+        int ig = ctx_.gvec().offset() + igloc;
+        if (!ig) {
+            q.f_pw_local(igloc) = 0;
+            continue;
+        }
+        auto G    = ctx_.gvec().gvec(ig);
+        double g2 = std::pow(ctx_.gvec().gvec_len(ig), 2);
+        double f  = std::exp(-g2 / 4 / alpha) / g2;
+        for (int x : {0, 1, 2}) {
+            f *= bsp_mod_[x][wrap(G[x], K[x])];
+        }
+        ewald_g += f * std::norm(q.f_pw_local(igloc)) * N * N;
+        /* plane-wave coefficients of the potential dE/dQ(k) */
+        q.f_pw_local(igloc) *= (fourpi / uc.omega()) * N * f;
+    }
+    ctx_.comm().allreduce(&ewald_g, 1);
+    if (ctx_.gvec().reduced()) {
+        ewald_g *= 2;
+    }
+    ewald_g *= (twopi / uc.omega());
+
+    if (forces__) {
+        q.fft_transform(1);
+
+        /* derivatives of the energy with respect to scaled fractional coordinates */
+        sddk::mdarray<double, 2> dedu(3, na);
+        dedu.zero();
+        #pragma omp parallel for schedule(static)
+        for (int ia = 0; ia < na; ia++) {
+            double zn = uc.atom(ia).zn();
+            for (int j2 = 0; j2 < p; j2++) {
+                int iz = wrap(grid_beg(2, ia) + j2, K[2]) - z_off;
+                if (iz < 0 || iz >= nz) {
+                    continue;
+                }
+                for (int j1 = 0; j1 < p; j1++) {
+                    int iy = wrap(grid_beg(1, ia) + j1, K[1]);
+                    for (int j0 = 0; j0 < p; j0++) {
+                        int ix   = wrap(grid_beg(0, ia) + j0, K[0]);
+                        double v = zn * q.f_rg(ctx_.fft_grid().index_by_coord(ix, iy, iz));
+                        dedu(0, ia) += v * dtheta(j0, 0, ia) * theta(j1, 1, ia) * theta(j2, 2, ia);
+                        dedu(1, ia) += v * theta(j0, 0, ia) * dtheta(j1, 1, ia) * theta(j2, 2, ia);
+                        dedu(2, ia) += v * theta(j0, 0, ia) * theta(j1, 1, ia) * dtheta(j2, 2, ia);
+                    }
+                }
+            }
+        }
+        ctx_.comm_fft().allreduce(dedu.at(memory_t::host), static_cast<int>(dedu.size()));
+
+        /* F = -dE/dr = -dE/du du/dx dx/dr */
+        auto& inv_lv = uc.inverse_lattice_vectors();
+        for (int ia = 0; ia < na; ia++) {
+            for (int x : {0, 1, 2}) {
+                for (int i : {0, 1, 2}) {
+                    (*forces__)(x, ia) -= dedu(i, ia) * K[i] * inv_lv(i, x);
+                }
+            }
+        }
+    }
+
+    return ewald_g;
+}
+
+} // namespace sirius
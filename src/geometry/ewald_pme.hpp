@@ -0,0 +1,75 @@
+// Copyright (c) 2013-2020 Anton Kozhevnikov, Thomas Schulthess
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+// the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+//    following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+//    and the following disclaimer in the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** \file ewald_pme.hpp
+ *
+ *  \brief Contains declaration of sirius::Ewald_pme class.
+ */
+
+#ifndef __EWALD_PME_HPP__
+#define __EWALD_PME_HPP__
+
+#include "simulation_context.hpp"
+
+namespace sirius {
+
+/// Smooth particle-mesh Ewald summation of the reciprocal-space part of the ion-ion interaction.
+/** The structure factor of the point charges
+ *  \f[
+ *      S({\bf G}) = \sum_{\alpha} Z_{\alpha} e^{i {\bf G} {\bf r}_{\alpha}}
+ *  \f]
+ *  is approximated by the Fourier transform of the charges spread over the dense FFT grid with the cardinal
+ *  B-splines \f$ M_p \f$ of order \f$ p \f$ (U. Essmann et al., J. Chem. Phys. 103, 8577 (1995)):
+ *  \f[
+ *      S({\bf G}) \approx b_1(m_1) b_2(m_2) b_3(m_3) \sum_{\bf k} Q({\bf k}) e^{i {\bf G} {\bf r}_{\bf k}} \quad
+ *      Q({\bf k}) = \sum_{\alpha} Z_{\alpha} \prod_{i=1}^{3} M_p(u_{\alpha i} - k_i)
+ *  \f]
+ *  where \f$ u_{\alpha i} = K_i x_{\alpha i} \f$ are the scaled fractional coordinates of atoms and \f$ K_i \f$ are
+ *  the dimensions of the FFT box. The cost of the reciprocal-space sum is then \f$ O(N_{G} \log N_{G} + N_{atoms}) \f$
+ *  instead of \f$ O(N_{G} N_{atoms}) \f$ of the direct summation. Forces are obtained by differentiating the
+ *  B-splines with respect to atomic positions.
+ */
+class Ewald_pme
+{
+  private:
+    /// Simulation context.
+    Simulation_context& ctx_;
+
+    /// Order of the B-spline interpolation.
+    int order_;
+
+    /// Squared moduli \f$ |b_i(m)|^2 \f$ of the Euler exponential spline factors for each dimension of the FFT box.
+    std::array<std::vector<double>, 3> bsp_mod_;
+
+    /// Compute B-spline weights \f$ M_p(w + p - 1 - j) \f$ and their derivatives for \f$ w \in [0, 1) \f$.
+    void bspline(double w__, double* theta__, double* dtheta__) const;
+
+  public:
+    /// Constructor.
+    Ewald_pme(Simulation_context& ctx__, int order__);
+
+    /// Compute the reciprocal-space part of the Ewald energy and, optionally, forces.
+    /** The \f$ {\bf G}=0 \f$ term and the self-interaction term are not included. If the pointer to the array of
+     *  forces is provided, the reciprocal-space contribution to the force is added to each atom. */
+    double reciprocal_sum(sddk::mdarray<double, 2>* forces__ = nullptr) const;
+};
+
+} // namespace sirius
+
+#endif // __EWALD_PME_HPP__
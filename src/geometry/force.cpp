@@ -31,6 +31,7 @@
 #include "beta_projectors/beta_projectors.hpp"
 #include "beta_projectors/beta_projectors_gradient.hpp"
 #include "non_local_functor.hpp"
+#include "ewald_pme.hpp"
 #include "hamiltonian/hamiltonian.hpp"
 
 namespace sirius {
@@ -279,48 +280,53 @@ mdarray<double, 2> const& Force::calc_forces_ewald()
 
     double alpha = ctx_.ewald_lambda();
 
-    double prefac = (ctx_.gvec().reduced() ? 4.0 : 2.0) * (twopi / unit_cell.omega());
+    if (ctx_.settings().ewald_method_ == "pme") {
+        Ewald_pme pme(ctx_, ctx_.settings().ewald_pme_order_);
+        pme.reciprocal_sum(&forces_ewald_);
+    } else {
+        double prefac = (ctx_.gvec().reduced() ? 4.0 : 2.0) * (twopi / unit_cell.omega());
 
-    int ig0{0};
-    if (ctx_.comm().rank() == 0) {
-        ig0 = 1;
-    }
+        int ig0{0};
+        if (ctx_.comm().rank() == 0) {
+            ig0 = 1;
+        }
 
-    mdarray<double_complex, 1> rho_tmp(ctx_.gvec().count());
-    rho_tmp.zero();
-    #pragma omp parallel for schedule(static)
-    for (int igloc = ig0; igloc < ctx_.gvec().count(); igloc++) {
-        int ig = ctx_.gvec().offset() + igloc;
+        mdarray<double_complex, 1> rho_tmp(ctx_.gvec().count());
+        rho_tmp.zero();
+        #pragma omp parallel for schedule(static)
+        for (int igloc = ig0; igloc < ctx_.gvec().count(); igloc++) {
+            int ig = ctx_.gvec().offset() + igloc;
 
-        double_complex rho(0, 0);
+            double_complex rho(0, 0);
 
-        for (int ja = 0; ja < unit_cell.num_atoms(); ja++) {
-            rho += ctx_.gvec_phase_factor(ig, ja) * static_cast<double>(unit_cell.atom(ja).zn());
-        }
+            for (int ja = 0; ja < unit_cell.num_atoms(); ja++) {
+                rho += ctx_.gvec_phase_factor(ig, ja) * static_cast<double>(unit_cell.atom(ja).zn());
+            }
 
-        rho_tmp[igloc] = std::conj(rho);
-    }
+            rho_tmp[igloc] = std::conj(rho);
+        }
 
-    #pragma omp parallel for
-    for (int ja = 0; ja < unit_cell.num_atoms(); ja++) {
-        for (int igloc = ig0; igloc < ctx_.gvec().count(); igloc++) {
-            int ig = ctx_.gvec().offset() + igloc;
+        #pragma omp parallel for
+        for (int ja = 0; ja < unit_cell.num_atoms(); ja++) {
+            for (int igloc = ig0; igloc < ctx_.gvec().count(); igloc++) {
+                int ig = ctx_.gvec().offset() + igloc;
 
-            double g2 = std::pow(ctx_.gvec().gvec_len(ig), 2);
+                double g2 = std::pow(ctx_.gvec().gvec_len(ig), 2);
 
-            /* cartesian form for getting cartesian force components */
-            vector3d<double> gvec_cart = ctx_.gvec().gvec_cart<index_domain_t::local>(igloc);
+                /* cartesian form for getting cartesian force components */
+                vector3d<double> gvec_cart = ctx_.gvec().gvec_cart<index_domain_t::local>(igloc);
 
-            double scalar_part = prefac * (rho_tmp[igloc] * ctx_.gvec_phase_factor(ig, ja)).imag() *
-                                 static_cast<double>(unit_cell.atom(ja).zn()) * std::exp(-g2 / (4 * alpha)) / g2;
+                double scalar_part = prefac * (rho_tmp[igloc] * ctx_.gvec_phase_factor(ig, ja)).imag() *
+                                     static_cast<double>(unit_cell.atom(ja).zn()) * std::exp(-g2 / (4 * alpha)) / g2;
 
-            for (int x : {0, 1, 2}) {
-                forces_ewald_(x, ja) += scalar_part * gvec_cart[x];
+                for (int x : {0, 1, 2}) {
+                    forces_ewald_(x, ja) += scalar_part * gvec_cart[x];
+                }
             }
         }
-    }
 
-    ctx_.comm().allreduce(&forces_ewald_(0, 0), 3 * ctx_.unit_cell().num_atoms());
+        ctx_.comm().allreduce(&forces_ewald_(0, 0), 3 * ctx_.unit_cell().num_atoms());
+    }
 
     double invpi = 1. / pi;
 
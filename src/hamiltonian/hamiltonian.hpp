@@ -178,6 +178,11 @@ class Hamiltonian_k
     /// Assignment operator is forbidden.
     Hamiltonian_k& operator=(Hamiltonian_k const& src__) = delete;
 
+    /// Return true if the plane-wave beta-projectors are used by the application of H and S.
+    /** With the real-space beta-projectors the D-operator is applied by the local operator, and the plane-wave
+     *  projectors are left only for the augmentation part of the S-operator. */
+    bool need_beta_pw() const;
+
   public:
     Hamiltonian_k(Hamiltonian0& H0__, K_point& kp__);
 
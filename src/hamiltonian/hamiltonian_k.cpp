@@ -40,18 +40,30 @@ Hamiltonian_k::Hamiltonian_k(Hamiltonian0& H0__, K_point& kp__) // TODO: move ki
     , kp_(kp__)
 {
     PROFILE("sirius::Hamiltonian_k");
-    H0_.local_op().prepare_k(kp_.gkvec_partition());
+    if (kp_.beta_projectors_real_space()) {
+        /* non-local D-operator is applied together with the local part of the Hamiltonian */
+        H0_.local_op().prepare_k(kp_.spfft_transform(), kp_.gkvec_partition(), kp_.spfft_transform_pair(),
+                                 kp_.beta_projectors_real_space(), &H0_.D());
+    } else {
+        H0_.local_op().prepare_k(kp_.spfft_transform(), kp_.gkvec_partition(), kp_.spfft_transform_pair());
+    }
     if (!H0_.ctx().full_potential()) {
-        if (H0_.ctx().iterative_solver_input().type_ != "exact") {
+        if (H0_.ctx().iterative_solver_input().type_ != "exact" && need_beta_pw()) {
             kp_.beta_projectors().prepare();
         }
     }
 }
 
+bool Hamiltonian_k::need_beta_pw() const
+{
+    return !kp_.beta_projectors_real_space() || H0_.ctx().unit_cell().augment();
+}
+
 Hamiltonian_k::~Hamiltonian_k()
 {
+    H0_.local_op().dismiss_k();
     if (!H0_.ctx().full_potential()) {
-        if (H0_.ctx().iterative_solver_input().type_ != "exact") {
+        if (H0_.ctx().iterative_solver_input().type_ != "exact" && need_beta_pw()) {
             kp_.beta_projectors().dismiss();
         }
     }
@@ -801,7 +813,16 @@ void Hamiltonian_k::apply_h_s(spin_range spins__, int N__, int n__, Wave_functio
 
     /* return if there are no beta-projectors */
     if (H0().ctx().unit_cell().mt_lo_basis_size()) {
-        apply_non_local_d_q<T>(spins__, N__, n__, kp().beta_projectors(), phi__, &H0().D(), hphi__, &H0().Q(), sphi__);
+        if (kp().beta_projectors_real_space()) {
+            /* D-operator was already applied in real space by the local operator; S is unity without augmentation */
+            if (sphi__ != nullptr && H0().ctx().unit_cell().augment()) {
+                apply_non_local_d_q<T>(spins__, N__, n__, kp().beta_projectors(), phi__, nullptr, nullptr,
+                                       &H0().Q(), sphi__);
+            }
+        } else {
+            apply_non_local_d_q<T>(spins__, N__, n__, kp().beta_projectors(), phi__, &H0().D(), hphi__, &H0().Q(),
+                                   sphi__);
+        }
     }
 
     /* apply the hubbard potential if relevant */
@@ -1198,7 +1219,7 @@ void Hamiltonian_k::apply_fv_h_o(bool apw_only__, bool phi_is_lo__, int N__, int
                     for (int xi = 0; xi < naw; xi++) {
                         int lm_aw    = type.indexb(xi).lm;
                         int idxrf_aw = type.indexb(xi).idxrf;
-                        auto& gc     = H0_.gaunt_coefs().gaunt_vector(lm_aw, lm_lo);
+                        auto gc      = H0_.gaunt_coefs().gaunt_vector(lm_aw, lm_lo);
                         hmt(xi, ilo) = atom.radial_integrals_sum_L3<spin_block_t::nm>(idxrf_aw, idxrf_lo, gc);
                     }
                 }
@@ -1331,7 +1352,7 @@ void Hamiltonian_k::apply_fv_h_o(bool apw_only__, bool phi_is_lo__, int N__, int
                                 }
                             }
                             if (hphi__ != nullptr) {
-                                auto& gc = H0_.gaunt_coefs().gaunt_vector(lm_lo, lm1);
+                                auto gc = H0_.gaunt_coefs().gaunt_vector(lm_lo, lm1);
                                 for (int i = 0; i < n__; i++) {
                                     hphi__->mt_coeffs(0).prime(offset_mt_coeffs + ilo, N__ + i) +=
                                         phi_lo_block(offsets_lo[ialoc] + jlo, i) *
@@ -1360,7 +1381,7 @@ void Hamiltonian_k::apply_fv_h_o(bool apw_only__, bool phi_is_lo__, int N__, int
                                     for (int xi = 0; xi < type.mt_aw_basis_size(); xi++) {
                                         int lm_aw    = type.indexb(xi).lm;
                                         int idxrf_aw = type.indexb(xi).idxrf;
-                                        auto& gc     = H0_.gaunt_coefs().gaunt_vector(lm_lo, lm_aw);
+                                        auto gc      = H0_.gaunt_coefs().gaunt_vector(lm_lo, lm_aw);
                                         z += atom.radial_integrals_sum_L3<spin_block_t::nm>(idxrf_lo, idxrf_aw, gc) *
                                              alm_phi(offsets_aw[ialoc] + xi, i);
                                     }
@@ -25,6 +25,8 @@
 #include "local_operator.hpp"
 #include "potential/potential.hpp"
 #include "function3d/smooth_periodic_function.hpp"
+#include "SDDK/fft_gamma_pair.hpp"
+#include "beta_projectors/beta_projectors_real_space.hpp"
 #include "utils/profiler.hpp"
 
 using namespace sddk;
@@ -177,12 +179,26 @@ Local_operator::Local_operator(Simulation_context const& ctx__, spfft::Transform
     }
 }
 
-void Local_operator::prepare_k(Gvec_partition const& gkvec_p__)
+void Local_operator::prepare_k(spfft::Transform& spfftk__, Gvec_partition const& gkvec_p__,
+                               Gamma_pair_transform* spfftk_pair__, Beta_projectors_real_space const* beta_rs__,
+                               Non_local_operator* d_op__)
 {
     PROFILE("sirius::Local_operator::prepare_k");
 
     int ngv_fft = gkvec_p__.gvec_count_fft();
 
+    spfftk_pair_ = spfftk_pair__;
+
+    if (beta_rs__ && !d_op__) {
+        throw std::runtime_error("[sirius::Local_operator::prepare_k] D-operator is required for the real-space "
+                                 "beta-projectors");
+    }
+    beta_rs_ = beta_rs__;
+    d_op_    = d_op__;
+
+    /* number of wave-functions transformed at once */
+    int nbatch = (spfftk_pair_) ? 2 : ctx_.control().fft_batch_size_;
+
     /* cache kinteic energy of plane-waves */
     if (static_cast<int>(pw_ekin_.size()) < ngv_fft) {
         pw_ekin_ = mdarray<double, 1>(ngv_fft, ctx_.mem_pool(memory_t::host), "Local_operator::pw_ekin");
@@ -196,14 +212,32 @@ void Local_operator::prepare_k(Gvec_partition const& gkvec_p__)
         pw_ekin_[ig_loc] = 0.5 * dot(gv, gv);
     }
 
-    if (static_cast<int>(vphi_.size(0)) < ngv_fft) {
-        vphi_ = mdarray<double_complex, 1>(ngv_fft, ctx_.mem_pool(memory_t::host), "Local_operator::vphi");
+    if (static_cast<int>(vphi_.size(0)) < ngv_fft || static_cast<int>(vphi_.size(1)) < nbatch) {
+        vphi_ = mdarray<double_complex, 2>(ngv_fft, nbatch, ctx_.mem_pool(memory_t::host), "Local_operator::vphi");
     }
 
     if (fft_coarse_.processing_unit() == SPFFT_PU_GPU) {
         pw_ekin_.allocate(ctx_.mem_pool(memory_t::device)).copy_to(memory_t::device);
         vphi_.allocate(ctx_.mem_pool(memory_t::device));
     }
+
+    /* create independent copies of the k-point FFT driver; each copy has its own grid and buffers, which is
+       required by the multi-transform interface of SpFFT */
+    spfftk_batch_.clear();
+    if (nbatch > 1 && !spfftk_pair_) {
+        PROFILE("sirius::Local_operator::prepare_k|spfft");
+        for (int i = 0; i < nbatch; i++) {
+            spfftk_batch_.emplace_back(spfftk__.clone());
+        }
+    }
+}
+
+void Local_operator::dismiss_k()
+{
+    spfftk_batch_.clear();
+    spfftk_pair_ = nullptr;
+    beta_rs_     = nullptr;
+    d_op_        = nullptr;
 }
 
 static inline void mul_by_veff(spfft::Transform& spfftk__, double* buff__,
@@ -302,9 +336,21 @@ void Local_operator::apply_h(spfft::Transform& spfftk__, Gvec_partition const& g
     /* alias array for all hphi in FFT-friendly storage */
     std::array<mdarray<double_complex, 2>, 2> hphi;
 
+    if (beta_rs_ && (spins__() == 2 || spfftk__.processing_unit() != SPFFT_PU_HOST)) {
+        throw std::runtime_error("[sirius::Local_operator::apply_h] real-space beta-projectors are supported only "
+                                 "on CPU in the spin-collinear case");
+    }
+
+    /* number of wave-functions transformed at once; batched transformation is used in the spin-collinear case */
+    int nbatch = (spins__() == 2 || spfftk_batch_.empty()) ? 1 : static_cast<int>(spfftk_batch_.size());
+    /* pairs of real wave-functions are transformed with one complex FFT */
+    if (spfftk_pair_ && spins__() != 2 && spfftk__.processing_unit() == SPFFT_PU_HOST) {
+        nbatch = 2;
+    }
+
     /* alias for wave-functions that are currently computed */
-    std::array<mdarray<double_complex, 1>, 2> phi1;
-    std::array<mdarray<double_complex, 1>, 2> hphi1;
+    std::vector<std::array<mdarray<double_complex, 1>, 2>> phi1(nbatch);
+    std::vector<std::array<mdarray<double_complex, 1>, 2>> hphi1(nbatch);
 
     /* local number of G-vectors for the FFT transformation */
     int ngv_fft = gkvec_p__.gvec_count_fft();
@@ -312,6 +358,9 @@ void Local_operator::apply_h(spfft::Transform& spfftk__, Gvec_partition const& g
     if (ngv_fft != spfftk__.num_local_elements()) {
         TERMINATE("wrong number of G-vectors");
     }
+    if (!spfftk_batch_.empty() && ngv_fft != spfftk_batch_[0].num_local_elements()) {
+        TERMINATE("wrong number of G-vectors in the batch of FFT drivers");
+    }
 
     memory_t mem_phi{memory_t::none};
     memory_t mem_hphi{memory_t::none};
@@ -361,61 +410,62 @@ void Local_operator::apply_h(spfft::Transform& spfftk__, Gvec_partition const& g
     /* pointer to FFT buffer */
     auto spfft_buf = spfftk__.space_domain_data(spfft_mem);
 
-    auto prepare_phi_hphi = [&](int i) {
+    auto prepare_phi_hphi = [&](int i, int j) {
         for (int ispn : spins__) {
             switch (spfft_mem) {
                 case SPFFT_PU_HOST: {              /* FFT is done on CPU */
                     if (is_host_memory(mem_phi)) { /* wave-functions are also on host memory */
-                        phi1[ispn] = mdarray<double_complex, 1>(phi[ispn].at(memory_t::host, 0, i), ngv_fft);
+                        phi1[j][ispn] = mdarray<double_complex, 1>(phi[ispn].at(memory_t::host, 0, i), ngv_fft);
                     } else { /* wave-functions are on the device memory */
-                        phi1[ispn] = mdarray<double_complex, 1>(ngv_fft, mp);
+                        phi1[j][ispn] = mdarray<double_complex, 1>(ngv_fft, mp);
                         /* copy wave-functions to host memory */
-                        acc::copyout(phi1[ispn].at(memory_t::host), phi[ispn].at(memory_t::device, 0, i), ngv_fft);
+                        acc::copyout(phi1[j][ispn].at(memory_t::host), phi[ispn].at(memory_t::device, 0, i), ngv_fft);
                     }
                     if (is_host_memory(mem_hphi)) {
-                        hphi1[ispn] = mdarray<double_complex, 1>(hphi[ispn].at(memory_t::host, 0, i), ngv_fft);
+                        hphi1[j][ispn] = mdarray<double_complex, 1>(hphi[ispn].at(memory_t::host, 0, i), ngv_fft);
                     } else {
-                        hphi1[ispn] = mdarray<double_complex, 1>(ngv_fft, mp);
+                        hphi1[j][ispn] = mdarray<double_complex, 1>(ngv_fft, mp);
                     }
-                    hphi1[ispn].zero(memory_t::host);
+                    hphi1[j][ispn].zero(memory_t::host);
                     break;
                 }
                 case SPFFT_PU_GPU: { /* FFT is done on GPU */
                     if (is_host_memory(mem_phi)) {
-                        phi1[ispn] = mdarray<double_complex, 1>(ngv_fft, *mpd);
+                        phi1[j][ispn] = mdarray<double_complex, 1>(ngv_fft, *mpd);
                         /* copy wave-functions to device */
-                        acc::copyin(phi1[ispn].at(memory_t::device), phi[ispn].at(memory_t::host, 0, i), ngv_fft);
+                        acc::copyin(phi1[j][ispn].at(memory_t::device), phi[ispn].at(memory_t::host, 0, i), ngv_fft);
                     } else {
-                        phi1[ispn] = mdarray<double_complex, 1>(nullptr, phi[ispn].at(memory_t::device, 0, i), ngv_fft);
+                        phi1[j][ispn] =
+                            mdarray<double_complex, 1>(nullptr, phi[ispn].at(memory_t::device, 0, i), ngv_fft);
                     }
                     if (is_host_memory(mem_hphi)) {
                         /* small buffers in the device memory */
-                        hphi1[ispn] = mdarray<double_complex, 1>(ngv_fft, *mpd);
+                        hphi1[j][ispn] = mdarray<double_complex, 1>(ngv_fft, *mpd);
                     } else {
-                        hphi1[ispn] =
+                        hphi1[j][ispn] =
                             mdarray<double_complex, 1>(nullptr, hphi[ispn].at(memory_t::device, 0, i), ngv_fft);
                     }
-                    hphi1[ispn].zero(memory_t::device);
+                    hphi1[j][ispn].zero(memory_t::device);
                     break;
                 }
             }
         }
     };
 
-    auto store_hphi = [&](int i) {
+    auto store_hphi = [&](int i, int j) {
         for (int ispn : spins__) {
             switch (spfft_mem) {
                 case SPFFT_PU_HOST: { /* FFT is done on CPU */
                     if (is_device_memory(mem_hphi)) {
                         /* copy to device */
-                        acc::copyin(hphi[ispn].at(memory_t::device, 0, i), hphi1[ispn].at(memory_t::host), ngv_fft);
+                        acc::copyin(hphi[ispn].at(memory_t::device, 0, i), hphi1[j][ispn].at(memory_t::host), ngv_fft);
                     }
                     break;
                 }
                 case SPFFT_PU_GPU: { /* FFT is done on GPU */
                     if (is_host_memory(mem_hphi)) {
                         /* copy back to host */
-                        acc::copyout(hphi[ispn].at(memory_t::host, 0, i), hphi1[ispn].at(memory_t::device), ngv_fft);
+                        acc::copyout(hphi[ispn].at(memory_t::host, 0, i), hphi1[j][ispn].at(memory_t::device), ngv_fft);
                     }
                     break;
                 }
@@ -425,20 +475,86 @@ void Local_operator::apply_h(spfft::Transform& spfftk__, Gvec_partition const& g
 
     /* transform wave-function to real space; the result of the transformation is stored in the FFT buffer */
     auto phi_to_r = [&](int ispn) {
-        spfftk__.backward(reinterpret_cast<double const*>(phi1[ispn].at(spfft_memory_t.at(spfft_mem))), spfft_mem);
+        spfftk__.backward(reinterpret_cast<double const*>(phi1[0][ispn].at(spfft_memory_t.at(spfft_mem))), spfft_mem);
     };
 
     /* transform function to PW domain */
     auto vphi_to_G = [&]() {
-        spfftk__.forward(spfft_mem, reinterpret_cast<double*>(vphi_.at(spfft_memory_t.at(spfft_mem))),
+        spfftk__.forward(spfft_mem, reinterpret_cast<double*>(vphi_.at(spfft_memory_t.at(spfft_mem), 0, 0)),
                          SPFFT_FULL_SCALING);
     };
 
+    /* projections <beta|phi> of the real-space wave-function */
+    mdarray<double_complex, 1> beta_phi;
+    if (beta_rs_) {
+        beta_phi = mdarray<double_complex, 1>(beta_rs_->num_beta(), mp);
+    }
+
+    /* multiply by effective potential the wave-function in the FFT buffer; if real-space beta-projectors are
+       used, the non-local part of the Hamiltonian is also added */
+    auto mul_by_veff_beta = [&](spfft::Transform& spfft__, double* buf__, int ispn) {
+        bool is_real = (spfft__.type() == SPFFT_TRANS_R2C);
+        if (beta_rs_) {
+            if (is_real) {
+                beta_rs_->inner(buf__, beta_phi);
+            } else {
+                beta_rs_->inner(reinterpret_cast<double_complex*>(buf__), beta_phi);
+            }
+        }
+        mul_by_veff(spfft__, buf__, veff_vec_, ispn);
+        if (beta_rs_) {
+            beta_rs_->apply_d(*d_op_, ispn, beta_phi);
+            if (is_real) {
+                beta_rs_->add(beta_phi, buf__);
+            } else {
+                beta_rs_->add(beta_phi, reinterpret_cast<double_complex*>(buf__));
+            }
+        }
+    };
+
+    /* transform a batch of wave-functions to real space, multiply by effective potential and transform back */
+    auto apply_v_batch = [&](int ispn, int nb) {
+        std::vector<double const*> phi_ptr(nb);
+        std::vector<double*> vphi_ptr(nb);
+        std::vector<SpfftProcessingUnitType> pu(nb, spfft_mem);
+        std::vector<SpfftScalingType> scaling(nb, SPFFT_FULL_SCALING);
+        for (int j = 0; j < nb; j++) {
+            phi_ptr[j]  = reinterpret_cast<double const*>(phi1[j][ispn].at(spfft_memory_t.at(spfft_mem)));
+            vphi_ptr[j] = reinterpret_cast<double*>(vphi_.at(spfft_memory_t.at(spfft_mem), 0, j));
+        }
+        spfft::multi_transform_backward(nb, spfftk_batch_.data(), phi_ptr.data(), pu.data());
+        for (int j = 0; j < nb; j++) {
+            mul_by_veff_beta(spfftk_batch_[j], spfftk_batch_[j].space_domain_data(spfft_mem), ispn);
+        }
+        spfft::multi_transform_forward(nb, spfftk_batch_.data(), pu.data(), vphi_ptr.data(), scaling.data());
+    };
+
+    /* transform a pair of real wave-functions to real space as psi_1(r) + i psi_2(r), multiply by effective
+       potential and transform back */
+    auto apply_v_pair = [&](int ispn, int nb) {
+        spfftk_pair_->backward(phi1[0][ispn].at(memory_t::host),
+                               (nb == 2) ? phi1[1][ispn].at(memory_t::host) : nullptr);
+        auto buf = spfftk_pair_->space_domain_data();
+        /* beta-projectors are real, so the projections of the pair are p_1 + i p_2 */
+        if (beta_rs_) {
+            beta_rs_->inner(buf, beta_phi);
+        }
+        #pragma omp parallel for schedule(static)
+        for (int ir = 0; ir < nr; ir++) {
+            buf[ir] *= veff_vec_[ispn]->f_rg(ir);
+        }
+        if (beta_rs_) {
+            beta_rs_->apply_d(*d_op_, ispn, beta_phi);
+            beta_rs_->add(beta_phi, buf);
+        }
+        spfftk_pair_->forward(vphi_.at(memory_t::host, 0, 0), (nb == 2) ? vphi_.at(memory_t::host, 0, 1) : nullptr);
+    };
+
     /* store the resulting hphi
        spin block (ispn_block) is used as a bit mask:
         - first bit: spin component which is updated
         - second bit: add or not kinetic energy term */
-    auto add_to_hphi = [&](int ispn_block) {
+    auto add_to_hphi = [&](int ispn_block, int j) {
         /* index of spin component */
         int ispn = ispn_block & 1;
         /* add kinetic energy if this is a diagonal block */
@@ -450,12 +566,12 @@ void Local_operator::apply_h(spfft::Transform& spfftk__, Gvec_partition const& g
                 if (ekin) {
                     #pragma omp parallel for schedule(static)
                     for (int ig = 0; ig < gkvec_p__.gvec_count_fft(); ig++) {
-                        hphi1[ispn][ig] += (phi1[ispn][ig] * pw_ekin_[ig] + vphi_[ig]);
+                        hphi1[j][ispn][ig] += (phi1[j][ispn][ig] * pw_ekin_[ig] + vphi_(ig, j));
                     }
                 } else {
                     #pragma omp parallel for schedule(static)
                     for (int ig = 0; ig < gkvec_p__.gvec_count_fft(); ig++) {
-                        hphi1[ispn][ig] += vphi_[ig];
+                        hphi1[j][ispn][ig] += vphi_(ig, j);
                     }
                 }
                 break;
@@ -464,8 +580,8 @@ void Local_operator::apply_h(spfft::Transform& spfftk__, Gvec_partition const& g
 #if defined(__GPU)
                 double alpha = static_cast<double>(ekin);
                 add_pw_ekin_gpu(gkvec_p__.gvec_count_fft(), alpha, pw_ekin_.at(memory_t::device),
-                                phi1[ispn].at(memory_t::device), vphi_.at(memory_t::device),
-                                hphi1[ispn].at(memory_t::device));
+                                phi1[j][ispn].at(memory_t::device), vphi_.at(memory_t::device, 0, j),
+                                hphi1[j][ispn].at(memory_t::device));
 #endif
                 break;
             }
@@ -476,7 +592,7 @@ void Local_operator::apply_h(spfft::Transform& spfftk__, Gvec_partition const& g
     int num_wf_loc = phi__.pw_coeffs(0).spl_num_col().local_size();
 
     /* if we don't have G-vector reductions, first = 0 and we start a normal loop */
-    for (int i = 0; i < num_wf_loc; i++) {
+    for (int i = 0; i < num_wf_loc; i += nbatch) {
 
         /* non-collinear case */
         /* 2x2 Hamiltonian in applied to spinor wave-functions
@@ -501,7 +617,7 @@ void Local_operator::apply_h(spfft::Transform& spfftk__, Gvec_partition const& g
            .---.---.
          */
         if (spins__() == 2) {
-            prepare_phi_hphi(i);
+            prepare_phi_hphi(i, 0);
             /* phi_u(G) -> phi_u(r) */
             phi_to_r(0);
             /* save phi_u(r) in temporary buf_rg array */
@@ -524,7 +640,7 @@ void Local_operator::apply_h(spfft::Transform& spfftk__, Gvec_partition const& g
             /* V_{uu}(r)phi_{u}(r) -> [V*phi]_{u}(G) */
             vphi_to_G();
             /* add kinetic energy */
-            add_to_hphi(0);
+            add_to_hphi(0, 0);
             /* multiply phi_{u} by V_{du} and copy to FFT buffer */
             switch (spfft_mem) {
                 case SPFFT_PU_HOST: {
@@ -542,7 +658,7 @@ void Local_operator::apply_h(spfft::Transform& spfftk__, Gvec_partition const& g
             /* V_{du}(r)phi_{u}(r) -> [V*phi]_{d}(G) */
             vphi_to_G();
             /* add to hphi_{d} */
-            add_to_hphi(3);
+            add_to_hphi(3, 0);
 
             /* for the second spin component */
 
@@ -565,7 +681,7 @@ void Local_operator::apply_h(spfft::Transform& spfftk__, Gvec_partition const& g
             /* V_{dd}(r)phi_{d}(r) -> [V*phi]_{d}(G) */
             vphi_to_G();
             /* add kinetic energy */
-            add_to_hphi(1);
+            add_to_hphi(1, 0);
             /* multiply phi_{d} by V_{ud} and copy to FFT buffer */
             switch (spfft_mem) {
                 case SPFFT_PU_HOST: {
@@ -583,20 +699,34 @@ void Local_operator::apply_h(spfft::Transform& spfftk__, Gvec_partition const& g
             /* V_{ud}(r)phi_{d}(r) -> [V*phi]_{u}(G) */
             vphi_to_G();
             /* add to hphi_{u} */
-            add_to_hphi(2);
+            add_to_hphi(2, 0);
             /* copy to main hphi array */
-            store_hphi(i);
+            store_hphi(i, 0);
         } else { /* spin-collinear or non-magnetic case */
-            prepare_phi_hphi(i);
-            /* phi(G) -> phi(r) */
-            phi_to_r(spins__());
-            /* multiply by effective potential */
-            mul_by_veff(spfftk__, spfft_buf, veff_vec_, spins__());
-            /* V(r)phi(r) -> [V*phi](G) */
-            vphi_to_G();
-            /* add kinetic energy */
-            add_to_hphi(spins__());
-            store_hphi(i);
+            /* number of wave-functions in the current batch */
+            int nb = std::min(nbatch, num_wf_loc - i);
+            for (int j = 0; j < nb; j++) {
+                prepare_phi_hphi(i + j, j);
+            }
+            if (spfftk_pair_ && nbatch == 2) {
+                /* [phi_1 + i phi_2](G) -> [phi_1 + i phi_2](r) -> V(r)[phi_1 + i phi_2](r) -> [V*phi_{1,2}](G) */
+                apply_v_pair(spins__(), nb);
+            } else if (nbatch == 1) {
+                /* phi(G) -> phi(r) */
+                phi_to_r(spins__());
+                /* multiply by effective potential */
+                mul_by_veff_beta(spfftk__, spfft_buf, spins__());
+                /* V(r)phi(r) -> [V*phi](G) */
+                vphi_to_G();
+            } else {
+                /* phi(G) -> phi(r) -> V(r)phi(r) -> [V*phi](G) for all wave-functions of the batch */
+                apply_v_batch(spins__(), nb);
+            }
+            for (int j = 0; j < nb; j++) {
+                /* add kinetic energy */
+                add_to_hphi(spins__(), j);
+                store_hphi(i + j, j);
+            }
         }
     }
 
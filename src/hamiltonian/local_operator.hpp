@@ -35,12 +35,15 @@ class Potential;
 class Simulation_context;
 template <typename T>
 class Smooth_periodic_function;
+class Beta_projectors_real_space;
+class Non_local_operator;
 }
 namespace sddk {
 class FFT3D;
 class Gvec_partition;
 class Wave_functions;
 class spin_range;
+class Gamma_pair_transform;
 }
 namespace spfft {
 class Transform;
@@ -96,8 +99,23 @@ class Local_operator
      */
     std::array<std::unique_ptr<Smooth_periodic_function<double>>, 6> veff_vec_;
 
-    /// Temporary array to store [V*phi](G)
-    sddk::mdarray<double_complex, 1> vphi_;
+    /// Temporary array to store [V*phi](G) for a batch of wave-functions.
+    sddk::mdarray<double_complex, 2> vphi_;
+
+    /// Independent copies of the G+k vectors FFT driver used to transform a batch of wave-functions at once.
+    std::vector<spfft::Transform> spfftk_batch_;
+
+    /// Complex FFT driver for pairs of real wave-functions in the Gamma-point case.
+    /** The driver is owned by the K_point and is recreated by K_point::generate_gkvec(). The pointer is set in
+     *  prepare_k() and reset in dismiss_k(), so it is valid only during the lifetime of the Hamiltonian_k of the
+     *  k-point. */
+    sddk::Gamma_pair_transform* spfftk_pair_{nullptr};
+
+    /// Beta-projectors in real space for the current k-point (not owned).
+    Beta_projectors_real_space const* beta_rs_{nullptr};
+
+    /// Non-local D-operator which is applied together with the real-space beta-projectors (not owned).
+    Non_local_operator* d_op_{nullptr};
 
     /// Temporary array to store psi_{up}(r).
     /** The size of the array is equal to the size of FFT buffer. */
@@ -125,8 +143,23 @@ class Local_operator
                    Potential*                  potential__ = nullptr);
 
     /// Prepare the k-point dependent arrays.
-    /** \param [in] gkvec_p  FFT-friendly G+k vector partitioning. */
-    void prepare_k(sddk::Gvec_partition const& gkvec_p__);
+    /** If more than one wave-function is transformed at once (see Control_input::fft_batch_size_) this method
+     *  also creates the pool of independent FFT drivers for the current k-point.
+     *
+     *  \param [in] spfftk   SpFFT transform object for G+k vectors.
+     *  \param [in] gkvec_p  FFT-friendly G+k vector partitioning.
+     *  \param [in] spfftk_pair Optional complex FFT driver for pairs of real wave-functions (Gamma-point case).
+     *  \param [in] beta_rs  Optional real-space beta-projectors of the k-point.
+     *  \param [in] d_op     D-operator which is applied with the real-space beta-projectors.
+     */
+    void prepare_k(spfft::Transform& spfftk__, sddk::Gvec_partition const& gkvec_p__,
+                   sddk::Gamma_pair_transform* spfftk_pair__ = nullptr,
+                   Beta_projectors_real_space const* beta_rs__ = nullptr, Non_local_operator* d_op__ = nullptr);
+
+    /// Release the k-point dependent resources created in prepare_k().
+    /** The pool of FFT drivers holds full copies of the FFT work buffers, so it is kept only while the
+     *  Hamiltonian of the k-point is alive. Pointers to the objects owned by the k-point are reset. */
+    void dismiss_k();
 
     /// Apply local part of Hamiltonian to pseudopotential wave-functions.
     /** \param [in]  spfftk  SpFFT transform object for G+k vectors.
@@ -143,6 +176,14 @@ class Local_operator
      *    - [0, 1]: apply full Hamiltonian to the spinor wave-functions
      *
      *  Local Hamiltonian includes kinetic term and local part of potential.
+     *
+     *  In the spin-collinear case the wave-functions are processed in batches of Control_input::fft_batch_size_
+     *  using the pool of FFT drivers created in prepare_k(). In the Gamma-point case, if the complex FFT driver
+     *  for pairs of real wave-functions was provided in prepare_k(), two wave-functions are transformed at once.
+     *
+     *  If the real-space beta-projectors were provided in prepare_k(), the non-local term
+     *  \f$ \sum_{\xi \xi'} |\beta_{\xi}\rangle D_{\xi \xi'} \langle \beta_{\xi'}|\psi\rangle \f$ is also applied
+     *  while the wave-function is in real space. In this case the caller must not apply the D-operator again.
      */
     void apply_h(spfft::Transform& spfftk__, sddk::Gvec_partition const& gkvec_p__, sddk::spin_range spins__,
                  sddk::Wave_functions& phi__, sddk::Wave_functions& hphi__, int idx0__, int n__);
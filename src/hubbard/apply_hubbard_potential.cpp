@@ -64,41 +64,48 @@ void Hubbard::apply_hubbard_potential(Wave_functions& hub_wf, const int ispn__,
     dmatrix<double_complex> Up(this->number_of_hubbard_orbitals(), n__);
     Up.zero();
 
-    #pragma omp parallel for schedule(static)
-    for (int ia = 0; ia < ctx_.unit_cell().num_atoms(); ++ia) {
-        const auto& atom = ctx_.unit_cell().atom(ia);
-        if (atom.type().hubbard_correction()) {
-            const int lmax_at = 2 * atom.type().hubbard_orbital(0).l + 1;
+    /* Up = V_{hub} dm is block-diagonal in atoms; blocks of the atoms with the same number of orbitals are
+       processed as a batch of independent GEMMs */
+    for (auto& group : atom_groups_) {
+        const int lmax_at = group.first;
+        auto& atoms       = group.second;
+        if (ctx_.num_mag_dims() == 3) {
             // we apply the hubbard correction. For now I have no papers
             // giving me the formula for the SO case so I rely on QE for it
             // but I do not like it at all
-            if (ctx_.num_mag_dims() == 3) {
-                for (int s1 = 0; s1 < ctx_.num_spins(); s1++) {
-                    for (int s2 = 0; s2 < ctx_.num_spins(); s2++) {
-                        const int ind = (s1 == s2) * s1 + (1 + 2 * s2 + s1) * (s1 != s2);
-
-                        // !!! Replace this with matrix matrix multiplication
-
-                        for (int nbd = 0; nbd < n__; nbd++) {
+            const int nb = 2 * lmax_at;
+            #pragma omp parallel
+            {
+                /* full spinor block of the Hubbard potential */
+                matrix<double_complex> v(nb, nb);
+                #pragma omp for schedule(static)
+                for (int i = 0; i < static_cast<int>(atoms.size()); i++) {
+                    int ia = atoms[i];
+                    for (int s1 = 0; s1 < ctx_.num_spins(); s1++) {
+                        for (int s2 = 0; s2 < ctx_.num_spins(); s2++) {
+                            const int ind = (s1 == s2) * s1 + (1 + 2 * s2 + s1) * (s1 != s2);
                             for (int m1 = 0; m1 < lmax_at; m1++) {
                                 for (int m2 = 0; m2 < lmax_at; m2++) {
-                                    Up(this->offset_[ia] + s1 * lmax_at + m1, nbd) += this->hubbard_potential_(m2, m1, ind, ia) *
-                                        dm(this->offset_[ia] + s2 * lmax_at + m2, nbd);
+                                    v(s1 * lmax_at + m1, s2 * lmax_at + m2) = this->hubbard_potential_(m2, m1, ind, ia);
                                 }
                             }
                         }
                     }
+                    linalg(linalg_t::blas).gemm('N', 'N', nb, n__, nb, &linalg_const<double_complex>::one(),
+                        v.at(memory_t::host), v.ld(), dm.at(memory_t::host, this->offset_[ia], 0), dm.ld(),
+                        &linalg_const<double_complex>::zero(), Up.at(memory_t::host, this->offset_[ia], 0), Up.ld());
                 }
-            } else {
-                // Conventional LDA or colinear magnetism
-                for (int nbd = 0; nbd < n__; nbd++) {
-                    for (int m1 = 0; m1 < lmax_at; m1++) {
-                        for (int m2 = 0; m2 < lmax_at; m2++) {
-                            Up(this->offset_[ia] + m1, nbd) += this->hubbard_potential_(m2, m1, ispn__, ia) *
-                                dm(this->offset_[ia] + m2, nbd);
-                        }
-                    }
-                }
+            }
+        } else {
+            // Conventional LDA or colinear magnetism
+            #pragma omp parallel for schedule(static)
+            for (int i = 0; i < static_cast<int>(atoms.size()); i++) {
+                int ia = atoms[i];
+                /* Up(m1, n) = \sum_{m2} V(m2, m1) dm(m2, n) */
+                linalg(linalg_t::blas).gemm('T', 'N', lmax_at, n__, lmax_at, &linalg_const<double_complex>::one(),
+                    this->hubbard_potential_.at(memory_t::host, 0, 0, ispn__, ia), this->hubbard_potential_.ld(),
+                    dm.at(memory_t::host, this->offset_[ia], 0), dm.ld(), &linalg_const<double_complex>::zero(),
+                    Up.at(memory_t::host, this->offset_[ia], 0), Up.ld());
             }
         }
     }
@@ -49,6 +49,13 @@ Hubbard::Hubbard(Simulation_context& ctx__)
     number_of_hubbard_orbitals_ = r.first;
     offset_ = r.second;
 
+    for (int ia = 0; ia < ctx_.unit_cell().num_atoms(); ia++) {
+        auto& atom_type = ctx_.unit_cell().atom(ia).type();
+        if (atom_type.hubbard_correction()) {
+            atom_groups_[2 * atom_type.hubbard_orbital(0).l + 1].push_back(ia);
+        }
+    }
+
     calculate_initial_occupation_numbers();
     calculate_hubbard_potential_and_energy();
 }
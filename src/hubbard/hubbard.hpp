@@ -27,6 +27,7 @@
 
 #include <cstdio>
 #include <cstdlib>
+#include <map>
 #include "simulation_context.hpp"
 #include "k_point/k_point.hpp"
 #include "k_point/k_point_set.hpp"
@@ -87,6 +88,11 @@ class Hubbard
     /// file containing the hubbard wave functions
     std::string wave_function_file_;
 
+    /// Hubbard atoms grouped by the number of orbitals (2l+1) per spin.
+    /** Diagonal blocks of the Hubbard operators of atoms in one group have the same size and they are processed
+        as a batch of independent matrix-matrix multiplications. */
+    std::map<int, std::vector<int>> atom_groups_;
+
     void calculate_initial_occupation_numbers();
 
     void compute_occupancies(K_point&                    kp,
@@ -43,17 +43,13 @@ Hubbard::compute_occupancies_derivatives(K_point& kp,
     // derivatives of the hubbard wave functions are needed.
     auto& phi = kp.hubbard_wave_functions();
 
+    std::vector<int> atoms;
     for (int ia = 0; ia < unit_cell_.num_atoms(); ia++) {
-        auto& atom_type   = unit_cell_.atom(ia).type();
-        if (atom_type.hubbard_correction()) {
-
-            kp.generate_atomic_wave_functions(atom_type.hubbard_indexb_wfc(),
-                                              ia,
-                                              this->offset_[ia],
-                                              true,
-                                              phi);
+        if (unit_cell_.atom(ia).type().hubbard_correction()) {
+            atoms.push_back(ia);
         }
     }
+    kp.generate_hubbard_atomic_wave_functions(atoms, phi);
 
     Beta_projectors_gradient bp_grad_(ctx_, kp.gkvec(), kp.igk_loc(), kp.beta_projectors());
     //kp.beta_projectors().prepare();
@@ -272,17 +268,13 @@ Hubbard::compute_occupancies_stress_derivatives(K_point&                    kp__
     bp_strain_deriv.prepare();
 
     /* compute the hubbard orbitals */
+    std::vector<int> atoms;
     for (int ia = 0; ia < unit_cell_.num_atoms(); ia++) {
-        auto& atom_type   = unit_cell_.atom(ia).type();
-        if (atom_type.hubbard_correction()) {
-
-            kp__.generate_atomic_wave_functions(atom_type.hubbard_indexb_wfc(),
-                                                ia,
-                                                this->offset_[ia],
-                                                true,
-                                                phi);
+        if (unit_cell_.atom(ia).type().hubbard_correction()) {
+            atoms.push_back(ia);
         }
     }
+    kp__.generate_hubbard_atomic_wave_functions(atoms, phi);
 
     if (ctx_.processing_unit() == device_t::GPU) {
         dm.allocate(memory_t::device);
@@ -423,6 +415,21 @@ void
 Hubbard::wavefunctions_strain_deriv(K_point& kp__, Wave_functions& dphi, mdarray<double, 2> const& rlm_g,
                                     mdarray<double, 3> const& rlm_dg, const int nu, const int mu)
 {
+    /* lengths of G+k vectors */
+    std::vector<double> gk_len(kp__.num_gkvec_loc());
+    for (int igkloc = 0; igkloc < kp__.num_gkvec_loc(); igkloc++) {
+        gk_len[igkloc] = kp__.gkvec().gkvec_cart<index_domain_t::local>(igkloc).length();
+    }
+
+    /* radial integrals of all atom types for all G+k vectors */
+    int nrf = ctx_.atomic_wf_ri().num_func_per_type();
+    mdarray<double, 3> ri_values(nrf, kp__.num_gkvec_loc(), unit_cell_.num_atom_types());
+    mdarray<double, 3> ridjl_values(nrf, kp__.num_gkvec_loc(), unit_cell_.num_atom_types());
+    for (int iat = 0; iat < unit_cell_.num_atom_types(); iat++) {
+        ctx_.atomic_wf_ri().values(iat, kp__.num_gkvec_loc(), gk_len.data(), &ri_values(0, 0, iat), nrf);
+        ctx_.atomic_wf_djl().values(iat, kp__.num_gkvec_loc(), gk_len.data(), &ridjl_values(0, 0, iat), nrf);
+    }
+
     #pragma omp parallel for schedule(static)
     for (int igkloc = 0; igkloc < kp__.num_gkvec_loc(); igkloc++) {
         /* global index of G+k vector */
@@ -430,15 +437,6 @@ Hubbard::wavefunctions_strain_deriv(K_point& kp__, Wave_functions& dphi, mdarray
         auto gvc = kp__.gkvec().gkvec_cart<index_domain_t::local>(igkloc);
         /* vs = {r, theta, phi} */
         auto gvs = SHT::spherical_coordinates(gvc);
-        std::vector<mdarray<double, 1>> ri_values(unit_cell_.num_atom_types());
-        for (int iat = 0; iat < unit_cell_.num_atom_types(); iat++) {
-            ri_values[iat] = ctx_.atomic_wf_ri().values(iat, gvs[0]);
-        }
-
-        std::vector<mdarray<double, 1>> ridjl_values(unit_cell_.num_atom_types());
-        for (int iat = 0; iat < unit_cell_.num_atom_types(); iat++) {
-            ridjl_values[iat] = ctx_.atomic_wf_djl().values(iat, gvs[0]);
-        }
 
         const double p = (mu == nu) ? 0.5 : 0.0;
         for (int ia = 0; ia < unit_cell_.num_atoms(); ia++) {
@@ -455,7 +453,7 @@ Hubbard::wavefunctions_strain_deriv(K_point& kp__, Wave_functions& dphi, mdarray
                     // case |g+k| = 0
                     if (gvs[0] < 1e-10) {
                         if (l == 0) {
-                            auto d1 = ri_values[atom_type.id()][i] * p * y00;
+                            auto d1 = ri_values(i, igkloc, atom_type.id()) * p * y00;
 
                             dphi.pw_coeffs(0).prime(igkloc, offset__) = -z * d1 * phase_factor;
                         } else {
@@ -466,9 +464,9 @@ Hubbard::wavefunctions_strain_deriv(K_point& kp__, Wave_functions& dphi, mdarray
                     } else {
                         for (int m = -l; m <= l; m++) {
                             int  lm = utils::lm(l, m);
-                            auto d1 = ri_values[atom_type.id()][i] * (gvc[mu] * rlm_dg(lm, nu, igkloc) +
+                            auto d1 = ri_values(i, igkloc, atom_type.id()) * (gvc[mu] * rlm_dg(lm, nu, igkloc) +
                                                                       p * rlm_g(lm, igkloc));
-                            auto d2 = ridjl_values[atom_type.id()][i] * rlm_g(lm, igkloc) * gvc[mu] * gvc[nu] / gvs[0];
+                            auto d2 = ridjl_values(i, igkloc, atom_type.id()) * rlm_g(lm, igkloc) * gvc[mu] * gvc[nu] / gvs[0];
 
                             dphi.pw_coeffs(0).prime(igkloc, offset__ + l + m) = -z * (d1 + d2) * std::conj(phase_factor);
                         }
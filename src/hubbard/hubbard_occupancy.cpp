@@ -73,7 +73,6 @@ void Hubbard::hubbard_compute_occupation_numbers(K_point_set& kset_)
 
     dmatrix<double_complex> dm(HowManyBands, this->number_of_hubbard_orbitals() * Ncf);
     matrix<double_complex>  dm1(HowManyBands, this->number_of_hubbard_orbitals() * Ncf);
-    matrix<double_complex>  Op(this->number_of_hubbard_orbitals() * Ncf, this->number_of_hubbard_orbitals() * Ncf);
 
     dm.zero();
 
@@ -165,66 +164,74 @@ void Hubbard::hubbard_compute_occupation_numbers(K_point_set& kset_)
         }
 
         // now compute O_{ij}^{sigma,sigma'} = \sum_{nk} <psi_nk|phi_{i,sigma}><phi_{j,sigma^'}|psi_nk> f_{nk}
+        // only the diagonal atomic blocks of O are needed; blocks of the atoms with the same number of orbitals
+        // are computed as a batch of independent GEMMs
         const double scal = (ctx_.num_mag_dims() == 0) ? 0.5 : 1.0;
         auto alpha = double_complex(kp->weight() * scal, 0.0);
-        linalg(linalg_t::blas).gemm('C', 'N', this->number_of_hubbard_orbitals() * Ncf,
-            this->number_of_hubbard_orbitals() * Ncf, HowManyBands, &alpha, dm.at(memory_t::host), dm.ld(),
-            dm1.at(memory_t::host), dm1.ld(), &linalg_const<double_complex>::zero(), Op.at(memory_t::host), Op.ld());
 
-        if (ctx_.num_mag_dims() == 3) {
-            // there must be a way to do that with matrix multiplication
-            #pragma omp parallel for schedule(static)
-            for (int ia = 0; ia < unit_cell_.num_atoms(); ia++) {
-                const auto& atom = unit_cell_.atom(ia);
-                if (atom.type().hubbard_correction()) {
-
-                    /* loop over the different channels */
-                    /* note that for atom with SO interactions, we need to jump
-                       by 2 instead of 1. This is due to the fact that the
-                       relativistic wave functions have different total angular
-                       momentum for the same n */
-
-                    for (int orb = 0; orb < atom.type().num_hubbard_orbitals(); orb += (atom.type().spin_orbit_coupling() ? 2 : 1)) {
-                        /*
-                           I know that the index of the hubbard wave functions (indexb_....) is
-                           consistent with the index of the hubbard orbitals
-                        */
-                        const int lmax_at = 2 * atom.type().hubbard_orbital(0).l + 1;
-                        for (int s1 = 0; s1 < ctx_.num_spins(); s1++) {
-                            for (int s2 = 0; s2 < ctx_.num_spins(); s2++) {
-                                int s = (s1 == s2) * s1 + (s1 != s2) * (1 + 2 * s2 + s1);
-                                for (int mp = 0; mp < lmax_at; mp++) {
-                                    for (int m = 0; m < lmax_at; m++) {
-                                        this->occupancy_number_(m, mp, s, ia) +=
-                                            Op(this->offset_[ia] + m + s1 * lmax_at, this->offset_[ia] + mp + s2 * lmax_at);
+        for (auto& group : atom_groups_) {
+            const int lmax_at = group.first;
+            auto& atoms       = group.second;
+            if (ctx_.num_mag_dims() == 3) {
+                const int nb = 2 * lmax_at;
+                #pragma omp parallel
+                {
+                    matrix<double_complex> Op(nb, nb);
+                    #pragma omp for schedule(static)
+                    for (int i = 0; i < static_cast<int>(atoms.size()); i++) {
+                        int ia           = atoms[i];
+                        const auto& atom = unit_cell_.atom(ia);
+                        linalg(linalg_t::blas).gemm('C', 'N', nb, nb, HowManyBands, &alpha,
+                            dm.at(memory_t::host, 0, this->offset_[ia]), dm.ld(),
+                            dm1.at(memory_t::host, 0, this->offset_[ia]), dm1.ld(),
+                            &linalg_const<double_complex>::zero(), Op.at(memory_t::host), Op.ld());
+
+                        /* loop over the different channels */
+                        /* note that for atom with SO interactions, we need to jump
+                           by 2 instead of 1. This is due to the fact that the
+                           relativistic wave functions have different total angular
+                           momentum for the same n */
+                        for (int orb = 0; orb < atom.type().num_hubbard_orbitals();
+                             orb += (atom.type().spin_orbit_coupling() ? 2 : 1)) {
+                            for (int s1 = 0; s1 < ctx_.num_spins(); s1++) {
+                                for (int s2 = 0; s2 < ctx_.num_spins(); s2++) {
+                                    int s = (s1 == s2) * s1 + (s1 != s2) * (1 + 2 * s2 + s1);
+                                    for (int mp = 0; mp < lmax_at; mp++) {
+                                        for (int m = 0; m < lmax_at; m++) {
+                                            this->occupancy_number_(m, mp, s, ia) +=
+                                                Op(m + s1 * lmax_at, mp + s2 * lmax_at);
+                                        }
                                     }
                                 }
                             }
                         }
                     }
                 }
-            }
-        } else {
-            // Well we need to apply a factor 1/2 (the constant scal
-            // above) when we compute the occupancies for the boring LDA
-            // + U. It is because the calculations of E and U consider
-            // occupancies <= 1.  Sirius for the boring lda+U has a
-            // factor 2 in the kp band occupancies. We need to
-            // compensate for it because it is taken into account in the
-            // calculation of the hubbard potential
-
-            #pragma omp parallel for schedule(static)
-            for (int ia = 0; ia < unit_cell_.num_atoms(); ia++) {
-                const auto& atom = unit_cell_.atom(ia);
-                if (atom.type().hubbard_correction()) {
-                    for (int orb = 0; orb < atom.type().num_hubbard_orbitals(); orb++) {
-                        const int lmax_at = 2 * atom.type().hubbard_orbital(0).l + 1;
+            } else {
+                // Well we need to apply a factor 1/2 (the constant scal
+                // above) when we compute the occupancies for the boring LDA
+                // + U. It is because the calculations of E and U consider
+                // occupancies <= 1.  Sirius for the boring lda+U has a
+                // factor 2 in the kp band occupancies. We need to
+                // compensate for it because it is taken into account in the
+                // calculation of the hubbard potential
+                #pragma omp parallel
+                {
+                    matrix<double_complex> Op(lmax_at, lmax_at);
+                    #pragma omp for schedule(static)
+                    for (int i = 0; i < static_cast<int>(atoms.size()); i++) {
+                        int ia           = atoms[i];
+                        const auto& atom = unit_cell_.atom(ia);
                         for (int ispn = 0; ispn < ctx_.num_spins(); ispn++) {
-                            for (int mp = 0; mp < lmax_at; mp++) {
-                                const int mmp = this->offset_[ia] + mp + ispn * this->number_of_hubbard_orbitals();
-                                for (int m = 0; m < lmax_at; m++) {
-                                    const int mm = this->offset_[ia] + m + ispn * this->number_of_hubbard_orbitals();
-                                    this->occupancy_number_(m, mp, ispn, ia) += Op(mm, mmp);
+                            int col = this->offset_[ia] + ispn * this->number_of_hubbard_orbitals();
+                            linalg(linalg_t::blas).gemm('C', 'N', lmax_at, lmax_at, HowManyBands, &alpha,
+                                dm.at(memory_t::host, 0, col), dm.ld(), dm1.at(memory_t::host, 0, col), dm1.ld(),
+                                &linalg_const<double_complex>::zero(), Op.at(memory_t::host), Op.ld());
+                            for (int orb = 0; orb < atom.type().num_hubbard_orbitals(); orb++) {
+                                for (int mp = 0; mp < lmax_at; mp++) {
+                                    for (int m = 0; m < lmax_at; m++) {
+                                        this->occupancy_number_(m, mp, ispn, ia) += Op(m, mp);
+                                    }
                                 }
                             }
                         }
@@ -32,6 +32,7 @@
 #include "constants.hpp"
 #include "SDDK/geometry3d.hpp"
 #include "utils/json.hpp"
+#include "dft/smearing.hpp"
 
 using namespace geometry3d;
 using namespace nlohmann;
@@ -221,6 +222,19 @@ struct Mixer_input
     /// Use Hartree potential in the inner() product for residuals.
     bool use_hartree_{false};
 
+    /// Mix the plane-wave coefficients of the density inside the coarse G-sphere instead of the real-space functions.
+    /** Only the pseudopotential case is supported. */
+    bool pw_mixing_{false};
+
+    /// Wave-vector of the Kerker preconditioner in the plane-wave mixing.
+    /** The residual of the charge density is scaled by \f$ G^2 / (G^2 + q_0^2) \f$. Zero value disables
+        the preconditioning. */
+    double kerker_q0_{0};
+
+    /// Store the history of the Broyden mixers in single precision.
+    /** Mixing itself is done in double precision. */
+    bool single_precision_history_{false};
+
     /// True if this section exists in the input file.
     bool exist_{false};
 
@@ -237,6 +251,9 @@ struct Mixer_input
             type_                = section.value("type", type_);
             beta_scaling_factor_ = section.value("beta_scaling_factor", beta_scaling_factor_);
             use_hartree_         = section.value("use_hartree", use_hartree_);
+            pw_mixing_           = section.value("pw_mixing", pw_mixing_);
+            kerker_q0_           = section.value("kerker_q0", kerker_q0_);
+            single_precision_history_ = section.value("single_precision_history", single_precision_history_);
         }
     }
 };
@@ -290,6 +307,22 @@ struct Iterative_solver_input
         the randomized wave functions. */
     std::string init_subspace_{"lcao"};
 
+    /// Minimum (initial) degree of the Chebyshev filter.
+    int chebyshev_degree_{8};
+
+    /// Maximum degree of the Chebyshev filter.
+    int chebyshev_max_degree_{32};
+
+    /// Maximum number of residual-minimization steps for each band in the RMM-DIIS solver.
+    int rmm_diis_num_steps_{4};
+
+    /// Number of bands refined simultaneously by the RMM-DIIS solver.
+    int rmm_diis_block_size_{32};
+
+    /// RMM-DIIS solver is used only when the iterative solver tolerance drops below this value.
+    /** Until then the Davidson solver is used to get close enough to the ground state. */
+    double rmm_diis_switch_tolerance_{1e-4};
+
     void read(json const& parser)
     {
         if (parser.count("iterative_solver")) {
@@ -307,6 +340,11 @@ struct Iterative_solver_input
             num_singular_           = section.value("num_singular", num_singular_);
             init_eval_old_          = section.value("init_eval_old", init_eval_old_);
             init_subspace_          = section.value("init_subspace", init_subspace_);
+            chebyshev_degree_       = section.value("chebyshev_degree", chebyshev_degree_);
+            chebyshev_max_degree_   = section.value("chebyshev_max_degree", chebyshev_max_degree_);
+            rmm_diis_num_steps_     = section.value("rmm_diis_num_steps", rmm_diis_num_steps_);
+            rmm_diis_block_size_    = section.value("rmm_diis_block_size", rmm_diis_block_size_);
+            rmm_diis_switch_tolerance_ = section.value("rmm_diis_switch_tolerance", rmm_diis_switch_tolerance_);
             std::transform(init_subspace_.begin(), init_subspace_.end(), init_subspace_.begin(), ::tolower);
         }
     }
@@ -408,6 +446,58 @@ struct Control_input
     /// Number of atoms in the beta-projectors chunk.
     int beta_chunk_size_{256};
 
+    /// Maximum size (in megabytes) of the cache of beta-projectors for a k-point.
+    /** Chunks of beta-projectors which do not fit into the cache are generated on the fly. Negative value means that
+     *  the size is selected by memory_usage: no limit on CPU and a fraction of the free device memory on GPU for
+     *  "high" and "medium" and no cache for "low". */
+    double beta_cache_size_{-1};
+
+    /// Apply the beta-projectors of the Hamiltonian in real space on the coarse FFT grid.
+    /** Projectors are sampled inside a sphere around each atom, so the cost of the non-local part of the
+     *  Hamiltonian scales linearly with the number of atoms. Supported only on CPU and in the spin-collinear case. */
+    bool beta_real_space_{false};
+
+    /// Radius of the real-space beta-projector sphere in units of the projector cutoff radius.
+    double beta_real_space_radius_scale_{1.5};
+
+    /// Generate the augmentation charge in real space on the fine FFT grid.
+    /** Augmentation charge of each atom is accumulated inside a sphere around the atom and transformed to the
+     *  plane-wave domain with a single FFT. */
+    bool rho_aug_real_space_{false};
+
+    /// Radius of the real-space augmentation sphere in units of the cutoff radius of the augmentation functions.
+    double rho_aug_real_space_radius_scale_{1.5};
+
+    /// Number of wave-functions transformed simultaneously in the application of the local Hamiltonian.
+    /** If the value is larger than one, a pool of independent SpFFT transforms is created and the batch of
+     *  wave-functions is transformed with a single multi-transform call. */
+    int fft_batch_size_{1};
+
+    /// Number of smooth periodic functions transformed simultaneously on the fine-grained FFT grid.
+    /** Used for the components of gradients and other vector functions (for example in the GGA part of the XC
+     *  potential). If the value is larger than one, a pool of independent copies of the fine-grained SpFFT transform
+     *  is created by the simulation context. */
+    int fft_batch_size_rg_{1};
+
+    /// Transform pairs of real wave-functions with one complex FFT in the Gamma-point case.
+    bool fft_gamma_pair_{true};
+
+    /// Allocation strategy of the memory pools.
+    /** Possible values are: "block_list" and "size_class". */
+    std::string memory_pool_type_{"block_list"};
+
+    /// Distribution of k-points between MPI ranks.
+    /** Possible values are: "block" (equal number of k-points per rank) and "cost" (contiguous chunks of k-points
+     *  with approximately equal estimated cost). */
+    std::string kpoint_distribution_{"block"};
+
+    /// Redistribute k-points between SCF iterations using the measured wall-time of the band solver.
+    bool kpoint_rebalance_{false};
+
+    /// Save the wave-functions to the storage file at the end of the ground state run.
+    /** Only the pseudopotential case is supported; the wave-functions are then restored on restart. */
+    bool save_wave_functions_{false};
+
     void read(json const& parser)
     {
         if (parser.count("control")) {
@@ -434,9 +524,23 @@ struct Control_input
             print_neighbors_     = section.value("print_neighbors", print_neighbors_);
             memory_usage_        = section.value("memory_usage", memory_usage_);
             beta_chunk_size_     = section.value("beta_chunk_size", beta_chunk_size_);
+            beta_cache_size_     = section.value("beta_cache_size", beta_cache_size_);
+            beta_real_space_     = section.value("beta_real_space", beta_real_space_);
+            beta_real_space_radius_scale_ = section.value("beta_real_space_radius_scale",
+                                                          beta_real_space_radius_scale_);
+            rho_aug_real_space_  = section.value("rho_aug_real_space", rho_aug_real_space_);
+            rho_aug_real_space_radius_scale_ = section.value("rho_aug_real_space_radius_scale",
+                                                             rho_aug_real_space_radius_scale_);
+            fft_batch_size_      = section.value("fft_batch_size", fft_batch_size_);
+            fft_batch_size_rg_   = section.value("fft_batch_size_rg", fft_batch_size_rg_);
+            fft_gamma_pair_      = section.value("fft_gamma_pair", fft_gamma_pair_);
+            memory_pool_type_    = section.value("memory_pool_type", memory_pool_type_);
+            kpoint_distribution_ = section.value("kpoint_distribution", kpoint_distribution_);
+            kpoint_rebalance_    = section.value("kpoint_rebalance", kpoint_rebalance_);
+            save_wave_functions_ = section.value("save_wave_functions", save_wave_functions_);
 
             auto strings = {&std_evp_solver_name_, &gen_evp_solver_name_, &fft_mode_, &processing_unit_,
-                            &memory_usage_};
+                            &memory_usage_, &memory_pool_type_, &kpoint_distribution_};
             for (auto s : strings) {
                 std::transform(s->begin(), s->end(), s->begin(), ::tolower);
             }
@@ -446,6 +550,20 @@ struct Control_input
             if (std::find(kw.begin(), kw.end(), memory_usage_) == kw.end()) {
                 throw std::runtime_error("wrong memory_usage input");
             }
+            kw = {"block_list", "size_class"};
+            if (std::find(kw.begin(), kw.end(), memory_pool_type_) == kw.end()) {
+                throw std::runtime_error("wrong memory_pool_type input");
+            }
+            kw = {"block", "cost"};
+            if (std::find(kw.begin(), kw.end(), kpoint_distribution_) == kw.end()) {
+                throw std::runtime_error("wrong kpoint_distribution input");
+            }
+            if (fft_batch_size_ < 1) {
+                throw std::runtime_error("wrong fft_batch_size input");
+            }
+            if (fft_batch_size_rg_ < 1) {
+                throw std::runtime_error("wrong fft_batch_size_rg input");
+            }
         }
     }
 };
@@ -476,6 +594,10 @@ struct Parameters_input
     /// Width of Gaussian smearing function in the units of [Ha].
     double smearing_width_{0.01};
 
+    /// Type of smearing function used to find band occupancies.
+    /** The label is parsed and validated when the input is read. */
+    smearing::smearing_t smearing_{smearing::smearing_t::gaussian};
+
     /// Cutoff for plane-waves (for density and potential expansion) in the units of [a.u.^-1].
     double pw_cutoff_{0.0};
 
@@ -537,6 +659,11 @@ struct Parameters_input
     /// Radius of atom nearest-neighbour cluster.
     double nn_radius_{-1};
 
+    /// Skin distance of the list of nearest-neighbour candidates.
+    /** If positive, the neighbours are searched within the extended radius and the list is reused during the
+        geometry updates until some atom moves by more than half of the skin distance. */
+    double nn_skin_{0};
+
     /// Effective screening medium.
     bool enable_esm_{false};
 
@@ -578,6 +705,9 @@ struct Parameters_input
 
             num_fv_states_  = section.value("num_fv_states", num_fv_states_);
             smearing_width_ = section.value("smearing_width", smearing_width_);
+            if (section.count("smearing")) {
+                smearing_ = smearing::get_smearing_t(section["smearing"].get<std::string>());
+            }
             pw_cutoff_      = section.value("pw_cutoff", pw_cutoff_);
             aw_cutoff_      = section.value("aw_cutoff", aw_cutoff_);
             gk_cutoff_      = section.value("gk_cutoff", gk_cutoff_);
@@ -604,6 +734,7 @@ struct Parameters_input
             density_tol_    = section.value("density_tol", density_tol_);
             molecule_       = section.value("molecule", molecule_);
             nn_radius_      = section.value("nn_radius", nn_radius_);
+            nn_skin_        = section.value("nn_skin", nn_skin_);
             reduce_aux_bf_  = section.value("reduce_aux_bf", reduce_aux_bf_);
             extra_charge_   = section.value("extra_charge", extra_charge_);
 
@@ -718,6 +849,24 @@ struct Settings_input
     /** 0 is Lebedev-Laikov coverage, 1 is unifrom coverage */
     int sht_coverage_{0};
 
+    /// Tolerance for the radially dependent angular expansion of the muffin-tin functions.
+    /** Near the nucleus the density is almost spherical; harmonics below this tolerance (relative to the spherical
+        component) are dropped from the muffin-tin spherical harmonic transforms. 0 keeps the full expansion. */
+    double radial_lmax_tol_{0};
+
+    /// Directory of the persistent cache of radial integrals.
+    /** Interpolation tables of radial integrals are stored in this directory and reused by the subsequent runs
+        with the same pseudopotentials and cutoffs. Empty string disables the cache. */
+    std::string radial_integrals_cache_{""};
+
+    /// Method of the reciprocal-space Ewald summation of the ion-ion energy and forces.
+    /** "direct" sums the structure factor explicitly over atoms for each G-vector, "pme" uses the smooth
+        particle-mesh Ewald method on the dense FFT grid. */
+    std::string ewald_method_{"direct"};
+
+    /// Order of the B-spline interpolation in the particle-mesh Ewald method.
+    int ewald_pme_order_{8};
+
     void read(json const& parser)
     {
         if (parser.count("settings")) {
@@ -735,7 +884,21 @@ struct Settings_input
             itsol_tol_ratio_  = section.value("itsol_tol_ratio", itsol_tol_ratio_);
             itsol_tol_scale_  = section.value("itsol_tol_scale", itsol_tol_scale_);
             sht_coverage_     = section.value("sht_coverage", sht_coverage_);
+            radial_lmax_tol_  = section.value("radial_lmax_tol", radial_lmax_tol_);
             min_occupancy_    = section.value("min_occupancy", min_occupancy_);
+            radial_integrals_cache_ = section.value("radial_integrals_cache", radial_integrals_cache_);
+            ewald_method_     = section.value("ewald_method", ewald_method_);
+            ewald_pme_order_  = section.value("ewald_pme_order", ewald_pme_order_);
+
+            std::transform(ewald_method_.begin(), ewald_method_.end(), ewald_method_.begin(), ::tolower);
+            std::list<std::string> kw = {"direct", "pme"};
+            if (std::find(kw.begin(), kw.end(), ewald_method_) == kw.end()) {
+                throw std::runtime_error("wrong ewald_method input");
+            }
+            /* odd orders are not supported by Ewald_pme */
+            if (ewald_pme_order_ < 4 || ewald_pme_order_ % 2) {
+                throw std::runtime_error("wrong ewald_pme_order input");
+            }
         }
     }
 };
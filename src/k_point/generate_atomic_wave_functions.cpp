@@ -26,98 +26,152 @@
 
 namespace sirius {
 
-void K_point::generate_atomic_wave_functions(const basis_functions_index& index, const int atom, const int offset,
-                                             const bool hubbard, Wave_functions& phi)
+void K_point::generate_hubbard_atomic_wave_functions(std::vector<int> const& atoms__, Wave_functions& phi__)
 {
-    if (index.size() == 0) {
-        return;
-    }
-
+    PROFILE("sirius::K_point::generate_hubbard_atomic_wave_functions");
+
+    /* offsets of the Hubbard orbitals of each atom */
+    auto offset = unit_cell_.num_wf_with_U().second;
+
+    /* description of a single column of the atomic orbitals in the Hubbard wave-functions */
+    struct hubbard_column_t
+    {
+        /* position of the first spin component with respect to the atom offset */
+        int col0;
+        /* position of the second spin component or -1 if it is not set */
+        int col1;
+        int l;
+        int lm;
+        /* radial integral is w * (ri[rf1] + ri[rf2]); rf2 is -1 if not used */
+        int rf1;
+        int rf2;
+        double w;
+    };
+
+    /* collect the columns of each atom type; the layout is the same for all atoms of a given type */
+    std::vector<std::vector<hubbard_column_t>> columns(unit_cell_.num_atom_types());
+    std::vector<bool> is_used(unit_cell_.num_atom_types(), false);
     int lmax{0};
-    for (int iat = 0; iat < unit_cell_.num_atom_types(); iat++) {
-        auto& atom_type = unit_cell_.atom_type(iat);
-        lmax            = std::max(lmax, atom_type.lmax_ps_atomic_wf());
-    }
-    lmax = std::max(lmax, unit_cell_.lmax());
-
-    auto& atom_type = unit_cell_.atom(atom).type();
-    #pragma omp parallel for schedule(static)
-    for (int igk_loc = 0; igk_loc < this->num_gkvec_loc(); igk_loc++) {
-        /* global index of G+k vector */
-        int igk = this->idxgk(igk_loc);
-        /* vs = {r, theta, phi} */
-        auto vs = SHT::spherical_coordinates(this->gkvec().gkvec_cart<index_domain_t::local>(igk_loc));
-
-        /* compute real spherical harmonics for G+k vector */
-        std::vector<double> rlm(utils::lmmax(lmax));
-        sf::spherical_harmonics(lmax, vs[1], vs[2], &rlm[0]);
-
-        /* need to find the index of the atom type get values of radial
-           integrals for a given G+k vector length */
-        sddk::mdarray<double, 1> ri_values;
-        ri_values = ctx_.atomic_wf_ri().values(atom_type.id(), vs[0]);
+    for (int ia : atoms__) {
+        int iat = unit_cell_.atom(ia).type_id();
+        if (is_used[iat]) {
+            continue;
+        }
+        is_used[iat] = true;
 
+        auto& atom_type = unit_cell_.atom_type(iat);
+        auto& index     = atom_type.hubbard_indexb_wfc();
         int n{0};
         for (int xi = 0; xi < index.size();) {
             int l = index[xi].l;
             /* index of the radial function */
-            int index_radial_function = index[xi].idxrf;
-
-            const auto phase        = twopi * dot(gkvec().gkvec(igk), unit_cell_.atom(atom).position());
-            const auto phase_factor = std::exp(double_complex(0.0, phase));
-            const auto& atom_type   = unit_cell_.atom(atom).type();
-            const auto z            = std::pow(double_complex(0, -1), l) * fourpi / std::sqrt(unit_cell_.omega());
-
-            if (!hubbard) {
-                /* for spin orbit coupling the initial wave functions of a given
-                 * shell are full spinors with a different radial part. the
-                 * orbitals j = l - 1/2 and j = l + 1/2 are next to each other
-                 * in the index structure, so I explicitely compute the
-                 * average */
+            int idxrf = index[xi].idxrf;
+            lmax      = std::max(lmax, l);
 
+            if (atom_type.spin_orbit_coupling()) {
+                /* in that case each atomic orbital has a distinct j and are considered as independent orbitals;
+                   the orbitals j = l - 1/2 and j = l + 1/2 are next to each other in the index structure, so the
+                   average of the radial integrals is taken */
                 for (int m = -l; m <= l; m++) {
-                    const int lm = utils::lm(l, m);
-                    phi.pw_coeffs(0).prime(igk_loc, n + offset) =
-                        z * std::conj(phase_factor) * rlm[lm] * ri_values[index_radial_function];
+                    columns[iat].push_back({n, n + 2 * l + 1, l, utils::lm(l, m),
+                                            atom_type.hubbard_orbital(idxrf).rindex(),
+                                            atom_type.hubbard_orbital(idxrf + 1).rindex(), 0.5});
                     n++;
                 }
-                xi += 2 * l + 1;
+                xi += 2 * (2 * l + 1);
+                n += 2 * l + 1;
             } else {
-                /* hubbard atomic orbitals */
-
-                if (atom_type.spin_orbit_coupling()) {
-                    /* in that case each atomic orbital has a distinct j and are
-                       considered as independent orbitals. */
-                    const auto average = (ri_values[atom_type.hubbard_orbital(index_radial_function).rindex()] +
-                                          ri_values[atom_type.hubbard_orbital(index_radial_function + 1).rindex()]);
-
-                    for (int m = -l; m <= l; m++) {
-                        const int lm = utils::lm(l, m);
-                        phi.pw_coeffs(1).prime(igk_loc, n + offset + 2 * l + 1) =
-                            0.5 * z * std::conj(phase_factor) * rlm[lm] * average;
-                        phi.pw_coeffs(0).prime(igk_loc, n + offset) =
-                            0.5 * z * std::conj(phase_factor) * rlm[lm] * average;
-                        n += 1;
+                /* it is a one orbital but with degeneracy 2; in the non-collinear case the spin-down component is
+                   a copy of the spin-up one */
+                for (int m = -l; m <= l; m++) {
+                    columns[iat].push_back({n, (ctx_.num_mag_dims() == 3) ? n + 2 * l + 1 : -1, l, utils::lm(l, m),
+                                            atom_type.hubbard_orbital(idxrf).rindex(), -1, 1.0});
+                    n++;
+                }
+                xi += 2 * l + 1;
+            }
+        }
+    }
+
+    /* plane-wave coefficients of the orbitals of atom types without the structure factor */
+    std::vector<mdarray<double_complex, 2>> wf_t(unit_cell_.num_atom_types());
+    for (int iat = 0; iat < unit_cell_.num_atom_types(); iat++) {
+        if (is_used[iat]) {
+            wf_t[iat] = mdarray<double_complex, 2>(num_gkvec_loc(), columns[iat].size(),
+                                                   ctx_.mem_pool(memory_t::host));
+        }
+    }
+
+    std::vector<double_complex> z(lmax + 1);
+    for (int l = 0; l <= lmax; l++) {
+        z[l] = std::pow(double_complex(0, -1), l) * fourpi / std::sqrt(unit_cell_.omega());
+    }
+
+    /* lengths of G+k vectors */
+    std::vector<double> gk_len(num_gkvec_loc());
+    for (int igk_loc = 0; igk_loc < num_gkvec_loc(); igk_loc++) {
+        gk_len[igk_loc] = gkvec().gkvec_cart<index_domain_t::local>(igk_loc).length();
+    }
+
+    /* values of radial integrals of the used atom types for all G+k vectors */
+    int nrf = ctx_.atomic_wf_ri().num_func_per_type();
+    mdarray<double, 3> ri_values(nrf, num_gkvec_loc(), unit_cell_.num_atom_types());
+    for (int iat = 0; iat < unit_cell_.num_atom_types(); iat++) {
+        if (is_used[iat]) {
+            ctx_.atomic_wf_ri().values(iat, num_gkvec_loc(), gk_len.data(), &ri_values(0, 0, iat), nrf);
+        }
+    }
+
+    #pragma omp parallel
+    {
+        std::vector<double> rlm(utils::lmmax(lmax));
+        #pragma omp for schedule(static)
+        for (int igk_loc = 0; igk_loc < num_gkvec_loc(); igk_loc++) {
+            /* vs = {r, theta, phi} */
+            auto vs = SHT::spherical_coordinates(gkvec().gkvec_cart<index_domain_t::local>(igk_loc));
+            /* compute real spherical harmonics for G+k vector */
+            sf::spherical_harmonics(lmax, vs[1], vs[2], &rlm[0]);
+
+            for (int iat = 0; iat < unit_cell_.num_atom_types(); iat++) {
+                if (!is_used[iat]) {
+                    continue;
+                }
+                for (int i = 0; i < static_cast<int>(columns[iat].size()); i++) {
+                    auto& c = columns[iat][i];
+                    double f = ri_values(c.rf1, igk_loc, iat);
+                    if (c.rf2 >= 0) {
+                        f += ri_values(c.rf2, igk_loc, iat);
                     }
-                    xi += 2 * (2 * l + 1);
-                    n += 2 * l + 1;
-                } else {
-
-                    /* it is a one orbital but with degeneracy 2. we should
-                       consider the magnetic and non magnetic case */
-                    for (int m = -l; m <= l; m++) {
-                        const int lm = utils::lm(l, m);
-                        phi.pw_coeffs(0).prime(igk_loc, n + offset) =
-                            z * std::conj(phase_factor) * rlm[lm] *
-                            ri_values[atom_type.hubbard_orbital(index_radial_function).rindex()];
-                        /* copy from spin up */
-                        if (ctx_.num_mag_dims() == 3) {
-                            phi.pw_coeffs(1).prime(igk_loc, n + offset + 2 * l + 1) =
-                                 phi.pw_coeffs(0).prime(igk_loc, n + offset);
-                        }
-                        n++;
+                    wf_t[iat](igk_loc, i) = c.w * z[c.l] * rlm[c.lm] * f;
+                }
+            }
+        }
+    }
+
+    /* multiply by the structure factors e^{-i(G+k)r_{\alpha}} of all atoms */
+    #pragma omp parallel
+    {
+        std::vector<double_complex> phase_gk(num_gkvec_loc());
+        #pragma omp for schedule(dynamic)
+        for (int i = 0; i < static_cast<int>(atoms__.size()); i++) {
+            int ia  = atoms__[i];
+            int iat = unit_cell_.atom(ia).type_id();
+
+            auto phase_k = std::exp(double_complex(0.0, twopi * dot(gkvec().vk(), unit_cell_.atom(ia).position())));
+            for (int igk_loc = 0; igk_loc < num_gkvec_loc(); igk_loc++) {
+                auto G            = gkvec().gvec(idxgk(igk_loc));
+                phase_gk[igk_loc] = std::conj(ctx_.gvec_phase_factor(G, ia) * phase_k);
+            }
+            for (int j = 0; j < static_cast<int>(columns[iat].size()); j++) {
+                auto& c = columns[iat][j];
+                for (int igk_loc = 0; igk_loc < num_gkvec_loc(); igk_loc++) {
+                    phi__.pw_coeffs(0).prime(igk_loc, offset[ia] + c.col0) = wf_t[iat](igk_loc, j) * phase_gk[igk_loc];
+                }
+                if (c.col1 >= 0) {
+                    for (int igk_loc = 0; igk_loc < num_gkvec_loc(); igk_loc++) {
+                        phi__.pw_coeffs(1).prime(igk_loc, offset[ia] + c.col1) =
+                            phi__.pw_coeffs(0).prime(igk_loc, offset[ia] + c.col0);
                     }
-                    xi += 2 * l + 1;
                 }
             }
         }
@@ -310,6 +310,12 @@ void K_point::generate_gkvec(double gk_cutoff__)
         spfft_pu, fft_type, ctx_.fft_coarse_grid()[0], ctx_.fft_coarse_grid()[1], ctx_.fft_coarse_grid()[2],
         ctx_.spfft_coarse().local_z_length(), gkvec_partition_->gvec_count_fft(), SPFFT_INDEX_TRIPLETS,
         gv.at(memory_t::host))));
+
+    /* real wave-functions are transformed in pairs with the complex FFT */
+    if (gkvec_->reduced() && spfft_pu == SPFFT_PU_HOST && ctx_.control().fft_gamma_pair_) {
+        spfft_transform_pair_ = std::unique_ptr<Gamma_pair_transform>(new Gamma_pair_transform(
+            *gkvec_partition_, ctx_.fft_coarse_grid(), ctx_.spfft_coarse().local_z_length()));
+    }
 }
 
 void K_point::update()
@@ -330,8 +336,11 @@ void K_point::update()
     }
 
     if (!ctx_.full_potential()) {
-        /* compute |beta> projectors for atom types */
-        beta_projectors_ = std::unique_ptr<Beta_projectors>(new Beta_projectors(ctx_, gkvec(), igk_loc_));
+        bool beta_rs = ctx_.control().beta_real_space_ && ctx_.iterative_solver_input().type_ != "exact";
+        /* compute |beta> projectors for atom types; with the real-space projectors the plane-wave ones are only
+           needed by the S-operator, density matrix and forces, so they are cached only if S is not unity */
+        beta_projectors_ = std::unique_ptr<Beta_projectors>(
+            new Beta_projectors(ctx_, gkvec(), igk_loc_, !beta_rs || unit_cell_.augment()));
 
         if (ctx_.iterative_solver_input().type_ == "exact") {
             beta_projectors_row_ = std::unique_ptr<Beta_projectors>(new Beta_projectors(ctx_, gkvec(), igk_row_));
@@ -339,6 +348,15 @@ void K_point::update()
 
         }
 
+        if (beta_rs) {
+            if (ctx_.processing_unit() != device_t::CPU || ctx_.num_mag_dims() == 3 || ctx_.so_correction()) {
+                throw std::runtime_error("[sirius::K_point::update] real-space beta-projectors are supported only "
+                                         "on CPU in the spin-collinear case");
+            }
+            beta_projectors_real_space_ = std::unique_ptr<Beta_projectors_real_space>(
+                new Beta_projectors_real_space(ctx_, spfft_transform(), vk_));
+        }
+
         if (ctx_.hubbard_correction()) {
             generate_hubbard_orbitals();
         }
@@ -759,89 +777,123 @@ void K_point::test_spinor_wave_functions(int use_fft)
 //==     std :: cout << "maximum error = " << maxerr << std::endl;
 }
 
-/** The following HDF5 data structure is created:
+/** Each MPI rank stores its block of G+k vectors in its own file (see wave_functions_file_name()). The
+    following HDF5 data structure is created:
   \verbatim
-  /K_point_set/ik/vk
-  /K_point_set/ik/band_energies
-  /K_point_set/ik/band_occupancies
-  /K_point_set/ik/gkvec
-  /K_point_set/ik/gvec
-  /K_point_set/ik/bands/ibnd/spinor_wave_function/ispn/pw
-  /K_point_set/ik/bands/ibnd/spinor_wave_function/ispn/mt
+  /ik/num_gkvec_loc
+  /ik/gvec
+  /ik/spinor_wave_functions/ispn
   \endverbatim
+  Band energies and occupancies are written to the main file by K_point_set::save().
 */
 void K_point::save(std::string const& name__, int id__) const
 {
-    /* rank 0 creates placeholders in the HDF5 file */
-    if (comm().rank() == 0) {
-        /* open file with write access */
-        HDF5_tree fout(name__, hdf5_access_t::read_write);
-        /* create /K_point_set/ik */
-        fout["K_point_set"].create_node(id__);
-        fout["K_point_set"][id__].write("vk", &vk_[0], 3);
-        fout["K_point_set"][id__].write("band_energies", band_energies_);
-        fout["K_point_set"][id__].write("band_occupancies", band_occupancies_);
-
-        /* save the entire G+k object */
-        //TODO: only the list of z-columns is probably needed to recreate the G+k vectors
-        serializer s;
-        gkvec().pack(s);
-        fout["K_point_set"][id__].write("gkvec", s.stream());
-
-        /* save the order of G-vectors */
-        mdarray<int, 2> gv(3, num_gkvec());
-        for (int i = 0; i < num_gkvec(); i++) {
-            auto v = gkvec().gvec(i);
-            for (int x: {0, 1, 2}) {
-                gv(x, i) = v[x];
-            }
-        }
-        fout["K_point_set"][id__].write("gvec", gv);
-        fout["K_point_set"][id__].create_node("bands");
-        for (int i = 0; i < ctx_.num_bands(); i++) {
-            fout["K_point_set"][id__]["bands"].create_node(i);
-            fout["K_point_set"][id__]["bands"][i].create_node("spinor_wave_function");
-            for (int ispn = 0; ispn < ctx_.num_spins(); ispn++) {
-                fout["K_point_set"][id__]["bands"][i]["spinor_wave_function"].create_node(ispn);
-            }
+    PROFILE("sirius::K_point::save");
+
+    HDF5_tree fout(name__, hdf5_access_t::read_write);
+    fout.create_node(id__);
+    fout[id__].write("num_gkvec_loc", gkvec().count());
+    if (gkvec().count() == 0) {
+        return;
+    }
+
+    /* save the order of the local G-vectors */
+    mdarray<int, 2> gv(3, gkvec().count());
+    for (int igloc = 0; igloc < gkvec().count(); igloc++) {
+        auto v = gkvec().gvec(gkvec().offset() + igloc);
+        for (int x: {0, 1, 2}) {
+            gv(x, igloc) = v[x];
         }
     }
-    /* wait for rank 0 */
-    comm().barrier();
-    int gkvec_count = gkvec().count();
-    int gkvec_offset = gkvec().offset();
-    std::vector<double_complex> wf_tmp(num_gkvec());
-
-    std::unique_ptr<HDF5_tree> fout;
-    /* rank 0 opens a file */
-    if (comm().rank() == 0) {
-        fout = std::unique_ptr<HDF5_tree>(new HDF5_tree(name__, hdf5_access_t::read_write));
+    fout[id__].write("gvec", gv);
+    /* wave-functions of each spin component are stored as a single {2, num_gkvec_loc, num_bands} array */
+    fout[id__].create_node("spinor_wave_functions");
+    for (int ispn = 0; ispn < ctx_.num_spins(); ispn++) {
+        auto& wf = spinor_wave_functions_->pw_coeffs(ispn).prime();
+        fout[id__]["spinor_wave_functions"].create_dataset<double>(std::to_string(ispn),
+            {2, gkvec().count(), ctx_.num_bands()});
+        fout[id__]["spinor_wave_functions"].write_slab(std::to_string(ispn),
+            reinterpret_cast<double const*>(wf.at(memory_t::host)), {0, 0, 0}, {2, gkvec().count(), ctx_.num_bands()});
+    }
+}
+
+void K_point::load(HDF5_tree h5in__, std::string const& name__, int id__)
+{
+    PROFILE("sirius::K_point::load");
+
+    auto h5k = h5in__[id__];
+
+    h5k.read("band_energies", band_energies_);
+    h5k.read("band_occupancies", band_occupancies_);
+
+    /* ranks which have written the blocks of G+k vectors of this k-point */
+    std::vector<int> wf_ranks;
+    h5k.read("wf_ranks", wf_ranks);
+
+    /* the stored wave-functions may come from a different MPI layout: find the position of the local
+     * G+k vectors in the stored blocks */
+    std::map<vector3d<int>, int> local_gvec_mapping;
+    for (int igloc = 0; igloc < gkvec().count(); igloc++) {
+        local_gvec_mapping[gkvec().gvec(gkvec().offset() + igloc)] = igloc;
     }
 
-    /* store wave-functions */
-    for (int i = 0; i < ctx_.num_bands(); i++) {
+    int nb = ctx_.num_bands();
+    int ngk{0};
+    int nfound{0};
+    for (int r : wf_ranks) {
+        HDF5_tree fin(wave_functions_file_name(name__, r), hdf5_access_t::read_only);
+
+        int n;
+        fin[id__].read("num_gkvec_loc", &n, 1);
+        if (n == 0) {
+            continue;
+        }
+        ngk += n;
+        mdarray<int, 2> gv(3, n);
+        fin[id__].read("gvec", gv);
+
+        std::vector<std::pair<int, int>> idx;
+        for (int ig = 0; ig < n; ig++) {
+            vector3d<int> G(&gv(0, ig));
+            auto it = local_gvec_mapping.find(G);
+            if (it != local_gvec_mapping.end()) {
+                idx.push_back(std::make_pair(ig, it->second));
+            }
+        }
+        if (idx.empty()) {
+            continue;
+        }
+        nfound += static_cast<int>(idx.size());
+
+        /* read the block of wave-functions in chunks of bands */
+        int bs = std::max(1, std::min(nb, (1 << 22) / n));
+        mdarray<double_complex, 2> wf_tmp(n, bs);
+
         for (int ispn = 0; ispn < ctx_.num_spins(); ispn++) {
-            /* gather full column of PW coefficients on rank 0 */
-            comm().gather(&spinor_wave_functions_->pw_coeffs(ispn).prime(0, i), wf_tmp.data(), gkvec_offset, gkvec_count, 0);
-            if (comm().rank() == 0) {
-                (*fout)["K_point_set"][id__]["bands"][i]["spinor_wave_function"][ispn].write("pw", wf_tmp);
+            auto& wf = spinor_wave_functions_->pw_coeffs(ispn).prime();
+            for (int i0 = 0; i0 < nb; i0 += bs) {
+                int nbs = std::min(bs, nb - i0);
+                fin[id__]["spinor_wave_functions"].read_slab(std::to_string(ispn),
+                    reinterpret_cast<double*>(wf_tmp.at(memory_t::host)), {0, 0, i0}, {2, n, nbs});
+                #pragma omp parallel for schedule(static)
+                for (int i = 0; i < nbs; i++) {
+                    for (auto& e : idx) {
+                        wf(e.second, i0 + i) = wf_tmp(e.first, i);
+                    }
+                }
             }
         }
-        comm().barrier();
     }
-}
-
-void K_point::load(HDF5_tree h5in, int id)
-{
-    STOP();
-    //== band_energies_.resize(ctx_.num_bands());
-    //== h5in[id].read("band_energies", band_energies_);
-
-    //== band_occupancies_.resize(ctx_.num_bands());
-    //== h5in[id].read("band_occupancies", band_occupancies_);
-    //==
-    //== h5in[id].read_mdarray("fv_eigen_vectors", fv_eigen_vectors_panel_);
-    //== h5in[id].read_mdarray("sv_eigen_vectors", sv_eigen_vectors_);
+    if (ngk != num_gkvec()) {
+        std::stringstream s;
+        s << "[sirius::K_point::load] wrong number of G+k vectors" << std::endl
+          << "  stored : " << ngk << std::endl
+          << "  current : " << num_gkvec();
+        throw std::runtime_error(s.str());
+    }
+    if (nfound != gkvec().count()) {
+        throw std::runtime_error("[sirius::K_point::load] stored G+k vectors don't match");
+    }
 }
 
 //== void K_point::save_wave_functions(int id)
@@ -914,12 +966,13 @@ void K_point::generate_hubbard_orbitals()
         phi.pw_coeffs(ispn).prime().zero();
     }
 
+    std::vector<int> atoms;
     for (int ia = 0; ia < unit_cell_.num_atoms(); ia++) {
-        auto& atom_type = unit_cell_.atom(ia).type();
-        if (atom_type.hubbard_correction()) {
-            generate_atomic_wave_functions(atom_type.hubbard_indexb_wfc(), ia, r.second[ia], true, phi);
+        if (unit_cell_.atom(ia).type().hubbard_correction()) {
+            atoms.push_back(ia);
         }
     }
+    generate_hubbard_atomic_wave_functions(atoms, phi);
 
     /* check if we have a norm conserving pseudo potential only */
     auto q_op = (unit_cell_.augment()) ? std::unique_ptr<Q_operator>(new Q_operator(ctx_)) : nullptr;
@@ -955,22 +1008,20 @@ K_point::generate_atomic_wave_functions(std::vector<int> atoms__,
 {
     PROFILE("sirius::K_point::generate_atomic_wave_functions");
 
-    int lmax{3};
-    int lmmax = utils::lmmax(lmax);
-    //for (int iat = 0; iat < unit_cell_.num_atom_types(); iat++) {
-    //    auto& atom_type = unit_cell_.atom_type(iat);
-    //    lmax            = std::max(lmax, atom_type.lmax_ps_atomic_wf());
-    //}
-    //lmax = std::max(lmax, unit_cell_.lmax());
-
-    /* compute offset for each atom */
+    /* compute offset for each atom and the maximum orbital quantum number */
     std::vector<int> offset;
     int n{0};
+    int lmax{0};
     for (int ia: atoms__) {
         offset.push_back(n);
         int iat = unit_cell_.atom(ia).type_id();
-        n += indexb__(iat)->size();
+        auto const& indexb = *indexb__(iat);
+        n += indexb.size();
+        for (int xi = 0; xi < indexb.size(); xi++) {
+            lmax = std::max(lmax, indexb[xi].l);
+        }
     }
+    int lmmax = utils::lmmax(lmax);
 
     /* allocate memory to store wave-functions for atom types */
     std::vector<mdarray<double_complex, 2>> wf_t(unit_cell_.num_atom_types());
@@ -982,6 +1033,21 @@ K_point::generate_atomic_wave_functions(std::vector<int> atoms__,
         }
     }
 
+    /* lengths of G+k vectors */
+    std::vector<double> gk_len(this->num_gkvec_loc());
+    for (int igk_loc = 0; igk_loc < this->num_gkvec_loc(); igk_loc++) {
+        gk_len[igk_loc] = this->gkvec().gkvec_cart<index_domain_t::local>(igk_loc).length();
+    }
+
+    /* get all values of the radial integrals of the used atom types for all G+k vectors */
+    int nrf = ri__.num_func_per_type();
+    mdarray<double, 3> ri_values(nrf, this->num_gkvec_loc(), unit_cell_.num_atom_types());
+    for (int iat = 0; iat < unit_cell_.num_atom_types(); iat++) {
+        if (wf_t[iat].size() != 0) {
+            ri__.values(iat, this->num_gkvec_loc(), gk_len.data(), &ri_values(0, 0, iat), nrf);
+        }
+    }
+
     #pragma omp parallel for schedule(static)
     for (int igk_loc = 0; igk_loc < this->num_gkvec_loc(); igk_loc++) {
         /* vs = {r, theta, phi} */
@@ -991,13 +1057,6 @@ K_point::generate_atomic_wave_functions(std::vector<int> atoms__,
         std::vector<double> rlm(lmmax);
         sf::spherical_harmonics(lmax, vs[1], vs[2], &rlm[0]);
 
-        /* get all values of the radial integrals for a given G+k vector */
-        std::vector<mdarray<double, 1>> ri_values(unit_cell_.num_atom_types());
-        for (int iat = 0; iat < unit_cell_.num_atom_types(); iat++) {
-            if (wf_t[iat].size() != 0) {
-                ri_values[iat] = ri__.values(iat, vs[0]);
-            }
-        }
         for (int iat = 0; iat < unit_cell_.num_atom_types(); iat++) {
             if (wf_t[iat].size() == 0) {
                 continue;
@@ -1013,33 +1072,36 @@ K_point::generate_atomic_wave_functions(std::vector<int> atoms__,
 
                 auto z = std::pow(double_complex(0, -1), l) * fourpi / std::sqrt(unit_cell_.omega());
 
-                wf_t[iat](igk_loc, xi) = z * rlm[lm] * ri_values[iat](idxrf);
+                wf_t[iat](igk_loc, xi) = z * rlm[lm] * ri_values(idxrf, igk_loc, iat);
             }
         }
     }
 
-    for (int ia: atoms__) {
-
-        double phase = twopi * dot(gkvec().vk(), unit_cell_.atom(ia).position());
-        double_complex phase_k = std::exp(double_complex(0.0, phase));
-
-        /* quickly compute phase factors without calling exp() function */
+    /* multiply by the structure factors; the phase factors are computed once per atom and G+k-vector from the
+       precomputed 1D exponents and reused for all orbitals of the atom */
+    #pragma omp parallel
+    {
         std::vector<double_complex> phase_gk(num_gkvec_loc());
-        #pragma omp parallel for schedule(static)
-        for (int igk_loc = 0; igk_loc < num_gkvec_loc(); igk_loc++) {
-            /* global index of G+k-vector */
-            int igk = this->idxgk(igk_loc);
-            auto G = gkvec().gvec(igk);
-            /* total phase e^{-i(G+k)r_{\alpha}} */
-            phase_gk[igk_loc] = std::conj(ctx_.gvec_phase_factor(G, ia) * phase_k);
-        }
+        #pragma omp for schedule(dynamic)
+        for (int i = 0; i < static_cast<int>(atoms__.size()); i++) {
+            int ia = atoms__[i];
+
+            double phase = twopi * dot(gkvec().vk(), unit_cell_.atom(ia).position());
+            double_complex phase_k = std::exp(double_complex(0.0, phase));
 
-        int iat = unit_cell_.atom(ia).type_id();
-        #pragma omp parallel
-        for (int xi = 0; xi < indexb__(iat)->size(); xi++) {
-            #pragma omp for schedule(static) nowait
             for (int igk_loc = 0; igk_loc < num_gkvec_loc(); igk_loc++) {
-                wf__.pw_coeffs(0).prime(igk_loc, offset[ia] + xi) = wf_t[iat](igk_loc, xi) * phase_gk[igk_loc];
+                /* global index of G+k-vector */
+                int igk = this->idxgk(igk_loc);
+                auto G = gkvec().gvec(igk);
+                /* total phase e^{-i(G+k)r_{\alpha}} */
+                phase_gk[igk_loc] = std::conj(ctx_.gvec_phase_factor(G, ia) * phase_k);
+            }
+
+            int iat = unit_cell_.atom(ia).type_id();
+            for (int xi = 0; xi < indexb__(iat)->size(); xi++) {
+                for (int igk_loc = 0; igk_loc < num_gkvec_loc(); igk_loc++) {
+                    wf__.pw_coeffs(0).prime(igk_loc, offset[i] + xi) = wf_t[iat](igk_loc, xi) * phase_gk[igk_loc];
+                }
             }
         }
     }
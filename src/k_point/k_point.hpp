@@ -27,10 +27,20 @@
 
 #include "lapw/matching_coefficients.hpp"
 #include "beta_projectors/beta_projectors.hpp"
+#include "beta_projectors/beta_projectors_real_space.hpp"
 #include "wave_functions.hpp"
+#include "SDDK/fft_gamma_pair.hpp"
 
 namespace sirius {
 
+/// Name of the HDF5 file with the wave-functions written by a given MPI rank.
+/** The serial HDF5 library can't write to one file from several ranks, so each rank stores its block of
+ *  wave-functions next to the main storage file. */
+inline std::string wave_functions_file_name(std::string const& name__, int rank__)
+{
+    return name__ + "." + std::to_string(rank__);
+}
+
 /// K-point related variables and methods.
 /** \image html wf_storage.png "Wave-function storage"
  *  \image html fv_eigen_vectors.png "First-variational eigen vectors" */
@@ -60,6 +70,9 @@ class K_point
 
     std::unique_ptr<spfft::Transform> spfft_transform_;
 
+    /// Complex FFT driver for pairs of real wave-functions in the Gamma-point case.
+    std::unique_ptr<Gamma_pair_transform> spfft_transform_pair_;
+
     /// First-variational eigen values
     std::vector<double> fv_eigen_values_;
 
@@ -174,6 +187,10 @@ class K_point
     /** Used to setup the full Hamiltonian in PP-PW case (for verification purpose only) */
     std::unique_ptr<Beta_projectors> beta_projectors_col_{nullptr};
 
+    /// Beta projectors sampled on the real-space points of the coarse FFT grid.
+    /** Created only if Control_input::beta_real_space_ is set. */
+    std::unique_ptr<Beta_projectors_real_space> beta_projectors_real_space_{nullptr};
+
     /// Preconditioner matrix for Chebyshev solver.
     mdarray<double_complex, 3> p_mtrx_;
 
@@ -267,8 +284,15 @@ class K_point
         states and second-variational eigen-vectors. */
     void generate_spinor_wave_functions();
 
-    void generate_atomic_wave_functions(const basis_functions_index& index, const int atom, const int offset,
-                                        const bool hubbard, Wave_functions& phi);
+    /// Generate plane-wave coefficients of the Hubbard atomic orbitals for a list of atoms.
+    /** The angular and radial parts (spherical harmonics times radial integrals) are computed once per atom type;
+     *  the orbitals of each atom are then obtained by multiplication with the structure factor. The orbitals are
+     *  placed at the offsets given by Unit_cell::num_wf_with_U().
+     *
+     *  \param [in]  atoms List of atoms with Hubbard correction.
+     *  \param [out] phi   Resulting wave-functions; must have storage for all Hubbard orbitals.
+     */
+    void generate_hubbard_atomic_wave_functions(std::vector<int> const& atoms__, Wave_functions& phi__);
 
     /// Generate plane-wave coefficients of the atomic wave-functions.
     /** Plane-wave coefficients of the atom-centered wave-functions
@@ -333,10 +357,14 @@ class K_point
 
     void orthogonalize_hubbard_orbitals(Wave_functions& phi__);
 
-    /// Save data to HDF5 file.
+    /// Save the local block of wave-functions to the HDF5 file of this MPI rank.
     void save(std::string const& name__, int id__) const;
 
-    void load(HDF5_tree h5in, int id);
+    /// Load band energies, occupancies and wave-functions.
+    /** Band energies and occupancies are read from the /K_point_set node of the main file; the wave-functions
+     *  are read from the files of the ranks that have written them and are redistributed to the current MPI
+     *  layout of G+k vectors. */
+    void load(HDF5_tree h5in__, std::string const& name__, int id__);
 
     //== void save_wave_functions(int id);
 
@@ -727,6 +755,12 @@ class K_point
         return *beta_projectors_;
     }
 
+    /// Return real-space beta projectors or nullptr if they are not used.
+    Beta_projectors_real_space const* beta_projectors_real_space() const
+    {
+        return beta_projectors_real_space_.get();
+    }
+
     Beta_projectors& beta_projectors_row()
     {
         assert(beta_projectors_ != nullptr);
@@ -765,6 +799,12 @@ class K_point
     {
         return *spfft_transform_;
     }
+
+    /// Return complex FFT driver for pairs of real wave-functions or nullptr if it is not used.
+    Gamma_pair_transform* spfft_transform_pair()
+    {
+        return spfft_transform_pair_.get();
+    }
 };
 
 } // namespace sirius
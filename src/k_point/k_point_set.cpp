@@ -18,10 +18,12 @@
 // OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <limits>
+#include <algorithm>
 #include "dft/smearing.hpp"
 #include "k_point/k_point.hpp"
 #include "k_point/k_point_set.hpp"
 #include "symmetry/get_irreducible_reciprocal_mesh.hpp"
+#include "SDDK/serializer.hpp"
 
 namespace sirius {
 
@@ -100,12 +102,21 @@ void K_point_set::initialize(std::vector<int> const& counts)
     PROFILE("sirius::K_point_set::initialize");
     /* distribute k-points along the 1-st dimension of the MPI grid */
     if (counts.empty()) {
-        splindex<splindex_t::block> spl_tmp(num_kpoints(), comm().size(), comm().rank());
-        spl_num_kpoints_ = splindex<splindex_t::chunk>(num_kpoints(), comm().size(), comm().rank(), spl_tmp.counts());
+        if (ctx_.control().kpoint_distribution_ == "cost") {
+            spl_num_kpoints_ = splindex<splindex_t::chunk>(num_kpoints(), comm().size(), comm().rank(),
+                                                           partition_by_cost(kpoint_cost(), comm().size()));
+        } else {
+            splindex<splindex_t::block> spl_tmp(num_kpoints(), comm().size(), comm().rank());
+            spl_num_kpoints_ = splindex<splindex_t::chunk>(num_kpoints(), comm().size(), comm().rank(),
+                                                           spl_tmp.counts());
+        }
     } else {
         spl_num_kpoints_ = splindex<splindex_t::chunk>(num_kpoints(), comm().size(), comm().rank(), counts);
     }
 
+    solve_time_      = std::vector<double>(num_kpoints(), 0);
+    solve_num_steps_ = std::vector<int>(num_kpoints(), 0);
+
     for (int ikloc = 0; ikloc < spl_num_kpoints_.local_size(); ikloc++) {
         kpoints_[spl_num_kpoints_[ikloc]]->initialize();
     }
@@ -116,6 +127,190 @@ void K_point_set::initialize(std::vector<int> const& counts)
     ctx_.print_memory_usage(__FILE__, __LINE__);
 }
 
+std::vector<double> K_point_set::kpoint_cost() const
+{
+    PROFILE("sirius::K_point_set::kpoint_cost");
+
+    std::vector<double> cost(num_kpoints(), 0);
+
+    /* measured wall-time is available only after the first band solve; the owners of the k-point (all ranks of
+       the band communicator) store the value */
+    if (solve_time_.size() == static_cast<size_t>(num_kpoints())) {
+        cost = solve_time_;
+        ctx_.comm().allreduce<double, mpi_op_t::max>(cost.data(), num_kpoints());
+        if (*std::min_element(cost.begin(), cost.end()) > 0) {
+            return cost;
+        }
+    }
+
+    std::vector<int> num_steps(num_kpoints(), 1);
+    if (solve_num_steps_.size() == static_cast<size_t>(num_kpoints())) {
+        num_steps = solve_num_steps_;
+        ctx_.comm().allreduce<int, mpi_op_t::max>(num_steps.data(), num_kpoints());
+    }
+
+    /* count G+k vectors using the local fraction of the coarse G-vectors */
+    auto& gv = ctx_.gvec_coarse();
+    std::vector<int> num_gkvec(num_kpoints(), 0);
+    for (int ik = 0; ik < num_kpoints(); ik++) {
+        auto vk = ctx_.unit_cell().reciprocal_lattice_vectors() * kpoints_[ik]->vk();
+        for (int igloc = 0; igloc < gv.count(); igloc++) {
+            if ((gv.gvec_cart<index_domain_t::local>(igloc) + vk).length() <= ctx_.gk_cutoff()) {
+                num_gkvec[ik]++;
+            }
+        }
+    }
+    gv.comm().allreduce(num_gkvec.data(), num_kpoints());
+
+    for (int ik = 0; ik < num_kpoints(); ik++) {
+        double n = std::max(num_gkvec[ik], 1);
+        cost[ik] = std::max(num_steps[ik], 1) * n * (std::log2(n) + ctx_.num_bands());
+    }
+    return cost;
+}
+
+std::vector<int> K_point_set::partition_by_cost(std::vector<double> const& cost__, int num_ranks__)
+{
+    int nk = static_cast<int>(cost__.size());
+
+    /* number of chunks needed if the cost of a chunk is limited by a given value */
+    auto num_chunks = [&](double max_cost) {
+        int n{1};
+        double c{0};
+        for (int ik = 0; ik < nk; ik++) {
+            if (c + cost__[ik] > max_cost) {
+                n++;
+                c = cost__[ik];
+            } else {
+                c += cost__[ik];
+            }
+        }
+        return n;
+    };
+
+    /* bisection on the maximum cost of a chunk */
+    double lo{0};
+    double hi{0};
+    for (int ik = 0; ik < nk; ik++) {
+        lo = std::max(lo, cost__[ik]);
+        hi += cost__[ik];
+    }
+    for (int i = 0; i < 100 && hi - lo > 1e-12 * hi; i++) {
+        double mid = 0.5 * (lo + hi);
+        if (num_chunks(mid) <= num_ranks__) {
+            hi = mid;
+        } else {
+            lo = mid;
+        }
+    }
+
+    std::vector<int> counts(num_ranks__, 0);
+    int ik{0};
+    for (int r = 0; r < num_ranks__; r++) {
+        double c{0};
+        while (ik < nk) {
+            /* keep at least one k-point for each of the remaining ranks */
+            if (counts[r] > 0 && (c + cost__[ik] > hi || nk - ik <= num_ranks__ - r - 1)) {
+                break;
+            }
+            c += cost__[ik];
+            counts[r]++;
+            ik++;
+        }
+    }
+    counts[num_ranks__ - 1] += nk - ik;
+
+    return counts;
+}
+
+void K_point_set::rebalance()
+{
+    PROFILE("sirius::K_point_set::rebalance");
+
+    if (ctx_.full_potential()) {
+        ctx_.message(1, __function_name__, "%s", "redistribution of k-points is not supported in full-potential case\n");
+        return;
+    }
+    if (comm().size() == 1) {
+        return;
+    }
+
+    auto cost   = kpoint_cost();
+    auto counts = partition_by_cost(cost, comm().size());
+
+    splindex<splindex_t::chunk> spl_new(num_kpoints(), comm().size(), comm().rank(), counts);
+
+    /* maximum load of the current and of the new distribution */
+    auto max_load = [&](splindex<splindex_t::chunk> const& spl) {
+        std::vector<double> load(comm().size(), 0);
+        for (int ik = 0; ik < num_kpoints(); ik++) {
+            load[spl.local_rank(ik)] += cost[ik];
+        }
+        return *std::max_element(load.begin(), load.end());
+    };
+    double load_old = max_load(spl_num_kpoints_);
+    double load_new = max_load(spl_new);
+
+    /* migration of wave-functions is not free; skip the small improvements */
+    if (load_new > 0.9 * load_old) {
+        return;
+    }
+    ctx_.message(1, __function_name__, "redistribute k-points, estimated maximum load: %f -> %f\n", load_old,
+                 load_new);
+
+    for (int ik = 0; ik < num_kpoints(); ik++) {
+        int src = spl_num_kpoints_.local_rank(ik);
+        int dst = spl_new.local_rank(ik);
+        if (src == dst) {
+            continue;
+        }
+        if (comm().rank() == dst) {
+            kpoints_[ik]->initialize();
+        }
+        /* G+k vectors are distributed in the same way between the ranks of the band communicator of the old and
+           new owners, so the local parts of the wave-functions are sent directly */
+        for (int ispn = 0; ispn < ctx_.num_spins(); ispn++) {
+            serializer s;
+            if (comm().rank() == src) {
+                serialize(s, kpoints_[ik]->spinor_wave_functions().pw_coeffs(ispn).prime());
+            }
+            s.send_recv(comm(), src, dst);
+            if (comm().rank() == dst) {
+                mdarray<double_complex, 2> tmp;
+                deserialize(s, tmp);
+                auto& psi = kpoints_[ik]->spinor_wave_functions().pw_coeffs(ispn).prime();
+                if (tmp.size() != psi.size()) {
+                    throw std::runtime_error("[sirius::K_point_set::rebalance] wrong size of wave-functions");
+                }
+                std::copy(&tmp[0], &tmp[0] + tmp.size(), &psi[0]);
+            }
+        }
+        if (comm().rank() == src) {
+            /* release the memory; band energies and occupancies are the same on all ranks */
+            auto vk = kpoints_[ik]->vk();
+            auto kp = std::unique_ptr<K_point>(new K_point(ctx_, &vk[0], kpoints_[ik]->weight(), ik));
+            for (int ispn = 0; ispn < ctx_.num_spin_dims(); ispn++) {
+                for (int j = 0; j < ctx_.num_bands(); j++) {
+                    kp->band_energy(j, ispn, kpoints_[ik]->band_energy(j, ispn));
+                    kp->band_occupancy(j, ispn, kpoints_[ik]->band_occupancy(j, ispn));
+                }
+            }
+            kpoints_[ik] = std::move(kp);
+        }
+    }
+    /* measured cost is kept only on the owners */
+    for (int ik = 0; ik < num_kpoints(); ik++) {
+        if (spl_new.local_rank(ik) != comm().rank()) {
+            solve_time_[ik]      = 0;
+            solve_num_steps_[ik] = 0;
+        }
+    }
+
+    spl_num_kpoints_ = spl_new;
+
+    ctx_.print_memory_usage(__FILE__, __LINE__);
+}
+
 void K_point_set::sync_band_occupancies()
 {
     int nranks = comm().size();
@@ -165,15 +360,8 @@ void K_point_set::find_band_occupancies()
 {
     PROFILE("sirius::K_point_set::find_band_occupancies");
 
-    double ef{0};
-    double de{0.1};
-
-    int s{1};
-    int sp;
-
-    mdarray<double, 3> bnd_occ(ctx_.num_bands(), ctx_.num_spin_dims(), num_kpoints());
-
-    double ne{0};
+    auto smearing_type  = ctx_.smearing();
+    auto smearing_width = ctx_.smearing_width();
 
     /* target number of electrons */
     double ne_target = ctx_.unit_cell().num_valence_electrons() - ctx_.parameters_input().extra_charge_;
@@ -195,46 +383,101 @@ void K_point_set::find_band_occupancies()
         return;
     }
 
-    int step{0};
-    /* calculate occupations */
-    while (std::abs(ne - ne_target) >= 1e-11) {
-        /* update Efermi */
-        ef += de;
-        /* compute total number of electrons */
-        ne = 0.0;
-        for (int ik = 0; ik < num_kpoints(); ik++) {
-            for (int ispn = 0; ispn < ctx_.num_spin_dims(); ispn++) {
-                for (int j = 0; j < ctx_.num_bands(); j++) {
-                    bnd_occ(j, ispn, ik) =
-                        smearing::gaussian(kpoints_[ik]->band_energy(j, ispn) - ef, ctx_.smearing_width()) *
-                        ctx_.max_occupancy();
-                    ne += bnd_occ(j, ispn, ik) * kpoints_[ik]->weight();
-                }
+    /* flat list of band energies and weights of the local k-points */
+    int nbnd = ctx_.num_bands() * ctx_.num_spin_dims();
+    std::vector<double> eband(spl_num_kpoints_.local_size() * nbnd);
+    std::vector<double> wband(spl_num_kpoints_.local_size() * nbnd);
+
+    double emin{std::numeric_limits<double>::max()};
+    double emax{std::numeric_limits<double>::lowest()};
+    for (int ikloc = 0; ikloc < spl_num_kpoints_.local_size(); ikloc++) {
+        int ik = spl_num_kpoints_[ikloc];
+        for (int ispn = 0; ispn < ctx_.num_spin_dims(); ispn++) {
+            for (int j = 0; j < ctx_.num_bands(); j++) {
+                int i    = ikloc * nbnd + ispn * ctx_.num_bands() + j;
+                eband[i] = kpoints_[ik]->band_energy(j, ispn);
+                wband[i] = kpoints_[ik]->weight() * ctx_.max_occupancy();
+                emin     = std::min(emin, eband[i]);
+                emax     = std::max(emax, eband[i]);
             }
         }
+    }
+    comm().allreduce<double, mpi_op_t::min>(&emin, 1);
+    comm().allreduce<double, mpi_op_t::max>(&emax, 1);
+
+    /* number of electrons and its derivative with respect to the Fermi level */
+    auto count_electrons = [&](double ef, double& dne) {
+        double ne{0};
+        dne = 0;
+        #pragma omp parallel for reduction(+:ne,dne)
+        for (int i = 0; i < static_cast<int>(eband.size()); i++) {
+            ne  += wband[i] * smearing::occupancy(smearing_type, eband[i] - ef, smearing_width);
+            dne += wband[i] * smearing::delta(smearing_type, eband[i] - ef, smearing_width);
+        }
+        double buf[] = {ne, dne};
+        comm().allreduce(buf, 2);
+        dne = buf[1];
+        return buf[0];
+    };
+
+    /* bracket the Fermi level */
+    double dne{0};
+    double ef_lo = emin - 20 * smearing_width;
+    double ef_hi = emax + 20 * smearing_width;
+    for (int i = 0; count_electrons(ef_hi, dne) < ne_target; i++) {
+        if (i == 100) {
+            TERMINATE("failed to bracket the Fermi level");
+        }
+        ef_hi += (ef_hi - ef_lo);
+    }
+    for (int i = 0; count_electrons(ef_lo, dne) > ne_target; i++) {
+        if (i == 100) {
+            TERMINATE("failed to bracket the Fermi level");
+        }
+        ef_lo -= (ef_hi - ef_lo);
+    }
 
-        sp = s;
-        s  = (ne > ne_target) ? -1 : 1;
-        /* reduce de step if we change the direction, otherwise increase the step */
-        de = (s != sp) ? (-de * 0.5) : (de * 1.25);
-
-        if (step > 10000) {
+    /* safeguarded Newton iterations: fall back to bisection if the Newton step leaves the bracket */
+    double ef = 0.5 * (ef_lo + ef_hi);
+    for (int step = 0;; step++) {
+        double ne = count_electrons(ef, dne);
+        if (std::abs(ne - ne_target) < 1e-11) {
+            break;
+        }
+        if (ne < ne_target) {
+            ef_lo = ef;
+        } else {
+            ef_hi = ef;
+        }
+        /* bracket can't be reduced any further */
+        if (ef_hi - ef_lo < 1e-14 * std::max(1.0, std::abs(ef))) {
+            break;
+        }
+        if (step > 1000) {
             std::stringstream s;
-            s << "search of band occupancies failed after 10000 steps";
+            s << "search of band occupancies failed after 1000 steps";
             TERMINATE(s);
         }
-        step++;
+        double ef_new = (dne > 0) ? ef + (ne_target - ne) / dne : ef_lo;
+        if (!(ef_new > ef_lo && ef_new < ef_hi)) {
+            ef_new = 0.5 * (ef_lo + ef_hi);
+        }
+        ef = ef_new;
     }
 
     energy_fermi_ = ef;
 
-    for (int ik = 0; ik < num_kpoints(); ik++) {
+    for (int ikloc = 0; ikloc < spl_num_kpoints_.local_size(); ikloc++) {
+        int ik = spl_num_kpoints_[ikloc];
         for (int ispn = 0; ispn < ctx_.num_spin_dims(); ispn++) {
             for (int j = 0; j < ctx_.num_bands(); j++) {
-                kpoints_[ik]->band_occupancy(j, ispn, bnd_occ(j, ispn, ik));
+                double e = kpoints_[ik]->band_energy(j, ispn) - ef;
+                kpoints_[ik]->band_occupancy(j, ispn,
+                    smearing::occupancy(smearing_type, e, smearing_width) * ctx_.max_occupancy());
             }
         }
     }
+    sync_band_occupancies();
 
     band_gap_ = 0.0;
 
@@ -309,6 +552,15 @@ void K_point_set::print_info()
 
 void K_point_set::save(std::string const& name__) const
 {
+    PROFILE("sirius::K_point_set::save");
+
+    /* rank of the k-point communicator of each global rank */
+    std::vector<int> rank_k(ctx_.comm().size());
+    rank_k[ctx_.comm().rank()] = comm().rank();
+    ctx_.comm().allgather(rank_k.data(), ctx_.comm().rank(), 1);
+
+    /* rank 0 writes band energies and occupancies, which are known to all ranks, and the list of ranks
+       storing the wave-functions of each k-point */
     if (ctx_.comm().rank() == 0) {
         if (!utils::file_exists(name__)) {
             HDF5_tree(name__, hdf5_access_t::truncate);
@@ -316,52 +568,85 @@ void K_point_set::save(std::string const& name__) const
         HDF5_tree fout(name__, hdf5_access_t::read_write);
         fout.create_node("K_point_set");
         fout["K_point_set"].write("num_kpoints", num_kpoints());
-    }
-    ctx_.comm().barrier();
-    for (int ik = 0; ik < num_kpoints(); ik++) {
-        /* check if this ranks stores the k-point */
-        if (ctx_.comm_k().rank() == spl_num_kpoints_.local_rank(ik)) {
-            kpoints_[ik]->save(name__, ik);
+        fout["K_point_set"].write("num_bands", ctx_.num_bands());
+        fout["K_point_set"].write("num_spins", ctx_.num_spins());
+
+        mdarray<double, 2> band_energies(ctx_.num_bands(), ctx_.num_spin_dims());
+        mdarray<double, 2> band_occupancies(ctx_.num_bands(), ctx_.num_spin_dims());
+        for (int ik = 0; ik < num_kpoints(); ik++) {
+            for (int ispn = 0; ispn < ctx_.num_spin_dims(); ispn++) {
+                for (int j = 0; j < ctx_.num_bands(); j++) {
+                    band_energies(j, ispn)    = kpoints_[ik]->band_energy(j, ispn);
+                    band_occupancies(j, ispn) = kpoints_[ik]->band_occupancy(j, ispn);
+                }
+            }
+            std::vector<int> wf_ranks;
+            for (int r = 0; r < ctx_.comm().size(); r++) {
+                if (rank_k[r] == spl_num_kpoints_.local_rank(ik)) {
+                    wf_ranks.push_back(r);
+                }
+            }
+            auto vk = kpoints_[ik]->vk();
+            fout["K_point_set"].create_node(ik);
+            fout["K_point_set"][ik].write("vk", &vk[0], 3);
+            fout["K_point_set"][ik].write("band_energies", band_energies);
+            fout["K_point_set"][ik].write("band_occupancies", band_occupancies);
+            fout["K_point_set"][ik].write("wf_ranks", wf_ranks);
         }
-        /* wait for all */
-        ctx_.comm().barrier();
     }
+
+    /* each rank writes the wave-functions of its local k-points into its own file */
+    auto fname = wave_functions_file_name(name__, ctx_.comm().rank());
+    HDF5_tree(fname, hdf5_access_t::truncate);
+    for (int ikloc = 0; ikloc < spl_num_kpoints_.local_size(); ikloc++) {
+        int ik = spl_num_kpoints_[ikloc];
+        kpoints_[ik]->save(fname, ik);
+    }
+    /* wait for all */
+    ctx_.comm().barrier();
 }
 
-/// \todo check parameters of saved data in a separate function
-void K_point_set::load()
+void K_point_set::load(std::string const& name__)
 {
-    STOP();
-
-    //== HDF5_tree fin(storage_file_name, false);
-
-    //== int num_kpoints_in;
-    //== fin["K_point_set"].read("num_kpoints", &num_kpoints_in);
-
-    //== std::vector<int> ikidx(num_kpoints(), -1);
-    //== // read available k-points
-    //== double vk_in[3];
-    //== for (int jk = 0; jk < num_kpoints_in; jk++)
-    //== {
-    //==     fin["K_point_set"][jk].read("coordinates", vk_in, 3);
-    //==     for (int ik = 0; ik < num_kpoints(); ik++)
-    //==     {
-    //==         vector3d<double> dvk;
-    //==         for (int x = 0; x < 3; x++) dvk[x] = vk_in[x] - kpoints_[ik]->vk(x);
-    //==         if (dvk.length() < 1e-12)
-    //==         {
-    //==             ikidx[ik] = jk;
-    //==             break;
-    //==         }
-    //==     }
-    //== }
-
-    //== for (int ik = 0; ik < num_kpoints(); ik++)
-    //== {
-    //==     int rank = spl_num_kpoints_.local_rank(ik);
-    //==
-    //==     if (comm_.rank() == rank) kpoints_[ik]->load(fin["K_point_set"], ikidx[ik]);
-    //== }
+    PROFILE("sirius::K_point_set::load");
+
+    HDF5_tree fin(name__, hdf5_access_t::read_only);
+
+    int num_bands_in;
+    fin["K_point_set"].read("num_bands", &num_bands_in, 1);
+    int num_spins_in;
+    fin["K_point_set"].read("num_spins", &num_spins_in, 1);
+    if (num_bands_in != ctx_.num_bands() || num_spins_in != ctx_.num_spins()) {
+        throw std::runtime_error("[sirius::K_point_set::load] wrong number of bands or spins");
+    }
+
+    int num_kpoints_in;
+    fin["K_point_set"].read("num_kpoints", &num_kpoints_in, 1);
+
+    /* index of current k-points in the HDF5 file, which (in general) may contain a different set of k-points */
+    std::vector<int> ikidx(num_kpoints(), -1);
+    for (int jk = 0; jk < num_kpoints_in; jk++) {
+        vector3d<double> vk;
+        fin["K_point_set"][jk].read("vk", &vk[0], 3);
+        for (int ik = 0; ik < num_kpoints(); ik++) {
+            if ((vk - kpoints_[ik]->vk()).length() < 1e-12) {
+                ikidx[ik] = jk;
+                break;
+            }
+        }
+    }
+
+    for (int ikloc = 0; ikloc < spl_num_kpoints_.local_size(); ikloc++) {
+        int ik = spl_num_kpoints_[ikloc];
+        if (ikidx[ik] < 0) {
+            std::stringstream s;
+            s << "[sirius::K_point_set::load] k-point " << ik << " is not found in " << name__;
+            throw std::runtime_error(s.str());
+        }
+        kpoints_[ik]->load(fin["K_point_set"], name__, ikidx[ik]);
+    }
+    sync_band_energies();
+    sync_band_occupancies();
 }
 
 //== void K_point_set::save_wave_functions()
@@ -48,6 +48,12 @@ class K_point_set
     /// Band gap found by find_band_occupancies().
     double band_gap_{0};
 
+    /// Wall-time of the band solver for each local k-point measured in the last SCF iteration.
+    std::vector<double> solve_time_;
+
+    /// Number of iterative solver steps for each local k-point in the last SCF iteration.
+    std::vector<int> solve_num_steps_;
+
     /// Copy constuctor is not allowed.
     K_point_set(K_point_set& src) = delete;
 
@@ -85,8 +91,36 @@ class K_point_set
     }
 
     /// Initialize the k-point set
+    /** If counts are not provided, k-points are distributed either in equal blocks or according to the estimated
+     *  cost (see control.kpoint_distribution input parameter). */
     void initialize(std::vector<int> const& counts = {});
 
+    /// Estimate the cost of solving the band problem for each k-point.
+    /** If the k-points were already solved, the measured wall-time of the band solver is returned. Otherwise the
+     *  cost is modelled as \f$ N_{iter} N_{G+k} (\log_2 N_{G+k} + N_{b}) \f$, where the first term accounts for the
+     *  FFTs of the local Hamiltonian and the second term for the subspace operations. The number of G+k vectors is
+     *  counted on the coarse G-vector set and does not require k-points to be initialized. This is a collective
+     *  operation which returns the same result on all ranks. */
+    std::vector<double> kpoint_cost() const;
+
+    /// Store the measured cost of the band solver for a local k-point.
+    void kpoint_cost(int ik__, double time__, int num_steps__)
+    {
+        solve_time_[ik__]      = time__;
+        solve_num_steps_[ik__] = num_steps__;
+    }
+
+    /// Redistribute k-points between MPI ranks according to their cost.
+    /** The new distribution is applied only if it reduces the estimated maximum load by a noticeable amount.
+     *  K-points that change owner are initialized on the new ranks and their wave-functions are sent over the
+     *  k-point communicator; the old ranks release the memory. Only the pseudopotential case is supported. */
+    void rebalance();
+
+    /// Split a list of k-points into contiguous chunks with approximately equal cost.
+    /** The maximum cost of a chunk is minimised by a bisection on the bottleneck value. Each rank gets at least
+     *  one k-point if there are enough k-points. Returns the number of k-points for each rank. */
+    static std::vector<int> partition_by_cost(std::vector<double> const& cost__, int num_ranks__);
+
     /// Sync band occupations numbers between all MPI ranks.
     void sync_band_occupancies();
 
@@ -100,9 +134,14 @@ class K_point_set
     void print_info();
 
     /// Save k-point set to HDF5 file.
+    /** Band energies and occupancies go to the main file; each rank writes the wave-functions of its local
+     *  k-points to a separate file (see wave_functions_file_name()). */
     void save(std::string const& name__) const;
 
-    void load();
+    /// Load band energies, occupancies and wave-functions from HDF5 file.
+    /** The k-points are matched by their coordinates; the wave-functions are redistributed to the current
+     *  MPI layout. */
+    void load(std::string const& name__);
 
     /// Update k-points after moving atoms or changing the lattice vectors.
     void update()
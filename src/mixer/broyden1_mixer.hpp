@@ -54,26 +54,22 @@ class Broyden1 : public Mixer<FUNCS...>
     double beta_;
     double beta0_;
     double beta_scaling_factor_;
-    mdarray<double, 2> S_old_;
   public:
-    Broyden1(std::size_t max_history, double beta, double beta0, double beta_scaling_factor)
-        : Mixer<FUNCS...>(max_history)
+    Broyden1(std::size_t max_history, double beta, double beta0, double beta_scaling_factor,
+             sddk::Communicator const& comm = sddk::Communicator::self(), bool single_precision_history = false)
+        : Mixer<FUNCS...>(max_history, comm, single_precision_history)
         , beta_(beta)
         , beta0_(beta0)
         , beta_scaling_factor_(beta_scaling_factor)
     {
-        S_old_ = mdarray<double, 2>(max_history, max_history);
     }
 
     void mix_impl() override
     {
-        const auto idx_step      = this->idx_hist(this->step_);
-        const auto idx_next_step = this->idx_hist(this->step_ + 1);
+        const auto idx_step = this->idx_hist(this->step_);
 
         const int history_size = static_cast<int>(std::min(this->step_, this->max_history_ - 1));
 
-        const bool normalize = false;
-
         // beta scaling
         if (this->step_ > this->max_history_) {
             const double rmse_avg = std::accumulate(this->rmse_history_.begin(), this->rmse_history_.end(), 0.0) /
@@ -87,34 +83,22 @@ class Broyden1 : public Mixer<FUNCS...>
         this->scale(0.0, this->input_);
 
         if (history_size > 0) {
-            sddk::mdarray<double, 2> S(history_size, history_size);
-            S.zero();
-            /* restore S from the previous step */
-            for (int j1 = 0; j1 < history_size - 1; j1++) {
-                for (int j2 = 0; j2 < history_size - 1; j2++) {
-                    S(j1 + 1, j2 + 1) = this->S_old_(j1, j2);
-                }
+            /* inner products of the residuals are cached between the steps; only the inner products with the
+               residual of the current step are computed */
+            std::vector<std::size_t> steps(history_size + 1);
+            for (int j = 0; j <= history_size; j++) {
+                steps[j] = this->step_ - j;
             }
+            this->update_residual_gram(steps);
 
-            for (int j1 = 0; j1 < history_size; j1++) {
-                int i1 = this->idx_hist(this->step_ - j1);
-                int i2 = this->idx_hist(this->step_ - j1 - 1);
-                this->copy(this->residual_history_[i1], this->tmp1_);
-                this->axpy(-1.0, this->residual_history_[i2], this->tmp1_);
-                int j2 = 0;;
-                //for (int j2 = 0; j2 <= j1; j2++) {
-                    int i3 = this->idx_hist(this->step_ - j2);
-                    int i4 = this->idx_hist(this->step_ - j2 - 1);
-                    this->copy(this->residual_history_[i3], this->tmp2_);
-                    this->axpy(-1.0, this->residual_history_[i4], this->tmp2_);
-
-                    S(j2, j1) = S(j1, j2) = this->template inner_product<normalize>(this->tmp1_, this->tmp2_);
-                //}
-            }
+            /* <r_{k1}|r_{k2}> where k1 and k2 are counted back from the current step */
+            auto g = [&](int k1, int k2) { return this->residual_gram(this->step_ - k1, this->step_ - k2); };
 
+            /* S_{j1,j2} = <df_{j1}|df_{j2}> where df_j = r_{step - j} - r_{step - j - 1} */
+            sddk::mdarray<double, 2> S(history_size, history_size);
             for (int j1 = 0; j1 < history_size; j1++) {
                 for (int j2 = 0; j2 < history_size; j2++) {
-                    S_old_(j1, j2) = S(j1, j2);
+                    S(j1, j2) = g(j1, j2) - g(j1, j2 + 1) - g(j1 + 1, j2) + g(j1 + 1, j2 + 1);
                 }
             }
 
@@ -128,15 +112,8 @@ class Broyden1 : public Mixer<FUNCS...>
             }
 
             sddk::mdarray<double, 1> c(history_size);
-            c.zero();
             for (int j = 0; j < history_size; j++) {
-                int i1 = this->idx_hist(this->step_ - j);
-                int i2 = this->idx_hist(this->step_ - j - 1);
-
-                this->copy(this->residual_history_[i1], this->tmp1_);
-                this->axpy(-1.0, this->residual_history_[i2], this->tmp1_);
-
-                c(j) = this->template inner_product<normalize>(this->tmp1_, this->residual_history_[idx_step]);
+                c(j) = g(j, 0) - g(j + 1, 0);
             }
 
             for (int j = 0; j < history_size; j++) {
@@ -145,22 +122,20 @@ class Broyden1 : public Mixer<FUNCS...>
                     gamma += c(i) * S(i, j);
                 }
 
-                int i1 = this->idx_hist(this->step_ - j);
-                int i2 = this->idx_hist(this->step_ - j - 1);
-
-                this->copy(this->residual_history_[i1], this->tmp1_);
-                this->axpy(-1.0, this->residual_history_[i2], this->tmp1_);
+                this->copy(this->residual(this->step_ - j), this->tmp1_);
+                this->axpy(-1.0, this->residual(this->step_ - j - 1), this->tmp1_);
 
-                this->copy(this->output_history_[i1], this->tmp2_);
-                this->axpy(-1.0, this->output_history_[i2], this->tmp2_);
+                this->copy(this->output(this->step_ - j), this->tmp2_);
+                this->axpy(-1.0, this->output(this->step_ - j - 1), this->tmp2_);
 
                 this->axpy(this->beta_, this->tmp1_, this->tmp2_);
                 this->axpy(-gamma, this->tmp2_, this->input_);
             }
         }
-        this->copy(this->output_history_[idx_step], this->output_history_[idx_next_step]);
-        this->axpy(this->beta_, this->residual_history_[idx_step], this->output_history_[idx_next_step]);
-        this->axpy(1.0, this->input_, this->output_history_[idx_next_step]);
+        /* x_{n+1} = x_n + beta * r_n + correction accumulated in the input buffer */
+        this->axpy(1.0, this->output(this->step_), this->input_);
+        this->axpy(this->beta_, this->residual(this->step_), this->input_);
+        this->copy(this->input_, this->next_output());
     }
 };
 } // namespace mixer
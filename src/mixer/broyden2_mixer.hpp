@@ -50,8 +50,9 @@ template <typename... FUNCS>
 class Broyden2 : public Mixer<FUNCS...>
 {
   public:
-    Broyden2(std::size_t max_history, double beta, double beta0, double beta_scaling_factor, double linear_mix_rmse_tol)
-        : Mixer<FUNCS...>(max_history)
+    Broyden2(std::size_t max_history, double beta, double beta0, double beta_scaling_factor, double linear_mix_rmse_tol,
+             sddk::Communicator const& comm = sddk::Communicator::self(), bool single_precision_history = false)
+        : Mixer<FUNCS...>(max_history, comm, single_precision_history)
         , beta_(beta)
         , beta0_(beta0)
         , beta_scaling_factor_(beta_scaling_factor)
@@ -61,8 +62,7 @@ class Broyden2 : public Mixer<FUNCS...>
 
     void mix_impl() override
     {
-        const auto idx_step      = this->idx_hist(this->step_);
-        const auto idx_next_step = this->idx_hist(this->step_ + 1);
+        const auto idx_step = this->idx_hist(this->step_);
 
         const auto history_size = std::min(this->step_, this->max_history_);
 
@@ -77,19 +77,22 @@ class Broyden2 : public Mixer<FUNCS...>
 
         const double rmse = this->rmse_history_[idx_step];
 
-        const bool normalize = false;
+        const bool broyden_step =
+            (history_size > 1 && rmse < this->linear_mix_rmse_tol_ && this->linear_mix_rmse_tol_ > 0) ||
+            (this->linear_mix_rmse_tol_ <= 0 && this->step_ > this->max_history_);
+
+        if (broyden_step) {
+            /* inner products of the residuals are cached between the steps; only the new ones are computed */
+            std::vector<std::size_t> steps(history_size);
+            for (int j = 0; j < static_cast<int>(history_size); j++) {
+                steps[j] = this->step_ - history_size + j;
+            }
+            this->update_residual_gram(steps);
 
-        if ((history_size > 1 && rmse < this->linear_mix_rmse_tol_ && this->linear_mix_rmse_tol_ > 0) ||
-            (this->linear_mix_rmse_tol_ <= 0 && this->step_ > this->max_history_)) {
             sddk::mdarray<double, 2> S(history_size, history_size);
-            S.zero();
             for (int j1 = 0; j1 < static_cast<int>(history_size); j1++) {
-                int i1 = this->idx_hist(this->step_ - history_size + j1);
-                for (int j2 = 0; j2 <= j1; j2++) {
-                    int i2 = this->idx_hist(this->step_ - history_size + j2);
-
-                    S(j2, j1) = S(j1, j2) =
-                        this->template inner_product<normalize>(this->residual_history_[i1], this->residual_history_[i2]);
+                for (int j2 = 0; j2 < static_cast<int>(history_size); j2++) {
+                    S(j1, j2) = this->residual_gram(steps[j1], steps[j2]);
                 }
             }
 
@@ -138,14 +141,17 @@ class Broyden2 : public Mixer<FUNCS...>
 
             /* make linear combination of vectors and residuals; this is the update vector \tilda x */
             for (int j = 0; j < static_cast<int>(history_size); j++) {
-                int i1 = this->idx_hist(this->step_ - history_size + j);
-                this->axpy(v2[j], this->residual_history_[i1], this->input_);
-                this->axpy(v2[j + history_size], this->output_history_[i1], this->input_);
+                this->axpy(v2[j], this->residual(steps[j]), this->input_);
+                this->axpy(v2[j + history_size], this->output(steps[j]), this->input_);
             }
+            this->copy(this->input_, this->next_output());
+            this->scale(beta_, this->next_output());
+            this->axpy(1.0 - beta_, this->output(this->step_), this->next_output());
+        } else {
+            /* linear mixing with the (preconditioned) residual */
+            this->copy(this->output(this->step_), this->next_output());
+            this->axpy(beta_, this->residual(this->step_), this->next_output());
         }
-        this->copy(this->input_, this->output_history_[idx_next_step]);
-        this->scale(beta_, this->output_history_[idx_next_step]);
-        this->axpy(1.0 - beta_, this->output_history_[idx_step], this->output_history_[idx_next_step]);
     }
 
   private:
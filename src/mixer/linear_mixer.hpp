@@ -51,11 +51,9 @@ class Linear : public Mixer<FUNCS...>
 
     void mix_impl() override
     {
-        const auto idx = this->idx_hist(this->step_ + 1);
-
-        this->copy(this->input_, this->output_history_[idx]);
-        this->scale(beta_, this->output_history_[idx]);
-        this->axpy(1.0 - beta_, this->output_history_[this->idx_hist(this->step_)], this->output_history_[idx]);
+        /* x_{n+1} = x_n + beta * r_n, where r_n is the (preconditioned) residual */
+        this->copy(this->output(this->step_), this->next_output());
+        this->axpy(beta_, this->residual(this->step_), this->next_output());
     }
 
   private:
@@ -26,6 +26,7 @@
 #define __MIXER_HPP__
 
 #include <tuple>
+#include <algorithm>
 #include <functional>
 #include <utility>
 #include <vector>
@@ -35,6 +36,8 @@
 #include <cmath>
 #include <numeric>
 
+#include "mpi/communicator.hpp"
+
 namespace sirius {
 namespace mixer {
 
@@ -69,6 +72,32 @@ struct FunctionProperties
     {
     }
 
+    ///
+    /**
+     *  \param [in]  size_         Function, which returns a measure of size of the (global) function.
+     *  \param [in]  inner_        Function, which computes the (global) inner product.
+     *  \param [in]  scal_         Function, which scales the input (x = alpha * x).
+     *  \param [in]  copy_         Function, which copies from one object to the other (y = x).
+     *  \param [in]  axpy_         Function, which scales and adds one object to the other (y = alpha * x + y).
+     *  \param [in]  inner_local_  Function, which computes local contributions to the inner products <x|y_i> of one
+     *                             function with a set of functions. The result must be consistent with inner_ after
+     *                             the reduction over the communicator of the mixer.
+     */
+    FunctionProperties(std::function<double(const FUNC&)> size_,
+                       std::function<double(const FUNC&, const FUNC&)> inner_,
+                       std::function<void(double, FUNC&)> scal_,
+                       std::function<void(const FUNC&, FUNC&)> copy_,
+                       std::function<void(double, const FUNC&, FUNC&)> axpy_,
+                       std::function<void(const FUNC&, std::vector<const FUNC*> const&, double*)> inner_local_)
+        : size(size_)
+        , inner(inner_)
+        , scal(scal_)
+        , copy(copy_)
+        , axpy(axpy_)
+        , inner_local(inner_local_)
+    {
+    }
+
     FunctionProperties()
         : size([](const FUNC&) -> double { return 0; })
         , inner([](const FUNC&, const FUNC&) -> double { return 0.0; })
@@ -92,6 +121,22 @@ struct FunctionProperties
 
     // axpy function. y = alpha * x + y
     std::function<void(double, const FUNC&, FUNC&)> axpy;
+
+    // Local contributions to the inner products <x|y_i> computed in a single pass (optional). The contributions are
+    // reduced by the mixer.
+    std::function<void(const FUNC&, std::vector<const FUNC*> const&, double*)> inner_local;
+
+    // Preconditioner of the residual (optional), for example Kerker preconditioning of the charge density.
+    std::function<void(FUNC&)> precondition;
+
+    // Number of single precision numbers in the packed copy of the function (optional, used to store the history).
+    std::function<std::size_t(const FUNC&)> packed_size;
+
+    // Store the function in single precision.
+    std::function<void(const FUNC&, float*)> pack;
+
+    // Restore the function from the single precision copy.
+    std::function<void(float const*, FUNC&)> unpack;
 };
 
 // Implementation of templated recursive calls through tuples
@@ -149,6 +194,75 @@ struct InnerProduct<0, normalize, FUNCS...>
     }
 };
 
+/// Compute inner products <x|y_i> of a single function of the tuples.
+/** Contributions of the functions, which provide the local inner product, are added to the local buffer (to be reduced
+ *  by the caller); contributions of the other functions are computed with the global inner product and added to the
+ *  global buffer. */
+template <std::size_t FUNC_INDEX, bool normalize, typename... FUNCS>
+inline void inner_product_batch(const std::tuple<FunctionProperties<FUNCS>...>& function_prop,
+                                const std::tuple<std::unique_ptr<FUNCS>...>& x,
+                                std::vector<const std::tuple<std::unique_ptr<FUNCS>...>*> const& y, double* local__,
+                                double* global__)
+{
+    using func_t = typename std::tuple_element<FUNC_INDEX, std::tuple<FUNCS...>>::type;
+
+    auto& prop = std::get<FUNC_INDEX>(function_prop);
+    auto& fx   = std::get<FUNC_INDEX>(x);
+    if (!fx) {
+        return;
+    }
+    std::vector<const func_t*> fy;
+    std::vector<int> idx;
+    for (int i = 0; i < static_cast<int>(y.size()); i++) {
+        if (std::get<FUNC_INDEX>(*y[i])) {
+            fy.push_back(std::get<FUNC_INDEX>(*y[i]).get());
+            idx.push_back(i);
+        }
+    }
+    double norm{1};
+    if (normalize) {
+        norm = 1.0 / prop.size(*fx);
+    }
+    if (prop.inner_local) {
+        std::vector<double> v(fy.size(), 0);
+        prop.inner_local(*fx, fy, v.data());
+        for (int i = 0; i < static_cast<int>(fy.size()); i++) {
+            local__[idx[i]] += v[i] * norm;
+        }
+    } else {
+        for (int i = 0; i < static_cast<int>(fy.size()); i++) {
+            global__[idx[i]] += prop.inner(*fx, *fy[i]) * norm;
+        }
+    }
+}
+
+/// Compute inner products <x|y_i> of a function tuple with a set of function tuples.
+/** This function is used in Broyden mixers to update the inner products of residuals. */
+template <std::size_t FUNC_REVERSE_INDEX, bool normalize, typename... FUNCS>
+struct InnerProductBatch
+{
+    static void apply(const std::tuple<FunctionProperties<FUNCS>...>& function_prop,
+                      const std::tuple<std::unique_ptr<FUNCS>...>& x,
+                      std::vector<const std::tuple<std::unique_ptr<FUNCS>...>*> const& y, double* local__,
+                      double* global__)
+    {
+        inner_product_batch<FUNC_REVERSE_INDEX, normalize, FUNCS...>(function_prop, x, y, local__, global__);
+        InnerProductBatch<FUNC_REVERSE_INDEX - 1, normalize, FUNCS...>::apply(function_prop, x, y, local__, global__);
+    }
+};
+
+template <bool normalize, typename... FUNCS>
+struct InnerProductBatch<0, normalize, FUNCS...>
+{
+    static void apply(const std::tuple<FunctionProperties<FUNCS>...>& function_prop,
+                      const std::tuple<std::unique_ptr<FUNCS>...>& x,
+                      std::vector<const std::tuple<std::unique_ptr<FUNCS>...>*> const& y, double* local__,
+                      double* global__)
+    {
+        inner_product_batch<0, normalize, FUNCS...>(function_prop, x, y, local__, global__);
+    }
+};
+
 template <std::size_t FUNC_REVERSE_INDEX, typename... FUNCS>
 struct Scaling
 {
@@ -174,6 +288,92 @@ struct Scaling<0, FUNCS...>
     }
 };
 
+template <std::size_t FUNC_REVERSE_INDEX, typename... FUNCS>
+struct Precondition
+{
+    static void apply(const std::tuple<FunctionProperties<FUNCS>...>& function_prop,
+                      std::tuple<std::unique_ptr<FUNCS>...>& x)
+    {
+        if (std::get<FUNC_REVERSE_INDEX>(x) && std::get<FUNC_REVERSE_INDEX>(function_prop).precondition) {
+            std::get<FUNC_REVERSE_INDEX>(function_prop).precondition(*std::get<FUNC_REVERSE_INDEX>(x));
+        }
+        Precondition<FUNC_REVERSE_INDEX - 1, FUNCS...>::apply(function_prop, x);
+    }
+};
+
+template <typename... FUNCS>
+struct Precondition<0, FUNCS...>
+{
+    static void apply(const std::tuple<FunctionProperties<FUNCS>...>& function_prop,
+                      std::tuple<std::unique_ptr<FUNCS>...>& x)
+    {
+        if (std::get<0>(x) && std::get<0>(function_prop).precondition) {
+            std::get<0>(function_prop).precondition(*std::get<0>(x));
+        }
+    }
+};
+
+/// Single precision copy of a function.
+template <typename FUNC>
+using Packed = std::vector<float>;
+
+template <std::size_t FUNC_REVERSE_INDEX, typename... FUNCS>
+struct Pack
+{
+    static void apply(const std::tuple<FunctionProperties<FUNCS>...>& function_prop,
+                      const std::tuple<std::unique_ptr<FUNCS>...>& x, std::tuple<Packed<FUNCS>...>& y)
+    {
+        if (std::get<FUNC_REVERSE_INDEX>(x)) {
+            auto& prop = std::get<FUNC_REVERSE_INDEX>(function_prop);
+            auto& buf  = std::get<FUNC_REVERSE_INDEX>(y);
+            buf.resize(prop.packed_size(*std::get<FUNC_REVERSE_INDEX>(x)));
+            prop.pack(*std::get<FUNC_REVERSE_INDEX>(x), buf.data());
+        }
+        Pack<FUNC_REVERSE_INDEX - 1, FUNCS...>::apply(function_prop, x, y);
+    }
+};
+
+template <typename... FUNCS>
+struct Pack<0, FUNCS...>
+{
+    static void apply(const std::tuple<FunctionProperties<FUNCS>...>& function_prop,
+                      const std::tuple<std::unique_ptr<FUNCS>...>& x, std::tuple<Packed<FUNCS>...>& y)
+    {
+        if (std::get<0>(x)) {
+            auto& prop = std::get<0>(function_prop);
+            auto& buf  = std::get<0>(y);
+            buf.resize(prop.packed_size(*std::get<0>(x)));
+            prop.pack(*std::get<0>(x), buf.data());
+        }
+    }
+};
+
+template <std::size_t FUNC_REVERSE_INDEX, typename... FUNCS>
+struct Unpack
+{
+    static void apply(const std::tuple<FunctionProperties<FUNCS>...>& function_prop,
+                      const std::tuple<Packed<FUNCS>...>& x, std::tuple<std::unique_ptr<FUNCS>...>& y)
+    {
+        if (std::get<FUNC_REVERSE_INDEX>(y)) {
+            std::get<FUNC_REVERSE_INDEX>(function_prop)
+                .unpack(std::get<FUNC_REVERSE_INDEX>(x).data(), *std::get<FUNC_REVERSE_INDEX>(y));
+        }
+        Unpack<FUNC_REVERSE_INDEX - 1, FUNCS...>::apply(function_prop, x, y);
+    }
+};
+
+template <typename... FUNCS>
+struct Unpack<0, FUNCS...>
+{
+    static void apply(const std::tuple<FunctionProperties<FUNCS>...>& function_prop,
+                      const std::tuple<Packed<FUNCS>...>& x, std::tuple<std::unique_ptr<FUNCS>...>& y)
+    {
+        if (std::get<0>(y)) {
+            std::get<0>(function_prop).unpack(std::get<0>(x).data(), *std::get<0>(y));
+        }
+    }
+};
+
 template <std::size_t FUNC_REVERSE_INDEX, typename... FUNCS>
 struct Copy
 {
@@ -231,6 +431,14 @@ struct Axpy<0, FUNCS...>
 /// Abstract mixer for variadic number of Function objects, which are described by FunctionProperties.
 /** Can mix variadic number of functions objects, for which operations are defined in FunctionProperties. Only
  *  functions, which are explicitly initialized, are mixed.
+ *
+ *  The history of outputs and residuals can be stored in single precision to reduce the memory footprint. In this
+ *  case the functions must provide FunctionProperties::pack and FunctionProperties::unpack. The output of the
+ *  current step is kept in double precision and the outputs of the previous steps are stored as differences with
+ *  respect to it, so the rounding error is proportional to the size of the SCF steps and not to the size of the
+ *  functions. All the arithmetic of the mixing is done in double precision. Instead of 2 * max_history copies of
+ *  the functions in double precision the history takes the memory of max_history copies, at the cost of two extra
+ *  buffers in double precision.
  */
 template <typename... FUNCS>
 class Mixer
@@ -242,14 +450,22 @@ class Mixer
 
     /// Construct a mixer. Functions have to initialized individually.
     /** \param [in]  max_history   Maximum number of steps stored, which contribute to the mixing.
-     *  \param [in]  commm         Communicator used for exchaning mixing contributions.
+     *  \param [in]  comm          Communicator used for exchaning mixing contributions.
+     *  \param [in]  single_precision_history  Store the history of outputs and residuals in single precision.
      */
-    Mixer(std::size_t max_history)
+    Mixer(std::size_t max_history, sddk::Communicator const& comm = sddk::Communicator::self(),
+          bool single_precision_history = false)
         : step_(0)
         , max_history_(max_history)
         , rmse_history_(max_history)
         , output_history_(max_history)
         , residual_history_(max_history)
+        , comm_(comm)
+        , residual_gram_(max_history * max_history, 0)
+        , residual_gram_valid_(max_history * max_history, false)
+        , single_precision_history_(single_precision_history)
+        , output_history_packed_(single_precision_history ? max_history : 0)
+        , residual_history_packed_(single_precision_history ? max_history : 0)
     {
     }
 
@@ -270,6 +486,10 @@ class Mixer
             throw std::runtime_error("Initializing function_prop after mixing not allowed!");
         }
 
+        if (single_precision_history_ && !(function_prop.packed_size && function_prop.pack && function_prop.unpack)) {
+            throw std::runtime_error("Single precision history requires packing of the mixer function!");
+        }
+
         std::get<FUNC_INDEX>(functions_) = function_prop;
 
         // NOTE: don't use std::forward for args, because we need them multiple times (don't forward
@@ -283,15 +503,32 @@ class Mixer
         std::get<FUNC_INDEX>(tmp2_).reset(new
                                           typename std::tuple_element<FUNC_INDEX, std::tuple<FUNCS...>>::type(args...));
 
-        for (std::size_t i = 0; i < max_history_; ++i) {
-            std::get<FUNC_INDEX>(output_history_[i])
-                .reset(new typename std::tuple_element<FUNC_INDEX, std::tuple<FUNCS...>>::type(args...));
-            std::get<FUNC_INDEX>(residual_history_[i])
-                .reset(new typename std::tuple_element<FUNC_INDEX, std::tuple<FUNCS...>>::type(args...));
-        }
+        if (single_precision_history_) {
+            std::get<FUNC_INDEX>(output_).reset(
+                new typename std::tuple_element<FUNC_INDEX, std::tuple<FUNCS...>>::type(args...));
+            std::get<FUNC_INDEX>(unpacked_).reset(
+                new typename std::tuple_element<FUNC_INDEX, std::tuple<FUNCS...>>::type(args...));
+
+            const auto n = function_prop.packed_size(init_value);
+            for (std::size_t i = 0; i < max_history_; ++i) {
+                std::get<FUNC_INDEX>(output_history_packed_[i]).assign(n, 0);
+                std::get<FUNC_INDEX>(residual_history_packed_[i]).assign(n, 0);
+            }
 
-        // initialize output and input with given initial value
-        std::get<FUNC_INDEX>(functions_).copy(init_value, *std::get<FUNC_INDEX>(output_history_[0]));
+            // initialize output with given initial value
+            std::get<FUNC_INDEX>(functions_).copy(init_value, *std::get<FUNC_INDEX>(output_));
+        } else {
+            for (std::size_t i = 0; i < max_history_; ++i) {
+                std::get<FUNC_INDEX>(output_history_[i])
+                    .reset(new typename std::tuple_element<FUNC_INDEX, std::tuple<FUNCS...>>::type(args...));
+                std::get<FUNC_INDEX>(residual_history_[i])
+                    .reset(new typename std::tuple_element<FUNC_INDEX, std::tuple<FUNCS...>>::type(args...));
+            }
+
+            // initialize output with given initial value
+            std::get<FUNC_INDEX>(functions_).copy(init_value, *std::get<FUNC_INDEX>(output_history_[0]));
+        }
+        // initialize input with given initial value
         std::get<FUNC_INDEX>(functions_).copy(init_value, *std::get<FUNC_INDEX>(input_));
     }
 
@@ -314,11 +551,10 @@ class Mixer
     template <std::size_t FUNC_INDEX>
     void get_output(typename std::tuple_element<FUNC_INDEX, std::tuple<FUNCS...>>::type& output)
     {
-        const auto idx = idx_hist(step_);
-        if (!std::get<FUNC_INDEX>(output_history_[idx])) {
+        if (!std::get<FUNC_INDEX>(input_)) {
             throw std::runtime_error("Mixer function not initialized!");
         }
-        std::get<FUNC_INDEX>(functions_).copy(*std::get<FUNC_INDEX>(output_history_[idx]), output);
+        std::get<FUNC_INDEX>(functions_).copy(*std::get<FUNC_INDEX>(this->output(step_)), output);
     }
 
     /// Mix input and stored history. Returns the root mean square error computed by inner products of residuals.
@@ -333,10 +569,19 @@ class Mixer
         if (rmse < rms_min__) {
             return rmse;
         }
+        /* rms error is computed for the original residual; the mixing uses the preconditioned one */
+        mixer_impl::Precondition<sizeof...(FUNCS) - 1, FUNCS...>::apply(functions_, this->residual_buffer());
+        if (single_precision_history_) {
+            this->pack(unpacked_, residual_history_packed_[idx_hist(step_)]);
+        }
 
         /* call mixing implementation */
         this->mix_impl();
 
+        if (single_precision_history_) {
+            this->update_output_history();
+        }
+
         ++step_;
         return rmse;
     }
@@ -348,17 +593,22 @@ class Mixer
     // update residual histroy for current step
     void update_residual()
     {
-        this->copy(input_, residual_history_[idx_hist(step_)]);
-        this->axpy(-1.0, output_history_[idx_hist(step_)], residual_history_[idx_hist(step_)]);
+        this->copy(input_, this->residual_buffer());
+        this->axpy(-1.0, this->output(step_), this->residual_buffer());
+
+        /* cached inner products with the overwritten residual are no longer valid */
+        const auto idx = idx_hist(step_);
+        for (std::size_t i = 0; i < max_history_; i++) {
+            residual_gram_valid_[idx * max_history_ + i] = false;
+            residual_gram_valid_[i * max_history_ + idx] = false;
+        }
     }
 
     // update rmse histroy for current step. Residuals must have been updated before.
     void update_rms()
     {
-        const auto idx = idx_hist(step_);
-
         /* compute sum of inner products; each inner product is normalized */
-        double rmse = inner_product<true>(residual_history_[idx], residual_history_[idx]);
+        double rmse = inner_product<true>(this->residual_buffer(), this->residual_buffer());
 
         rmse_history_[idx_hist(step_)] = std::sqrt(rmse);
     }
@@ -369,6 +619,87 @@ class Mixer
         return step % max_history_;
     }
 
+    /// Output of the given step in double precision.
+    /** With the single precision history the output of a previous step is restored in a buffer, which is valid
+     *  until the next call to output() or residual().
+     */
+    std::tuple<std::unique_ptr<FUNCS>...> const& output(std::size_t step__)
+    {
+        const auto idx = idx_hist(step__);
+        if (!single_precision_history_) {
+            return output_history_[idx];
+        }
+        if (idx == idx_hist(step_)) {
+            return output_;
+        }
+        this->unpack(output_history_packed_[idx], unpacked_);
+        this->axpy(1.0, output_, unpacked_);
+        return unpacked_;
+    }
+
+    /// Residual of the given step in double precision.
+    /** With the single precision history the residual is restored in a buffer, which is valid until the next call
+     *  to output() or residual().
+     */
+    std::tuple<std::unique_ptr<FUNCS>...> const& residual(std::size_t step__)
+    {
+        const auto idx = idx_hist(step__);
+        if (!single_precision_history_) {
+            return residual_history_[idx];
+        }
+        this->unpack(residual_history_packed_[idx], unpacked_);
+        return unpacked_;
+    }
+
+    /// Storage for the output of the next step.
+    /** With the single precision history the input buffer is reused; it is not needed after the residual of the
+     *  current step is computed.
+     */
+    std::tuple<std::unique_ptr<FUNCS>...>& next_output()
+    {
+        return single_precision_history_ ? input_ : output_history_[idx_hist(step_ + 1)];
+    }
+
+    // Residual of the current step before it is stored in the single precision history
+    std::tuple<std::unique_ptr<FUNCS>...>& residual_buffer()
+    {
+        return single_precision_history_ ? unpacked_ : residual_history_[idx_hist(step_)];
+    }
+
+    /// Make the new output the reference of the single precision history.
+    /** Outputs of the previous steps, which remain in the history, are stored as x_j - x_{k+1}, where x_{k+1} is
+     *  the new output. */
+    void update_output_history()
+    {
+        /* dx = x_{k+1} - x_k */
+        this->copy(input_, tmp1_);
+        this->axpy(-1.0, output_, tmp1_);
+
+        /* x_j - x_{k+1} = (x_j - x_k) - dx; the slot of step k + 1 - max_history is overwritten */
+        const int s0 = std::max(0, static_cast<int>(step_) - static_cast<int>(max_history_) + 2);
+        for (int s = s0; s < static_cast<int>(step_); s++) {
+            this->unpack(output_history_packed_[idx_hist(s)], unpacked_);
+            this->axpy(-1.0, tmp1_, unpacked_);
+            this->pack(unpacked_, output_history_packed_[idx_hist(s)]);
+        }
+        /* x_k - x_{k+1} = -dx */
+        this->scale(-1.0, tmp1_);
+        this->pack(tmp1_, output_history_packed_[idx_hist(step_)]);
+
+        /* input buffer is overwritten by the next set_input() */
+        std::swap(output_, input_);
+    }
+
+    void pack(const std::tuple<std::unique_ptr<FUNCS>...>& x, std::tuple<mixer_impl::Packed<FUNCS>...>& y)
+    {
+        mixer_impl::Pack<sizeof...(FUNCS) - 1, FUNCS...>::apply(functions_, x, y);
+    }
+
+    void unpack(const std::tuple<mixer_impl::Packed<FUNCS>...>& x, std::tuple<std::unique_ptr<FUNCS>...>& y)
+    {
+        mixer_impl::Unpack<sizeof...(FUNCS) - 1, FUNCS...>::apply(functions_, x, y);
+    }
+
     template <bool normalize>
     double inner_product(const std::tuple<std::unique_ptr<FUNCS>...>& x,
                          const std::tuple<std::unique_ptr<FUNCS>...>& y)
@@ -376,6 +707,85 @@ class Mixer
         return mixer_impl::InnerProduct<sizeof...(FUNCS) - 1, normalize, FUNCS...>::apply(functions_, x, y);
     }
 
+    /// Update the cached (not normalized) inner products between the residuals of the given steps.
+    /** Only the missing inner products are computed. They are grouped by the first residual, so each residual is
+     *  passed only once, and the local contributions of all groups are reduced with a single allreduce call. Usually
+     *  only the inner products with the residual of the current step are missing.
+     */
+    void update_residual_gram(std::vector<std::size_t> const& steps__)
+    {
+        std::vector<std::size_t> idx;
+        for (auto s : steps__) {
+            idx.push_back(idx_hist(s));
+        }
+
+        /* list of missing inner products, grouped by the first residual */
+        std::vector<std::pair<std::size_t, std::vector<std::size_t>>> missing;
+        for (std::size_t i = 0; i < idx.size(); i++) {
+            std::vector<std::size_t> v;
+            for (std::size_t j = 0; j <= i; j++) {
+                if (!residual_gram_valid_[idx[i] * max_history_ + idx[j]]) {
+                    v.push_back(idx[j]);
+                    /* mark as valid to avoid double counting of the symmetric pair */
+                    residual_gram_valid_[idx[i] * max_history_ + idx[j]] = true;
+                    residual_gram_valid_[idx[j] * max_history_ + idx[i]] = true;
+                }
+            }
+            if (v.size()) {
+                missing.push_back(std::make_pair(idx[i], v));
+            }
+        }
+        if (missing.empty()) {
+            return;
+        }
+
+        std::size_t n{0};
+        for (auto& e : missing) {
+            n += e.second.size();
+        }
+        std::vector<double> local(n, 0);
+        std::vector<double> global(n, 0);
+
+        std::size_t offset{0};
+        for (auto& e : missing) {
+            if (single_precision_history_) {
+                /* residuals are restored one by one; the first residual of the group is kept in tmp1_ */
+                this->unpack(residual_history_packed_[e.first], tmp1_);
+                for (auto j : e.second) {
+                    this->unpack(residual_history_packed_[j], unpacked_);
+                    std::vector<const std::tuple<std::unique_ptr<FUNCS>...>*> y(1, &unpacked_);
+                    mixer_impl::InnerProductBatch<sizeof...(FUNCS) - 1, false, FUNCS...>::apply(
+                        functions_, tmp1_, y, &local[offset], &global[offset]);
+                    offset++;
+                }
+            } else {
+                std::vector<const std::tuple<std::unique_ptr<FUNCS>...>*> y;
+                for (auto j : e.second) {
+                    y.push_back(&residual_history_[j]);
+                }
+                mixer_impl::InnerProductBatch<sizeof...(FUNCS) - 1, false, FUNCS...>::apply(
+                    functions_, residual_history_[e.first], y, &local[offset], &global[offset]);
+                offset += e.second.size();
+            }
+        }
+        comm_.allreduce(local.data(), static_cast<int>(n));
+
+        offset = 0;
+        for (auto& e : missing) {
+            for (auto j : e.second) {
+                residual_gram_[e.first * max_history_ + j] = residual_gram_[j * max_history_ + e.first] =
+                    local[offset] + global[offset];
+                offset++;
+            }
+        }
+    }
+
+    /// Return the cached inner product of the residuals of two steps.
+    inline double residual_gram(std::size_t step1__, std::size_t step2__) const
+    {
+        return residual_gram_[idx_hist(step1__) * max_history_ + idx_hist(step2__)];
+    }
+
     void scale(double alpha, std::tuple<std::unique_ptr<FUNCS>...>& x)
     {
         mixer_impl::Scaling<sizeof...(FUNCS) - 1, FUNCS...>::apply(functions_, alpha, x);
@@ -383,6 +793,9 @@ class Mixer
 
     void copy(const std::tuple<std::unique_ptr<FUNCS>...>& x, std::tuple<std::unique_ptr<FUNCS>...>& y)
     {
+        if (&x == &y) {
+            return;
+        }
         mixer_impl::Copy<sizeof...(FUNCS) - 1, FUNCS...>::apply(functions_, x, y);
     }
 
@@ -415,6 +828,30 @@ class Mixer
     // Tempory storage for compuations
     std::tuple<std::unique_ptr<FUNCS>...> tmp1_;
     std::tuple<std::unique_ptr<FUNCS>...> tmp2_;
+
+    // Communicator used to reduce the local contributions of the inner products
+    sddk::Communicator const& comm_;
+
+    // Cached (not normalized) inner products of the residuals stored in the history slots
+    std::vector<double> residual_gram_;
+
+    // Validity of the cached inner products
+    std::vector<bool> residual_gram_valid_;
+
+    // True if the history of outputs and residuals is stored in single precision
+    bool single_precision_history_;
+
+    // Output of the current step in double precision (single precision history only)
+    std::tuple<std::unique_ptr<FUNCS>...> output_;
+
+    // Buffer for the functions restored from the single precision history
+    std::tuple<std::unique_ptr<FUNCS>...> unpacked_;
+
+    // Outputs of the previous steps stored as differences with the output of the current step
+    std::vector<std::tuple<mixer_impl::Packed<FUNCS>...>> output_history_packed_;
+
+    // Residuals stored in single precision
+    std::vector<std::tuple<mixer_impl::Packed<FUNCS>...>> residual_history_packed_;
 };
 } // namespace mixer
 } // namespace sirius
@@ -25,11 +25,98 @@
 #include <cassert>
 
 #include "mixer/mixer_functions.hpp"
+#include "SDDK/omp.hpp"
 
 namespace sirius {
 
 namespace mixer {
 
+/* conversion of contiguous blocks of numbers to and from the single precision storage of the mixer history */
+
+static inline std::size_t packed_block_size(double const*, std::size_t n__)
+{
+    return n__;
+}
+
+static inline std::size_t packed_block_size(double_complex const*, std::size_t n__)
+{
+    return 2 * n__;
+}
+
+static inline void pack_block(double const* x__, std::size_t n__, float* buf__)
+{
+    #pragma omp parallel for schedule(static) if (n__ > 4096)
+    for (std::size_t i = 0; i < n__; i++) {
+        buf__[i] = static_cast<float>(x__[i]);
+    }
+}
+
+static inline void pack_block(double_complex const* x__, std::size_t n__, float* buf__)
+{
+    pack_block(reinterpret_cast<double const*>(x__), 2 * n__, buf__);
+}
+
+static inline void unpack_block(float const* buf__, std::size_t n__, double* x__)
+{
+    #pragma omp parallel for schedule(static) if (n__ > 4096)
+    for (std::size_t i = 0; i < n__; i++) {
+        x__[i] = static_cast<double>(buf__[i]);
+    }
+}
+
+static inline void unpack_block(float const* buf__, std::size_t n__, double_complex* x__)
+{
+    unpack_block(buf__, 2 * n__, reinterpret_cast<double*>(x__));
+}
+
+/// Set the conversion of the function to and from single precision.
+/** \param [in] visit Generic function visit(x, f), which calls f(ptr, n) for each contiguous block of double or
+ *                    complex numbers of the (const or non-const) function x.
+ */
+template <typename FUNC, typename V>
+static void set_packing(FunctionProperties<FUNC>& prop__, V visit__)
+{
+    prop__.packed_size = [visit__](FUNC const& x) -> std::size_t {
+        std::size_t n{0};
+        visit__(x, [&n](auto ptr, std::size_t m) { n += packed_block_size(ptr, m); });
+        return n;
+    };
+    prop__.pack = [visit__](FUNC const& x, float* buf) -> void {
+        visit__(x, [&buf](auto ptr, std::size_t m) {
+            pack_block(ptr, m, buf);
+            buf += packed_block_size(ptr, m);
+        });
+    };
+    prop__.unpack = [visit__](float const* buf, FUNC& x) -> void {
+        visit__(x, [&buf](auto ptr, std::size_t m) {
+            unpack_block(buf, m, ptr);
+            buf += packed_block_size(ptr, m);
+        });
+    };
+}
+
+/* visit the real-space and muffin-tin parts of the periodic function and, optionally, its plane-wave coefficients */
+static auto periodic_function_blocks(bool use_pw__)
+{
+    return [use_pw__](auto& x, auto&& f) {
+        f(x.f_rg().at(memory_t::host), x.f_rg().size());
+        if (use_pw__) {
+            f(x.f_pw_local().at(memory_t::host), static_cast<std::size_t>(x.ctx().gvec().count()));
+        }
+        if (x.ctx().full_potential()) {
+            for (int ialoc = 0; ialoc < x.ctx().unit_cell().spl_num_atoms().local_size(); ialoc++) {
+                f(x.f_mt(ialoc).at(memory_t::host), x.f_mt(ialoc).size());
+            }
+        }
+    };
+}
+
+/* visit the whole array */
+static auto array_blocks()
+{
+    return [](auto& x, auto&& f) { f(x.at(memory_t::host), x.size()); };
+}
+
 FunctionProperties<Periodic_function<double>> periodic_function_property()
 {
     auto global_size_func = [](const Periodic_function<double>& x) -> double
@@ -41,6 +128,45 @@ FunctionProperties<Periodic_function<double>> periodic_function_property()
         return sirius::inner(x, y);
     };
 
+    /* local contributions to <x|y_i>; the interstitial part is computed in a single pass over the grid */
+    auto inner_local_func = [](const Periodic_function<double>& x,
+                               std::vector<const Periodic_function<double>*> const& y, double* result) -> void {
+        int n  = static_cast<int>(y.size());
+        int nr = x.spfft().local_slice_size();
+        /* partial sums of each thread; they are reduced in the thread order to keep the result reproducible */
+        mdarray<double, 2> r(n, omp_get_max_threads());
+        r.zero();
+        #pragma omp parallel
+        {
+            int it = omp_get_thread_num();
+            #pragma omp for schedule(static)
+            for (int ir = 0; ir < nr; ir++) {
+                double v = x.f_rg(ir);
+                if (x.ctx().full_potential()) {
+                    v *= x.ctx().theta(ir);
+                }
+                for (int i = 0; i < n; i++) {
+                    r(i, it) += v * y[i]->f_rg(ir);
+                }
+            }
+        }
+        for (int it = 0; it < static_cast<int>(r.size(1)); it++) {
+            for (int i = 0; i < n; i++) {
+                result[i] += r(i, it);
+            }
+        }
+        for (int i = 0; i < n; i++) {
+            result[i] *= x.ctx().unit_cell().omega() / spfft_grid_size(x.spfft());
+        }
+        if (x.ctx().full_potential()) {
+            for (int ialoc = 0; ialoc < x.ctx().unit_cell().spl_num_atoms().local_size(); ialoc++) {
+                for (int i = 0; i < n; i++) {
+                    result[i] += sirius::inner(x.f_mt(ialoc), y[i]->f_mt(ialoc));
+                }
+            }
+        }
+    };
+
     auto scal_function = [](double alpha, Periodic_function<double>& x) -> void {
         #pragma omp parallel
         {
@@ -102,8 +228,10 @@ FunctionProperties<Periodic_function<double>> periodic_function_property()
         }
     };
 
-    return FunctionProperties<Periodic_function<double>>(global_size_func, inner_prod_func, scal_function, copy_function,
-                                                         axpy_function);
+    FunctionProperties<Periodic_function<double>> prop(global_size_func, inner_prod_func, scal_function,
+                                                       copy_function, axpy_function, inner_local_func);
+    set_packing(prop, periodic_function_blocks(false));
+    return prop;
 }
 
 FunctionProperties<Periodic_function<double>> periodic_function_property_modified(bool use_coarse_gvec__)
@@ -113,30 +241,36 @@ FunctionProperties<Periodic_function<double>> periodic_function_property_modifie
         return x.ctx().unit_cell().omega();
     };
 
-    auto inner_prod_func = [use_coarse_gvec__](Periodic_function<double> const& x, Periodic_function<double> const& y) -> double {
-        double result{0};
+    /* local contributions to <x|y_i> computed in a single pass over the G-vectors */
+    auto inner_local_func = [use_coarse_gvec__](Periodic_function<double> const& x,
+                                                std::vector<Periodic_function<double> const*> const& y,
+                                                double* result) -> void {
+        int n   = static_cast<int>(y.size());
         int ig0 = (x.ctx().comm().rank() == 0) ? 1 : 0;
-        if (use_coarse_gvec__) {
-            for (int igloc = ig0; igloc < x.ctx().gvec_coarse().count(); igloc++) {
-                /* local index in fine G-vector list */
-                int ig1 = x.ctx().gvec().gvec_base_mapping(igloc);
-                /* global index */
-                int ig = x.ctx().gvec().offset() + ig1;
-
-                result += std::real(std::conj(x.f_pw_local(ig1)) * y.f_pw_local(ig1)) / std::pow(x.ctx().gvec().gvec_len(ig), 2);
-            }
-        } else {
-            for (int igloc = ig0; igloc < x.ctx().gvec().count(); igloc++) {
-                /* global index */
-                int ig = x.ctx().gvec().offset() + igloc;
-
-                result += std::real(std::conj(x.f_pw_local(igloc)) * y.f_pw_local(igloc)) / std::pow(x.ctx().gvec().gvec_len(ig), 2);
+        int ng  = use_coarse_gvec__ ? x.ctx().gvec_coarse().count() : x.ctx().gvec().count();
+        for (int igloc = ig0; igloc < ng; igloc++) {
+            /* local index in fine G-vector list */
+            int ig1 = use_coarse_gvec__ ? x.ctx().gvec().gvec_base_mapping(igloc) : igloc;
+            /* global index */
+            int ig = x.ctx().gvec().offset() + ig1;
+
+            auto z = std::conj(x.f_pw_local(ig1)) / std::pow(x.ctx().gvec().gvec_len(ig), 2);
+            for (int i = 0; i < n; i++) {
+                result[i] += std::real(z * y[i]->f_pw_local(ig1));
             }
         }
-        if (x.ctx().gvec().reduced()) {
-            result *= 2;
+        for (int i = 0; i < n; i++) {
+            if (x.ctx().gvec().reduced()) {
+                result[i] *= 2;
+            }
+            result[i] *= fourpi;
         }
-        result *= fourpi;
+    };
+
+    auto inner_prod_func = [inner_local_func](Periodic_function<double> const& x,
+                                              Periodic_function<double> const& y) -> double {
+        double result{0};
+        inner_local_func(x, {&y}, &result);
         x.ctx().comm().allreduce(&result, 1);
         return result;
     };
@@ -214,8 +348,10 @@ FunctionProperties<Periodic_function<double>> periodic_function_property_modifie
         }
     };
 
-    return FunctionProperties<Periodic_function<double>>(global_size_func, inner_prod_func, scal_function, copy_function,
-                                                         axpy_function);
+    FunctionProperties<Periodic_function<double>> prop(global_size_func, inner_prod_func, scal_function,
+                                                       copy_function, axpy_function, inner_local_func);
+    set_packing(prop, periodic_function_blocks(true));
+    return prop;
 }
 
 FunctionProperties<sddk::mdarray<double_complex, 4>> density_function_property()
@@ -250,8 +386,10 @@ FunctionProperties<sddk::mdarray<double_complex, 4>> density_function_property()
         }
     };
 
-    return FunctionProperties<sddk::mdarray<double_complex, 4>>(global_size_func, inner_prod_func, scal_function,
-                                                                copy_function, axpy_function);
+    FunctionProperties<sddk::mdarray<double_complex, 4>> prop(global_size_func, inner_prod_func, scal_function,
+                                                              copy_function, axpy_function);
+    set_packing(prop, array_blocks());
+    return prop;
 }
 
 FunctionProperties<paw_density> paw_density_function_property()
@@ -290,8 +428,106 @@ FunctionProperties<paw_density> paw_density_function_property()
         }
     };
 
-    return FunctionProperties<paw_density>(global_size_func, inner_prod_func, scal_function, copy_function,
-                                           axpy_function);
+    FunctionProperties<paw_density> prop(global_size_func, inner_prod_func, scal_function, copy_function,
+                                         axpy_function);
+    set_packing(prop, [](auto& x, auto&& f) {
+        for (int i = 0; i < x.ctx().unit_cell().spl_num_paw_atoms().local_size(); i++) {
+            for (int j = 0; j < x.ctx().num_mag_dims() + 1; j++) {
+                f(x.ae_density(j, i).at(memory_t::host), x.ae_density(j, i).size());
+                f(x.ps_density(j, i).at(memory_t::host), x.ps_density(j, i).size());
+            }
+        }
+    });
+    return prop;
+}
+
+FunctionProperties<sddk::mdarray<double_complex, 2>> pw_density_function_property(Simulation_context const& ctx__,
+                                                                                   bool use_hartree__,
+                                                                                   double kerker_q0__)
+{
+    auto ctx = &ctx__;
+
+    auto global_size_func = [ctx](mdarray<double_complex, 2> const& x) -> double
+    {
+        return ctx->unit_cell().omega();
+    };
+
+    /* local contributions to <x|y_i>; the plain metric is Omega * sum_G x^{*}(G) y(G) and the Hartree metric
+       of the charge density is 4pi * sum_{G != 0} x^{*}(G) y(G) / G^2 */
+    auto inner_local_func = [ctx, use_hartree__](mdarray<double_complex, 2> const& x,
+                                                 std::vector<mdarray<double_complex, 2> const*> const& y,
+                                                 double* result) -> void {
+        int n     = static_cast<int>(y.size());
+        int ncomp = static_cast<int>(x.size(1));
+        /* only half of the G-vectors is stored in case of reduced G-vector set */
+        double f = ctx->gvec().reduced() ? 2 : 1;
+        for (int j = 0; j < ncomp; j++) {
+            bool hartree = use_hartree__ && j == 0;
+            for (int igloc = 0; igloc < ctx->gvec_coarse().count(); igloc++) {
+                /* global index in the fine G-vector list */
+                int ig = ctx->gvec().offset() + ctx->gvec().gvec_base_mapping(igloc);
+                double w{0};
+                if (ig == 0) {
+                    w = hartree ? 0 : ctx->unit_cell().omega();
+                } else {
+                    w = f * (hartree ? fourpi / std::pow(ctx->gvec().gvec_len(ig), 2) : ctx->unit_cell().omega());
+                }
+                auto z = std::conj(x(igloc, j)) * w;
+                for (int i = 0; i < n; i++) {
+                    result[i] += std::real(z * (*y[i])(igloc, j));
+                }
+            }
+        }
+    };
+
+    auto inner_prod_func = [ctx, inner_local_func](mdarray<double_complex, 2> const& x,
+                                                   mdarray<double_complex, 2> const& y) -> double {
+        double result{0};
+        inner_local_func(x, {&y}, &result);
+        ctx->comm().allreduce(&result, 1);
+        return result;
+    };
+
+    auto scal_function = [](double alpha, mdarray<double_complex, 2>& x) -> void {
+        #pragma omp parallel for schedule(static)
+        for (std::size_t i = 0; i < x.size(); ++i) {
+            x[i] *= alpha;
+        }
+    };
+
+    auto copy_function = [](mdarray<double_complex, 2> const& x, mdarray<double_complex, 2>& y) -> void {
+        assert(x.size() == y.size());
+        #pragma omp parallel for schedule(static)
+        for (std::size_t i = 0; i < x.size(); ++i) {
+            y[i] = x[i];
+        }
+    };
+
+    auto axpy_function = [](double alpha, mdarray<double_complex, 2> const& x, mdarray<double_complex, 2>& y) -> void {
+        assert(x.size() == y.size());
+        #pragma omp parallel for schedule(static)
+        for (std::size_t i = 0; i < x.size(); ++i) {
+            y[i] += alpha * x[i];
+        }
+    };
+
+    FunctionProperties<sddk::mdarray<double_complex, 2>> prop(global_size_func, inner_prod_func, scal_function,
+                                                              copy_function, axpy_function, inner_local_func);
+    set_packing(prop, array_blocks());
+
+    /* Kerker preconditioning of the charge density residual: R(G) -> R(G) G^2 / (G^2 + q0^2) */
+    if (kerker_q0__ > 0) {
+        prop.precondition = [ctx, kerker_q0__](mdarray<double_complex, 2>& x) -> void {
+            #pragma omp parallel for schedule(static)
+            for (int igloc = 0; igloc < ctx->gvec_coarse().count(); igloc++) {
+                int ig  = ctx->gvec().offset() + ctx->gvec().gvec_base_mapping(igloc);
+                auto g2 = std::pow(ctx->gvec().gvec_len(ig), 2);
+                x(igloc, 0) *= g2 / (g2 + std::pow(kerker_q0__, 2));
+            }
+        };
+    }
+
+    return prop;
 }
 
 } // namespace mixer
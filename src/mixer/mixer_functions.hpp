@@ -42,6 +42,16 @@ FunctionProperties<sddk::mdarray<double_complex, 4>> density_function_property()
 
 FunctionProperties<paw_density> paw_density_function_property();
 
+/// Properties of the plane-wave coefficients of the density and magnetization inside the coarse G-sphere.
+/** The function is stored as an array of (local number of coarse G-vectors, number of components).
+ *  \param [in] ctx         Simulation context.
+ *  \param [in] use_hartree Use the Hartree metric (weight 4pi/G^2) for the charge density component.
+ *  \param [in] kerker_q0   Wave-vector of the Kerker preconditioner of the charge density; zero disables it.
+ */
+FunctionProperties<sddk::mdarray<double_complex, 2>> pw_density_function_property(Simulation_context const& ctx__,
+                                                                                   bool use_hartree__,
+                                                                                   double kerker_q0__);
+
 } // namespace mixer
 
 } // namespace sirius
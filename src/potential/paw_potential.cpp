@@ -63,6 +63,34 @@ void Potential::init_PAW()
         paw_potential_data_.push_back(std::move(ppd));
     }
 
+    /* allocate XC workspaces for PAW atom types */
+    paw_xc_workspace_ = std::vector<paw_xc_workspace_t>(unit_cell_.num_atom_types());
+    for (int iat = 0; iat < unit_cell_.num_atom_types(); iat++) {
+        auto& atom_type = unit_cell_.atom_type(iat);
+        if (!atom_type.is_paw()) {
+            continue;
+        }
+        auto& rgrid    = atom_type.radial_grid();
+        int lm_max_rho = utils::lmmax(2 * atom_type.indexr().lmax_lo());
+        /* in the non-collinear case spin-up and spin-down densities come from the forward transformation */
+        int lmmax_ud = (ctx_.num_mag_dims() == 3) ? sht_->lmmax() : lm_max_rho;
+
+        auto& ws     = paw_xc_workspace_[iat];
+        ws.rho_lm    = sf(lm_max_rho, rgrid);
+        ws.rho_up_lm = sf(lmmax_ud, rgrid);
+        ws.rho_dn_lm = sf(lmmax_ud, rgrid);
+        ws.f_lm      = sf(sht_->lmmax(), rgrid);
+        for (int j = 0; j < ctx_.num_mag_dims() + 1; j++) {
+            ws.rho_tp.emplace_back(sht_->num_points(), rgrid);
+            ws.vxc_tp.emplace_back(sht_->num_points(), rgrid);
+        }
+        ws.rho_up_tp = Spheric_function<function_domain_t::spatial, double>(sht_->num_points(), rgrid);
+        ws.rho_dn_tp = Spheric_function<function_domain_t::spatial, double>(sht_->num_points(), rgrid);
+        ws.vxc_up_tp = Spheric_function<function_domain_t::spatial, double>(sht_->num_points(), rgrid);
+        ws.vxc_dn_tp = Spheric_function<function_domain_t::spatial, double>(sht_->num_points(), rgrid);
+        ws.exc_tp    = Spheric_function<function_domain_t::spatial, double>(sht_->num_points(), rgrid);
+    }
+
     for (int i = 0; i < unit_cell_.num_paw_atoms(); i++) {
         int ia              = unit_cell_.paw_atom_index(i);
         int bs              = unit_cell_.atom(ia).mt_basis_size();
@@ -138,14 +166,13 @@ void Potential::generate_PAW_effective_potential(Density const& density)
     paw_total_core_energy_    = energies[3];
 }
 
-double Potential::xc_mt_PAW_nonmagnetic(sf& full_potential, sf const& full_density, std::vector<double> const& rho_core)
+double Potential::xc_mt_PAW_nonmagnetic(sf& full_potential, sf const& full_density, std::vector<double> const& rho_core,
+                                        paw_xc_workspace_t& ws)
 {
-    int lmmax = static_cast<int>(full_density.size(0));
-
     Radial_grid<double> const& rgrid = full_density.radial_grid();
 
-    /* new array to store core and valence densities */
-    sf full_rho_lm_sf_new(lmmax, rgrid);
+    /* store core and valence densities */
+    auto& full_rho_lm_sf_new = ws.rho_lm;
 
     full_rho_lm_sf_new.zero();
     full_rho_lm_sf_new += full_density;
@@ -157,33 +184,26 @@ double Potential::xc_mt_PAW_nonmagnetic(sf& full_potential, sf const& full_densi
         full_rho_lm_sf_new(0, ir) += invY00 * rho_core[ir];
     }
 
-    auto full_rho_tp_sf = transform(*sht_, full_rho_lm_sf_new);
-
-    /* create potential in theta phi */
-    Spheric_function<function_domain_t::spatial, double> vxc_tp_sf(sht_->num_points(), rgrid);
+    transform(*sht_, full_rho_lm_sf_new, ws.rho_tp[0]);
 
-    /* create energy in theta phi */
-    Spheric_function<function_domain_t::spatial, double> exc_tp_sf(sht_->num_points(), rgrid);
+    xc_mt_nonmagnetic(rgrid, xc_func_, full_rho_lm_sf_new, ws.rho_tp[0], ws.vxc_tp[0], ws.exc_tp);
 
-    xc_mt_nonmagnetic(rgrid, xc_func_, full_rho_lm_sf_new, full_rho_tp_sf, vxc_tp_sf, exc_tp_sf);
-
-    full_potential += transform(*sht_, vxc_tp_sf);
+    transform(*sht_, ws.vxc_tp[0], ws.f_lm);
+    full_potential += ws.f_lm;
 
     /* calculate energy */
-    auto exc_lm_sf = transform(*sht_, exc_tp_sf);
+    transform(*sht_, ws.exc_tp, ws.f_lm);
 
-    return inner(exc_lm_sf, full_rho_lm_sf_new);
+    return inner(ws.f_lm, full_rho_lm_sf_new);
 }
 
 double Potential::xc_mt_PAW_collinear(std::vector<sf>& potential, std::vector<sf const*> density,
-                                      std::vector<double> const& rho_core)
+                                      std::vector<double> const& rho_core, paw_xc_workspace_t& ws)
 {
-    int lmsize_rho = static_cast<int>(density[0]->size(0));
-
     Radial_grid<double> const& rgrid = density[0]->radial_grid();
 
-    /* new array to store core and valence densities */
-    sf full_rho_lm_sf_new(lmsize_rho, rgrid);
+    /* store core and valence densities */
+    auto& full_rho_lm_sf_new = ws.rho_lm;
 
     full_rho_lm_sf_new.zero();
     full_rho_lm_sf_new += (*density[0]);
@@ -197,38 +217,44 @@ double Potential::xc_mt_PAW_collinear(std::vector<sf>& potential, std::vector<sf
 
     /* calculate spin up spin down density components in lm components */
     /* up = 1/2 ( rho + magn );  down = 1/2 ( rho - magn ) */
-    auto rho_u_lm_sf = 0.5 * (full_rho_lm_sf_new + (*density[1]));
-    auto rho_d_lm_sf = 0.5 * (full_rho_lm_sf_new - (*density[1]));
+    for (int ir = 0; ir < rgrid.num_points(); ir++) {
+        for (int lm = 0; lm < ws.rho_lm.angular_domain_size(); lm++) {
+            ws.rho_up_lm(lm, ir) = 0.5 * (full_rho_lm_sf_new(lm, ir) + (*density[1])(lm, ir));
+            ws.rho_dn_lm(lm, ir) = 0.5 * (full_rho_lm_sf_new(lm, ir) - (*density[1])(lm, ir));
+        }
+    }
 
     // transform density to theta phi components
-    auto rho_u_tp_sf = transform(*sht_, rho_u_lm_sf);
-    auto rho_d_tp_sf = transform(*sht_, rho_d_lm_sf);
-
-    // create potential in theta phi
-    Spheric_function<function_domain_t::spatial, double> vxc_u_tp_sf(sht_->num_points(), rgrid);
-    Spheric_function<function_domain_t::spatial, double> vxc_d_tp_sf(sht_->num_points(), rgrid);
-
-    // create energy in theta phi
-    Spheric_function<function_domain_t::spatial, double> exc_tp_sf(sht_->num_points(), rgrid);
+    transform(*sht_, ws.rho_up_lm, ws.rho_up_tp);
+    transform(*sht_, ws.rho_dn_lm, ws.rho_dn_tp);
 
     // calculate XC
-    xc_mt_magnetic(rgrid, xc_func_, rho_u_lm_sf, rho_u_tp_sf, rho_d_lm_sf, rho_d_tp_sf, vxc_u_tp_sf, vxc_d_tp_sf,
-                   exc_tp_sf);
+    xc_mt_magnetic(rgrid, xc_func_, ws.rho_up_lm, ws.rho_up_tp, ws.rho_dn_lm, ws.rho_dn_tp, ws.vxc_up_tp,
+                   ws.vxc_dn_tp, ws.exc_tp);
+
+    for (int ir = 0; ir < rgrid.num_points(); ir++) {
+        for (int itp = 0; itp < sht_->num_points(); itp++) {
+            ws.vxc_tp[0](itp, ir) = 0.5 * (ws.vxc_up_tp(itp, ir) + ws.vxc_dn_tp(itp, ir));
+            ws.vxc_tp[1](itp, ir) = 0.5 * (ws.vxc_up_tp(itp, ir) - ws.vxc_dn_tp(itp, ir));
+        }
+    }
 
     // transform back in lm
-    potential[0] += transform(*sht_, 0.5 * (vxc_u_tp_sf + vxc_d_tp_sf));
-    potential[1] += transform(*sht_, 0.5 * (vxc_u_tp_sf - vxc_d_tp_sf));
+    for (int i = 0; i < 2; i++) {
+        transform(*sht_, ws.vxc_tp[i], ws.f_lm);
+        potential[i] += ws.f_lm;
+    }
 
     //------------------------
     //--- calculate energy ---
     //------------------------
-    Spheric_function<function_domain_t::spectral, double> exc_lm_sf = transform(*sht_, exc_tp_sf);
+    transform(*sht_, ws.exc_tp, ws.f_lm);
 
-    return inner(exc_lm_sf, full_rho_lm_sf_new);
+    return inner(ws.f_lm, full_rho_lm_sf_new);
 }
 
 double Potential::xc_mt_PAW_noncollinear(std::vector<sf>& potential, std::vector<sf const*> density,
-                                         std::vector<double> const& rho_core)
+                                         std::vector<double> const& rho_core, paw_xc_workspace_t& ws)
 {
     if (density.size() != 4 || potential.size() != 4) {
         TERMINATE("xc_mt_PAW_noncollinear FATAL ERROR!")
@@ -237,15 +263,15 @@ double Potential::xc_mt_PAW_noncollinear(std::vector<sf>& potential, std::vector
     Radial_grid<double> const& rgrid = density[0]->radial_grid();
 
     /* transform density to theta phi components */
-    std::vector<Spheric_function<function_domain_t::spatial, double>> rho_tp(density.size());
+    auto& rho_tp = ws.rho_tp;
 
     for (size_t i = 0; i < density.size(); i++) {
-        rho_tp[i] = transform(*sht_, *density[i]);
+        transform(*sht_, *density[i], rho_tp[i]);
     }
 
     /* transform 4D magnetization to spin-up, spin-down form (correct for LSDA)  rho ± |magn| */
-    Spheric_function<function_domain_t::spatial, double> rho_u_tp(sht_->num_points(), rgrid);
-    Spheric_function<function_domain_t::spatial, double> rho_d_tp(sht_->num_points(), rgrid);
+    auto& rho_u_tp = ws.rho_up_tp;
+    auto& rho_d_tp = ws.rho_dn_tp;
 
     for (int ir = 0; ir < rgrid.num_points(); ir++) {
         for (int itp = 0; itp < sht_->num_points(); itp++) {
@@ -258,26 +284,19 @@ double Potential::xc_mt_PAW_noncollinear(std::vector<sf>& potential, std::vector
     }
 
     /* in lm representation */
-    auto rho_u_lm = transform(*sht_, rho_u_tp);
-    auto rho_d_lm = transform(*sht_, rho_d_tp);
-
-    /* allocate potential in theta phi */
-    Spheric_function<function_domain_t::spatial, double> vxc_u_tp(sht_->num_points(), rgrid);
-    Spheric_function<function_domain_t::spatial, double> vxc_d_tp(sht_->num_points(), rgrid);
+    auto& rho_u_lm = ws.rho_up_lm;
+    auto& rho_d_lm = ws.rho_dn_lm;
+    transform(*sht_, rho_u_tp, rho_u_lm);
+    transform(*sht_, rho_d_tp, rho_d_lm);
 
-    // allocate energy in theta phi
-    Spheric_function<function_domain_t::spatial, double> exc_tp(sht_->num_points(), rgrid);
+    auto& vxc_u_tp = ws.vxc_up_tp;
+    auto& vxc_d_tp = ws.vxc_dn_tp;
 
     /* calculate XC */
-    xc_mt_magnetic(rgrid, xc_func_, rho_u_lm, rho_u_tp, rho_d_lm, rho_d_tp, vxc_u_tp, vxc_d_tp, exc_tp);
-
-    /* allocate 4D potential in theta phi components */
-    std::vector<Spheric_function<function_domain_t::spatial, double>> vxc_tp;
+    xc_mt_magnetic(rgrid, xc_func_, rho_u_lm, rho_u_tp, rho_d_lm, rho_d_tp, vxc_u_tp, vxc_d_tp, ws.exc_tp);
 
-    /* allocate the rest */
-    for (size_t i = 0; i < potential.size(); i++) {
-        vxc_tp.push_back(Spheric_function<function_domain_t::spatial, double>(sht_->num_points(), rgrid));
-    }
+    /* 4D potential in theta phi components */
+    auto& vxc_tp = ws.vxc_tp;
 
     /* transform back potential from up/down to 4D form*/
     for (int ir = 0; ir < rgrid.num_points(); ir++) {
@@ -301,13 +320,17 @@ double Potential::xc_mt_PAW_noncollinear(std::vector<sf>& potential, std::vector
 
     /* transform back to lm- domain */
     for (size_t i = 0; i < density.size(); i++) {
-        potential[i] += transform(*sht_, vxc_tp[i]);
+        transform(*sht_, vxc_tp[i], ws.f_lm);
+        potential[i] += ws.f_lm;
     }
 
     /* transform to lm- domain */
-    auto exc_lm = transform(*sht_, exc_tp);
+    transform(*sht_, ws.exc_tp, ws.f_lm);
+
+    /* total density; spin-up and spin-down components are no longer needed */
+    rho_u_lm += rho_d_lm;
 
-    return inner(exc_lm, rho_u_lm + rho_d_lm);
+    return inner(ws.f_lm, rho_u_lm);
 }
 
 double Potential::calc_PAW_hartree_potential(Atom& atom, sf const& full_density, sf& full_potential)
@@ -368,25 +391,28 @@ void Potential::calc_PAW_local_potential(
     auto& ps_core = ppd.atom_->type().ps_core_charge_density();
     auto& ae_core = ppd.atom_->type().paw_ae_core_charge_density();
 
+    /* calling loop over PAW atoms is serial, so the workspace of the atom type can be reused */
+    auto& ws = paw_xc_workspace_[ppd.atom_->type_id()];
+
     double ae_xc_energy = 0.0;
     double ps_xc_energy = 0.0;
 
     switch (ctx_.num_mag_dims()) {
         case 0: {
-            ae_xc_energy = xc_mt_PAW_nonmagnetic(ppd.ae_potential_[0], *ae_density[0], ae_core);
-            ps_xc_energy = xc_mt_PAW_nonmagnetic(ppd.ps_potential_[0], *ps_density[0], ps_core);
+            ae_xc_energy = xc_mt_PAW_nonmagnetic(ppd.ae_potential_[0], *ae_density[0], ae_core, ws);
+            ps_xc_energy = xc_mt_PAW_nonmagnetic(ppd.ps_potential_[0], *ps_density[0], ps_core, ws);
             break;
         }
 
         case 1: {
-            ae_xc_energy = xc_mt_PAW_collinear(ppd.ae_potential_, ae_density, ae_core);
-            ps_xc_energy = xc_mt_PAW_collinear(ppd.ps_potential_, ps_density, ps_core);
+            ae_xc_energy = xc_mt_PAW_collinear(ppd.ae_potential_, ae_density, ae_core, ws);
+            ps_xc_energy = xc_mt_PAW_collinear(ppd.ps_potential_, ps_density, ps_core, ws);
             break;
         }
 
         case 3: {
-            ae_xc_energy = xc_mt_PAW_noncollinear(ppd.ae_potential_, ae_density, ae_core);
-            ps_xc_energy = xc_mt_PAW_noncollinear(ppd.ps_potential_, ps_density, ps_core);
+            ae_xc_energy = xc_mt_PAW_noncollinear(ppd.ae_potential_, ae_density, ae_core, ws);
+            ps_xc_energy = xc_mt_PAW_noncollinear(ppd.ps_potential_, ps_density, ps_core, ws);
             break;
         }
 
@@ -28,6 +28,7 @@
 #include "density/density.hpp"
 #include "hubbard/hubbard.hpp"
 #include "xc_functional.hpp"
+#include "SDDK/omp.hpp"
 
 namespace sirius {
 
@@ -136,6 +137,56 @@ class Potential : public Field4D
 
     std::vector<paw_potential_data_t> paw_potential_data_;
 
+    /// Preallocated buffers for the XC potential of PAW atoms of one type.
+    /** The buffers are reused by all atoms of the type; PAW atoms are processed one after another, so a single set
+     *  of buffers per type is enough. */
+    struct paw_xc_workspace_t
+    {
+        /// Total (valence + core) density in Rlm.
+        sf rho_lm;
+        /// Spin-up and spin-down densities in Rlm.
+        sf rho_up_lm;
+        sf rho_dn_lm;
+        /// Output of the forward transformation.
+        sf f_lm;
+        /// Density and magnetization in (theta, phi).
+        std::vector<Spheric_function<function_domain_t::spatial, double>> rho_tp;
+        /// Potential and magnetic field in (theta, phi).
+        std::vector<Spheric_function<function_domain_t::spatial, double>> vxc_tp;
+        Spheric_function<function_domain_t::spatial, double> rho_up_tp;
+        Spheric_function<function_domain_t::spatial, double> rho_dn_tp;
+        Spheric_function<function_domain_t::spatial, double> vxc_up_tp;
+        Spheric_function<function_domain_t::spatial, double> vxc_dn_tp;
+        Spheric_function<function_domain_t::spatial, double> exc_tp;
+    };
+
+    /// XC workspaces of PAW atoms indexed by atom type.
+    std::vector<paw_xc_workspace_t> paw_xc_workspace_;
+
+    /// Preallocated buffers for the XC potential of the full-potential muffin-tin atoms of one type.
+    /** Atoms of the type are processed in chunks of at most num_atoms atoms; the (theta, phi) values of each atom
+     *  of the chunk are stored one after another, so the spherical harmonic transforms of the chunk are done with
+     *  a single GEMM. */
+    struct xc_mt_workspace_t
+    {
+        /// Maximum number of atoms in the chunk.
+        int num_atoms{0};
+        mdarray<double, 3> rho_tp;
+        mdarray<double, 3> vxc_tp;
+        mdarray<double, 3> exc_tp;
+        /// Magnetization and, later, magnetic field in (theta, phi).
+        std::vector<mdarray<double, 3>> vecmagtp;
+        mdarray<double, 3> rho_up_tp;
+        mdarray<double, 3> rho_dn_tp;
+        mdarray<double, 3> vxc_up_tp;
+        mdarray<double, 3> vxc_dn_tp;
+        mdarray<double, 3> rho_up_lm;
+        mdarray<double, 3> rho_dn_lm;
+    };
+
+    /// XC workspaces of the muffin-tin atoms indexed by atom type.
+    std::vector<xc_mt_workspace_t> xc_mt_workspace_;
+
     mdarray<double, 4> paw_dij_;
 
     int max_paw_basis_size_{0};
@@ -151,13 +202,14 @@ class Potential : public Field4D
 
     void init_PAW();
 
-    double xc_mt_PAW_nonmagnetic(sf& full_potential, sf const& full_density, std::vector<double> const& rho_core);
+    double xc_mt_PAW_nonmagnetic(sf& full_potential, sf const& full_density, std::vector<double> const& rho_core,
+                                 paw_xc_workspace_t& ws);
 
     double xc_mt_PAW_collinear(std::vector<sf>& potential, std::vector<sf const*> density,
-                               std::vector<double> const& rho_core);
+                               std::vector<double> const& rho_core, paw_xc_workspace_t& ws);
 
     double xc_mt_PAW_noncollinear(std::vector<sf>& potential, std::vector<sf const*> density,
-                                  std::vector<double> const& rho_core);
+                                  std::vector<double> const& rho_core, paw_xc_workspace_t& ws);
 
     void calc_PAW_local_potential(paw_potential_data_t& pdd, std::vector<sf const*> ae_density,
                                   std::vector<sf const*> ps_density);
@@ -376,6 +428,57 @@ class Potential : public Field4D
         if (ctx_.full_potential()) {
             gvec_ylm_ = mdarray<double_complex, 2>(ctx_.lmmax_pot(), ctx_.gvec().count(), memory_t::host, "gvec_ylm_");
 
+            /* the atoms of a type are transformed in chunks; the chunk size is set by the memory budget of the
+               workspaces, so that it does not depend on the number of atoms per rank or on the number of threads */
+            double budget{-1};
+            if (ctx_.control().memory_usage_ == "low") {
+                budget = 64;
+            }
+            if (ctx_.control().memory_usage_ == "medium") {
+                budget = 512;
+            }
+            /* number of (theta, phi) arrays per atom */
+            int narr = 3 + ctx_.num_mag_dims() + ((ctx_.num_spins() == 2) ? 4 : 0);
+
+            xc_mt_workspace_ = std::vector<xc_mt_workspace_t>(unit_cell_.num_atom_types());
+            for (int iat = 0; iat < unit_cell_.num_atom_types(); iat++) {
+                int na{0};
+                for (int ialoc = 0; ialoc < unit_cell_.spl_num_atoms().local_size(); ialoc++) {
+                    if (unit_cell_.atom(unit_cell_.spl_num_atoms(ialoc)).type_id() == iat) {
+                        na++;
+                    }
+                }
+                if (!na) {
+                    continue;
+                }
+                int np   = sht_->num_points();
+                int nmtp = unit_cell_.atom_type(iat).num_mt_points();
+
+                if (budget > 0) {
+                    double sz = sizeof(double) * double(np) * nmtp * narr;
+                    /* at least one atom per thread is kept in the chunk */
+                    int nmax = std::max(omp_get_max_threads(), static_cast<int>(budget * (1 << 20) / sz));
+                    na = std::min(na, nmax);
+                }
+
+                auto& ws     = xc_mt_workspace_[iat];
+                ws.num_atoms = na;
+                ws.rho_tp    = mdarray<double, 3>(np, nmtp, na);
+                ws.vxc_tp    = mdarray<double, 3>(np, nmtp, na);
+                ws.exc_tp    = mdarray<double, 3>(np, nmtp, na);
+                for (int j = 0; j < ctx_.num_mag_dims(); j++) {
+                    ws.vecmagtp.emplace_back(np, nmtp, na);
+                }
+                if (ctx_.num_spins() == 2) {
+                    ws.rho_up_tp = mdarray<double, 3>(np, nmtp, na);
+                    ws.rho_dn_tp = mdarray<double, 3>(np, nmtp, na);
+                    ws.vxc_up_tp = mdarray<double, 3>(np, nmtp, na);
+                    ws.vxc_dn_tp = mdarray<double, 3>(np, nmtp, na);
+                    ws.rho_up_lm = mdarray<double, 3>(sht_->lmmax(), nmtp, na);
+                    ws.rho_dn_lm = mdarray<double, 3>(sht_->lmmax(), nmtp, na);
+                }
+            }
+
             switch (ctx_.valence_relativity()) {
                 case relativity_t::iora: {
                     rm2_inv_pw_ = mdarray<double_complex, 1>(ctx_.gvec().num_gvec());
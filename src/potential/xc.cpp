@@ -326,141 +326,220 @@ void Potential::xc_mt(Density const& density__)
 {
     PROFILE("sirius::Potential::xc_mt");
 
-    #pragma omp parallel for
-    for (int ialoc = 0; ialoc < unit_cell_.spl_num_atoms().local_size(); ialoc++) {
-        int ia = unit_cell_.spl_num_atoms(ialoc);
-        auto& rgrid = unit_cell_.atom(ia).radial_grid();
-        int nmtp = unit_cell_.atom(ia).num_mt_points();
+    using sf_tp = Spheric_function<function_domain_t::spatial, double>;
 
-        /* backward transform density from Rlm to (theta, phi) */
-        auto rho_tp = transform(*sht_, density__.rho().f_mt(ialoc));
+    int num_points = sht_->num_points();
+    int lmmax_pot  = ctx_.lmmax_pot();
 
-        /* backward transform magnetization from Rlm to (theta, phi) */
-        std::vector<Spheric_function<function_domain_t::spatial, double> > vecmagtp(ctx_.num_mag_dims());
-        for (int j = 0; j < ctx_.num_mag_dims(); j++) {
-            vecmagtp[j] = transform(*sht_, density__.magnetization(j).f_mt(ialoc));
+    /* pointers to the muffin-tin parts of the function for the given list of local atoms */
+    auto f_mt_ptr = [](Periodic_function<double> const& f__, std::vector<int> const& atoms__) {
+        std::vector<double const*> ptr;
+        for (int ialoc : atoms__) {
+            ptr.push_back(&f__.f_mt(ialoc)(0, 0));
         }
-
-        /* "up" component of the density */
-        Spheric_function<function_domain_t::spectral, double> rho_up_lm;
-        Spheric_function<function_domain_t::spatial, double> rho_up_tp(sht_->num_points(), rgrid);
-
-        /* "dn" component of the density */
-        Spheric_function<function_domain_t::spectral, double> rho_dn_lm;
-        Spheric_function<function_domain_t::spatial, double> rho_dn_tp(sht_->num_points(), rgrid);
-
-        /* check if density has negative values */
-        double rhomin = 0.0;
-        for (int ir = 0; ir < nmtp; ir++) {
-            for (int itp = 0; itp < sht_->num_points(); itp++) {
-                rhomin = std::min(rhomin, rho_tp(itp, ir));
-            }
+        return ptr;
+    };
+    auto f_mt_ptr_out = [](Periodic_function<double>& f__, std::vector<int> const& atoms__) {
+        std::vector<double*> ptr;
+        for (int ialoc : atoms__) {
+            ptr.push_back(&f__.f_mt(ialoc)(0, 0));
         }
-
-        if (rhomin < 0.0 && std::abs(rhomin) > 1e-9) {
-            std::stringstream s;
-            s << "Charge density for atom " << ia << " has negative values" << std::endl
-              << "most negatve value : " << rhomin << std::endl
-              << "current Rlm expansion of the charge density may be not sufficient, try to increase lmax_rho";
-            WARNING(s);
+        return ptr;
+    };
+
+    /* atoms of the same type share the radial grid; spherical harmonic transforms of a chunk of local atoms of
+       one type are done with a single GEMM */
+    for (int iat = 0; iat < unit_cell_.num_atom_types(); iat++) {
+        std::vector<int> atoms_of_type;
+        for (int ialoc = 0; ialoc < unit_cell_.spl_num_atoms().local_size(); ialoc++) {
+            if (unit_cell_.atom(unit_cell_.spl_num_atoms(ialoc)).type_id() == iat) {
+                atoms_of_type.push_back(ialoc);
+            }
         }
-
-        if (ctx_.num_spins() == 1) {
-            for (int ir = 0; ir < nmtp; ir++) {
-                /* fix negative density */
-                for (int itp = 0; itp < sht_->num_points(); itp++) {
-                    if (rho_tp(itp, ir) < 0.0) {
-                        rho_tp(itp, ir) = 0.0;
+        auto& rgrid = unit_cell_.atom_type(iat).radial_grid();
+        int nmtp    = unit_cell_.atom_type(iat).num_mt_points();
+
+        /* preallocated workspaces of this atom type; the values of each atom of the chunk are stored one after
+           another */
+        auto& ws        = xc_mt_workspace_[iat];
+        auto& rho_tp    = ws.rho_tp;
+        auto& vxc_tp    = ws.vxc_tp;
+        auto& exc_tp    = ws.exc_tp;
+        auto& vecmagtp  = ws.vecmagtp;
+        auto& rho_up_tp = ws.rho_up_tp;
+        auto& rho_dn_tp = ws.rho_dn_tp;
+        auto& vxc_up_tp = ws.vxc_up_tp;
+        auto& vxc_dn_tp = ws.vxc_dn_tp;
+        auto& rho_up_lm = ws.rho_up_lm;
+        auto& rho_dn_lm = ws.rho_dn_lm;
+
+        for (int i0 = 0; i0 < static_cast<int>(atoms_of_type.size()); i0 += ws.num_atoms) {
+            int na = std::min(ws.num_atoms, static_cast<int>(atoms_of_type.size()) - i0);
+            std::vector<int> atoms(atoms_of_type.begin() + i0, atoms_of_type.begin() + i0 + na);
+
+            int lmmax_rho = density__.rho().f_mt(atoms[0]).angular_domain_size();
+
+            /* number of angular harmonics for each radial point; it is reduced near the nucleus where the density
+               is almost spherical */
+            int lmmax_full = std::min(sht_->lmmax(), lmmax_rho);
+            std::vector<int> lmmax_r(nmtp, lmmax_full);
+            if (ctx_.settings().radial_lmax_tol_ > 0) {
+                std::fill(lmmax_r.begin(), lmmax_r.end(), 1);
+                /* the same shells are used for the density and the magnetization, so both must be resolved; the
+                   tolerance is relative to the spherical part of the charge density */
+                auto rho_ptr = f_mt_ptr(density__.rho(), atoms);
+                for (int j = 0; j < ctx_.num_mag_dims() + 1; j++) {
+                    auto ptr = (j == 0) ? rho_ptr : f_mt_ptr(density__.magnetization(j - 1), atoms);
+                    for (int i = 0; i < na; i++) {
+                        auto lmmax_r_a = SHT::radial_lmmax(lmmax_rho, ptr[i], nmtp, lmmax_full,
+                                                           ctx_.settings().radial_lmax_tol_, rho_ptr[i]);
+                        for (int ir = 0; ir < nmtp; ir++) {
+                            lmmax_r[ir] = std::max(lmmax_r[ir], lmmax_r_a[ir]);
+                        }
                     }
                 }
             }
-        } else {
+            auto shells = SHT::radial_shells(lmmax_r);
+            /* where the density has the full expansion, the potential is also computed with the full expansion */
+            std::vector<int> lmmax_pot_r(nmtp);
             for (int ir = 0; ir < nmtp; ir++) {
-                for (int itp = 0; itp < sht_->num_points(); itp++) {
-                    /* compute magnitude of the magnetization vector */
-                    double mag = 0.0;
-                    for (int j = 0; j < ctx_.num_mag_dims(); j++) {
-                        mag += std::pow(vecmagtp[j](itp, ir), 2);
-                    }
-                    mag = std::sqrt(mag);
-
-                    /* in magnetic case fix both density and magnetization */
-                    for (int itp = 0; itp < sht_->num_points(); itp++) {
-                        if (rho_tp(itp, ir) < 0.0) {
-                            rho_tp(itp, ir) = 0.0;
-                            mag = 0.0;
-                        }
-                        /* fix numerical noise at high values of magnetization */
-                        mag = std::min(mag, rho_tp(itp, ir));
-
-                        /* compute "up" and "dn" components */
-                        rho_up_tp(itp, ir) = 0.5 * (rho_tp(itp, ir) + mag);
-                        rho_dn_tp(itp, ir) = 0.5 * (rho_tp(itp, ir) - mag);
-                    }
-                }
+                lmmax_pot_r[ir] = (lmmax_r[ir] == lmmax_full) ? lmmax_pot : lmmax_r[ir];
             }
+            auto shells_pot = SHT::radial_shells(lmmax_pot_r);
 
-            /* transform from (theta, phi) to Rlm */
-            rho_up_lm = transform(*sht_, rho_up_tp);
-            rho_dn_lm = transform(*sht_, rho_dn_tp);
-        }
+            /* backward transform density and magnetization from Rlm to (theta, phi) */
+            sht_->backward_transform(lmmax_rho, f_mt_ptr(density__.rho(), atoms), shells, rho_tp.at(memory_t::host));
+            for (int j = 0; j < ctx_.num_mag_dims(); j++) {
+                sht_->backward_transform(lmmax_rho, f_mt_ptr(density__.magnetization(j), atoms), shells,
+                                         vecmagtp[j].at(memory_t::host));
+            }
 
-        Spheric_function<function_domain_t::spatial, double> exc_tp(sht_->num_points(), rgrid);
-        Spheric_function<function_domain_t::spatial, double> vxc_tp(sht_->num_points(), rgrid);
+            #pragma omp parallel for
+            for (int i = 0; i < na; i++) {
+                int ia = unit_cell_.spl_num_atoms(atoms[i]);
 
-        if (ctx_.num_spins() == 1) {
-            xc_mt_nonmagnetic(rgrid, xc_func_, density__.rho().f_mt(ialoc), rho_tp, vxc_tp, exc_tp);
-        } else {
-            Spheric_function<function_domain_t::spatial, double> vxc_up_tp(sht_->num_points(), rgrid);
-            Spheric_function<function_domain_t::spatial, double> vxc_dn_tp(sht_->num_points(), rgrid);
+                /* check if density has negative values */
+                double rhomin = 0.0;
+                for (int ir = 0; ir < nmtp; ir++) {
+                    for (int itp = 0; itp < num_points; itp++) {
+                        rhomin = std::min(rhomin, rho_tp(itp, ir, i));
+                    }
+                }
 
-            xc_mt_magnetic(rgrid, xc_func_, rho_up_lm, rho_up_tp, rho_dn_lm, rho_dn_tp, vxc_up_tp, vxc_dn_tp, exc_tp);
+                if (rhomin < 0.0 && std::abs(rhomin) > 1e-9) {
+                    std::stringstream s;
+                    s << "Charge density for atom " << ia << " has negative values" << std::endl
+                      << "most negatve value : " << rhomin << std::endl
+                      << "current Rlm expansion of the charge density may be not sufficient, try to increase lmax_rho";
+                    WARNING(s);
+                }
 
-            for (int ir = 0; ir < nmtp; ir++) {
-                for (int itp = 0; itp < sht_->num_points(); itp++) {
-                    /* align magnetic filed parallel to magnetization */
-                    /* use vecmagtp as temporary vector */
-                    double mag =  rho_up_tp(itp, ir) - rho_dn_tp(itp, ir);
-                    if (mag > 1e-8) {
-                        /* |Bxc| = 0.5 * (V_up - V_dn) */
-                        double b = 0.5 * (vxc_up_tp(itp, ir) - vxc_dn_tp(itp, ir));
-                        for (int j = 0; j < ctx_.num_mag_dims(); j++) {
-                            vecmagtp[j](itp, ir) = b * vecmagtp[j](itp, ir) / mag;
+                for (int ir = 0; ir < nmtp; ir++) {
+                    for (int itp = 0; itp < num_points; itp++) {
+                        /* fix negative density */
+                        if (rho_tp(itp, ir, i) < 0.0) {
+                            rho_tp(itp, ir, i) = 0.0;
                         }
-                    } else {
-                        for (int j = 0; j < ctx_.num_mag_dims(); j++) {
-                            vecmagtp[j](itp, ir) = 0.0;
+                        if (ctx_.num_spins() == 2) {
+                            /* compute magnitude of the magnetization vector */
+                            double mag = 0.0;
+                            for (int j = 0; j < ctx_.num_mag_dims(); j++) {
+                                mag += std::pow(vecmagtp[j](itp, ir, i), 2);
+                            }
+                            mag = std::sqrt(mag);
+                            /* in magnetic case fix both density and magnetization */
+                            if (rho_tp(itp, ir, i) == 0.0) {
+                                mag = 0.0;
+                            }
+                            /* fix numerical noise at high values of magnetization */
+                            mag = std::min(mag, rho_tp(itp, ir, i));
+
+                            /* compute "up" and "dn" components */
+                            rho_up_tp(itp, ir, i) = 0.5 * (rho_tp(itp, ir, i) + mag);
+                            rho_dn_tp(itp, ir, i) = 0.5 * (rho_tp(itp, ir, i) - mag);
                         }
                     }
-                    /* Vxc = 0.5 * (V_up + V_dn) */
-                    vxc_tp(itp, ir) = 0.5 * (vxc_up_tp(itp, ir) + vxc_dn_tp(itp, ir));
                 }
             }
-            /* z, x, y order */
-            std::array<int, 3> comp_map = {2, 0, 1};
-            /* convert magnetic field back to Rlm */
-            for (int j = 0; j < ctx_.num_mag_dims(); j++) {
-                auto bxcrlm = transform(*sht_, vecmagtp[j]);
-                for (int ir = 0; ir < nmtp; ir++) {
-                    /* add auxiliary magnetic field antiparallel to starting magnetization */
-                    bxcrlm(0, ir) -= aux_bf_(j, ia) * ctx_.unit_cell().atom(ia).vector_field()[comp_map[j]];
-                    for (int lm = 0; lm < ctx_.lmmax_pot(); lm++) {
-                        effective_magnetic_field(j).f_mt<index_domain_t::local>(lm, ir, ialoc) = bxcrlm(lm, ir);
+
+            if (ctx_.num_spins() == 2) {
+                /* transform from (theta, phi) to Rlm */
+                sht_->forward_transform(rho_up_tp.at(memory_t::host), nmtp * na, sht_->lmmax(), sht_->lmmax(),
+                                        rho_up_lm.at(memory_t::host));
+                sht_->forward_transform(rho_dn_tp.at(memory_t::host), nmtp * na, sht_->lmmax(), sht_->lmmax(),
+                                        rho_dn_lm.at(memory_t::host));
+            }
+
+            #pragma omp parallel for
+            for (int i = 0; i < na; i++) {
+                /* views of the workspaces for one atom */
+                sf_tp rho_tp_a(&rho_tp(0, 0, i), num_points, rgrid);
+                sf_tp vxc_tp_a(&vxc_tp(0, 0, i), num_points, rgrid);
+                sf_tp exc_tp_a(&exc_tp(0, 0, i), num_points, rgrid);
+
+                if (ctx_.num_spins() == 1) {
+                    xc_mt_nonmagnetic(rgrid, xc_func_, density__.rho().f_mt(atoms[i]), rho_tp_a, vxc_tp_a, exc_tp_a);
+                } else {
+                    Spheric_function<function_domain_t::spectral, double> rho_up_lm_a(&rho_up_lm(0, 0, i),
+                                                                                       sht_->lmmax(), rgrid);
+                    Spheric_function<function_domain_t::spectral, double> rho_dn_lm_a(&rho_dn_lm(0, 0, i),
+                                                                                       sht_->lmmax(), rgrid);
+                    sf_tp rho_up_tp_a(&rho_up_tp(0, 0, i), num_points, rgrid);
+                    sf_tp rho_dn_tp_a(&rho_dn_tp(0, 0, i), num_points, rgrid);
+                    sf_tp vxc_up_tp_a(&vxc_up_tp(0, 0, i), num_points, rgrid);
+                    sf_tp vxc_dn_tp_a(&vxc_dn_tp(0, 0, i), num_points, rgrid);
+
+                    xc_mt_magnetic(rgrid, xc_func_, rho_up_lm_a, rho_up_tp_a, rho_dn_lm_a, rho_dn_tp_a, vxc_up_tp_a,
+                                   vxc_dn_tp_a, exc_tp_a);
+
+                    for (int ir = 0; ir < nmtp; ir++) {
+                        for (int itp = 0; itp < num_points; itp++) {
+                            /* align magnetic filed parallel to magnetization */
+                            /* use vecmagtp as temporary vector */
+                            double mag =  rho_up_tp(itp, ir, i) - rho_dn_tp(itp, ir, i);
+                            if (mag > 1e-8) {
+                                /* |Bxc| = 0.5 * (V_up - V_dn) */
+                                double b = 0.5 * (vxc_up_tp(itp, ir, i) - vxc_dn_tp(itp, ir, i));
+                                for (int j = 0; j < ctx_.num_mag_dims(); j++) {
+                                    vecmagtp[j](itp, ir, i) = b * vecmagtp[j](itp, ir, i) / mag;
+                                }
+                            } else {
+                                for (int j = 0; j < ctx_.num_mag_dims(); j++) {
+                                    vecmagtp[j](itp, ir, i) = 0.0;
+                                }
+                            }
+                            /* Vxc = 0.5 * (V_up + V_dn) */
+                            vxc_tp(itp, ir, i) = 0.5 * (vxc_up_tp(itp, ir, i) + vxc_dn_tp(itp, ir, i));
+                        }
                     }
                 }
             }
-        }
 
-        /* forward transform from (theta, phi) to Rlm */
-        auto vxcrlm = transform(*sht_, vxc_tp);
-        auto excrlm = transform(*sht_, exc_tp);
-        for (int ir = 0; ir < nmtp; ir++) {
-            for (int lm = 0; lm < ctx_.lmmax_pot(); lm++) {
-                xc_potential_->f_mt<index_domain_t::local>(lm, ir, ialoc) = vxcrlm(lm, ir);
-                xc_energy_density_->f_mt<index_domain_t::local>(lm, ir, ialoc) = excrlm(lm, ir);
+            /* forward transform from (theta, phi) to Rlm */
+            sht_->forward_transform(vxc_tp.at(memory_t::host), shells_pot, lmmax_pot, lmmax_pot,
+                                    f_mt_ptr_out(*xc_potential_, atoms));
+            sht_->forward_transform(exc_tp.at(memory_t::host), shells_pot, lmmax_pot, lmmax_pot,
+                                    f_mt_ptr_out(*xc_energy_density_, atoms));
+
+            if (ctx_.num_spins() == 2) {
+                /* z, x, y order */
+                std::array<int, 3> comp_map = {2, 0, 1};
+                /* convert magnetic field back to Rlm */
+                for (int j = 0; j < ctx_.num_mag_dims(); j++) {
+                    sht_->forward_transform(vecmagtp[j].at(memory_t::host), shells_pot, lmmax_pot, lmmax_pot,
+                                            f_mt_ptr_out(effective_magnetic_field(j), atoms));
+                    for (int i = 0; i < na; i++) {
+                        int ia = unit_cell_.spl_num_atoms(atoms[i]);
+                        for (int ir = 0; ir < nmtp; ir++) {
+                            /* add auxiliary magnetic field antiparallel to starting magnetization */
+                            effective_magnetic_field(j).f_mt<index_domain_t::local>(0, ir, atoms[i]) -=
+                                aux_bf_(j, ia) * ctx_.unit_cell().atom(ia).vector_field()[comp_map[j]];
+                        }
+                    }
+                }
             }
-        }
-    } // ialoc
+        } // i0
+    } // iat
 }
 
 template <bool add_pseudo_core__>
@@ -548,14 +627,14 @@ void Potential::xc_rg_nonmagnetic(Density const& density__)
         /* generate pw coeffs of the laplacian */
         if (use_2nd_deriv) {
             lapl_rho = laplacian(rho);
-            /* Laplacian in real space */
-            lapl_rho.fft_transform(1);
         }
 
-        /* gradient in real space */
-        for (int x: {0, 1, 2}) {
-            grad_rho[x].fft_transform(1);
+        /* gradient and Laplacian in real space */
+        std::vector<Smooth_periodic_function<double>*> f({&grad_rho[0], &grad_rho[1], &grad_rho[2]});
+        if (use_2nd_deriv) {
+            f.push_back(&lapl_rho);
         }
+        sirius::fft_transform(f, 1, ctx_.spfft_batch());
 
         /* product of gradients */
         grad_rho_grad_rho = dot(grad_rho, grad_rho);
@@ -696,9 +775,7 @@ void Potential::xc_rg_nonmagnetic(Density const& density__)
             auto grad_vsigma = gradient(vsigma);
 
             /* backward transform gradient from pw to real space */
-            for (int x: {0, 1, 2}) {
-                grad_vsigma[x].fft_transform(1);
-            }
+            grad_vsigma.fft_transform(1, ctx_.spfft_batch());
 
             /* compute scalar product of two gradients */
             auto grad_vsigma_grad_rho = dot(grad_vsigma, grad_rho);
@@ -715,9 +792,9 @@ void Potential::xc_rg_nonmagnetic(Density const& density__)
                 for (int ir = 0; ir < num_points; ir++) {
                     vsigma_grad_rho[x].f_rg(ir) = grad_rho[x].f_rg(ir) * vsigma.f_rg(ir);
                 }
-                /* transform to plane wave domain */
-                vsigma_grad_rho[x].fft_transform(-1);
             }
+            /* transform to plane wave domain */
+            vsigma_grad_rho.fft_transform(-1, ctx_.spfft_batch());
             div_vsigma_grad_rho = divergence(vsigma_grad_rho);
             /* transform to real space domain */
             div_vsigma_grad_rho.fft_transform(1);
@@ -815,18 +892,15 @@ void Potential::xc_rg_magnetic(Density const& density__)
     if (is_gga) {
         PROFILE("sirius::Potential::xc_rg_magnetic|grad1");
         /* get plane-wave coefficients of densities */
-        rho_up.fft_transform(-1);
-        rho_dn.fft_transform(-1);
+        sirius::fft_transform<double>({&rho_up, &rho_dn}, -1, ctx_.spfft_batch());
 
         /* generate pw coeffs of the gradient and laplacian */
         grad_rho_up = gradient(rho_up);
         grad_rho_dn = gradient(rho_dn);
 
         /* gradient in real space */
-        for (int x: {0, 1, 2}) {
-            grad_rho_up[x].fft_transform(1);
-            grad_rho_dn[x].fft_transform(1);
-        }
+        sirius::fft_transform<double>({&grad_rho_up[0], &grad_rho_up[1], &grad_rho_up[2],
+                                       &grad_rho_dn[0], &grad_rho_dn[1], &grad_rho_dn[2]}, 1, ctx_.spfft_batch());
 
         /* product of gradients */
         grad_rho_up_grad_rho_up = dot(grad_rho_up, grad_rho_up);
@@ -1004,15 +1078,15 @@ void Potential::xc_rg_magnetic(Density const& density__)
               up_gradrho_vsigma[x].f_rg(ir) = 2 * grad_rho_up[x].f_rg(ir) * vsigma_uu.f_rg(ir) + grad_rho_dn[x].f_rg(ir) * vsigma_ud.f_rg(ir);
               dn_gradrho_vsigma[x].f_rg(ir) = 2 * grad_rho_dn[x].f_rg(ir) * vsigma_dd.f_rg(ir) + grad_rho_up[x].f_rg(ir) * vsigma_ud.f_rg(ir);
             }
-            /* transform to plane wave domain */
-            up_gradrho_vsigma[x].fft_transform(-1);
-            dn_gradrho_vsigma[x].fft_transform(-1);
         }
+        /* transform to plane wave domain */
+        sirius::fft_transform<double>({&up_gradrho_vsigma[0], &up_gradrho_vsigma[1], &up_gradrho_vsigma[2],
+                                       &dn_gradrho_vsigma[0], &dn_gradrho_vsigma[1], &dn_gradrho_vsigma[2]}, -1,
+                                      ctx_.spfft_batch());
 
         auto div_up_gradrho_vsigma = divergence(up_gradrho_vsigma);
-        div_up_gradrho_vsigma.fft_transform(1);
         auto div_dn_gradrho_vsigma = divergence(dn_gradrho_vsigma);
-        div_dn_gradrho_vsigma.fft_transform(1);
+        sirius::fft_transform<double>({&div_up_gradrho_vsigma, &div_dn_gradrho_vsigma}, 1, ctx_.spfft_batch());
 
         /* add remaining term to Vxc */
         #pragma omp parallel for
@@ -0,0 +1,163 @@
+// Copyright (c) 2013-2017 Anton Kozhevnikov, Thomas Schulthess
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+// the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+//    following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+//    and the following disclaimer in the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/** \file multi_spline.hpp
+ *
+ *  \brief Contains definition and implementation of sirius::Multi_spline class.
+ */
+
+#ifndef __MULTI_SPLINE_HPP__
+#define __MULTI_SPLINE_HPP__
+
+#include "radial/spline.hpp"
+
+namespace sirius {
+
+/// Set of cubic splines defined on the same radial grid.
+/** Coefficients of all functions are packed into a single array in which the coefficients of a given power of
+ *  \f$ \Delta x \f$ at a given grid point are stored contiguously for all functions:
+ *  \f[
+ *    f_{\alpha}(x_i + \Delta x) = a_{\alpha i} + b_{\alpha i} \Delta x + c_{\alpha i} \Delta x^2 +
+ *      d_{\alpha i} \Delta x^3
+ *  \f]
+ *  with \f$ \alpha \f$ being the fastest index. This allows to evaluate a group of functions at a given point with
+ *  a single vectorizable loop. The grid itself is not stored; the caller is responsible for finding the
+ *  index of the grid interval and the offset \f$ \Delta x \f$.
+ */
+template <typename T>
+class Multi_spline
+{
+  private:
+    /// Number of functions.
+    int num_func_{0};
+
+    /// Number of grid points.
+    int num_points_{0};
+
+    /// Spline coefficients with the dimensions (num_func, 4, num_points).
+    sddk::mdarray<T, 3> coeffs_;
+
+  public:
+    /// Default constructor.
+    Multi_spline()
+    {
+    }
+
+    /// Constructor of an empty set of splines.
+    Multi_spline(int num_func__, int num_points__)
+        : num_func_(num_func__)
+        , num_points_(num_points__)
+    {
+        coeffs_ = sddk::mdarray<T, 3>(num_func_, 4, num_points_, sddk::memory_t::host, "Multi_spline::coeffs_");
+        coeffs_.zero();
+    }
+
+    /// Get the reference to a value of the function at the grid point x[i].
+    inline T& operator()(int f__, int i__)
+    {
+        return coeffs_(f__, 0, i__);
+    }
+
+    /// Get value of the function at the grid point x[i].
+    inline T operator()(int f__, int i__) const
+    {
+        return coeffs_(f__, 0, i__);
+    }
+
+    /// Get value of the function at the point x[i] + dx.
+    inline T operator()(int f__, int i__, T dx__) const
+    {
+        return coeffs_(f__, 0, i__) +
+               dx__ * (coeffs_(f__, 1, i__) + dx__ * (coeffs_(f__, 2, i__) + dx__ * coeffs_(f__, 3, i__)));
+    }
+
+    /// Evaluate a contiguous range of functions [f0, f0 + n) at the point x[i] + dx.
+    inline void operator()(int f0__, int n__, int i__, T dx__, T* val__) const
+    {
+        T const* a = &coeffs_(f0__, 0, i__);
+        T const* b = &coeffs_(f0__, 1, i__);
+        T const* c = &coeffs_(f0__, 2, i__);
+        T const* d = &coeffs_(f0__, 3, i__);
+        #pragma omp simd
+        for (int f = 0; f < n__; f++) {
+            val__[f] = a[f] + dx__ * (b[f] + dx__ * (c[f] + dx__ * d[f]));
+        }
+    }
+
+    /// Evaluate a contiguous range of functions [f0, f0 + n) for a batch of points x[i_j] + dx_j.
+    /** Result for the j-th point is stored at val[j * ld]. */
+    inline void operator()(int f0__, int n__, int np__, int const* i__, T const* dx__, T* val__, int ld__) const
+    {
+        #pragma omp parallel for schedule(static)
+        for (int j = 0; j < np__; j++) {
+            (*this)(f0__, n__, i__[j], dx__[j], &val__[j * ld__]);
+        }
+    }
+
+    /// Interpolate the function using the values stored at the grid points.
+    void interpolate(int f__, Radial_grid<T> const& grid__)
+    {
+        assert(grid__.num_points() == num_points_);
+
+        Spline<T> s(grid__);
+        for (int i = 0; i < num_points_; i++) {
+            s(i) = coeffs_(f__, 0, i);
+        }
+        s.interpolate();
+        for (int i = 0; i < num_points_; i++) {
+            for (int k = 0; k < 4; k++) {
+                coeffs_(f__, k, i) = s.coeffs()(i, k);
+            }
+        }
+    }
+
+    /// Set values of the function at the grid points and interpolate it.
+    void interpolate(int f__, Radial_grid<T> const& grid__, T const* y__)
+    {
+        for (int i = 0; i < num_points_; i++) {
+            coeffs_(f__, 0, i) = y__[i];
+        }
+        interpolate(f__, grid__);
+    }
+
+    inline int num_func() const
+    {
+        return num_func_;
+    }
+
+    inline int num_points() const
+    {
+        return num_points_;
+    }
+
+    /// Packed array of spline coefficients.
+    inline sddk::mdarray<T, 3>& coeffs()
+    {
+        return coeffs_;
+    }
+
+    inline sddk::mdarray<T, 3> const& coeffs() const
+    {
+        return coeffs_;
+    }
+};
+
+} // namespace sirius
+
+#endif // __MULTI_SPLINE_HPP__
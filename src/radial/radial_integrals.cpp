@@ -26,6 +26,118 @@
 
 namespace sirius {
 
+uint64_t pseudopotential_hash(Atom_type const& atom_type__, uint64_t h__)
+{
+    auto hash_vector = [&](std::vector<double> const& v) {
+        if (!v.empty()) {
+            h__ = utils::hash(v.data(), v.size() * sizeof(double), h__);
+        }
+    };
+    auto hash_spline = [&](Spline<double> const& s) {
+        for (int i = 0; i < s.num_points(); i++) {
+            h__ = utils::hash(&s(i), sizeof(double), h__);
+        }
+    };
+
+    int zn = atom_type__.zn();
+    h__    = utils::hash(&zn, sizeof(int), h__);
+
+    auto& rgrid = atom_type__.radial_grid();
+    for (int ir = 0; ir < rgrid.num_points(); ir++) {
+        double x = rgrid[ir];
+        h__      = utils::hash(&x, sizeof(double), h__);
+    }
+
+    int nbrf = atom_type__.num_beta_radial_functions();
+    for (int idxrf = 0; idxrf < nbrf; idxrf++) {
+        int l = atom_type__.indexr(idxrf).l;
+        h__   = utils::hash(&l, sizeof(int), h__);
+        hash_spline(atom_type__.beta_radial_function(idxrf));
+    }
+    if (atom_type__.augment()) {
+        for (int l = 0; l <= 2 * atom_type__.indexr().lmax(); l++) {
+            for (int idxrf2 = 0; idxrf2 < nbrf; idxrf2++) {
+                for (int idxrf1 = 0; idxrf1 <= idxrf2; idxrf1++) {
+                    hash_spline(atom_type__.q_radial_function(idxrf1, idxrf2, l));
+                }
+            }
+        }
+    }
+    hash_vector(atom_type__.local_potential());
+    hash_vector(atom_type__.ps_core_charge_density());
+    hash_vector(atom_type__.ps_total_charge_density());
+
+    for (int i = 0; i < static_cast<int>(atom_type__.indexr_wfs().size()); i++) {
+        int l = atom_type__.indexr_wfs(i).l;
+        h__   = utils::hash(&l, sizeof(int), h__);
+        hash_spline(std::get<3>(atom_type__.ps_atomic_wf(i)));
+    }
+    for (int i = 0; i < static_cast<int>(atom_type__.indexr_hub().size()); i++) {
+        int l = atom_type__.indexr_hub(i).l;
+        h__   = utils::hash(&l, sizeof(int), h__);
+        hash_spline(atom_type__.hubbard_radial_function(i));
+    }
+    for (int ir = 0; ir < atom_type__.free_atom_radial_grid().num_points(); ir++) {
+        double v[] = {atom_type__.free_atom_radial_grid(ir), atom_type__.free_atom_density(ir)};
+        h__        = utils::hash(v, sizeof(v), h__);
+    }
+    return h__;
+}
+
+std::vector<double> filter_q_grid(double qmax__)
+{
+    int nq = 2 * static_cast<int>(qmax__ / 0.01) + 1;
+    std::vector<double> qgrid(nq);
+    for (int iq = 0; iq < nq; iq++) {
+        qgrid[iq] = iq * qmax__ / (nq - 1);
+    }
+    return qgrid;
+}
+
+std::vector<Spline<double>> filter_radial_functions(std::vector<double> const& qgrid__,
+                                                    sddk::mdarray<double, 2> const& ri__,
+                                                    std::vector<int> const& l__, double rmax__)
+{
+    int nq    = static_cast<int>(qgrid__.size());
+    double dq = qgrid__[1] - qgrid__[0];
+    int nf    = static_cast<int>(l__.size());
+    int lmax  = *std::max_element(l__.begin(), l__.end());
+
+    int nr = std::max(100, static_cast<int>(rmax__ / 0.005));
+    Radial_grid_lin<double> rgrid(nr, 0, rmax__);
+
+    std::vector<Spline<double>> rf(nf);
+    for (int i = 0; i < nf; i++) {
+        rf[i] = Spline<double>(rgrid);
+    }
+
+    #pragma omp parallel
+    {
+        std::vector<double> jl(lmax + 1);
+        std::vector<double> f(nf);
+        #pragma omp for
+        for (int ir = 0; ir < nr; ir++) {
+            std::fill(f.begin(), f.end(), 0);
+            for (int iq = 0; iq < nq; iq++) {
+                double q = qgrid__[iq];
+                /* Simpson weights */
+                double w = (iq == 0 || iq == nq - 1) ? 1 : ((iq % 2) ? 4 : 2);
+                Spherical_Bessel_functions::sbessel(lmax, q * rgrid[ir], &jl[0]);
+                for (int i = 0; i < nf; i++) {
+                    f[i] += w * q * q * ri__(i, iq) * jl[l__[i]];
+                }
+            }
+            for (int i = 0; i < nf; i++) {
+                rf[i](ir) = f[i] * dq * 2 / (3 * pi);
+            }
+        }
+    }
+    for (int i = 0; i < nf; i++) {
+        rf[i].interpolate();
+    }
+    return rf;
+}
+
 template <bool jl_deriv>
 void Radial_integrals_atomic_wf<jl_deriv>::generate()
 {
@@ -51,7 +163,7 @@ void Radial_integrals_atomic_wf<jl_deriv>::generate()
 
         /* loop over all pseudo wave-functions */
         for (int i = 0; i < nwf; i++) {
-            values_(i, iat) = Spline<double>(grid_q_);
+            int f = func_idx(i, iat);
 
             int l = (hubbard_) ? atom_type.indexr_hub(i).l : atom_type.indexr_wfs(i).l;
             auto& rwf = (hubbard_) ? atom_type.hubbard_radial_function(i) : std::get<3>(atom_type.ps_atomic_wf(i));
@@ -59,14 +171,14 @@ void Radial_integrals_atomic_wf<jl_deriv>::generate()
             #pragma omp parallel for
             for (int iq = 0; iq < nq(); iq++) {
                 if (jl_deriv) {
-                    auto s              = jl(iq).deriv_q(l);
-                    values_(i, iat)(iq) = sirius::inner(s, rwf, 1);
+                    auto s         = jl(iq).deriv_q(l);
+                    values_(f, iq) = sirius::inner(s, rwf, 1);
                 } else {
-                    values_(i, iat)(iq) = sirius::inner(jl(iq)[l], rwf, 1);
+                    values_(f, iq) = sirius::inner(jl(iq)[l], rwf, 1);
                 }
             }
 
-            values_(i, iat).interpolate();
+            values_.interpolate(f, grid_q_);
         }
     }
 }
@@ -89,11 +201,9 @@ void Radial_integrals_aug<jl_deriv>::generate()
         /* maximum l of beta-projectors */
         int lmax_beta = atom_type.indexr().lmax();
 
-        for (int l = 0; l <= 2 * lmax_beta; l++) {
-            for (int idx = 0; idx < nbrf * (nbrf + 1) / 2; idx++) {
-                values_(idx, l, iat) = Spline<double>(grid_q_);
-            }
-        }
+        /* values of the radial integrals on the q-grid */
+        sddk::mdarray<double, 3> ri(nq(), nbrf * (nbrf + 1) / 2, 2 * lmax_beta + 1);
+        ri.zero();
 
         #pragma omp parallel for
         for (int iq_loc = 0; iq_loc < spl_q_.local_size(); iq_loc++) {
@@ -112,10 +222,10 @@ void Radial_integrals_aug<jl_deriv>::generate()
                         if (l3 >= std::abs(l1 - l2) && l3 <= (l1 + l2) && (l1 + l2 + l3) % 2 == 0) {
                             if (jl_deriv) {
                                 auto s = jl.deriv_q(l3);
-                                values_(idx, l3, iat)(iq) =
+                                ri(iq, idx, l3) =
                                     sirius::inner(s, atom_type.q_radial_function(idxrf1, idxrf2, l3), 0);
                             } else {
-                                values_(idx, l3, iat)(iq) =
+                                ri(iq, idx, l3) =
                                     sirius::inner(jl[l3], atom_type.q_radial_function(idxrf1, idxrf2, l3), 0);
                             }
                         }
@@ -125,14 +235,14 @@ void Radial_integrals_aug<jl_deriv>::generate()
         }
         for (int l = 0; l <= 2 * lmax_beta; l++) {
             for (int idx = 0; idx < nbrf * (nbrf + 1) / 2; idx++) {
-                unit_cell_.comm().allgather(&values_(idx, l, iat)(0), spl_q_.global_offset(), spl_q_.local_size());
+                unit_cell_.comm().allgather(&ri(0, idx, l), spl_q_.global_offset(), spl_q_.local_size());
             }
         }
 
         #pragma omp parallel for
         for (int l = 0; l <= 2 * lmax_beta; l++) {
             for (int idx = 0; idx < nbrf * (nbrf + 1) / 2; idx++) {
-                values_(idx, l, iat).interpolate();
+                values_.interpolate(func_idx(idx, l, iat), grid_q_, &ri(0, idx, l));
             }
         }
     }
@@ -149,7 +259,7 @@ void Radial_integrals_rho_pseudo::generate()
             continue;
         }
 
-        values_(iat) = Spline<double>(grid_q_);
+        std::vector<double> ri(nq());
 
         Spline<double> rho(atom_type.radial_grid(), atom_type.ps_total_charge_density());
 
@@ -158,10 +268,9 @@ void Radial_integrals_rho_pseudo::generate()
             int iq = spl_q_[iq_loc];
             Spherical_Bessel_functions jl(0, atom_type.radial_grid(), grid_q_[iq]);
 
-            values_(iat)(iq) = sirius::inner(jl[0], rho, 0, atom_type.num_mt_points()) / fourpi;
+            ri[iq] = sirius::inner(jl[0], rho, 0, atom_type.num_mt_points()) / fourpi;
         }
-        unit_cell_.comm().allgather(&values_(iat)(0), spl_q_.global_offset(), spl_q_.local_size());
-        values_(iat).interpolate();
+        gather_and_interpolate(iat, ri.data());
     }
 }
 
@@ -177,7 +286,7 @@ void Radial_integrals_rho_core_pseudo<jl_deriv>::generate()
             continue;
         }
 
-        values_(iat) = Spline<double>(grid_q_);
+        std::vector<double> ri(nq());
 
         Spline<double> ps_core(atom_type.radial_grid(), atom_type.ps_core_charge_density());
 
@@ -187,14 +296,13 @@ void Radial_integrals_rho_core_pseudo<jl_deriv>::generate()
             Spherical_Bessel_functions jl(0, atom_type.radial_grid(), grid_q_[iq]);
 
             if (jl_deriv) {
-                auto s           = jl.deriv_q(0);
-                values_(iat)(iq) = sirius::inner(s, ps_core, 2, atom_type.num_mt_points());
+                auto s = jl.deriv_q(0);
+                ri[iq] = sirius::inner(s, ps_core, 2, atom_type.num_mt_points());
             } else {
-                values_(iat)(iq) = sirius::inner(jl[0], ps_core, 2, atom_type.num_mt_points());
+                ri[iq] = sirius::inner(jl[0], ps_core, 2, atom_type.num_mt_points());
             }
         }
-        unit_cell_.comm().allgather(&values_(iat)(0), spl_q_.global_offset(), spl_q_.local_size());
-        values_(iat).interpolate();
+        gather_and_interpolate(iat, ri.data());
     }
 }
 
@@ -211,9 +319,8 @@ void Radial_integrals_beta<jl_deriv>::generate()
             continue;
         }
 
-        for (int idxrf = 0; idxrf < nrb; idxrf++) {
-            values_(idxrf, iat) = Spline<double>(grid_q_);
-        }
+        /* values of the radial integrals on the q-grid */
+        sddk::mdarray<double, 2> ri(nq(), nrb);
 
         #pragma omp parallel for
         for (int iq_loc = 0; iq_loc < spl_q_.local_size(); iq_loc++) {
@@ -225,16 +332,15 @@ void Radial_integrals_beta<jl_deriv>::generate()
                 /* remember that beta(r) are defined as miltiplied by r */
                 if (jl_deriv) {
                     auto s  = jl.deriv_q(l);
-                    values_(idxrf, iat)(iq) = sirius::inner(s, atom_type.beta_radial_function(idxrf), 1);
+                    ri(iq, idxrf) = sirius::inner(s, atom_type.beta_radial_function(idxrf), 1);
                 } else {
-                    values_(idxrf, iat)(iq) = sirius::inner(jl[l], atom_type.beta_radial_function(idxrf), 1);
+                    ri(iq, idxrf) = sirius::inner(jl[l], atom_type.beta_radial_function(idxrf), 1);
                 }
             }
         }
 
         for (int idxrf = 0; idxrf < nrb; idxrf++) {
-            unit_cell_.comm().allgather(&values_(idxrf, iat)(0), spl_q_.global_offset(), spl_q_.local_size());
-            values_(idxrf, iat).interpolate();
+            gather_and_interpolate(func_idx(idxrf, iat), &ri(0, idxrf));
         }
     }
 }
@@ -291,7 +397,7 @@ void Radial_integrals_vloc<jl_deriv>::generate()
             continue;
         }
 
-        values_(iat) = Spline<double>(grid_q_);
+        std::vector<double> ri(nq());
 
         auto& vloc = atom_type.local_potential();
 
@@ -342,10 +448,9 @@ void Radial_integrals_vloc<jl_deriv>::generate()
                     }
                 }
             }
-            values_(iat)(iq) = s.interpolate().integrate(0);
+            ri[iq] = s.interpolate().integrate(0);
         }
-        unit_cell_.comm().allgather(&values_(iat)(0), spl_q_.global_offset(), spl_q_.local_size());
-        values_(iat).interpolate();
+        gather_and_interpolate(iat, ri.data());
     }
 }
 
@@ -355,7 +460,6 @@ void Radial_integrals_rho_free_atom::generate()
 
     for (int iat = 0; iat < unit_cell_.num_atom_types(); iat++) {
         auto& atom_type = unit_cell_.atom_type(iat);
-        values_(iat)    = Spline<double>(grid_q_);
 
         #pragma omp parallel for
         for (int iq = 0; iq < grid_q_.num_points(); iq++) {
@@ -365,15 +469,15 @@ void Radial_integrals_rho_free_atom::generate()
                 for (int ir = 0; ir < s.num_points(); ir++) {
                     s(ir) = atom_type.free_atom_density(ir);
                 }
-                values_(iat)(iq) = s.interpolate().integrate(2);
+                values_(iat, iq) = s.interpolate().integrate(2);
             } else {
                 for (int ir = 0; ir < s.num_points(); ir++) {
                     s(ir) = atom_type.free_atom_density(ir) * std::sin(g * atom_type.free_atom_radial_grid(ir));
                 }
-                values_(iat)(iq) = s.interpolate().integrate(1);
+                values_(iat, iq) = s.interpolate().integrate(1);
             }
         }
-        values_(iat).interpolate();
+        values_.interpolate(iat, grid_q_);
     }
 }
 
@@ -25,12 +25,35 @@
 #ifndef __RADIAL_INTEGRALS_HPP__
 #define __RADIAL_INTEGRALS_HPP__
 
+#include <unistd.h>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
 #include "unit_cell/unit_cell.hpp"
 #include "specfunc/sbessel.hpp"
+#include "radial/multi_spline.hpp"
 
 namespace sirius {
 
+/// Hash of the pseudopotential data of the atom type which enters the radial integrals.
+uint64_t pseudopotential_hash(Atom_type const& atom_type__, uint64_t h__);
+
+/// Uniform q-grid on [0, qmax] with an odd number of points for the Simpson integration of the Fourier back-filter.
+std::vector<double> filter_q_grid(double qmax__);
+
+/// Fourier back-filter of the radial functions given by their radial integrals on the q-grid.
+/** Computes \f$ f_i(r) = \frac{2}{\pi} \int_{0}^{q_{max}} q^2 f_i(q) j_{\ell_i}(qr) dq \f$ on a linear radial grid
+ *  [0, rmax] with the Simpson rule. The radial integrals ri(i, iq) are given on the grid of filter_q_grid(); the
+ *  number of functions is the size of the list of their orbital quantum numbers. */
+std::vector<Spline<double>> filter_radial_functions(std::vector<double> const& qgrid__,
+                                                    sddk::mdarray<double, 2> const& ri__,
+                                                    std::vector<int> const& l__, double rmax__);
+
 /// Base class for all kinds of radial integrals.
+/** Radial integrals form an N-dimensional array of functions of q; the last dimension is always the atom type.
+ *  The interpolation tables of all integrals are packed into a single Multi_spline object. Integrals are enumerated
+ *  with the linear index of the N-dimensional array (first index runs fastest), so all integrals of a given
+ *  atom type form a contiguous range of functions which can be evaluated with a single vectorized loop. */
 template <int N>
 class Radial_integrals_base
 {
@@ -44,12 +67,154 @@ class Radial_integrals_base
     /// Split index of q-points.
     splindex<splindex_t::block> spl_q_;
 
-    /// Array with integrals.
-    sddk::mdarray<Spline<double>, N> values_;
+    /// Dimensions of the array of radial integrals.
+    std::array<int, N> dims_;
+
+    /// Packed interpolation tables of radial integrals.
+    Multi_spline<double> values_;
 
     /// Maximum length of the reciprocal wave-vector.
     double qmax_{0};
 
+    /// Allocate interpolation tables for the array of radial integrals with the given dimensions.
+    void init_values(std::array<int, N> dims__)
+    {
+        dims_ = dims__;
+        int n{1};
+        for (int i = 0; i < N; i++) {
+            n *= dims_[i];
+        }
+        values_ = Multi_spline<double>(n, grid_q_.num_points());
+    }
+
+    /// Gather the values of the function computed for the local fraction of q-points and interpolate it.
+    void gather_and_interpolate(int f__, double* y__)
+    {
+        unit_cell_.comm().allgather(y__, spl_q_.global_offset(), spl_q_.local_size());
+        values_.interpolate(f__, grid_q_, y__);
+    }
+
+    /// Linear index of the radial integral in the packed table.
+    template <typename... Args>
+    inline int func_idx(Args... args) const
+    {
+        static_assert(sizeof...(args) == N, "wrong number of indices");
+        int idx[] = {args...};
+        int f{0};
+        for (int i = N - 1; i >= 0; i--) {
+            f = f * dims_[i] + idx[i];
+        }
+        return f;
+    }
+
+    /// Name of the cache file for the interpolation tables.
+    /** The name is built from the content hash of the pseudopotentials, the q-grid and the label of the radial
+     *  integrals. Empty string is returned if the cache is disabled. */
+    std::string cache_file_name(std::string const& label__) const
+    {
+        auto& dir = unit_cell_.parameters().settings().radial_integrals_cache_;
+        if (dir.empty()) {
+            return "";
+        }
+        uint64_t h = utils::hash(label__.data(), label__.size());
+        int nq     = grid_q_.num_points();
+        h          = utils::hash(&nq, sizeof(int), h);
+        h          = utils::hash(&qmax_, sizeof(double), h);
+        h          = utils::hash(dims_.data(), N * sizeof(int), h);
+        auto& inp  = unit_cell_.parameters().parameters_input();
+        h          = utils::hash(&inp.enable_esm_, sizeof(bool), h);
+        h          = utils::hash(inp.esm_bc_.data(), inp.esm_bc_.size(), h);
+        for (int iat = 0; iat < unit_cell_.num_atom_types(); iat++) {
+            h = pseudopotential_hash(unit_cell_.atom_type(iat), h);
+        }
+        std::stringstream s;
+        s << dir << "/ri_" << label__ << "_" << std::hex << std::setw(16) << std::setfill('0') << h << ".bin";
+        return s.str();
+    }
+
+    /// Restore the interpolation tables from the cache file.
+    /** The file has a simple binary layout: a header with the number of functions and the number of q-points,
+     *  followed by the packed spline coefficients exactly as they are stored in Multi_spline. Rank 0 reads the
+     *  file and broadcasts its content, so that all ranks take the same decision.
+     *
+     *  \return True if the tables were found in the cache. */
+    bool load_from_cache(std::string const& label__)
+    {
+        auto fname = cache_file_name(label__);
+        if (fname.empty()) {
+            return false;
+        }
+
+        PROFILE("sirius::Radial_integrals|load_from_cache");
+
+        int nf = values_.num_func();
+        int nq = values_.num_points();
+
+        int found{0};
+        if (unit_cell_.comm().rank() == 0) {
+            std::ifstream ifs(fname, std::ios::binary);
+            if (ifs.good()) {
+                char magic[8];
+                int nf_in{0};
+                int nq_in{0};
+                ifs.read(magic, 8);
+                ifs.read(reinterpret_cast<char*>(&nf_in), sizeof(int));
+                ifs.read(reinterpret_cast<char*>(&nq_in), sizeof(int));
+                if (ifs.good() && std::string(magic, 8) == "SIRIUSRI" && nf_in == nf && nq_in == nq) {
+                    ifs.read(reinterpret_cast<char*>(values_.coeffs().at(memory_t::host)),
+                             values_.coeffs().size() * sizeof(double));
+                    found = ifs.good() ? 1 : 0;
+                }
+            }
+        }
+        unit_cell_.comm().bcast(&found, 1, 0);
+        if (!found) {
+            return false;
+        }
+        unit_cell_.comm().bcast(values_.coeffs().at(memory_t::host), static_cast<int>(values_.coeffs().size()), 0);
+        return true;
+    }
+
+    /// Store the interpolation tables in the cache file.
+    /** The file is written under a temporary name and renamed, so concurrent jobs never see a partial file. */
+    void save_to_cache(std::string const& label__) const
+    {
+        auto fname = cache_file_name(label__);
+        if (fname.empty() || unit_cell_.comm().rank() != 0) {
+            return;
+        }
+
+        PROFILE("sirius::Radial_integrals|save_to_cache");
+
+        int nf = values_.num_func();
+        int nq = values_.num_points();
+
+        auto tmp = fname + "." + std::to_string(getpid());
+        {
+            std::ofstream ofs(tmp, std::ios::binary);
+            ofs.write("SIRIUSRI", 8);
+            ofs.write(reinterpret_cast<char const*>(&nf), sizeof(int));
+            ofs.write(reinterpret_cast<char const*>(&nq), sizeof(int));
+            ofs.write(reinterpret_cast<char const*>(values_.coeffs().at(memory_t::host)),
+                      values_.coeffs().size() * sizeof(double));
+            if (!ofs.good()) {
+                std::remove(tmp.c_str());
+                return;
+            }
+        }
+        std::rename(tmp.c_str(), fname.c_str());
+    }
+
+    /// Load the interpolation tables from the cache or generate and store them.
+    template <typename F>
+    void generate_cached(std::string const& label__, F&& generate__)
+    {
+        if (!load_from_cache(label__)) {
+            generate__();
+            save_to_cache(label__);
+        }
+    }
+
   public:
     /// Constructor.
     Radial_integrals_base(Unit_cell const& unit_cell__, double const qmax__, int const np__)
@@ -90,7 +255,37 @@ class Radial_integrals_base
     inline double value(Args... args, double q__) const
     {
         auto idx = iqdq(q__);
-        return values_(args...)(idx.first, idx.second);
+        return values_(func_idx(args...), idx.first, idx.second);
+    }
+
+    /// Number of radial integrals per atom type.
+    inline int num_func_per_type() const
+    {
+        return values_.num_func() / dims_[N - 1];
+    }
+
+    /// Evaluate all radial integrals of a given atom type at a given q-point.
+    /** The result is stored in the array of size num_func_per_type(). */
+    inline void values(int iat__, double q__, double* val__) const
+    {
+        auto idx = iqdq(q__);
+        int n    = num_func_per_type();
+        values_(iat__ * n, n, idx.first, idx.second, val__);
+    }
+
+    /// Evaluate all radial integrals of a given atom type for a batch of q-points.
+    /** The result for the j-th q-point is stored at val[j * ld]. */
+    void values(int iat__, int nq__, double const* q__, double* val__, int ld__) const
+    {
+        std::vector<int> iq(nq__);
+        std::vector<double> dq(nq__);
+        for (int j = 0; j < nq__; j++) {
+            auto idx = iqdq(q__[j]);
+            iq[j]    = idx.first;
+            dq[j]    = idx.second;
+        }
+        int n = num_func_per_type();
+        values_(iat__ * n, n, nq__, iq.data(), dq.data(), val__, ld__);
     }
 
     inline int nq() const
@@ -130,28 +325,19 @@ class Radial_integrals_atomic_wf : public Radial_integrals_base<2>
             }
         }
 
-        values_ = sddk::mdarray<Spline<double>, 2>(nrf_max_, unit_cell_.num_atom_types());
+        init_values({nrf_max_, unit_cell_.num_atom_types()});
 
-        generate();
+        generate_cached(std::string(hubbard_ ? "hubbard_wf" : "atomic_wf") + (jl_deriv ? "_djl" : ""),
+                        [this]() { generate(); });
     }
 
-    /// retrieve a given orbital from an atom type
-    inline Spline<double> const& values(int iwf__, int iat__) const
-    {
-        return values_(iwf__, iat__);
-    }
+    using Radial_integrals_base<2>::values;
 
     /// Get all values for a given atom type and q-point.
     inline sddk::mdarray<double, 1> values(int iat__, double q__) const
     {
-        auto idx        = iqdq(q__);
-        auto& atom_type = unit_cell_.atom_type(iat__);
-        int nrf         = (hubbard_) ? atom_type.indexr_hub().size() : atom_type.indexr_wfs().size();
-
-        sddk::mdarray<double, 1> val(nrf);
-        for (int i = 0; i < nrf; i++) {
-            val(i) = values_(i, iat__)(idx.first, idx.second);
-        }
+        sddk::mdarray<double, 1> val(nrf_max_);
+        values(iat__, q__, val.at(memory_t::host));
         return val;
     }
 };
@@ -175,9 +361,9 @@ class Radial_integrals_aug : public Radial_integrals_base<3>
             int nmax = unit_cell_.max_mt_radial_basis_size();
             int lmax = unit_cell_.lmax();
 
-            values_ = sddk::mdarray<Spline<double>, 3>(nmax * (nmax + 1) / 2, 2 * lmax + 1, unit_cell_.num_atom_types());
+            init_values({nmax * (nmax + 1) / 2, 2 * lmax + 1, unit_cell_.num_atom_types()});
 
-            generate();
+            generate_cached(jl_deriv ? "aug_djl" : "aug", [this]() { generate(); });
         }
     }
 
@@ -190,11 +376,13 @@ class Radial_integrals_aug : public Radial_integrals_base<3>
         sddk::mdarray<double, 2> val(nbrf * (nbrf + 1) / 2, 2 * lmax + 1);
 
         if (ri_callback_ == nullptr) {
-            auto idx = iqdq(q__);
+            /* evaluate all integrals of the atom type and pick the ones of this atom type */
+            std::vector<double> tmp(num_func_per_type());
+            Radial_integrals_base<3>::values(iat__, q__, tmp.data());
 
             for (int l = 0; l <= 2 * lmax; l++) {
                 for (int i = 0; i < nbrf * (nbrf + 1) / 2; i++) {
-                    val(i, l) = values_(i, l, iat__)(idx.first, idx.second);
+                    val(i, l) = tmp[i + dims_[0] * l];
                 }
             }
         } else {
@@ -202,6 +390,37 @@ class Radial_integrals_aug : public Radial_integrals_base<3>
         }
         return val;
     }
+
+    /// Get the radial integrals of a given atom type for a batch of q-points.
+    /** The result has the dimensions (nbrf * (nbrf + 1) / 2, 2 * lmax + 1, nq). */
+    inline sddk::mdarray<double, 3> values(int iat__, int nq__, double const* q__) const
+    {
+        auto& atom_type = unit_cell_.atom_type(iat__);
+        int lmax        = atom_type.indexr().lmax();
+        int nbrf        = atom_type.mt_radial_basis_size();
+
+        sddk::mdarray<double, 3> val(nbrf * (nbrf + 1) / 2, 2 * lmax + 1, nq__);
+
+        if (ri_callback_ == nullptr) {
+            int n = num_func_per_type();
+            sddk::mdarray<double, 2> tmp(n, nq__);
+            Radial_integrals_base<3>::values(iat__, nq__, q__, tmp.at(memory_t::host), n);
+
+            #pragma omp parallel for schedule(static)
+            for (int j = 0; j < nq__; j++) {
+                for (int l = 0; l <= 2 * lmax; l++) {
+                    for (int i = 0; i < nbrf * (nbrf + 1) / 2; i++) {
+                        val(i, l, j) = tmp(i + dims_[0] * l, j);
+                    }
+                }
+            }
+        } else {
+            for (int j = 0; j < nq__; j++) {
+                ri_callback_(iat__ + 1, q__[j], &val(0, 0, j), nbrf * (nbrf + 1) / 2, 2 * lmax + 1);
+            }
+        }
+        return val;
+    }
 };
 
 
@@ -214,14 +433,14 @@ class Radial_integrals_rho_pseudo : public Radial_integrals_base<1>
     Radial_integrals_rho_pseudo(Unit_cell const& unit_cell__, double qmax__, int np__)
         : Radial_integrals_base<1>(unit_cell__, qmax__, np__)
     {
-        values_ = mdarray<Spline<double>, 1>(unit_cell_.num_atom_types());
-        generate();
+        init_values({unit_cell_.num_atom_types()});
+        generate_cached("rho_pseudo", [this]() { generate(); });
 
         if (unit_cell_.parameters().control().print_checksum_ && unit_cell_.comm().rank() == 0) {
             double cs{0};
             for (int iat = 0; iat < unit_cell_.num_atom_types(); iat++) {
                 for (int iq = 0; iq < grid_q_.num_points(); iq++) {
-                    cs += values_(iat)(iq);
+                    cs += values_(iat, iq);
                 }
             }
             utils::print_checksum("Radial_integrals_rho_pseudo", cs);
@@ -240,8 +459,8 @@ class Radial_integrals_rho_core_pseudo : public Radial_integrals_base<1>
     Radial_integrals_rho_core_pseudo(Unit_cell const& unit_cell__, double qmax__, int np__)
         : Radial_integrals_base<1>(unit_cell__, qmax__, np__)
     {
-        values_ = mdarray<Spline<double>, 1>(unit_cell_.num_atom_types());
-        generate();
+        init_values({unit_cell_.num_atom_types()});
+        generate_cached(jl_deriv ? "rho_core_pseudo_djl" : "rho_core_pseudo", [this]() { generate(); });
     }
 };
 
@@ -264,24 +483,39 @@ class Radial_integrals_beta : public Radial_integrals_base<2>
     {
         if (ri_callback_ == nullptr) {
             /* create space for <j_l(qr)|beta> or <d j_l(qr) / dq|beta> radial integrals */
-            values_ = mdarray<Spline<double>, 2>(unit_cell_.max_mt_radial_basis_size(), unit_cell_.num_atom_types());
-            generate();
+            init_values({unit_cell_.max_mt_radial_basis_size(), unit_cell_.num_atom_types()});
+            generate_cached(jl_deriv ? "beta_djl" : "beta", [this]() { generate(); });
         }
     }
 
     /// Get all values for a given atom type and q-point.
-    inline sddk::mdarray<double, 1> values(int iat__, double q__) const
+    /** The array must have the size of at least max_mt_radial_basis_size(). */
+    inline void values(int iat__, double q__, double* val__) const
     {
-        auto& atom_type = unit_cell_.atom_type(iat__);
-        sddk::mdarray<double, 1> val(atom_type.mt_radial_basis_size());
         if (ri_callback_ == nullptr) {
-            auto idx = iqdq(q__);
-            for (int i = 0; i < atom_type.mt_radial_basis_size(); i++) {
-                val(i) = values_(i, iat__)(idx.first, idx.second);
-            }
+            Radial_integrals_base<2>::values(iat__, q__, val__);
         } else {
-            ri_callback_(iat__ + 1, q__, &val[0], atom_type.mt_radial_basis_size());
+            ri_callback_(iat__ + 1, q__, val__, unit_cell_.atom_type(iat__).mt_radial_basis_size());
         }
+    }
+
+    /// Get all values for a given atom type and a batch of q-points.
+    void values(int iat__, int nq__, double const* q__, double* val__, int ld__) const
+    {
+        if (ri_callback_ == nullptr) {
+            Radial_integrals_base<2>::values(iat__, nq__, q__, val__, ld__);
+        } else {
+            for (int j = 0; j < nq__; j++) {
+                ri_callback_(iat__ + 1, q__[j], &val__[j * ld__], unit_cell_.atom_type(iat__).mt_radial_basis_size());
+            }
+        }
+    }
+
+    /// Get all values for a given atom type and q-point.
+    inline sddk::mdarray<double, 1> values(int iat__, double q__) const
+    {
+        sddk::mdarray<double, 1> val(unit_cell_.max_mt_radial_basis_size());
+        values(iat__, q__, val.at(memory_t::host));
         return val;
     }
 };
@@ -317,8 +551,8 @@ class Radial_integrals_vloc : public Radial_integrals_base<1>
     Radial_integrals_vloc(Unit_cell const& unit_cell__, double qmax__, int np__)
         : Radial_integrals_base<1>(unit_cell__, qmax__, np__)
     {
-        values_ = mdarray<Spline<double>, 1>(unit_cell_.num_atom_types());
-        generate();
+        init_values({unit_cell_.num_atom_types()});
+        generate_cached(jl_deriv ? "vloc_djl" : "vloc", [this]() { generate(); });
     }
 
     /// Special implementation to recover the true radial integral value.
@@ -329,7 +563,7 @@ class Radial_integrals_vloc : public Radial_integrals_base<1>
             if (jl_deriv) {
                 return 0;
             } else {
-                return values_(iat__)(0);
+                return values_(iat__, 0);
             }
         } else {
             auto& atom_type = unit_cell_.atom_type(iat__);
@@ -338,17 +572,17 @@ class Radial_integrals_vloc : public Radial_integrals_base<1>
             if (jl_deriv) {
                 if (!unit_cell_.parameters().parameters_input().enable_esm_ ||
                     unit_cell_.parameters().parameters_input().esm_bc_ == "pbc") {
-                    return values_(iat__)(idx.first, idx.second) / q2 / q__ -
+                    return values_(iat__, idx.first, idx.second) / q2 / q__ -
                            atom_type.zn() * std::exp(-q2 / 4) * (4 + q2) / 2 / q2 / q2;
                 } else {
-                    return values_(iat__)(idx.first, idx.second) / q2 / q__;
+                    return values_(iat__, idx.first, idx.second) / q2 / q__;
                 }
             } else {
                 if (!unit_cell_.parameters().parameters_input().enable_esm_ ||
                     unit_cell_.parameters().parameters_input().esm_bc_ == "pbc") {
-                    return values_(iat__)(idx.first, idx.second) / q__ - atom_type.zn() * std::exp(-q2 / 4) / q2;
+                    return values_(iat__, idx.first, idx.second) / q__ - atom_type.zn() * std::exp(-q2 / 4) / q2;
                 } else {
-                    return values_(iat__)(idx.first, idx.second) / q__;
+                    return values_(iat__, idx.first, idx.second) / q__;
                 }
             }
         }
@@ -365,8 +599,8 @@ class Radial_integrals_rho_free_atom : public Radial_integrals_base<1>
     Radial_integrals_rho_free_atom(Unit_cell const& unit_cell__, double qmax__, int np__)
         : Radial_integrals_base<1>(unit_cell__, qmax__, np__)
     {
-        values_ = mdarray<Spline<double>, 1>(unit_cell_.num_atom_types());
-        generate();
+        init_values({unit_cell_.num_atom_types()});
+        generate_cached("rho_free_atom", [this]() { generate(); });
     }
 
     /// Special implementation to recover the true radial integral value.
@@ -374,9 +608,9 @@ class Radial_integrals_rho_free_atom : public Radial_integrals_base<1>
     {
         auto idx = iqdq(q__);
         if (std::abs(q__) < 1e-12) {
-            return values_(iat__)(0);
+            return values_(iat__, 0);
         } else {
-            return values_(iat__)(idx.first, idx.second) / q__;
+            return values_(iat__, idx.first, idx.second) / q__;
         }
     }
 };
@@ -602,6 +602,11 @@ class Spline : public Radial_grid<U>
         return coeffs_;
     }
 
+    inline sddk::mdarray<T, 2>& coeffs()
+    {
+        return coeffs_;
+    }
+
     //void copy_to_device()
     //{
     //    // Radial_grid<U>::copy_to_device();
@@ -25,6 +25,8 @@
 #ifndef __GAUNT_HPP__
 #define __GAUNT_HPP__
 
+#include <array>
+#include <numeric>
 #include "memory.hpp"
 #include "typedefs.hpp"
 #include "utils/utils.hpp"
@@ -51,9 +53,127 @@ struct gaunt_L1_L2
     T   coef;
 };
 
+/// Sum over L3 of the Gaunt coefficients multiplied by the vector elements.
+/** The coefficients and their lm3 indices are stored contiguously; the loop is vectorized with separate
+ *  accumulators for the real and imaginary parts. */
+inline double gaunt_sum_L3(int n__, int const* lm3__, double const* coef__, double const* v__)
+{
+    double sum{0};
+    #pragma omp simd reduction(+:sum)
+    for (int k = 0; k < n__; k++) {
+        sum += coef__[k] * v__[lm3__[k]];
+    }
+    return sum;
+}
+
+inline double_complex gaunt_sum_L3(int n__, int const* lm3__, double const* coef__, double_complex const* v__)
+{
+    double re{0};
+    double im{0};
+    #pragma omp simd reduction(+:re, im)
+    for (int k = 0; k < n__; k++) {
+        re += coef__[k] * v__[lm3__[k]].real();
+        im += coef__[k] * v__[lm3__[k]].imag();
+    }
+    return double_complex(re, im);
+}
+
+inline double_complex gaunt_sum_L3(int n__, int const* lm3__, double_complex const* coef__, double const* v__)
+{
+    double re{0};
+    double im{0};
+    #pragma omp simd reduction(+:re, im)
+    for (int k = 0; k < n__; k++) {
+        re += coef__[k].real() * v__[lm3__[k]];
+        im += coef__[k].imag() * v__[lm3__[k]];
+    }
+    return double_complex(re, im);
+}
+
+inline double_complex gaunt_sum_L3(int n__, int const* lm3__, double_complex const* coef__,
+                                   double_complex const* v__)
+{
+    double re{0};
+    double im{0};
+    #pragma omp simd reduction(+:re, im)
+    for (int k = 0; k < n__; k++) {
+        auto c = coef__[k];
+        auto v = v__[lm3__[k]];
+        re += c.real() * v.real() - c.imag() * v.imag();
+        im += c.real() * v.imag() + c.imag() * v.real();
+    }
+    return double_complex(re, im);
+}
+
+/// Non-zero Gaunt coefficients of a single {lm1, lm2} pair.
+/** This is a light-weight view of one row in the compressed storage of Gaunt_coefficients. The entries can be
+ *  accessed as {lm3, l3, coef} structures or as contiguous arrays of lm3 indices and coefficients. */
+template <typename T>
+class gaunt_L3_row
+{
+  private:
+    gaunt_L3<T> const* g_{nullptr};
+    int const* lm3_{nullptr};
+    T const* coef_{nullptr};
+    int size_{0};
+
+  public:
+    gaunt_L3_row(gaunt_L3<T> const* g__, int const* lm3__, T const* coef__, int size__)
+        : g_(g__)
+        , lm3_(lm3__)
+        , coef_(coef__)
+        , size_(size__)
+    {
+    }
+
+    /// Number of non-zero coefficients.
+    inline int size() const
+    {
+        return size_;
+    }
+
+    inline gaunt_L3<T> const& operator[](int i__) const
+    {
+        assert(i__ >= 0 && i__ < size_);
+        return g_[i__];
+    }
+
+    inline gaunt_L3<T> const* begin() const
+    {
+        return g_;
+    }
+
+    inline gaunt_L3<T> const* end() const
+    {
+        return g_ + size_;
+    }
+
+    /// Contiguous array of lm3 indices.
+    inline int const* lm3() const
+    {
+        return lm3_;
+    }
+
+    /// Contiguous array of coefficients.
+    inline T const* coef() const
+    {
+        return coef_;
+    }
+
+    /// Return \f$ \sum_{k} c_k v_{\ell_3 m_3(k)} \f$.
+    template <typename V>
+    inline auto sum(V const* v__) const -> decltype(T{} * V{})
+    {
+        return gaunt_sum_L3(size_, lm3_, coef_, v__);
+    }
+};
+
 /// Compact storage of non-zero Gaunt coefficients \f$ \langle \ell_1 m_1 | \ell_3 m_3 | \ell_2 m_2 \rangle \f$.
 /** Very important! The following notation is adopted and used everywhere: lm1 and lm2 represent 'bra' and 'ket' 
  *  spherical harmonics of the Gaunt integral and lm3 represent the inner spherical harmonic. 
+ *
+ *  Non-zero coefficients are kept in the compressed sparse row (CSR) format: all entries are stored in a single
+ *  contiguous array and the entries of each {lm1, lm2} pair (or each lm3) are addressed by the row offsets.
  */
 template <typename T>
 class Gaunt_coefficients
@@ -74,11 +194,30 @@ class Gaunt_coefficients
     /// lmmax of |lm2>
     int lmmax2_;
 
-    /// List of non-zero Gaunt coefficients for each lm3.
-    mdarray<std::vector<gaunt_L1_L2<T>>, 1> gaunt_packed_L1_L2_;
+    /// Offsets of the rows for each lm3 in the array of {lm1, lm2, coef} entries.
+    std::vector<int> row_ptr_L1_L2_;
+
+    /// Non-zero Gaunt coefficients grouped by lm3.
+    std::vector<gaunt_L1_L2<T>> gaunt_L1_L2_;
+
+    /// Offsets of the rows for each {lm1, lm2} pair (row index is lm1 + lmmax1 * lm2).
+    std::vector<int> row_ptr_L3_;
 
-    /// List of non-zero Gaunt coefficients for each combination of lm1, lm2.
-    mdarray<std::vector<gaunt_L3<T>>, 2> gaunt_packed_L3_;
+    /// Non-zero Gaunt coefficients grouped by {lm1, lm2}.
+    std::vector<gaunt_L3<T>> gaunt_L3_;
+
+    /// lm3 indices of gaunt_L3_ entries stored contiguously.
+    std::vector<int> lm3_L3_;
+
+    /// Coefficients of gaunt_L3_ entries stored contiguously.
+    std::vector<T> coef_L3_;
+
+    inline int idx_L3(int lm1__, int lm2__) const
+    {
+        assert(lm1__ >= 0 && lm1__ < lmmax1_);
+        assert(lm2__ >= 0 && lm2__ < lmmax2_);
+        return lm1__ + lmmax1_ * lm2__;
+    }
 
   public:
     /// Class constructor.
@@ -94,11 +233,9 @@ class Gaunt_coefficients
         lmmax3_ = utils::lmmax(lmax3_);
         lmmax2_ = utils::lmmax(lmax2_);
 
-        gaunt_packed_L1_L2_ = mdarray<std::vector<gaunt_L1_L2<T>>, 1>(lmmax3_);
-        gaunt_L1_L2<T> g12;
-
-        gaunt_packed_L3_ = mdarray<std::vector<gaunt_L3<T>>, 2>(lmmax1_, lmmax2_);
-        gaunt_L3<T> g3;
+        /* non-zero coefficients in the order of generation: {lm1, lm2, lm3} */
+        std::vector<std::array<int, 4>> idx;
+        std::vector<T> val;
 
         for (int l1 = 0, lm1 = 0; l1 <= lmax1_; l1++) {
             for (int m1 = -l1; m1 <= l1; m1++, lm1++) {
@@ -109,15 +246,8 @@ class Gaunt_coefficients
 
                                 T gc = get__(l1, l3, l2, m1, m3, m2);
                                 if (std::abs(gc) > 1e-12) {
-                                    g12.lm1  = lm1;
-                                    g12.lm2  = lm2;
-                                    g12.coef = gc;
-                                    gaunt_packed_L1_L2_[lm3].push_back(g12);
-
-                                    g3.lm3  = lm3;
-                                    g3.l3   = l3;
-                                    g3.coef = gc;
-                                    gaunt_packed_L3_(lm1, lm2).push_back(g3);
+                                    idx.push_back({lm1, lm2, lm3, l3});
+                                    val.push_back(gc);
                                 }
                             }
                         }
@@ -125,13 +255,45 @@ class Gaunt_coefficients
                 }
             }
         }
+        int nnz = static_cast<int>(val.size());
+
+        /* counting sort of the entries into rows; the order of entries inside a row is preserved */
+        row_ptr_L1_L2_ = std::vector<int>(lmmax3_ + 1, 0);
+        row_ptr_L3_    = std::vector<int>(lmmax1_ * lmmax2_ + 1, 0);
+        for (int i = 0; i < nnz; i++) {
+            row_ptr_L1_L2_[idx[i][2] + 1]++;
+            row_ptr_L3_[idx_L3(idx[i][0], idx[i][1]) + 1]++;
+        }
+        std::partial_sum(row_ptr_L1_L2_.begin(), row_ptr_L1_L2_.end(), row_ptr_L1_L2_.begin());
+        std::partial_sum(row_ptr_L3_.begin(), row_ptr_L3_.end(), row_ptr_L3_.begin());
+
+        gaunt_L1_L2_ = std::vector<gaunt_L1_L2<T>>(nnz);
+        gaunt_L3_    = std::vector<gaunt_L3<T>>(nnz);
+        lm3_L3_      = std::vector<int>(nnz);
+        coef_L3_     = std::vector<T>(nnz);
+
+        auto pos_L1_L2 = row_ptr_L1_L2_;
+        auto pos_L3    = row_ptr_L3_;
+        for (int i = 0; i < nnz; i++) {
+            int j = pos_L1_L2[idx[i][2]]++;
+            gaunt_L1_L2_[j].lm1  = idx[i][0];
+            gaunt_L1_L2_[j].lm2  = idx[i][1];
+            gaunt_L1_L2_[j].coef = val[i];
+
+            j = pos_L3[idx_L3(idx[i][0], idx[i][1])]++;
+            gaunt_L3_[j].lm3  = idx[i][2];
+            gaunt_L3_[j].l3   = idx[i][3];
+            gaunt_L3_[j].coef = val[i];
+            lm3_L3_[j]        = idx[i][2];
+            coef_L3_[j]       = val[i];
+        }
     }
 
     /// Return number of non-zero Gaunt coefficients for a given lm3.
     inline int num_gaunt(int lm3) const
     {
         assert(lm3 >= 0 && lm3 < lmmax3_);
-        return static_cast<int>(gaunt_packed_L1_L2_[lm3].size());
+        return row_ptr_L1_L2_[lm3 + 1] - row_ptr_L1_L2_[lm3];
     }
 
     /// Return a structure containing {lm1, lm2, coef} for a given lm3 and index.
@@ -152,20 +314,22 @@ class Gaunt_coefficients
     inline gaunt_L1_L2<T> const& gaunt(int lm3, int idx) const
     {
         assert(lm3 >= 0 && lm3 < lmmax3_);
-        assert(idx >= 0 && idx < (int)gaunt_packed_L1_L2_[lm3].size());
-        return gaunt_packed_L1_L2_[lm3][idx];
+        assert(idx >= 0 && idx < num_gaunt(lm3));
+        return gaunt_L1_L2_[row_ptr_L1_L2_[lm3] + idx];
     }
 
     /// Return number of non-zero Gaunt coefficients for a combination of lm1 and lm2.
     inline int num_gaunt(int lm1, int lm2) const
     {
-        return static_cast<int>(gaunt_packed_L3_(lm1, lm2).size());
+        int i = idx_L3(lm1, lm2);
+        return row_ptr_L3_[i + 1] - row_ptr_L3_[i];
     }
 
     /// Return a structure containing {lm3, coef} for a given lm1, lm2 and index
     inline gaunt_L3<T> const& gaunt(int lm1, int lm2, int idx) const
     {
-        return gaunt_packed_L3_(lm1, lm2)[idx];
+        assert(idx >= 0 && idx < num_gaunt(lm1, lm2));
+        return gaunt_L3_[row_ptr_L3_[idx_L3(lm1, lm2)] + idx];
     }
 
     /// Return a sum over L3 (lm3) index of Gaunt coefficients and a complex vector.
@@ -177,11 +341,7 @@ class Gaunt_coefficients
      */
     inline double_complex sum_L3_gaunt(int lm1, int lm2, double_complex const* v) const
     {
-        double_complex zsum(0, 0);
-        for (int k = 0; k < (int)gaunt_packed_L3_(lm1, lm2).size(); k++) {
-            zsum += gaunt_packed_L3_(lm1, lm2)[k].coef * v[gaunt_packed_L3_(lm1, lm2)[k].lm3];
-        }
-        return zsum;
+        return gaunt_vector(lm1, lm2).sum(v);
     }
 
     /// Return a sum over L3 (lm3) index of Gaunt coefficients and a real vector.
@@ -193,17 +353,16 @@ class Gaunt_coefficients
      */
     inline T sum_L3_gaunt(int lm1, int lm2, double const* v) const
     {
-        T sum = 0;
-        for (int k = 0; k < (int)gaunt_packed_L3_(lm1, lm2).size(); k++) {
-            sum += gaunt_packed_L3_(lm1, lm2)[k].coef * v[gaunt_packed_L3_(lm1, lm2)[k].lm3];
-        }
-        return sum;
+        return gaunt_vector(lm1, lm2).sum(v);
     }
 
-    /// Return vector of non-zero Gaunt coefficients for a given combination of lm1 and lm2
-    inline std::vector<gaunt_L3<T>> const& gaunt_vector(int lm1, int lm2) const
+    /// Return non-zero Gaunt coefficients for a given combination of lm1 and lm2
+    inline gaunt_L3_row<T> gaunt_vector(int lm1, int lm2) const
     {
-        return gaunt_packed_L3_(lm1, lm2);
+        int i  = idx_L3(lm1, lm2);
+        int i0 = row_ptr_L3_[i];
+        return gaunt_L3_row<T>(gaunt_L3_.data() + i0, lm3_L3_.data() + i0, coef_L3_.data() + i0,
+                               row_ptr_L3_[i + 1] - i0);
     }
 
     inline sddk::mdarray<T, 3> get_full_set_L3() const
@@ -212,9 +371,8 @@ class Gaunt_coefficients
         gc.zero();
         for (int lm2 = 0; lm2 < lmmax2_; lm2++) {
             for (int lm1 = 0; lm1 < lmmax1_; lm1++) {
-                for (int k = 0; k < (int)gaunt_packed_L3_(lm1, lm2).size(); k++) {
-                    int lm3 = gaunt_packed_L3_(lm1, lm2)[k].lm3;
-                    gc(lm3, lm1, lm2) = gaunt_packed_L3_(lm1, lm2)[k].coef;
+                for (auto& g : gaunt_vector(lm1, lm2)) {
+                    gc(g.lm3, lm1, lm2) = g.coef;
                 }
             }
         }
@@ -227,6 +227,198 @@ class SHT // TODO: better name
     template <typename T>
     void forward_transform(T const* ftp, int nr, int lmmax, int ld, T* flm) const;
 
+    /// Perform a backward transformation of a batch of functions defined on the same radial grid.
+    /** The coefficients of the functions are gathered into a contiguous array and all functions are transformed
+     *  with a single GEMM instead of one small GEMM per function.
+     *
+     *  \param [in]  ld    Size of leading dimension of each flm.
+     *  \param [in]  flm   Raw pointers to \f$ f_{\ell m}(r) \f$ of the functions.
+     *  \param [in]  nr    Number of radial points.
+     *  \param [in]  lmmax Maximum number of lm- harmonics to take into sum.
+     *  \param [out] ftp   Raw pointer to \f$ f(\theta, \phi, r) \f$ of all functions, stored one after another.
+     */
+    template <typename T>
+    void backward_transform(int ld, std::vector<T const*> const& flm, int nr, int lmmax, T* ftp) const
+    {
+        int n = static_cast<int>(flm.size());
+        sddk::mdarray<T, 3> tmp(lmmax, nr, n);
+        #pragma omp parallel for schedule(static)
+        for (int i = 0; i < n; i++) {
+            for (int ir = 0; ir < nr; ir++) {
+                std::copy(flm[i] + ir * ld, flm[i] + ir * ld + lmmax, &tmp(0, ir, i));
+            }
+        }
+        backward_transform(lmmax, tmp.at(sddk::memory_t::host), nr * n, lmmax, ftp);
+    }
+
+    /// Perform a forward transformation of a batch of functions defined on the same radial grid.
+    /** All functions are transformed with a single GEMM and the coefficients are scattered to the output.
+     *
+     *  \param [in]  ftp   Raw pointer to \f$ f(\theta, \phi, r) \f$ of all functions, stored one after another.
+     *  \param [in]  nr    Number of radial points.
+     *  \param [in]  lmmax Maximum number of lm- coefficients to generate.
+     *  \param [in]  ld    Size of leading dimension of each flm.
+     *  \param [out] flm   Raw pointers to \f$ f_{\ell m}(r) \f$ of the functions.
+     */
+    template <typename T>
+    void forward_transform(T const* ftp, int nr, int lmmax, int ld, std::vector<T*> const& flm) const
+    {
+        int n = static_cast<int>(flm.size());
+        sddk::mdarray<T, 3> tmp(lmmax, nr, n);
+        forward_transform(ftp, nr * n, lmmax, lmmax, tmp.at(sddk::memory_t::host));
+        #pragma omp parallel for schedule(static)
+        for (int i = 0; i < n; i++) {
+            for (int ir = 0; ir < nr; ir++) {
+                std::copy(&tmp(0, ir, i), &tmp(0, ir, i) + lmmax, flm[i] + ir * ld);
+            }
+        }
+    }
+
+    /// Range of radial points sharing the same number of angular harmonics.
+    struct radial_shell_t
+    {
+        /// First radial point of the shell.
+        int ir_begin;
+        /// End (one past the last) radial point of the shell.
+        int ir_end;
+        /// Number of lm- harmonics in the shell.
+        int lmmax;
+    };
+
+    /// Group consecutive radial points with the same number of angular harmonics into shells.
+    static std::vector<radial_shell_t> radial_shells(std::vector<int> const& lmmax_r__)
+    {
+        std::vector<radial_shell_t> shells;
+        for (int ir = 0; ir < static_cast<int>(lmmax_r__.size()); ir++) {
+            if (shells.empty() || shells.back().lmmax != lmmax_r__[ir]) {
+                shells.push_back({ir, ir + 1, lmmax_r__[ir]});
+            } else {
+                shells.back().ir_end = ir + 1;
+            }
+        }
+        return shells;
+    }
+
+    /// Perform a backward transformation of a batch of functions with a radially dependent angular expansion.
+    /** Harmonics above the lmmax of the shell are ignored. Each shell is transformed with a single GEMM.
+     *
+     *  \param [in]  ld     Size of leading dimension of each flm.
+     *  \param [in]  flm    Raw pointers to \f$ f_{\ell m}(r) \f$ of the functions.
+     *  \param [in]  shells Radial shells covering all radial points.
+     *  \param [out] ftp    Raw pointer to \f$ f(\theta, \phi, r) \f$ of all functions, stored one after another.
+     */
+    template <typename T>
+    void backward_transform(int ld, std::vector<T const*> const& flm, std::vector<radial_shell_t> const& shells,
+                            T* ftp) const
+    {
+        int nr = shells.back().ir_end;
+        if (shells.size() == 1) {
+            backward_transform(ld, flm, nr, shells[0].lmmax, ftp);
+            return;
+        }
+        int n = static_cast<int>(flm.size());
+        for (auto& sh : shells) {
+            int nrs = sh.ir_end - sh.ir_begin;
+            std::vector<T const*> ptr(n);
+            for (int i = 0; i < n; i++) {
+                ptr[i] = flm[i] + sh.ir_begin * ld;
+            }
+            sddk::mdarray<T, 3> tmp(num_points_, nrs, n);
+            backward_transform(ld, ptr, nrs, sh.lmmax, tmp.at(sddk::memory_t::host));
+            #pragma omp parallel for schedule(static)
+            for (int i = 0; i < n; i++) {
+                std::copy(&tmp(0, 0, i), &tmp(0, 0, i) + num_points_ * nrs,
+                          ftp + (static_cast<size_t>(i) * nr + sh.ir_begin) * num_points_);
+            }
+        }
+    }
+
+    /// Perform a forward transformation of a batch of functions with a radially dependent angular expansion.
+    /** In each shell only the harmonics up to the lmmax of the shell are computed; the rest are set to zero.
+     *
+     *  \param [in]  ftp    Raw pointer to \f$ f(\theta, \phi, r) \f$ of all functions, stored one after another.
+     *  \param [in]  shells Radial shells covering all radial points.
+     *  \param [in]  lmmax  Maximum number of lm- coefficients to generate.
+     *  \param [in]  ld     Size of leading dimension of each flm.
+     *  \param [out] flm    Raw pointers to \f$ f_{\ell m}(r) \f$ of the functions.
+     */
+    template <typename T>
+    void forward_transform(T const* ftp, std::vector<radial_shell_t> const& shells, int lmmax, int ld,
+                           std::vector<T*> const& flm) const
+    {
+        int nr = shells.back().ir_end;
+        if (shells.size() == 1 && shells[0].lmmax >= lmmax) {
+            forward_transform(ftp, nr, lmmax, ld, flm);
+            return;
+        }
+        int n = static_cast<int>(flm.size());
+        for (auto& sh : shells) {
+            int nrs = sh.ir_end - sh.ir_begin;
+            int lmmax_s = std::min(lmmax, sh.lmmax);
+            sddk::mdarray<T, 3> tmp(num_points_, nrs, n);
+            #pragma omp parallel for schedule(static)
+            for (int i = 0; i < n; i++) {
+                auto src = ftp + (static_cast<size_t>(i) * nr + sh.ir_begin) * num_points_;
+                std::copy(src, src + num_points_ * nrs, &tmp(0, 0, i));
+            }
+            std::vector<T*> ptr(n);
+            for (int i = 0; i < n; i++) {
+                ptr[i] = flm[i] + sh.ir_begin * ld;
+            }
+            forward_transform(tmp.at(sddk::memory_t::host), nrs, lmmax_s, ld, ptr);
+            #pragma omp parallel for schedule(static)
+            for (int i = 0; i < n; i++) {
+                for (int ir = 0; ir < nrs; ir++) {
+                    std::fill(ptr[i] + ir * ld + lmmax_s, ptr[i] + ir * ld + lmmax, 0);
+                }
+            }
+        }
+    }
+
+    /// Select the number of angular harmonics for each radial point of a function.
+    /** For each radial point the smallest \f$ (\ell+1)^2 \f$ is found such that all harmonics with higher
+     *  \f$ \ell \f$ are below the tolerance relative to the spherical component. The result is made non-decreasing
+     *  in r, so the angular expansion is reduced only towards the nucleus.
+     *
+     *  \param [in] ld    Size of leading dimension of flm.
+     *  \param [in] flm   Raw pointer to \f$ f_{\ell m}(r) \f$.
+     *  \param [in] nr    Number of radial points.
+     *  \param [in] lmmax Number of lm- harmonics of the function.
+     *  \param [in] tol   Relative tolerance.
+     *  \param [in] fref  Raw pointer to the reference function with the same leading dimension, whose spherical
+     *                    component sets the scale of the tolerance (for example the charge density for the
+     *                    magnetization). If null, the function itself is used.
+     */
+    static std::vector<int> radial_lmmax(int ld, double const* flm, int nr, int lmmax, double tol,
+                                         double const* fref = nullptr)
+    {
+        if (!fref) {
+            fref = flm;
+        }
+        int lmax = utils::lmax(lmmax);
+        std::vector<int> lmmax_r(nr);
+        for (int ir = 0; ir < nr; ir++) {
+            double f0 = std::abs(fref[ir * ld]);
+            int l0{0};
+            for (int l = lmax; l > 0; l--) {
+                for (int lm = utils::lm(l, -l); lm <= utils::lm(l, l); lm++) {
+                    if (std::abs(flm[ir * ld + lm]) > tol * f0) {
+                        l0 = l;
+                        break;
+                    }
+                }
+                if (l0) {
+                    break;
+                }
+            }
+            lmmax_r[ir] = utils::lmmax(l0);
+            if (ir) {
+                lmmax_r[ir] = std::max(lmmax_r[ir], lmmax_r[ir - 1]);
+            }
+        }
+        return lmmax_r;
+    }
+
     /// Convert form Rlm to Ylm representation.
     static void convert(int lmax__, double const* f_rlm__, double_complex* f_ylm__)
     {
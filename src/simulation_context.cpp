@@ -943,6 +943,13 @@ void Simulation_context::update()
         if (!beta_ri_ || beta_ri_->qmax() < new_gk_cutoff) {
             beta_ri_ = std::unique_ptr<Radial_integrals_beta<false>>(
                 new Radial_integrals_beta<false>(unit_cell(), new_gk_cutoff, settings().nprii_beta_, beta_ri_callback_));
+            /* filtered radial functions are computed from the radial integrals */
+            beta_rf_rg_.clear();
+        }
+
+        /* radial functions of the real-space beta-projectors do not depend on k and are computed once */
+        if (control().beta_real_space_ && beta_rf_rg_.empty()) {
+            init_beta_rf_rg();
         }
 
         if (!beta_ri_djl_ || beta_ri_djl_->qmax() < new_gk_cutoff) {
@@ -1028,6 +1035,13 @@ void Simulation_context::update()
             spfft_pu, fft_type, fft_grid_[0], fft_grid_[1], fft_grid_[2],
             spl_z.local_size(), gvec_partition_->gvec_count_fft(), SPFFT_INDEX_TRIPLETS, gv.at(memory_t::host))));
 
+        spfft_transform_batch_.clear();
+        if (control().fft_batch_size_rg_ > 1) {
+            for (int i = 0; i < control().fft_batch_size_rg_; i++) {
+                spfft_transform_batch_.emplace_back(spfft_transform_->clone());
+            }
+        }
+
         /* copy G-vectors to GPU; this is done once because Miller indices of G-vectors
            do not change during the execution */
         switch (this->processing_unit()) {
@@ -1138,6 +1152,13 @@ void Simulation_context::update()
                 }
             }
         }
+
+        /* index of rotated G-vectors in the remapped distribution */
+        std::vector<matrix3d<int>> invRT(unit_cell().symmetry().num_mag_sym());
+        for (int isym = 0; isym < unit_cell().symmetry().num_mag_sym(); isym++) {
+            invRT[isym] = unit_cell().symmetry().magnetic_group_symmetry(isym).spg_op.invRT;
+        }
+        remap_gvec_->init_rotations(invRT);
     }
 
     /* precompute some G-vector related arrays */
@@ -1349,6 +1370,55 @@ void Simulation_context::init_atoms_to_grid_idx(double R__)
     }
 }
 
+void Simulation_context::init_beta_rf_rg()
+{
+    PROFILE("sirius::Simulation_context::init_beta_rf_rg");
+
+    beta_rf_rg_   = std::vector<std::vector<Spline<double>>>(unit_cell().num_atom_types());
+    beta_rmax_rg_ = std::vector<double>(unit_cell().num_atom_types(), 0);
+
+    for (int iat = 0; iat < unit_cell().num_atom_types(); iat++) {
+        auto& atom_type = unit_cell().atom_type(iat);
+        int nrb         = atom_type.num_beta_radial_functions();
+        if (!nrb) {
+            continue;
+        }
+
+        /* find the cutoff radius of the projectors */
+        double fmax{0};
+        for (int idxrf = 0; idxrf < nrb; idxrf++) {
+            auto& f = atom_type.beta_radial_function(idxrf);
+            for (int ir = 0; ir < f.num_points(); ir++) {
+                fmax = std::max(fmax, std::abs(f(ir)));
+            }
+        }
+        int ir_max{0};
+        for (int idxrf = 0; idxrf < nrb; idxrf++) {
+            auto& f = atom_type.beta_radial_function(idxrf);
+            for (int ir = 0; ir < f.num_points(); ir++) {
+                if (std::abs(f(ir)) > 1e-10 * fmax) {
+                    ir_max = std::max(ir_max, ir);
+                }
+            }
+        }
+        double rmax = control().beta_real_space_radius_scale_ * atom_type.radial_grid(std::min(ir_max + 1,
+            atom_type.radial_grid().num_points() - 1));
+
+        /* radial integrals of the projectors on the q-grid up to the G+k cutoff */
+        auto qgrid = filter_q_grid(gk_cutoff());
+        int nq     = static_cast<int>(qgrid.size());
+        mdarray<double, 2> ri(unit_cell().max_mt_radial_basis_size(), nq);
+        beta_ri().values(iat, nq, qgrid.data(), &ri(0, 0), unit_cell().max_mt_radial_basis_size());
+
+        std::vector<int> l(nrb);
+        for (int idxrf = 0; idxrf < nrb; idxrf++) {
+            l[idxrf] = atom_type.indexr(idxrf).l;
+        }
+        beta_rf_rg_[iat]   = filter_radial_functions(qgrid, ri, l, rmax);
+        beta_rmax_rg_[iat] = rmax;
+    }
+}
+
 void Simulation_context::init_step_function()
 {
     auto v = make_periodic_function<index_domain_t::global>([&](int iat, double g)
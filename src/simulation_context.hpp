@@ -98,6 +98,11 @@ class Simulation_context : public Simulation_parameters
     std::unique_ptr<spfft::Transform> spfft_transform_;
     std::unique_ptr<spfft::Grid> spfft_grid_;
 
+    /// Independent copies of the fine-grained FFT driver for the batched transformation of periodic functions.
+    /** Each copy has its own grid and buffers as required by the multi-transform interface of SpFFT. The pool is
+     *  empty if Control_input::fft_batch_size_rg_ is one. */
+    std::vector<spfft::Transform> spfft_transform_batch_;
+
     /// Grid descriptor for the coarse-grained FFT transform.
     sddk::FFT3D_grid fft_coarse_grid_;
 
@@ -191,6 +196,13 @@ class Simulation_context : public Simulation_parameters
     /// Radial integrals of the local part of pseudopotential with derivatives of spherical Bessel functions.
     std::unique_ptr<Radial_integrals_vloc<true>> vloc_ri_djl_;
 
+    /// Fourier-filtered radial functions of the beta-projectors for the real-space application.
+    /** The functions depend only on the atom type and the G+k cutoff and are shared by all k-points. */
+    std::vector<std::vector<Spline<double>>> beta_rf_rg_;
+
+    /// Radii of the spheres in which the real-space beta-projectors are sampled.
+    std::vector<double> beta_rmax_rg_;
+
     /// List of real-space point indices for each of the atoms.
     std::vector<std::vector<std::pair<int, double>>> atoms_to_grid_idx_;
 
@@ -276,6 +288,9 @@ class Simulation_context : public Simulation_parameters
     /// Find a list of real-space grid points around each atom.
     void init_atoms_to_grid_idx(double R__);
 
+    /// Generate Fourier-filtered radial functions of the beta-projectors for the real-space application.
+    void init_beta_rf_rg();
+
     /// Get the stsrting time stamp.
     void start()
     {
@@ -558,6 +573,18 @@ class Simulation_context : public Simulation_parameters
         return *beta_ri_djl_;
     }
 
+    /// Fourier-filtered radial functions of the beta-projectors of an atom type sampled on a linear grid.
+    inline std::vector<Spline<double>> const& beta_rf_rg(int iat__) const
+    {
+        return beta_rf_rg_[iat__];
+    }
+
+    /// Radius of the sphere in which the real-space beta-projectors of an atom type are sampled.
+    inline double beta_rmax_rg(int iat__) const
+    {
+        return beta_rmax_rg_[iat__];
+    }
+
     inline Radial_integrals_aug<false> const& aug_ri() const
     {
         return *aug_ri_;
@@ -702,6 +729,12 @@ class Simulation_context : public Simulation_parameters
         return *spfft_transform_;
     }
 
+    /// Pool of copies of the fine-grained FFT driver used by the batched transformation of periodic functions.
+    std::vector<spfft::Transform>& spfft_batch()
+    {
+        return spfft_transform_batch_;
+    }
+
     spfft::Transform& spfft_coarse()
     {
         return *spfft_transform_coarse_;
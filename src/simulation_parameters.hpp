@@ -31,6 +31,7 @@
 #include "utils/cmd_args.hpp"
 #include "utils/utils.hpp"
 #include "memory.hpp"
+#include "dft/smearing.hpp"
 
 using namespace sddk;
 
@@ -389,6 +390,12 @@ class Simulation_parameters
         parameters_input_.smearing_width_ = smearing_width__;
     }
 
+    /// Type of smearing function.
+    smearing::smearing_t smearing() const
+    {
+        return parameters_input_.smearing_;
+    }
+
     void set_auto_rmt(int auto_rmt__)
     {
         parameters_input_.auto_rmt_ = auto_rmt__;
@@ -576,7 +583,7 @@ class Simulation_parameters
     memory_pool& mem_pool(memory_t M__) const
     {
         if (memory_pool_.count(M__) == 0) {
-            memory_pool_.emplace(M__, memory_pool(M__));
+            memory_pool_.emplace(M__, memory_pool(M__, 0, get_memory_pool_t(control().memory_pool_type_)));
         }
         return memory_pool_.at(M__);
     }
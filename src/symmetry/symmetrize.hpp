@@ -79,6 +79,10 @@ inline void symmetrize_function(Unit_cell_symmetry const& sym__, Gvec_shells con
 {
     PROFILE("sirius::symmetrize_function|fpw");
 
+    if (gvec_shells__.num_rotations() != sym__.num_mag_sym()) {
+        throw std::runtime_error("[sirius::symmetrize_function] index of rotated G-vectors is not initialized");
+    }
+
     auto v = gvec_shells__.remap_forward(f_pw__);
 
     std::vector<double_complex> sym_f_pw(v.size(), 0);
@@ -115,11 +119,10 @@ inline void symmetrize_function(Unit_cell_symmetry const& sym__, Gvec_shells con
                     double_complex phase = phase_factor(i, gv_rot);
 
                     /* local index of a rotated G-vector */
-                    int ig_rot = gvec_shells__.index_by_gvec(gv_rot);
+                    int ig_rot = gvec_shells__.index_rotated(i, igloc);
 
-                    if (ig_rot == -1) {
-                        gv_rot = gv_rot * (-1);
-                        ig_rot = gvec_shells__.index_by_gvec(gv_rot);
+                    if (ig_rot < 0) {
+                        ig_rot = -ig_rot - 1;
                         assert(ig_rot >= 0 && ig_rot < (int)v.size());
                         zsym += std::conj(v[ig_rot]) * phase;
                     } else {
@@ -134,10 +137,10 @@ inline void symmetrize_function(Unit_cell_symmetry const& sym__, Gvec_shells con
                     auto& invRT = sym__.magnetic_group_symmetry(i).spg_op.invRT;
                     auto gv_rot = invRT * G;
                     /* index of a rotated G-vector */
-                    int ig_rot = gvec_shells__.index_by_gvec(gv_rot);
+                    int ig_rot = gvec_shells__.index_rotated(i, igloc);
                     double_complex phase = std::conj(phase_factor(i, gv_rot));
 
-                    if (ig_rot == -1) {
+                    if (ig_rot < 0) {
                         /* skip */
                     } else {
                         assert(ig_rot >= 0 && ig_rot < int(v.size()));
@@ -165,6 +168,10 @@ inline void symmetrize_vector_function(Unit_cell_symmetry const& sym__, Gvec_she
                sym_phase_factors__(2, G[2], isym);
     };
 
+    if (gvec_shells__.num_rotations() != sym__.num_mag_sym()) {
+        throw std::runtime_error("[sirius::symmetrize_vector_function] index of rotated G-vectors is not initialized");
+    }
+
     auto v = gvec_shells__.remap_forward(fz_pw__);
 
     std::vector<double_complex> sym_f_pw(v.size(), 0);
@@ -185,16 +192,13 @@ inline void symmetrize_vector_function(Unit_cell_symmetry const& sym__, Gvec_she
                 double_complex zsym(0, 0);
 
                 for (int i = 0; i < sym__.num_mag_sym(); i++) {
-                    auto& invRT = sym__.magnetic_group_symmetry(i).spg_op.invRT;
                     auto& S = sym__.magnetic_group_symmetry(i).spin_rotation;
                     double_complex phase = phase_factor(i, G) * S(2, 2);
-                    auto gv_rot = invRT * G;
                     /* index of a rotated G-vector */
-                    int ig_rot = gvec_shells__.index_by_gvec(gv_rot);
+                    int ig_rot = gvec_shells__.index_rotated(i, igloc);
 
-                    if (ig_rot == -1) {
-                        gv_rot = gv_rot * (-1);
-                        ig_rot = gvec_shells__.index_by_gvec(gv_rot);
+                    if (ig_rot < 0) {
+                        ig_rot = -ig_rot - 1;
                         assert(ig_rot >= 0 && ig_rot < (int)v.size());
                         zsym += std::conj(v[ig_rot]) * phase;
                     } else {
@@ -210,10 +214,10 @@ inline void symmetrize_vector_function(Unit_cell_symmetry const& sym__, Gvec_she
                     auto& S = sym__.magnetic_group_symmetry(i).spin_rotation;
                     auto gv_rot = invRT * G;
                     /* index of rotated G-vector */
-                    int ig_rot = gvec_shells__.index_by_gvec(gv_rot);
+                    int ig_rot = gvec_shells__.index_rotated(i, igloc);
                     double_complex phase = std::conj(phase_factor(i, gv_rot)) / S(2, 2) ;
 
-                    if (ig_rot == -1) {
+                    if (ig_rot < 0) {
                         /* skip */
                     } else {
                         assert(ig_rot >= 0 && ig_rot < int(v.size()));
@@ -250,6 +254,10 @@ inline void symmetrize_vector_function(Unit_cell_symmetry const& sym__, Gvec_she
 {
     PROFILE("sirius::symmetrize_vector_function|vpw");
 
+    if (gvec_shells__.num_rotations() != sym__.num_mag_sym()) {
+        throw std::runtime_error("[sirius::symmetrize_vector_function] index of rotated G-vectors is not initialized");
+    }
+
     auto vx = gvec_shells__.remap_forward(fx_pw__);
     auto vy = gvec_shells__.remap_forward(fy_pw__);
     auto vz = gvec_shells__.remap_forward(fz_pw__);
@@ -290,16 +298,13 @@ inline void symmetrize_vector_function(Unit_cell_symmetry const& sym__, Gvec_she
 
                 for (int i = 0; i < sym__.num_mag_sym(); i++) {
                     /* full space-group symmetry operation is {R|t} */
-                    auto& invRT = sym__.magnetic_group_symmetry(i).spg_op.invRT;
                     auto& S = sym__.magnetic_group_symmetry(i).spin_rotation;
                     double_complex phase = phase_factor(i, G);
-                    auto gv_rot = invRT * G;
                     /* index of a rotated G-vector */
-                    int ig_rot = gvec_shells__.index_by_gvec(gv_rot);
+                    int ig_rot = gvec_shells__.index_rotated(i, igloc);
 
-                    if (ig_rot == -1) {
-                        gv_rot = gv_rot * (-1);
-                        ig_rot = gvec_shells__.index_by_gvec(gv_rot);
+                    if (ig_rot < 0) {
+                        ig_rot = -ig_rot - 1;
                         auto v_rot = vrot({vx[ig_rot], vy[ig_rot], vz[ig_rot]}, S);
                         assert(ig_rot >=0 && ig_rot < (int)vx.size());
                         xsym += std::conj(v_rot[0]) * phase;
@@ -323,11 +328,11 @@ inline void symmetrize_vector_function(Unit_cell_symmetry const& sym__, Gvec_she
                     const auto& invS = sym__.magnetic_group_symmetry(i).spin_rotation_inv;
                     auto gv_rot = invRT * G;
                     /* index of a rotated G-vector */
-                    int ig_rot = gvec_shells__.index_by_gvec(gv_rot);
+                    int ig_rot = gvec_shells__.index_rotated(i, igloc);
                     auto v_rot = vrot({xsym, ysym, zsym}, invS);
                     double_complex phase = std::conj(phase_factor(i, gv_rot));
 
-                    if (ig_rot == -1) {
+                    if (ig_rot < 0) {
                         /* skip */
                     } else {
                         assert(ig_rot >= 0 && ig_rot < int(vz.size()));
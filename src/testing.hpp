@@ -29,9 +29,12 @@
 #include <iostream>
 #include <vector>
 #include <cmath>
+#include <memory>
+#include <functional>
 #include "SDDK/dmatrix.hpp"
 #include "utils/profiler.hpp"
 #include "linalg/linalg.hpp"
+#include "simulation_context.hpp"
 
 namespace sirius {
 
@@ -154,6 +157,92 @@ sddk::dmatrix<T> random_positive_definite(int N__, int bs__, sddk::BLACS_grid co
     return B;
 }
 
+/// Add Gaussian beta-projectors x^{l+1} exp(-x^2) with l = 0, ..., lmax to the atom type.
+/** Their Fourier transform is negligible beyond the usual G+k cutoffs, so the filtered radial functions decay as
+ *  fast as the original ones and a real-space sphere doesn't truncate them. */
+inline void add_gaussian_beta(Atom_type& atype__, int lmax__)
+{
+    std::vector<double> beta(atype__.radial_grid().num_points());
+    for (int l = 0; l <= lmax__; l++) {
+        for (int i = 0; i < atype__.radial_grid().num_points(); i++) {
+            double x = atype__.radial_grid(i);
+            beta[i]  = std::pow(x, l + 1) * std::exp(-x * x);
+        }
+        atype__.add_beta_radial_function(l, beta);
+    }
+}
+
+/// Create and initialize a simulation context with the model pseudopotential atom "Cu".
+/** The default input is a simple cubic cell with a = 5 and one atom at the origin. The input is updated with the
+ *  JSON fragment of overrides as a JSON merge patch, so the lattice vectors and atomic positions are replaced as a
+ *  whole. The model atom has 11 valence electrons, a local potential, a pseudo-charge density and s, p, d
+ *  pseudo-atomic wave-functions; the beta-projectors and augmentation functions are added by the optional callback,
+ *  the ionic D-matrix is then set to -2 on the diagonal. */
+inline std::unique_ptr<Simulation_context>
+create_model_context(std::string const& options__, std::function<void(Atom_type&)> add_projectors__ = nullptr)
+{
+    auto dict = json::parse(R"({
+        "parameters" : {
+            "electronic_structure_method" : "pseudopotential",
+            "pw_cutoff" : 20,
+            "gk_cutoff" : 6
+        },
+        "control" : {
+            "verification" : 0,
+            "verbosity" : 0
+        },
+        "unit_cell" : {
+            "lattice_vectors" : [[5, 0, 0], [0, 5, 0], [0, 0, 5]],
+            "atom_types" : ["Cu"],
+            "atom_files" : {"Cu" : ""},
+            "atoms" : {"Cu" : [[0, 0, 0]]}
+        }
+    })");
+    dict.merge_patch(json::parse(options__));
+
+    std::unique_ptr<Simulation_context> ctx(new Simulation_context(dict.dump()));
+
+    /* the atom file name is empty, so the type is filled here and not read during the initialization */
+    auto& atype = ctx->unit_cell().atom_type("Cu");
+    atype.zn(11);
+    atype.set_radial_grid(radial_grid_t::lin_exp, 1000, 0.0, 100.0, 6);
+    int np = atype.radial_grid().num_points();
+    std::vector<double> f(np);
+    for (int l = 0; l <= 2; l++) {
+        for (int i = 0; i < np; i++) {
+            double x = atype.radial_grid(i);
+            f[i]     = std::exp(-x) * std::pow(x, l);
+        }
+        atype.add_ps_atomic_wf(3, l, f);
+    }
+    for (int i = 0; i < np; i++) {
+        double x = atype.radial_grid(i);
+        f[i]     = -atype.zn() / (std::exp(-x * (x + 1)) + x);
+    }
+    atype.local_potential(f);
+    for (int i = 0; i < np; i++) {
+        double x = atype.radial_grid(i);
+        f[i]     = 2 * atype.zn() * std::exp(-x * x) * x;
+    }
+    atype.ps_total_charge_density(f);
+
+    if (add_projectors__) {
+        add_projectors__(atype);
+    }
+    int nbf = atype.num_beta_radial_functions();
+    if (nbf) {
+        matrix<double> dion(nbf, nbf);
+        dion.zero();
+        for (int i = 0; i < nbf; i++) {
+            dion(i, i) = -2.0;
+        }
+        atype.d_mtrx_ion(dion);
+    }
+
+    ctx->initialize();
+    return ctx;
+}
+
 }
 
 #endif
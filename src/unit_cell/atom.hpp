@@ -431,44 +431,36 @@ class Atom
      */
     template <spin_block_t sblock>
     inline double_complex
-    radial_integrals_sum_L3(int idxrf1__, int idxrf2__, std::vector<gaunt_L3<double_complex>> const& gnt__) const
+    radial_integrals_sum_L3(int idxrf1__, int idxrf2__, gaunt_L3_row<double_complex> const& gnt__) const
     {
-        double_complex zsum(0, 0);
-
-        for (size_t i = 0; i < gnt__.size(); i++) {
-            switch (sblock) {
-                case spin_block_t::nm: {
-                    /* just the Hamiltonian */
-                    zsum += gnt__[i].coef * h_radial_integrals_(gnt__[i].lm3, idxrf1__, idxrf2__);
-                    break;
-                }
-                case spin_block_t::uu: {
-                    /* h + Bz */
-                    zsum += gnt__[i].coef * (h_radial_integrals_(gnt__[i].lm3, idxrf1__, idxrf2__) +
-                                             b_radial_integrals_(gnt__[i].lm3, idxrf1__, idxrf2__, 0));
-                    break;
-                }
-                case spin_block_t::dd: {
-                    /* h - Bz */
-                    zsum += gnt__[i].coef * (h_radial_integrals_(gnt__[i].lm3, idxrf1__, idxrf2__) -
-                                             b_radial_integrals_(gnt__[i].lm3, idxrf1__, idxrf2__, 0));
-                    break;
-                }
-                case spin_block_t::ud: {
-                    /* Bx - i By */
-                    zsum += gnt__[i].coef * double_complex(b_radial_integrals_(gnt__[i].lm3, idxrf1__, idxrf2__, 1),
-                                                           -b_radial_integrals_(gnt__[i].lm3, idxrf1__, idxrf2__, 2));
-                    break;
-                }
-                case spin_block_t::du: {
-                    /* Bx + i By */
-                    zsum += gnt__[i].coef * double_complex(b_radial_integrals_(gnt__[i].lm3, idxrf1__, idxrf2__, 1),
-                                                           b_radial_integrals_(gnt__[i].lm3, idxrf1__, idxrf2__, 2));
-                    break;
-                }
+        /* radial integrals are stored contiguously in lm3 index */
+        switch (sblock) {
+            case spin_block_t::nm: {
+                /* just the Hamiltonian */
+                return gnt__.sum(&h_radial_integrals_(0, idxrf1__, idxrf2__));
+            }
+            case spin_block_t::uu: {
+                /* h + Bz */
+                return gnt__.sum(&h_radial_integrals_(0, idxrf1__, idxrf2__)) +
+                       gnt__.sum(&b_radial_integrals_(0, idxrf1__, idxrf2__, 0));
+            }
+            case spin_block_t::dd: {
+                /* h - Bz */
+                return gnt__.sum(&h_radial_integrals_(0, idxrf1__, idxrf2__)) -
+                       gnt__.sum(&b_radial_integrals_(0, idxrf1__, idxrf2__, 0));
+            }
+            case spin_block_t::ud: {
+                /* Bx - i By */
+                return gnt__.sum(&b_radial_integrals_(0, idxrf1__, idxrf2__, 1)) -
+                       double_complex(0, 1) * gnt__.sum(&b_radial_integrals_(0, idxrf1__, idxrf2__, 2));
+            }
+            case spin_block_t::du: {
+                /* Bx + i By */
+                return gnt__.sum(&b_radial_integrals_(0, idxrf1__, idxrf2__, 1)) +
+                       double_complex(0, 1) * gnt__.sum(&b_radial_integrals_(0, idxrf1__, idxrf2__, 2));
             }
         }
-        return zsum;
+        return double_complex(0, 0);
     }
 
     inline int num_mt_points() const
@@ -287,58 +287,142 @@ json Unit_cell::serialize(bool cart_pos__) const
     return dict;
 }
 
-void Unit_cell::find_nearest_neighbours(double cluster_radius)
+std::vector<std::vector<nearest_neighbour_descriptor>> Unit_cell::find_neighbours_cell_list(double radius__) const
 {
-    PROFILE("sirius::Unit_cell::find_nearest_neighbours");
-
-    auto max_frac_coord = find_translations(cluster_radius, lattice_vectors_);
+    PROFILE("sirius::Unit_cell::find_neighbours_cell_list");
 
-    nearest_neighbours_.clear();
-    nearest_neighbours_.resize(num_atoms());
-
-    #pragma omp parallel for default(shared)
+    /* number of cells and width of the stencil of neighbouring cells along each lattice vector */
+    vector3d<int> ncell;
+    vector3d<int> stencil;
+    for (int x : {0, 1, 2}) {
+        /* distance between the planes of the unit cell that are perpendicular to the x-th reciprocal vector */
+        double d = 1.0 / vector3d<double>(inverse_lattice_vectors_(x, 0), inverse_lattice_vectors_(x, 1),
+                                           inverse_lattice_vectors_(x, 2)).length();
+        ncell[x]   = std::max(1, static_cast<int>(d / radius__));
+        stencil[x] = static_cast<int>(std::ceil(radius__ * ncell[x] / d));
+    }
+
+    /* reduced fractional coordinates and translations that bring atoms into the unit cell */
+    std::vector<vector3d<double>> pos(num_atoms());
+    std::vector<vector3d<int>> T0(num_atoms());
+    /* linked list of atoms in each cell */
+    std::vector<int> head(ncell[0] * ncell[1] * ncell[2], -1);
+    std::vector<int> next(num_atoms(), -1);
+    std::vector<vector3d<int>> cell_of_atom(num_atoms());
     for (int ia = 0; ia < num_atoms(); ia++) {
-        auto iapos = get_cartesian_coordinates(atom(ia).position());
-
-        std::vector<nearest_neighbour_descriptor> nn;
-
-        std::vector<std::pair<double, int>> nn_sort;
+        for (int x : {0, 1, 2}) {
+            double f  = atom(ia).position()[x];
+            T0[ia][x] = static_cast<int>(std::floor(f));
+            pos[ia][x] = f - T0[ia][x];
+            cell_of_atom[ia][x] = std::min(static_cast<int>(pos[ia][x] * ncell[x]), ncell[x] - 1);
+        }
+        auto& c = cell_of_atom[ia];
+        int ic  = c[0] + ncell[0] * (c[1] + ncell[1] * c[2]);
+        next[ia] = head[ic];
+        head[ic] = ia;
+    }
 
-        for (int i0 = -max_frac_coord[0]; i0 <= max_frac_coord[0]; i0++) {
-            for (int i1 = -max_frac_coord[1]; i1 <= max_frac_coord[1]; i1++) {
-                for (int i2 = -max_frac_coord[2]; i2 <= max_frac_coord[2]; i2++) {
-                    nearest_neighbour_descriptor nnd;
-                    nnd.translation[0] = i0;
-                    nnd.translation[1] = i1;
-                    nnd.translation[2] = i2;
+    auto divmod = [](int i, int n, int& q) {
+        q = static_cast<int>(std::floor(static_cast<double>(i) / n));
+        return i - q * n;
+    };
 
-                    auto vt = get_cartesian_coordinates<int>(nnd.translation);
+    std::vector<std::vector<nearest_neighbour_descriptor>> nn(num_atoms());
 
-                    for (int ja = 0; ja < num_atoms(); ja++) {
+    #pragma omp parallel for schedule(dynamic)
+    for (int ia = 0; ia < num_atoms(); ia++) {
+        auto iapos = get_cartesian_coordinates(atom(ia).position());
+        auto& c = cell_of_atom[ia];
+        for (int i0 = -stencil[0]; i0 <= stencil[0]; i0++) {
+            for (int i1 = -stencil[1]; i1 <= stencil[1]; i1++) {
+                for (int i2 = -stencil[2]; i2 <= stencil[2]; i2++) {
+                    /* neighbouring cell and the periodic image of the unit cell to which it belongs */
+                    vector3d<int> T;
+                    int j0 = divmod(c[0] + i0, ncell[0], T[0]);
+                    int j1 = divmod(c[1] + i1, ncell[1], T[1]);
+                    int j2 = divmod(c[2] + i2, ncell[2], T[2]);
+                    for (int ja = head[j0 + ncell[0] * (j1 + ncell[1] * j2)]; ja >= 0; ja = next[ja]) {
+                        nearest_neighbour_descriptor nnd;
                         nnd.atom_id = ja;
-
-                        auto japos = get_cartesian_coordinates(atom(ja).position());
-
-                        vector3d<double> v = japos + vt - iapos;
-
+                        /* translation with respect to the original (not reduced) atomic positions */
+                        for (int x : {0, 1, 2}) {
+                            nnd.translation[x] = T[x] - T0[ja][x] + T0[ia][x];
+                        }
+                        vector3d<double> v = get_cartesian_coordinates(atom(ja).position()) +
+                                             get_cartesian_coordinates<int>(nnd.translation) - iapos;
                         nnd.distance = v.length();
-
-                        if (nnd.distance <= cluster_radius) {
-                            nn.push_back(nnd);
-
-                            nn_sort.push_back(std::pair<double, int>(nnd.distance, (int)nn.size() - 1));
+                        if (nnd.distance <= radius__) {
+                            nn[ia].push_back(nnd);
                         }
                     }
                 }
             }
         }
+        std::sort(nn[ia].begin(), nn[ia].end(),
+                  [](nearest_neighbour_descriptor const& a, nearest_neighbour_descriptor const& b) {
+                      return std::tie(a.distance, a.translation, a.atom_id) <
+                             std::tie(b.distance, b.translation, b.atom_id);
+                  });
+    }
 
-        std::sort(nn_sort.begin(), nn_sort.end());
-        nearest_neighbours_[ia].resize(nn.size());
-        for (int i = 0; i < (int)nn.size(); i++) {
-            nearest_neighbours_[ia][i] = nn[nn_sort[i].second];
+    return nn;
+}
+
+void Unit_cell::find_nearest_neighbours(double cluster_radius)
+{
+    PROFILE("sirius::Unit_cell::find_nearest_neighbours");
+
+    double skin = parameters_.parameters_input().nn_skin_;
+
+    /* check if the list of neighbour candidates can be reused */
+    bool reuse = (skin > 0) && (static_cast<int>(nn_candidates_.size()) == num_atoms()) &&
+                 (std::abs(nn_candidates_radius_ - cluster_radius - skin) < 1e-12);
+    if (reuse) {
+        for (int x : {0, 1, 2}) {
+            for (int y : {0, 1, 2}) {
+                reuse = reuse && (std::abs(nn_candidates_lattice_vectors_(x, y) - lattice_vectors_(x, y)) < 1e-12);
+            }
         }
     }
+    if (reuse) {
+        double dmax{0};
+        for (int ia = 0; ia < num_atoms(); ia++) {
+            dmax = std::max(dmax, get_cartesian_coordinates(atom(ia).position() - nn_candidates_pos_[ia]).length());
+        }
+        reuse = (dmax < 0.5 * skin);
+    }
+
+    if (skin > 0) {
+        if (!reuse) {
+            nn_candidates_radius_          = cluster_radius + skin;
+            nn_candidates_                 = find_neighbours_cell_list(nn_candidates_radius_);
+            nn_candidates_lattice_vectors_ = lattice_vectors_;
+            nn_candidates_pos_.resize(num_atoms());
+            for (int ia = 0; ia < num_atoms(); ia++) {
+                nn_candidates_pos_[ia] = atom(ia).position();
+            }
+        }
+        nearest_neighbours_.resize(num_atoms());
+        /* update distances of the candidates and select the neighbours within the cluster radius */
+        #pragma omp parallel for schedule(dynamic)
+        for (int ia = 0; ia < num_atoms(); ia++) {
+            nearest_neighbours_[ia].clear();
+            for (auto nnd : nn_candidates_[ia]) {
+                nnd.distance = neighbour_distance(ia, nnd.atom_id, nnd.translation);
+                if (nnd.distance <= cluster_radius) {
+                    nearest_neighbours_[ia].push_back(nnd);
+                }
+            }
+            std::sort(nearest_neighbours_[ia].begin(), nearest_neighbours_[ia].end(),
+                      [](nearest_neighbour_descriptor const& a, nearest_neighbour_descriptor const& b) {
+                          return std::tie(a.distance, a.translation, a.atom_id) <
+                                 std::tie(b.distance, b.translation, b.atom_id);
+                      });
+        }
+    } else {
+        nn_candidates_.clear();
+        nearest_neighbours_ = find_neighbours_cell_list(cluster_radius);
+    }
 
     if (parameters_.control().print_neighbors_ && comm_.rank() == 0) {
         std::printf("Nearest neighbors\n");
@@ -145,6 +145,34 @@ class Unit_cell
     /// List of nearest neighbours for each atom.
     std::vector<std::vector<nearest_neighbour_descriptor>> nearest_neighbours_;
 
+    /// List of neighbour candidates within the cluster radius extended by the skin distance.
+    /** The list is reused by find_nearest_neighbours() as long as no atom has moved by more than half of the
+     *  skin distance since the list was built. */
+    std::vector<std::vector<nearest_neighbour_descriptor>> nn_candidates_;
+
+    /// Atomic positions at the time when the list of neighbour candidates was built.
+    std::vector<vector3d<double>> nn_candidates_pos_;
+
+    /// Lattice vectors at the time when the list of neighbour candidates was built.
+    matrix3d<double> nn_candidates_lattice_vectors_;
+
+    /// Radius of the neighbour candidates (cluster radius plus the skin distance).
+    double nn_candidates_radius_{0};
+
+    /// Find all neighbours within a given radius using the linked-cell (binning) search.
+    /** Atoms are binned into a grid of cells whose perpendicular widths are not smaller than the search radius,
+     *  so only the atoms from the surrounding cells (and their periodic images) have to be checked. The output
+     *  for each atom is sorted by distance and, for equal distances, by translation and atom index. */
+    std::vector<std::vector<nearest_neighbour_descriptor>> find_neighbours_cell_list(double radius__) const;
+
+    /// Distance between atoms ia and ja translated by T.
+    inline double neighbour_distance(int ia__, int ja__, std::array<int, 3> const& T__) const
+    {
+        vector3d<double> v = get_cartesian_coordinates(atom(ja__).position()) +
+                             get_cartesian_coordinates<int>(T__) - get_cartesian_coordinates(atom(ia__).position());
+        return v.length();
+    }
+
     /// Minimum muffin-tin radius.
     double min_mt_radius_{0};
 
@@ -260,7 +288,10 @@ class Unit_cell
     /// Set lattice vectors.
     void set_lattice_vectors(vector3d<double> a0__, vector3d<double> a1__, vector3d<double> a2__);
 
-    /// Find the cluster of nearest neighbours around each atom
+    /// Find the cluster of nearest neighbours around each atom.
+    /** If the skin distance is set in the input parameters, the neighbour candidates are searched within the
+     *  extended radius and the subsequent calls only update the distances as long as the atoms move less than
+     *  half of the skin distance. */
     void find_nearest_neighbours(double cluster_radius);
 
     bool is_point_in_mt(vector3d<double> vc, int& ja, int& jr, double& dr, double tp[2]) const;
@@ -308,6 +339,49 @@ class Unit_cell
         return inverse_lattice_vectors_ * a__;
     }
 
+    /// Visit the points of a z-plane of the real-space grid which are inside a sphere around a given position.
+    /** The box enclosing the sphere can be larger than the unit cell, so a grid point is visited once for each of its
+     *  periodic images inside the sphere. The callback receives the x- and y-indices of the grid point, the unwrapped
+     *  fractional coordinates of the image and its spherical coordinates with respect to the center.
+     *
+     *  \param [in] dims    Dimensions of the real-space grid.
+     *  \param [in] iz      Global z-index of the plane.
+     *  \param [in] center  Fractional coordinates of the center of the sphere.
+     *  \param [in] radius  Radius of the sphere; the points on the surface are excluded.
+     *  \param [in] f       Callback function f(ix, iy, r, vs).
+     */
+    template <typename F>
+    inline void for_each_grid_point_in_sphere(std::array<int, 3> const& dims__, int iz__, vector3d<double> center__,
+                                              double radius__, F&& f__) const
+    {
+        std::array<int, 3> ext;
+        std::array<int, 3> c0;
+        for (int x : {0, 1, 2}) {
+            /* half-size of the box; the distance between the lattice planes is 2pi / |b_x| */
+            auto& b    = reciprocal_lattice_vectors_;
+            double len = std::sqrt(std::pow(b(0, x), 2) + std::pow(b(1, x), 2) + std::pow(b(2, x), 2));
+            ext[x]     = static_cast<int>(std::ceil(radius__ * len * dims__[x] / twopi)) + 1;
+            c0[x]      = static_cast<int>(std::round(center__[x] * dims__[x]));
+        }
+        /* first image of the plane inside the box */
+        int i2_beg = c0[2] - ext[2];
+        i2_beg += (((iz__ - i2_beg) % dims__[2]) + dims__[2]) % dims__[2];
+        for (int i2 = i2_beg; i2 <= c0[2] + ext[2]; i2 += dims__[2]) {
+            for (int i1 = c0[1] - ext[1]; i1 <= c0[1] + ext[1]; i1++) {
+                int iy = ((i1 % dims__[1]) + dims__[1]) % dims__[1];
+                for (int i0 = c0[0] - ext[0]; i0 <= c0[0] + ext[0]; i0++) {
+                    int ix = ((i0 % dims__[0]) + dims__[0]) % dims__[0];
+
+                    vector3d<double> r(double(i0) / dims__[0], double(i1) / dims__[1], double(i2) / dims__[2]);
+                    auto vs = SHT::spherical_coordinates(get_cartesian_coordinates(r - center__));
+                    if (vs[0] < radius__) {
+                        f__(ix, iy, r, vs);
+                    }
+                }
+            }
+        }
+    }
+
     /// Unit cell volume.
     inline double omega() const
     {